@@ -757,6 +757,7 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
         size = initial_size;
     }
     ref_type top_ref;
+    bool select_prev_commit = false;
     File::Map<char> initial_mapping;
     try {
         File::Map<char> map(m_file, File::access_ReadOnly, size); // Throws
@@ -769,6 +770,29 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
 
         top_ref = get_top_ref(map.get_addr(), size);
 
+        // With the single sync commit protocol, the header may select a commit
+        // whose data did not make it to disk. In that case the previous
+        // commit, which was made durable before the last one was started, is
+        // used instead. Versions of the file format which predate the commit
+        // record may have left the flag set for a commit without one, so it
+        // is only trusted for a commit written in a later version.
+        const Header& header = *reinterpret_cast<const Header*>(map.get_addr());
+        int slot_selector = ((header.m_flags & flags_SelectBit) != 0 ? 1 : 0);
+        bool has_commit_record = (header.m_flags & flags_CommitChecksum) != 0 &&
+                                 header.m_file_format[slot_selector] >= commit_record_file_format_version;
+        bool validate = (cfg.session_initiator || !cfg.is_shared) && !is_file_on_streaming_form(header);
+        m_incomplete_commit_discarded = false;
+        if (validate && has_commit_record && !verify_commit(map, size, top_ref)) {
+            int other_slot = 1 - slot_selector;
+            ref_type prev_top_ref = to_ref(header.m_top_ref[other_slot]);
+            if (!verify_commit(map, size, prev_top_ref))
+                throw_header_exception("Last commit is incomplete and the previous one can not be recovered",
+                                       header, path);
+            top_ref = prev_top_ref;
+            select_prev_commit = true;
+            m_incomplete_commit_discarded = true;
+        }
+
         m_data = map.get_addr();
         initial_mapping = std::move(map); // replace at end of function
         // with correctly sized chunks instead...
@@ -833,6 +857,17 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
             realm::util::encryption_read_barrier(initial_mapping, 0, sizeof(Header));
         }
     }
+    if (select_prev_commit && !cfg.read_only) {
+        File::Map<Header> writable_map(m_file, File::access_ReadWrite, sizeof(Header)); // Throws
+        Header& writable_header = *writable_map.get_addr();
+        realm::util::encryption_read_barrier(writable_map, 0);
+        writable_header.m_flags ^= flags_SelectBit;
+        realm::util::encryption_write_barrier(writable_map, 0);
+        if (!get_disable_sync_to_disk() && !cfg.disable_sync)
+            writable_map.sync();
+
+        realm::util::encryption_read_barrier(initial_mapping, 0, sizeof(Header));
+    }
     int file_format_version = get_committed_file_format_version();
     initial_mapping.unmap();
     m_data = nullptr;
@@ -1054,6 +1089,80 @@ void SlabAlloc::validate_header(const char* data, size_t size, const std::string
 }
 
 
+void SlabAlloc::CommitChecksum::update(const char* data, size_t size) noexcept
+{
+    REALM_ASSERT_DEBUG(size % 8 == 0);
+    for (const char* end = data + size; data != end; data += 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof word);
+        m_hash = (m_hash ^ word) * 0x9E3779B97F4A7C15ULL;
+        m_hash ^= m_hash >> 32;
+    }
+}
+
+void SlabAlloc::CommitChecksum::update_array(const char* header, size_t byte_size) noexcept
+{
+    char first_word[8];
+    memcpy(first_word, header, sizeof first_word);
+    memset(first_word, 0, 4);
+    update(first_word, sizeof first_word);
+    update(header + sizeof first_word, byte_size - sizeof first_word);
+}
+
+bool SlabAlloc::verify_commit(const util::File::Map<char>& map, size_t len, ref_type top_ref)
+{
+    // The commit record is an integer array of (ref, size) pairs describing
+    // every range written by the commit, except for the top array and the
+    // record itself. It is placed immediately after the top array, and its
+    // checksum field holds the checksum of all of them. Anything read here may
+    // be garbage if the commit was interrupted, so everything is bounds checked.
+    auto in_file = [len](uint64_t ref, uint64_t size) {
+        return ref % 8 == 0 && size % 8 == 0 && ref >= sizeof(Header) && ref <= len && size <= len - ref;
+    };
+    const char* data = map.get_addr();
+    try {
+        if (!in_file(top_ref, NodeHeader::header_size))
+            return false;
+        realm::util::encryption_read_barrier(map, top_ref, NodeHeader::header_size);
+        size_t top_size = NodeHeader::get_byte_size_from_header(data + top_ref);
+        ref_type record_ref = top_ref + top_size;
+        if (!in_file(top_ref, top_size + NodeHeader::header_size))
+            return false;
+        realm::util::encryption_read_barrier(map, top_ref, top_size + NodeHeader::header_size);
+        const char* top_header = data + top_ref;
+        const char* record_header = data + record_ref;
+        if (NodeHeader::get_wtype_from_header(record_header) != NodeHeader::wtype_Bits ||
+            NodeHeader::get_hasrefs_from_header(record_header))
+            return false;
+        size_t record_size = NodeHeader::get_byte_size_from_header(record_header);
+        size_t num_entries = NodeHeader::get_size_from_header(record_header);
+        if (!in_file(record_ref, record_size) || num_entries % 2 != 0)
+            return false;
+        realm::util::encryption_read_barrier(map, record_ref, record_size);
+
+        CommitChecksum checksum;
+        for (size_t i = 0; i < num_entries; i += 2) {
+            uint64_t ref = uint64_t(Array::get(record_header, i));
+            uint64_t size = uint64_t(Array::get(record_header, i + 1));
+            if (!in_file(ref, size))
+                return false;
+            realm::util::encryption_read_barrier(map, size_t(ref), size_t(size));
+            checksum.update(data + ref, size_t(size));
+        }
+        checksum.update_array(top_header, top_size);
+        checksum.update_array(record_header, record_size);
+
+        uint32_t stored_checksum;
+        memcpy(&stored_checksum, record_header, sizeof stored_checksum);
+        return stored_checksum == checksum.get();
+    }
+    catch (const DecryptionFailed&) {
+        // A page which was being written when the commit was interrupted
+        return false;
+    }
+}
+
+
 size_t SlabAlloc::get_total_size() const noexcept
 {
     return m_slabs.empty() ? size_t(m_baseline.load(std::memory_order_relaxed)) : m_slabs.back().ref_end;
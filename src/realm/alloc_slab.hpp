@@ -170,6 +170,14 @@ public:
     /// transaction.
     int get_committed_file_format_version() const noexcept;
 
+    /// Returns true if the last call to attach_file() found the selected
+    /// commit to be incomplete, and selected the previous one instead. See
+    /// DBOptions::enable_commit_checksum.
+    bool incomplete_commit_discarded() const noexcept
+    {
+        return m_incomplete_commit_discarded;
+    }
+
     bool is_file_on_streaming_form() const
     {
         const Header& header = *reinterpret_cast<const Header*>(m_data);
@@ -518,8 +526,15 @@ private:
     // Values of each used bit in m_flags
     enum {
         flags_SelectBit = 1,
+        // The selected commit was written with a commit record which can be
+        // validated by verify_commit(), see GroupWriter::write_group().
+        flags_CommitChecksum = 2,
     };
 
+    // The first file format version whose writers maintain
+    // flags_CommitChecksum. Earlier writers leave it unchanged.
+    static constexpr int commit_record_file_format_version = 11;
+
     // 24 bytes
     struct Header {
         uint64_t m_top_ref[2]; // 2 * 8 bytes
@@ -528,9 +543,28 @@ private:
         uint8_t m_file_format[2]; // See `library_file_format`
         uint8_t m_reserved;
         // bit 0 of m_flags is used to select between the two top refs.
+        // bit 1 of m_flags is set when the selected commit can be validated.
         uint8_t m_flags;
     };
 
+    // Checksum of the data written by a commit. It is computed over 8-byte
+    // words, so that feeding it a sequence of ranges gives the same result as
+    // feeding it their concatenation, provided all sizes are multiples of 8.
+    class CommitChecksum {
+    public:
+        void update(const char* data, size_t size) noexcept;
+        // Update with an array whose checksum field (the first 4 bytes) is
+        // treated as zero
+        void update_array(const char* header, size_t byte_size) noexcept;
+        uint32_t get() const noexcept
+        {
+            return uint32_t(m_hash ^ (m_hash >> 32));
+        }
+
+    private:
+        uint64_t m_hash = 0xcbf29ce484222325ULL;
+    };
+
     // 16 bytes
     struct StreamingFooter {
         uint64_t m_top_ref;
@@ -646,6 +680,7 @@ private:
     size_t m_commit_size = 0;
 
     bool m_debug_out = false;
+    bool m_incomplete_commit_discarded = false;
 
     /// Throws if free-lists are no longer valid.
     size_t consolidate_free_read_only();
@@ -662,6 +697,10 @@ private:
     /// Read the top_ref from the given buffer and set m_file_on_streaming_form
     /// if the buffer contains a file in streaming form
     static ref_type get_top_ref(const char* data, size_t len);
+    /// Check that all data written by the commit with the specified top ref
+    /// made it to the file, using the commit record which follows the top
+    /// array. The map must cover the first 'len' bytes of the file.
+    static bool verify_commit(const util::File::Map<char>& map, size_t len, ref_type top_ref);
 
     // Gets the path of the attached file, or other relevant debugging info.
     std::string get_file_path_for_assertions() const;
@@ -16,6 +16,7 @@
  *
  **************************************************************************/
 
+#include <algorithm>
 #include <array>
 #include <cstring> // std::memcpy
 #include <iomanip>
@@ -225,6 +226,8 @@ void Array::init_from_mem(MemRef mem) noexcept
     m_is_inner_bptree_node = get_is_inner_bptree_node_from_header(header);
     m_has_refs = get_hasrefs_from_header(header);
     m_context_flag = get_context_flag_from_header(header);
+    m_is_encoded = get_wtype_from_header(header) == wtype_Offset;
+    m_base = m_is_encoded ? get_base_from_header(header) : 0;
 
     set_width(m_width);
 }
@@ -331,10 +334,25 @@ ref_type Array::do_write_deep(_impl::ArrayWriterBase& out, bool only_if_modified
         new_array.add(value); // Throws
     }
 
+    new_array.clear_padding();
     return new_array.do_write_shallow(out); // Throws
 }
 
 
+void Array::clear_padding() noexcept
+{
+    REALM_ASSERT_DEBUG(get_wtype_from_header(get_header_from_data(m_data)) == wtype_Bits);
+    size_t num_bits = m_size * m_width;
+    char* begin = m_data + num_bits / 8;
+    char* end = m_data + (get_byte_size() - header_size);
+    if (num_bits % 8 != 0 && begin != end) {
+        *begin &= char((1 << (num_bits % 8)) - 1);
+        ++begin;
+    }
+    std::fill(begin, end, char(0));
+}
+
+
 void Array::move(size_t begin, size_t end, size_t dest_begin)
 {
     REALM_ASSERT_3(begin, <=, end);
@@ -370,6 +388,7 @@ void Array::move(size_t begin, size_t end, size_t dest_begin)
 
 void Array::move(Array& dst, size_t ndx)
 {
+    decode(); // Throws
     size_t nb_to_move = m_size - ndx;
     dst.copy_on_write();
     dst.ensure_minimum_width(this->m_ubound);
@@ -403,7 +422,7 @@ void Array::add_to_column(KeyColumn* column, int64_t value)
 void Array::set(size_t ndx, int64_t value)
 {
     REALM_ASSERT_3(ndx, <, m_size);
-    if ((this->*(m_vtable->getter))(ndx) == value)
+    if ((this->*m_getter)(ndx) == value)
         return;
 
     // Check if we need to copy before modifying
@@ -461,6 +480,7 @@ void Array::insert(size_t ndx, int_fast64_t value)
 {
     REALM_ASSERT_DEBUG(ndx <= m_size);
 
+    decode(); // Throws
 
     Getter old_getter = m_getter; // Save old getter before potential width expansion
 
@@ -583,6 +603,11 @@ void Array::truncate_and_destroy_children(size_t new_size)
 
 void Array::do_ensure_minimum_width(int_fast64_t value)
 {
+    if (m_is_encoded) {
+        decode(); // Throws
+        if (value >= m_lbound && value <= m_ubound)
+            return;
+    }
 
     // Make room for the new value
     size_t width = bit_width(value);
@@ -601,9 +626,86 @@ void Array::do_ensure_minimum_width(int_fast64_t value)
     }
 }
 
+bool Array::try_encode()
+{
+    if (m_size == 0)
+        return false;
+    int64_t min = get(0);
+    int64_t max = min;
+    for (size_t i = 1; i < m_size; ++i) {
+        int64_t v = get(i);
+        min = std::min(min, v);
+        max = std::max(max, v);
+    }
+    size_t width;
+    if (!get_encoded_width(min, max, width))
+        return false;
+    encode(min, width); // Throws
+    return true;
+}
+
+bool Array::get_encoded_width(int64_t min, int64_t max, size_t& width) const noexcept
+{
+    if (m_is_encoded || m_has_refs || m_is_inner_bptree_node || m_alloc.is_read_only(m_ref))
+        return false;
+    REALM_ASSERT_DEBUG(get_wtype_from_header(get_header()) == wtype_Bits);
+
+    // Limiting the offsets to 32 bits keeps them far from the values that encode_value() clamps to
+    uint64_t span = uint64_t(max) - uint64_t(min);
+    if (span > uint64_t(ubound_for_width(32)))
+        return false;
+    width = bit_width(int64_t(span));
+    return calc_byte_size(wtype_Offset, m_size, uint_least8_t(width)) <
+           calc_byte_size(wtype_Bits, m_size, uint_least8_t(m_width));
+}
+
+void Array::encode(int64_t base, size_t width)
+{
+    // Encoded arrays are never extended, so there is no need for extra capacity
+    size_t byte_size = calc_byte_size(wtype_Offset, m_size, uint_least8_t(width));
+    MemRef mem = m_alloc.alloc(byte_size); // Throws
+    char* header = mem.get_addr();
+    init_header(header, false, false, m_context_flag, wtype_Offset, int(width), m_size, byte_size);
+    char* data = get_data_from_header(header);
+    for (size_t i = 0; i < m_size; ++i)
+        set_direct(data, width, i, get(i) - base);
+    set_base_in_header(base, header);
+
+    replace_node(mem); // Throws
+}
+
+void Array::do_decode()
+{
+    REALM_ASSERT_DEBUG(m_is_encoded);
+    int64_t min = 0;
+    int64_t max = 0;
+    for (size_t i = 0; i < m_size; ++i) {
+        int64_t v = get(i);
+        min = std::min(min, v);
+        max = std::max(max, v);
+    }
+    size_t width = std::max(bit_width(min), bit_width(max));
+
+    MemRef mem = create_node(m_size, m_alloc, m_context_flag, type_Normal, wtype_Bits, int(width)); // Throws
+    char* data = get_data_from_header(mem.get_addr());
+    for (size_t i = 0; i < m_size; ++i)
+        set_direct(data, width, i, get(i));
+
+    replace_node(mem); // Throws
+}
+
+void Array::replace_node(MemRef mem)
+{
+    ref_type old_ref = m_ref;
+    char* old_header = get_header();
+    init_from_mem(mem);
+    update_parent(); // Throws
+    m_alloc.free_(old_ref, old_header);
+}
+
 void Array::set_all_to_zero()
 {
-    if (m_size == 0 || m_width == 0)
+    if (m_size == 0 || (m_width == 0 && m_base == 0))
         return;
 
     copy_on_write(); // Throws
@@ -615,6 +717,7 @@ void Array::set_all_to_zero()
 void Array::adjust_ge(int_fast64_t limit, int_fast64_t diff)
 {
     if (diff != 0) {
+        decode(); // Throws
         for (size_t i = 0, n = size(); i != n;) {
             REALM_TEMPEX(i = adjust_ge, m_width, (i, n, limit, diff))
         }
@@ -654,8 +757,9 @@ size_t Array::adjust_ge(size_t start, size_t end, int_fast64_t limit, int_fast64
 // pointed at are sorted increasingly
 //
 // This method is mostly used by query_engine to enumerate table row indexes in increasing order through a TableView
-size_t Array::find_gte(const int64_t target, size_t start, size_t end) const
+size_t Array::find_gte(const int64_t value, size_t start, size_t end) const
 {
+    int64_t target = encode_value(value);
     switch (m_width) {
         case 0:
             return find_gte<0>(target, start, end);
@@ -693,7 +797,7 @@ size_t Array::find_gte(const int64_t target, size_t start, size_t end) const
     size_t idx;
 
     for (idx = start; idx < end; ++idx) {
-        if (get(idx) >= target) {
+        if (get<w>(idx) >= target) {
             ref = idx;
             break;
         }
@@ -922,6 +1026,7 @@ bool Array::minmax(int64_t& result, size_t start, size_t end, size_t* return_ndx
     }
 
     int64_t m = get<w>(start);
+    best_index = start;
     ++start;
 
 #if 0 // We must now return both value AND index of result. SSE does not support finding index, so we've disabled it
@@ -971,6 +1076,19 @@ bool Array::minmax(int64_t& result, size_t start, size_t end, size_t* return_ndx
 #endif
 #endif
 
+#ifdef REALM_COMPILER_AVX
+    if (w >= 8 && start < end && sseavx<2>()) {
+        // Find the value with AVX first, and then its index with a (likewise vectorised) search for it
+        const char* data = m_data + start * w / 8;
+        int64_t v = find_max ? avx::maximum(w, data, end - start) : avx::minimum(w, data, end - start);
+        if (find_max ? v > m : v < m) {
+            m = v;
+            best_index = find_first(v + m_base, start, end); // Takes a decoded value
+        }
+        start = end;
+    }
+#endif
+
     for (; start < end; ++start) {
         const int64_t v = get<w>(start);
         if (find_max ? v > m : v < m) {
@@ -987,17 +1105,32 @@ bool Array::minmax(int64_t& result, size_t start, size_t end, size_t* return_ndx
 
 bool Array::maximum(int64_t& result, size_t start, size_t end, size_t* return_ndx) const
 {
-    REALM_TEMPEX2(return minmax, true, m_width, (result, start, end, return_ndx));
+    bool found;
+    REALM_TEMPEX2(found = minmax, true, m_width, (result, start, end, return_ndx));
+    if (found)
+        result += m_base;
+    return found;
 }
 
 bool Array::minimum(int64_t& result, size_t start, size_t end, size_t* return_ndx) const
 {
-    REALM_TEMPEX2(return minmax, false, m_width, (result, start, end, return_ndx));
+    bool found;
+    REALM_TEMPEX2(found = minmax, false, m_width, (result, start, end, return_ndx));
+    if (found)
+        result += m_base;
+    return found;
 }
 
 int64_t Array::sum(size_t start, size_t end) const
 {
-    REALM_TEMPEX(return sum, m_width, (start, end));
+    int64_t s;
+    REALM_TEMPEX(s = sum, m_width, (start, end));
+    if (REALM_UNLIKELY(m_base != 0)) {
+        if (end == size_t(-1))
+            end = m_size;
+        s = int64_t(uint64_t(s) + uint64_t(m_base) * (end - start));
+    }
+    return s;
 }
 
 template <size_t w>
@@ -1069,6 +1202,13 @@ int64_t Array::sum(size_t start, size_t end) const
         start += sizeof(int64_t) * 8 / no0(w) * chunks;
     }
 
+#ifdef REALM_COMPILER_AVX
+    if (w >= 8 && sseavx<2>()) {
+        // Widens to 64 bit lanes, so unlike the SSE path below this cannot overflow for large leaves
+        return s + avx::sum(w, m_data + start * w / 8, end - start);
+    }
+#endif
+
 #ifdef REALM_COMPILER_SSE
     if (sseavx<42>()) {
 
@@ -1168,6 +1308,7 @@ int64_t Array::sum(size_t start, size_t end) const
 
 size_t Array::count(int64_t value) const noexcept
 {
+    value = encode_value(value);
     const uint64_t* next = reinterpret_cast<uint64_t*>(m_data);
     size_t value_count = 0;
     const size_t end = m_size;
@@ -1585,7 +1726,7 @@ void Array::set_width() noexcept
     m_width = width;
 
     m_vtable = &VTableForWidth<width>::vtable;
-    m_getter = m_vtable->getter;
+    m_getter = m_base ? &Array::get_decoded<width> : m_vtable->getter;
 }
 
 // This method reads 8 concecutive values into res[8], starting from index 'ndx'. It's allowed for the 8 values to
@@ -2043,12 +2184,12 @@ void Array::to_dot_parent_edge(std::ostream& out) const
 
 size_t Array::lower_bound_int(int64_t value) const noexcept
 {
-    REALM_TEMPEX(return lower_bound, m_width, (m_data, m_size, value));
+    REALM_TEMPEX(return lower_bound, m_width, (m_data, m_size, encode_value(value)));
 }
 
 size_t Array::upper_bound_int(int64_t value) const noexcept
 {
-    REALM_TEMPEX(return upper_bound, m_width, (m_data, m_size, value));
+    REALM_TEMPEX(return upper_bound, m_width, (m_data, m_size, encode_value(value)));
 }
 
 
@@ -2102,7 +2243,10 @@ int_fast64_t Array::get(const char* header, size_t ndx) noexcept
 {
     const char* data = get_data_from_header(header);
     uint_least8_t width = get_width_from_header(header);
-    return get_direct(data, width, ndx);
+    int64_t value = get_direct(data, width, ndx);
+    if (REALM_UNLIKELY(get_wtype_from_header(header) == wtype_Offset))
+        value += get_base_from_header(header);
+    return value;
 }
 
 
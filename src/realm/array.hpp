@@ -57,6 +57,7 @@ Searching: The main finding function is:
 #include <realm/query_conditions.hpp>
 #include <realm/column_fwd.hpp>
 #include <realm/array_direct.hpp>
+#include <realm/array_avx.hpp>
 #include <realm/array_unsigned.hpp>
 
 /*
@@ -413,6 +414,18 @@ public:
 
     bool minimum(int64_t& result, size_t start = 0, size_t end = size_t(-1), size_t* return_ndx = nullptr) const;
 
+    /// Store the elements as offsets from their minimum (frame-of-reference
+    /// encoding) if that makes the array smaller. Returns true if the array was
+    /// encoded. Only arrays without refs that are not read-only are
+    /// considered. Encoded arrays are read-only in the sense that they are
+    /// decoded into a new array the first time they are modified.
+    bool try_encode();
+
+    bool is_encoded() const noexcept
+    {
+        return m_is_encoded;
+    }
+
     /// This information is guaranteed to be cached in the array accessor.
     bool is_inner_bptree_node() const noexcept;
 
@@ -600,6 +613,13 @@ public:
 
 #endif
 
+#ifdef REALM_COMPILER_AVX
+    // AVX2/AVX-512 find for the four functions Equal/NotEqual/Less/Greater on 8, 16, 32 and 64 bit elements
+    template <class cond, Action action, size_t width, class Callback>
+    bool find_avx(int64_t value, size_t start, size_t end, size_t baseindex, QueryState<int64_t>* state,
+                  Callback callback) const;
+#endif
+
     template <size_t width>
     inline bool test_zero(uint64_t value) const; // Tests value for 0-elements
 
@@ -657,6 +677,12 @@ public:
     /// written by a non-recursive invocation of write().
     size_t get_byte_size() const noexcept;
 
+    /// Zero the bits between the last element and the end of the last 64-bit
+    /// word, which are otherwise left as they were in the allocated memory,
+    /// so that write() produces the same bytes every time. The array must be
+    /// writable.
+    void clear_padding() noexcept;
+
     /// Get the maximum number of bytes that can be written by a
     /// non-recursive invocation of write() on an array with the
     /// specified number of elements, that is, the maximum value that
@@ -719,8 +745,49 @@ protected:
     void set_width() noexcept;
     void set_width(size_t) noexcept;
 
+    // Encoded arrays are decoded instead of copied, as they are never modified in place
+    void copy_on_write()
+    {
+        if (REALM_UNLIKELY(m_is_encoded))
+            do_decode(); // Throws
+        else
+            Node::copy_on_write(); // Throws
+    }
+
+    void decode()
+    {
+        if (REALM_UNLIKELY(m_is_encoded))
+            do_decode(); // Throws
+    }
+
+    // Set 'width' to the width of the offsets needed to encode the values in [min, max]. Returns false if the
+    // encoding would not make the array smaller.
+    bool get_encoded_width(int64_t min, int64_t max, size_t& width) const noexcept;
+    // Replace the array by one storing its elements as offsets from 'base'
+    void encode(int64_t base, size_t width);
+
+    // The offset from the base representing 'value'. Values not representable as offsets are clamped, which is
+    // safe as offsets never come close to the limits of int64_t.
+    int64_t encode_value(int64_t value) const noexcept
+    {
+        if (REALM_LIKELY(m_base == 0))
+            return value;
+        if (util::int_subtract_with_overflow_detect(value, m_base))
+            return m_base > 0 ? std::numeric_limits<int64_t>::min() : std::numeric_limits<int64_t>::max();
+        return value;
+    }
+
 private:
     void do_ensure_minimum_width(int_fast64_t);
+    void do_decode();
+    // Attach to 'mem' in place of the current node, which is freed
+    void replace_node(MemRef mem);
+
+    template <size_t w>
+    int64_t get_decoded(size_t ndx) const noexcept
+    {
+        return m_base + get<w>(ndx);
+    }
 
     template <size_t w>
     int64_t sum(size_t start, size_t end) const;
@@ -785,6 +852,8 @@ protected:
     bool m_is_inner_bptree_node; // This array is an inner node of B+-tree.
     bool m_has_refs;             // Elements whose first bit is zero are refs to subarrays.
     bool m_context_flag;         // Meaning depends on context.
+    bool m_is_encoded = false;   // Elements are offsets from m_base (wtype_Offset).
+    int64_t m_base = 0;          // Added to the elements of an encoded array.
 
 private:
     ref_type do_write_shallow(_impl::ArrayWriterBase&) const;
@@ -1087,6 +1156,10 @@ inline void Array::get_chunk(size_t ndx, int64_t res[8]) const noexcept
 {
     REALM_ASSERT_DEBUG(ndx < m_size);
     (this->*(m_vtable->chunk_getter))(ndx, res);
+    if (REALM_UNLIKELY(m_base != 0)) {
+        for (size_t i = 0; i < 8 && ndx + i < m_size; ++i)
+            res[i] += m_base;
+    }
 }
 
 
@@ -1440,8 +1513,10 @@ bool Array::find_action(size_t index, util::Optional<int64_t> value, QueryState<
 {
     if (action == act_CallbackIdx)
         return callback(index);
-    else
-        return state->match<action, false>(index, 0, value);
+    // The value is a stored element, which needs decoding if it is aggregated
+    if ((action == act_Sum || action == act_Max || action == act_Min) && value)
+        value = *value + m_base;
+    return state->match<action, false>(index, 0, value);
 }
 template <Action action, class Callback>
 bool Array::find_action_pattern(size_t index, uint64_t pattern, QueryState<int64_t>* state, Callback callback) const
@@ -1592,11 +1667,11 @@ bool Array::find_optimized(int64_t value, size_t start, size_t end, size_t basei
             // if this is what we are looking for. And we have to adjust the indexes to compensate for the
             // null value at position 0.
             if (find_null) {
-                value = get(0);
+                value = get<bitwidth>(0);
             }
             else {
                 // If the value to search for is equal to the null value, the value cannot be in the array
-                if (value == get(0)) {
+                if (value == get<bitwidth>(0)) {
                     return true;
                 }
             }
@@ -1607,7 +1682,7 @@ bool Array::find_optimized(int64_t value, size_t start, size_t end, size_t basei
         else {
             // We were called by find() of a nullable array. So skip first entry, take nulls in count, etc, etc. Fixme:
             // Huge speed optimizations are possible here! This is a very simple generic method.
-            auto null_value = get(0);
+            auto null_value = get<bitwidth>(0);
             for (; start2 < end; start2++) {
                 int64_t v = get<bitwidth>(start2 + 1);
                 bool value_is_null = (v == null_value);
@@ -1685,9 +1760,9 @@ bool Array::find_optimized(int64_t value, size_t start, size_t end, size_t basei
             if (action == act_Min)
                 Array::minimum(res, start2, end2, &res_ndx);
 
-            find_action<action, Callback>(res_ndx + baseindex, res, state, callback);
-            // find_action will increment match count by 1, so we need to `-1` from the number of elements that
-            // we performed the fast Array methods on.
+            // The result is decoded already, so it is passed directly to the state. This will increment match count
+            // by 1, so we need to `-1` from the number of elements that we performed the fast Array methods on.
+            state->match<action, false>(res_ndx + baseindex, 0, util::make_optional(res));
             state->m_match_count += end2 - start2 - 1;
         }
         else if (action == act_Count) {
@@ -1704,6 +1779,13 @@ bool Array::find_optimized(int64_t value, size_t start, size_t end, size_t basei
     // finder cannot handle this bitwidth
     REALM_ASSERT_3(m_width, !=, 0);
 
+#if defined(REALM_COMPILER_AVX)
+    // Prefer AVX2/AVX-512 when there is at least one full block to compare. Widths below 8 bits are searched
+    // 64 bits at a time by compare() below.
+    if (bitwidth >= 8 && end - start2 >= avx::find_block_size && sseavx<2>())
+        return find_avx<cond, action, bitwidth, Callback>(value, start2, end, baseindex, state, callback);
+#endif
+
 #if defined(REALM_COMPILER_SSE)
     // Only use SSE if payload is at least one SSE chunk (128 bits) in size. Also note taht SSE doesn't support
     // Less-than comparison for 64-bit values.
@@ -1750,6 +1832,35 @@ bool Array::find_optimized(int64_t value, size_t start, size_t end, size_t basei
 #endif
 }
 
+#ifdef REALM_COMPILER_AVX
+template <class cond, Action action, size_t bitwidth, class Callback>
+bool Array::find_avx(int64_t value, size_t start, size_t end, size_t baseindex, QueryState<int64_t>* state,
+                     Callback callback) const
+{
+    // Compare a block at a time into a bitmap with one bit per element, then report the matches. Counting
+    // consumes the bitmap directly with popcount.
+    constexpr size_t block_size = avx::find_block_size;
+    uint64_t matches[block_size / 64];
+    for (; end - start >= block_size; start += block_size) {
+        avx::find_matches(cond::condition, bitwidth, m_data + start * bitwidth / 8, block_size, value, matches);
+        for (size_t i = 0; i < block_size / 64; ++i) {
+            uint64_t m = matches[i];
+            size_t chunk_start = start + i * 64;
+            if (m == 0 || find_action_pattern<action, Callback>(chunk_start + baseindex, m, state, callback))
+                continue;
+            while (m) {
+                size_t ndx = chunk_start + first_set_bit64(m);
+                if (!find_action<action, Callback>(ndx + baseindex, get<bitwidth>(ndx), state, callback))
+                    return false;
+                m &= m - 1;
+            }
+        }
+    }
+
+    return compare<cond, action, bitwidth, Callback>(value, start, end, baseindex, state, callback);
+}
+#endif
+
 template <size_t width>
 inline int64_t Array::lower_bits() const
 {
@@ -2125,6 +2236,9 @@ template <class cond, Action action, size_t bitwidth, class Callback>
 bool Array::find(int64_t value, size_t start, size_t end, size_t baseindex, QueryState<int64_t>* state,
                  Callback callback, bool nullable_array, bool find_null) const
 {
+    // The search works on the stored elements of an encoded array
+    if (!find_null)
+        value = encode_value(value);
     return find_optimized<cond, action, bitwidth, Callback>(value, start, end, baseindex, state, callback,
                                                             nullable_array, find_null);
 }
@@ -2241,6 +2355,18 @@ bool Array::compare_leafs(const Array* foreign, size_t start, size_t end, size_t
     if (start == end)
         return true;
 
+    if (REALM_UNLIKELY(m_base != 0 || foreign->m_base != 0)) {
+        // The comparisons below work on the stored elements, so compare the decoded values one by one instead
+        for (; start < end; ++start) {
+            int64_t v = get(start);
+            if (c(v, foreign->get(start))) {
+                // find_action() takes a stored element
+                if (!find_action<action, Callback>(start + baseindex, v - m_base, state, callback))
+                    return false;
+            }
+        }
+        return true;
+    }
 
     int64_t v;
 
@@ -0,0 +1,457 @@
+/*************************************************************************
+ *
+ * Copyright 2021 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/array_avx.hpp>
+#include <realm/query_conditions.hpp>
+#include <realm/utilities.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef REALM_COMPILER_AVX
+
+#include <immintrin.h>
+
+// The kernels below are selected at runtime, so they must be compiled for their instruction set even when the
+// library as a whole is not. MSVC allows any intrinsic without special flags.
+#ifdef _MSC_VER
+#define REALM_TARGET_AVX2
+#define REALM_TARGET_AVX512
+#else
+#define REALM_TARGET_AVX2 __attribute__((target("avx2")))
+#define REALM_TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512bw")))
+#endif
+
+using namespace realm;
+
+namespace {
+
+template <class T>
+inline int64_t get_element(const char* data, size_t ndx)
+{
+    T v;
+    memcpy(&v, data + ndx * sizeof(T), sizeof(T));
+    return v;
+}
+
+inline int64_t get_element(size_t width, const char* data, size_t ndx)
+{
+    switch (width) {
+        case 8:
+            return get_element<int8_t>(data, ndx);
+        case 16:
+            return get_element<int16_t>(data, ndx);
+        case 32:
+            return get_element<int32_t>(data, ndx);
+        default:
+            return get_element<int64_t>(data, ndx);
+    }
+}
+
+template <bool find_max>
+inline int64_t pick(int64_t a, int64_t b)
+{
+    return find_max ? std::max(a, b) : std::min(a, b);
+}
+
+template <bool find_max>
+int64_t minmax_scalar(size_t width, const char* data, size_t begin, size_t end, int64_t best)
+{
+    for (size_t i = begin; i < end; ++i)
+        best = pick<find_max>(best, get_element(width, data, i));
+    return best;
+}
+
+// AVX2
+
+REALM_TARGET_AVX2 inline __m256i load(const char* p)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+// Sign extend eight 32-bit lanes and add them pairwise into four 64-bit lanes
+REALM_TARGET_AVX2 inline __m256i widen(__m256i s32)
+{
+    return _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_castsi256_si128(s32)),
+                            _mm256_cvtepi32_epi64(_mm256_extracti128_si256(s32, 1)));
+}
+
+template <int condition>
+REALM_TARGET_AVX2 inline __m256i compare_avx2_8(__m256i a, __m256i v)
+{
+    return condition == cond_Greater ? _mm256_cmpgt_epi8(a, v)
+                                     : condition == cond_Less ? _mm256_cmpgt_epi8(v, a) : _mm256_cmpeq_epi8(a, v);
+}
+
+template <int condition>
+REALM_TARGET_AVX2 inline __m256i compare_avx2_16(__m256i a, __m256i v)
+{
+    return condition == cond_Greater ? _mm256_cmpgt_epi16(a, v)
+                                     : condition == cond_Less ? _mm256_cmpgt_epi16(v, a) : _mm256_cmpeq_epi16(a, v);
+}
+
+template <int condition>
+REALM_TARGET_AVX2 inline __m256i compare_avx2_32(__m256i a, __m256i v)
+{
+    return condition == cond_Greater ? _mm256_cmpgt_epi32(a, v)
+                                     : condition == cond_Less ? _mm256_cmpgt_epi32(v, a) : _mm256_cmpeq_epi32(a, v);
+}
+
+template <int condition>
+REALM_TARGET_AVX2 inline __m256i compare_avx2_64(__m256i a, __m256i v)
+{
+    return condition == cond_Greater ? _mm256_cmpgt_epi64(a, v)
+                                     : condition == cond_Less ? _mm256_cmpgt_epi64(v, a) : _mm256_cmpeq_epi64(a, v);
+}
+
+// NotEqual is computed as the complement of Equal
+template <int condition>
+inline uint64_t adjust_mask(uint64_t mask)
+{
+    return condition == cond_NotEqual ? ~mask : mask;
+}
+
+template <int condition>
+REALM_TARGET_AVX2 void find_matches_avx2(size_t width, const char* data, size_t size, int64_t value,
+                                         uint64_t* matches)
+{
+    switch (width) {
+        case 8: {
+            const __m256i v = _mm256_set1_epi8(static_cast<char>(value));
+            for (size_t i = 0; i < size; i += 64) {
+                const char* p = data + i;
+                uint64_t lo = uint32_t(_mm256_movemask_epi8(compare_avx2_8<condition>(load(p), v)));
+                uint64_t hi = uint32_t(_mm256_movemask_epi8(compare_avx2_8<condition>(load(p + 32), v)));
+                *matches++ = adjust_mask<condition>(lo | hi << 32);
+            }
+            break;
+        }
+        case 16: {
+            const __m256i v = _mm256_set1_epi16(static_cast<short>(value));
+            for (size_t i = 0; i < size; i += 64) {
+                const char* p = data + i * 2;
+                uint64_t mask = 0;
+                for (size_t j = 0; j < 2; ++j) {
+                    // Narrow two 16-bit compare results to bytes. packs works within 128-bit lanes, so the
+                    // quadwords must be put back in order before extracting the mask.
+                    __m256i a = compare_avx2_16<condition>(load(p + 64 * j), v);
+                    __m256i b = compare_avx2_16<condition>(load(p + 64 * j + 32), v);
+                    __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+                    mask |= uint64_t(uint32_t(_mm256_movemask_epi8(packed))) << (32 * j);
+                }
+                *matches++ = adjust_mask<condition>(mask);
+            }
+            break;
+        }
+        case 32: {
+            const __m256i v = _mm256_set1_epi32(static_cast<int>(value));
+            for (size_t i = 0; i < size; i += 64) {
+                const char* p = data + i * 4;
+                uint64_t mask = 0;
+                for (size_t j = 0; j < 8; ++j) {
+                    __m256i c = compare_avx2_32<condition>(load(p + 32 * j), v);
+                    mask |= uint64_t(_mm256_movemask_ps(_mm256_castsi256_ps(c))) << (8 * j);
+                }
+                *matches++ = adjust_mask<condition>(mask);
+            }
+            break;
+        }
+        case 64: {
+            const __m256i v = _mm256_set1_epi64x(value);
+            for (size_t i = 0; i < size; i += 64) {
+                const char* p = data + i * 8;
+                uint64_t mask = 0;
+                for (size_t j = 0; j < 16; ++j) {
+                    __m256i c = compare_avx2_64<condition>(load(p + 32 * j), v);
+                    mask |= uint64_t(_mm256_movemask_pd(_mm256_castsi256_pd(c))) << (4 * j);
+                }
+                *matches++ = adjust_mask<condition>(mask);
+            }
+            break;
+        }
+        default:
+            REALM_UNREACHABLE();
+    }
+}
+
+REALM_TARGET_AVX2 int64_t sum_avx2(size_t width, const char* data, size_t size)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    switch (width) {
+        case 8:
+            for (; i + 32 <= size; i += 32) {
+                __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16));
+                __m256i s32 = _mm256_add_epi32(_mm256_madd_epi16(_mm256_cvtepi8_epi16(lo), ones),
+                                               _mm256_madd_epi16(_mm256_cvtepi8_epi16(hi), ones));
+                acc = _mm256_add_epi64(acc, widen(s32));
+            }
+            break;
+        case 16:
+            for (; i + 16 <= size; i += 16)
+                acc = _mm256_add_epi64(acc, widen(_mm256_madd_epi16(load(data + i * 2), ones)));
+            break;
+        case 32:
+            for (; i + 8 <= size; i += 8)
+                acc = _mm256_add_epi64(acc, widen(load(data + i * 4)));
+            break;
+        case 64:
+            for (; i + 4 <= size; i += 4)
+                acc = _mm256_add_epi64(acc, load(data + i * 8));
+            break;
+        default:
+            REALM_UNREACHABLE();
+    }
+
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    int64_t s = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < size; ++i)
+        s += get_element(width, data, i);
+    return s;
+}
+
+template <bool find_max>
+REALM_TARGET_AVX2 int64_t minmax_avx2(size_t width, const char* data, size_t size)
+{
+    const size_t per_vector = 256 / width;
+    if (size < per_vector)
+        return minmax_scalar<find_max>(width, data, 1, size, get_element(width, data, 0));
+
+    __m256i best = load(data);
+    size_t i = per_vector;
+    for (; i + per_vector <= size; i += per_vector) {
+        __m256i v = load(data + i * width / 8);
+        switch (width) {
+            case 8:
+                best = find_max ? _mm256_max_epi8(best, v) : _mm256_min_epi8(best, v);
+                break;
+            case 16:
+                best = find_max ? _mm256_max_epi16(best, v) : _mm256_min_epi16(best, v);
+                break;
+            case 32:
+                best = find_max ? _mm256_max_epi32(best, v) : _mm256_min_epi32(best, v);
+                break;
+            case 64: {
+                // No 64-bit min/max before AVX-512
+                __m256i gt = find_max ? _mm256_cmpgt_epi64(v, best) : _mm256_cmpgt_epi64(best, v);
+                best = _mm256_blendv_epi8(best, v, gt);
+                break;
+            }
+            default:
+                REALM_UNREACHABLE();
+        }
+    }
+
+    alignas(32) char lanes[32];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), best);
+    int64_t res = minmax_scalar<find_max>(width, lanes, 1, per_vector, get_element(width, lanes, 0));
+    return minmax_scalar<find_max>(width, data, i, size, res);
+}
+
+// AVX-512
+
+REALM_TARGET_AVX512 inline __m512i widen(__m512i s32)
+{
+    return _mm512_add_epi64(_mm512_cvtepi32_epi64(_mm512_castsi512_si256(s32)),
+                            _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(s32, 1)));
+}
+
+template <int condition>
+constexpr int avx512_predicate()
+{
+    return condition == cond_Equal ? _MM_CMPINT_EQ
+                                   : condition == cond_NotEqual ? _MM_CMPINT_NE
+                                                                : condition == cond_Greater ? _MM_CMPINT_NLE
+                                                                                            : _MM_CMPINT_LT;
+}
+
+template <int condition>
+REALM_TARGET_AVX512 void find_matches_avx512(size_t width, const char* data, size_t size, int64_t value,
+                                             uint64_t* matches)
+{
+    constexpr int pred = avx512_predicate<condition>();
+    switch (width) {
+        case 8: {
+            const __m512i v = _mm512_set1_epi8(static_cast<char>(value));
+            for (size_t i = 0; i < size; i += 64)
+                *matches++ = _mm512_cmp_epi8_mask(_mm512_loadu_si512(data + i), v, pred);
+            break;
+        }
+        case 16: {
+            const __m512i v = _mm512_set1_epi16(static_cast<short>(value));
+            for (size_t i = 0; i < size; i += 64) {
+                const char* p = data + i * 2;
+                uint64_t lo = _mm512_cmp_epi16_mask(_mm512_loadu_si512(p), v, pred);
+                uint64_t hi = _mm512_cmp_epi16_mask(_mm512_loadu_si512(p + 64), v, pred);
+                *matches++ = lo | hi << 32;
+            }
+            break;
+        }
+        case 32: {
+            const __m512i v = _mm512_set1_epi32(static_cast<int>(value));
+            for (size_t i = 0; i < size; i += 64) {
+                const char* p = data + i * 4;
+                uint64_t mask = 0;
+                for (size_t j = 0; j < 4; ++j)
+                    mask |= uint64_t(_mm512_cmp_epi32_mask(_mm512_loadu_si512(p + 64 * j), v, pred)) << (16 * j);
+                *matches++ = mask;
+            }
+            break;
+        }
+        case 64: {
+            const __m512i v = _mm512_set1_epi64(value);
+            for (size_t i = 0; i < size; i += 64) {
+                const char* p = data + i * 8;
+                uint64_t mask = 0;
+                for (size_t j = 0; j < 8; ++j)
+                    mask |= uint64_t(_mm512_cmp_epi64_mask(_mm512_loadu_si512(p + 64 * j), v, pred)) << (8 * j);
+                *matches++ = mask;
+            }
+            break;
+        }
+        default:
+            REALM_UNREACHABLE();
+    }
+}
+
+REALM_TARGET_AVX512 int64_t sum_avx512(size_t width, const char* data, size_t size)
+{
+    const __m512i ones = _mm512_set1_epi16(1);
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    switch (width) {
+        case 8:
+            for (; i + 64 <= size; i += 64) {
+                __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32));
+                __m512i s32 = _mm512_add_epi32(_mm512_madd_epi16(_mm512_cvtepi8_epi16(lo), ones),
+                                               _mm512_madd_epi16(_mm512_cvtepi8_epi16(hi), ones));
+                acc = _mm512_add_epi64(acc, widen(s32));
+            }
+            break;
+        case 16:
+            for (; i + 32 <= size; i += 32)
+                acc = _mm512_add_epi64(acc, widen(_mm512_madd_epi16(_mm512_loadu_si512(data + i * 2), ones)));
+            break;
+        case 32:
+            for (; i + 16 <= size; i += 16)
+                acc = _mm512_add_epi64(acc, widen(_mm512_loadu_si512(data + i * 4)));
+            break;
+        case 64:
+            for (; i + 8 <= size; i += 8)
+                acc = _mm512_add_epi64(acc, _mm512_loadu_si512(data + i * 8));
+            break;
+        default:
+            REALM_UNREACHABLE();
+    }
+
+    int64_t s = _mm512_reduce_add_epi64(acc);
+    for (; i < size; ++i)
+        s += get_element(width, data, i);
+    return s;
+}
+
+template <bool find_max>
+REALM_TARGET_AVX512 int64_t minmax_avx512(size_t width, const char* data, size_t size)
+{
+    const size_t per_vector = 512 / width;
+    if (size < per_vector)
+        return minmax_scalar<find_max>(width, data, 1, size, get_element(width, data, 0));
+
+    __m512i best = _mm512_loadu_si512(data);
+    size_t i = per_vector;
+    for (; i + per_vector <= size; i += per_vector) {
+        __m512i v = _mm512_loadu_si512(data + i * width / 8);
+        switch (width) {
+            case 8:
+                best = find_max ? _mm512_max_epi8(best, v) : _mm512_min_epi8(best, v);
+                break;
+            case 16:
+                best = find_max ? _mm512_max_epi16(best, v) : _mm512_min_epi16(best, v);
+                break;
+            case 32:
+                best = find_max ? _mm512_max_epi32(best, v) : _mm512_min_epi32(best, v);
+                break;
+            case 64:
+                best = find_max ? _mm512_max_epi64(best, v) : _mm512_min_epi64(best, v);
+                break;
+            default:
+                REALM_UNREACHABLE();
+        }
+    }
+
+    alignas(64) char lanes[64];
+    _mm512_store_si512(lanes, best);
+    int64_t res = minmax_scalar<find_max>(width, lanes, 1, per_vector, get_element(width, lanes, 0));
+    return minmax_scalar<find_max>(width, data, i, size, res);
+}
+
+template <int condition>
+void find_matches_for(size_t width, const char* data, size_t size, int64_t value, uint64_t* matches)
+{
+    if (sseavx<512>())
+        find_matches_avx512<condition>(width, data, size, value, matches);
+    else
+        find_matches_avx2<condition>(width, data, size, value, matches);
+}
+
+} // anonymous namespace
+
+namespace realm {
+namespace avx {
+
+void find_matches(int condition, size_t width, const char* data, size_t size, int64_t value, uint64_t* matches)
+{
+    REALM_ASSERT_DEBUG(size % 64 == 0);
+    switch (condition) {
+        case cond_Equal:
+            return find_matches_for<cond_Equal>(width, data, size, value, matches);
+        case cond_NotEqual:
+            return find_matches_for<cond_NotEqual>(width, data, size, value, matches);
+        case cond_Greater:
+            return find_matches_for<cond_Greater>(width, data, size, value, matches);
+        case cond_Less:
+            return find_matches_for<cond_Less>(width, data, size, value, matches);
+    }
+    REALM_UNREACHABLE();
+}
+
+int64_t sum(size_t width, const char* data, size_t size)
+{
+    return sseavx<512>() ? sum_avx512(width, data, size) : sum_avx2(width, data, size);
+}
+
+int64_t maximum(size_t width, const char* data, size_t size)
+{
+    REALM_ASSERT_DEBUG(size > 0);
+    return sseavx<512>() ? minmax_avx512<true>(width, data, size) : minmax_avx2<true>(width, data, size);
+}
+
+int64_t minimum(size_t width, const char* data, size_t size)
+{
+    REALM_ASSERT_DEBUG(size > 0);
+    return sseavx<512>() ? minmax_avx512<false>(width, data, size) : minmax_avx2<false>(width, data, size);
+}
+
+} // namespace avx
+} // namespace realm
+
+#endif // REALM_COMPILER_AVX
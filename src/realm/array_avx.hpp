@@ -0,0 +1,51 @@
+/*************************************************************************
+ *
+ * Copyright 2021 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_ARRAY_AVX_HPP
+#define REALM_ARRAY_AVX_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace realm {
+namespace avx {
+
+// Kernels operating on the payload of an integer Array leaf with a width of 8, 16, 32 or 64 bits. The kernels
+// are compiled for AVX2 and AVX-512 (F+BW) regardless of the compiler flags used for the rest of the library, and
+// pick the widest instruction set reported by cpuid_init(). Callers must check sseavx<2>() first. Data does not
+// need to be aligned.
+
+// Number of elements find_matches() should be given per call. Keeps the match bitmap on the stack small.
+constexpr size_t find_block_size = 256;
+
+// Compare 'size' elements starting at 'data' against 'value' using 'condition' (cond_Equal, cond_NotEqual,
+// cond_Greater or cond_Less) and set bit (i % 64) of matches[i / 64] if element i matches. 'size' must be a
+// multiple of 64, and 'value' must be representable in 'width' bits.
+void find_matches(int condition, size_t width, const char* data, size_t size, int64_t value, uint64_t* matches);
+
+// Sum of 'size' elements starting at 'data'
+int64_t sum(size_t width, const char* data, size_t size);
+
+// Largest / smallest of 'size' elements starting at 'data'. 'size' must be non-zero.
+int64_t maximum(size_t width, const char* data, size_t size);
+int64_t minimum(size_t width, const char* data, size_t size);
+
+} // namespace avx
+} // namespace realm
+
+#endif // REALM_ARRAY_AVX_HPP
@@ -22,6 +22,7 @@
 #include <realm/array_blob.hpp>
 #include <realm/array_integer.hpp>
 #include <realm/impl/destroy_guard.hpp>
+#include <realm/query_conditions.hpp>
 
 using namespace realm;
 
@@ -204,6 +205,56 @@ size_t ArraySmallBlobs::find_first(BinaryData value, bool is_string, size_t begi
     return not_found;
 }
 
+template <class Cond>
+void ArraySmallBlobs::find_string_matches(StringData value, size_t begin, size_t end,
+                                          uint64_t* matches) const noexcept
+{
+    static_assert(std::is_same<Cond, Equal>::value || std::is_same<Cond, BeginsWith>::value ||
+                      std::is_same<Cond, EndsWith>::value,
+                  "Unsupported condition");
+    REALM_ASSERT_DEBUG(!value.is_null() && value.size() > 0);
+    REALM_ASSERT_DEBUG(begin <= end && end <= size());
+    std::fill(matches, matches + (end - begin + 63) / 64, 0);
+
+    // The strings are stored back to back with a zero terminator, so the size of a string follows from the
+    // offsets alone. The offsets are decoded 8 at a time, and only the strings of a suitable size are compared.
+    const size_t value_size = value.size();
+    const char first_byte = value[0];
+    size_t start_ofs = begin ? to_size_t(m_offsets.get(begin - 1)) : 0;
+    int64_t offsets[8];
+    for (size_t chunk_begin = begin; chunk_begin < end; chunk_begin += 8) {
+        m_offsets.get_chunk(chunk_begin, offsets);
+        size_t chunk_size = std::min(end - chunk_begin, size_t(8));
+        for (size_t j = 0; j < chunk_size; ++j) {
+            size_t end_ofs = to_size_t(offsets[j]);
+            size_t stored_size = end_ofs - start_ofs;
+            bool match = false;
+            if (stored_size > value_size) {
+                size_t string_size = stored_size - 1;
+                const char* data = m_blob.get(start_ofs);
+                if (std::is_same<Cond, Equal>::value) {
+                    match = string_size == value_size && data[0] == first_byte &&
+                            std::memcmp(data, value.data(), value_size) == 0;
+                }
+                else if (std::is_same<Cond, BeginsWith>::value) {
+                    match = data[0] == first_byte && std::memcmp(data, value.data(), value_size) == 0;
+                }
+                else {
+                    match = std::memcmp(data + string_size - value_size, value.data(), value_size) == 0;
+                }
+            }
+            size_t i = chunk_begin + j - begin;
+            if (match && !m_nulls.get(chunk_begin + j))
+                matches[i / 64] |= uint64_t(1) << (i % 64);
+            start_ofs = end_ofs;
+        }
+    }
+}
+
+template void ArraySmallBlobs::find_string_matches<Equal>(StringData, size_t, size_t, uint64_t*) const noexcept;
+template void ArraySmallBlobs::find_string_matches<BeginsWith>(StringData, size_t, size_t, uint64_t*) const noexcept;
+template void ArraySmallBlobs::find_string_matches<EndsWith>(StringData, size_t, size_t, uint64_t*) const noexcept;
+
 StringData ArraySmallBlobs::get_string_legacy(size_t ndx) const
 {
     REALM_ASSERT_3(ndx, <, m_offsets.size());
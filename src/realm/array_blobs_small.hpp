@@ -99,6 +99,12 @@ public:
 
     size_t find_first(BinaryData value, bool is_string, size_t begin, size_t end) const noexcept;
 
+    /// Compare the strings in [begin, end) with a non-null, non-empty
+    /// `value` in bulk, like ArrayStringShort::find_matches(). `Cond` is
+    /// Equal, BeginsWith or EndsWith.
+    template <class Cond>
+    void find_string_matches(StringData value, size_t begin, size_t end, uint64_t* matches) const noexcept;
+
     /// Get the specified element without the cost of constructing an
     /// array instance. If an array instance is already available, or
     /// you need to get multiple values, then this method will be
@@ -64,8 +64,8 @@ bool ArrayInteger::minmax(size_t from, size_t to, uint64_t maxdiff, int64_t* min
         return false;
     }
     else {
-        *max = max2;
-        *min = min2;
+        *max = max2 + m_base;
+        *min = min2 + m_base;
         return true;
     }
 }
@@ -158,8 +158,49 @@ void ArrayIntNull::replace_nulls_with(int64_t new_null)
 }
 
 
+bool ArrayIntNull::try_encode()
+{
+    int64_t null = null_value();
+    int64_t min = 0;
+    int64_t max = 0;
+    bool found = false;
+    for (size_t i = 1; i < Array::size(); ++i) {
+        int64_t v = Array::get(i);
+        if (v == null)
+            continue;
+        min = found ? std::min(min, v) : v;
+        max = found ? std::max(max, v) : v;
+        found = true;
+    }
+    // An array of nulls only is as small as it gets already
+    if (!found)
+        return false;
+
+    int64_t new_null;
+    if (max < std::numeric_limits<int64_t>::max()) {
+        new_null = max + 1;
+        max = new_null;
+    }
+    else if (min > std::numeric_limits<int64_t>::min()) {
+        new_null = min - 1;
+        min = new_null;
+    }
+    else {
+        return false;
+    }
+
+    size_t width;
+    if (!get_encoded_width(min, max, width))
+        return false;
+    if (new_null != null)
+        replace_nulls_with(new_null); // Throws
+    encode(min, width);               // Throws
+    return true;
+}
+
 void ArrayIntNull::avoid_null_collision(int64_t value)
 {
+    decode(); // Throws
     if (m_width == 64) {
         if (value == null_value()) {
             int_fast64_t new_null = choose_random_null(value);
@@ -190,6 +231,10 @@ void ArrayIntNull::avoid_null_collision(int64_t value)
 
             replace_nulls_with(new_null); // Expands array
         }
+        else if (value == null_value()) {
+            // A decoded array may use a null value below the upper bound, see try_encode(). No value is above it.
+            replace_nulls_with(m_ubound);
+        }
     }
 }
 
@@ -190,6 +190,10 @@ public:
     bool maximum(int64_t& result, size_t start = 0, size_t end = npos, size_t* return_ndx = nullptr) const;
     bool minimum(int64_t& result, size_t start = 0, size_t end = npos, size_t* return_ndx = nullptr) const;
 
+    /// As Array::try_encode(), but the null value is first moved next to the
+    /// other values, so that it does not widen the offsets.
+    bool try_encode();
+
     bool find(int cond, Action action, value_type value, size_t start, size_t end, size_t baseindex,
               QueryState<int64_t>* state) const;
 
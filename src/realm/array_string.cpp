@@ -19,6 +19,7 @@
 #include <realm/array_string.hpp>
 #include <realm/array_integer.hpp>
 #include <realm/spec.hpp>
+#include <realm/query_conditions.hpp>
 
 using namespace realm;
 
@@ -297,10 +298,9 @@ size_t ArrayString::find_first(StringData value, size_t begin, size_t end) const
             break;
         }
         case Type::enum_strings: {
-            size_t sz = m_string_enum_values->size();
-            size_t res = m_string_enum_values->find_first(value, 0, sz);
+            size_t res = find_enum_index(value);
             if (res != realm::not_found) {
-                return static_cast<ArrayInteger*>(m_arr)->find_first(res, begin, end);
+                return find_first_enum_index(res, begin, end);
             }
             break;
         }
@@ -308,6 +308,43 @@ size_t ArrayString::find_first(StringData value, size_t begin, size_t end) const
     return not_found;
 }
 
+template <class Cond>
+bool ArrayString::find_leaf_matches(StringData value, size_t begin, size_t end, uint64_t* matches) const noexcept
+{
+    switch (m_type) {
+        case Type::small_strings:
+            static_cast<ArrayStringShort*>(m_arr)->find_matches<Cond>(value, begin, end, matches);
+            return true;
+        case Type::medium_strings:
+            static_cast<ArraySmallBlobs*>(m_arr)->find_string_matches<Cond>(value, begin, end, matches);
+            return true;
+        case Type::big_strings:
+        case Type::enum_strings:
+            break;
+    }
+    return false;
+}
+
+template <>
+bool ArrayString::find_matches<Equal>(StringData value, size_t begin, size_t end, uint64_t* matches) const noexcept
+{
+    return find_leaf_matches<Equal>(value, begin, end, matches);
+}
+
+template <>
+bool ArrayString::find_matches<BeginsWith>(StringData value, size_t begin, size_t end, uint64_t* matches) const
+    noexcept
+{
+    return find_leaf_matches<BeginsWith>(value, begin, end, matches);
+}
+
+template <>
+bool ArrayString::find_matches<EndsWith>(StringData value, size_t begin, size_t end, uint64_t* matches) const
+    noexcept
+{
+    return find_leaf_matches<EndsWith>(value, begin, end, matches);
+}
+
 namespace {
 
 template <class T>
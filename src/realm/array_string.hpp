@@ -102,8 +102,35 @@ public:
 
     size_t find_first(StringData value, size_t begin, size_t end) const noexcept;
 
+    /// Compare the elements in [begin, end) with a non-null, non-empty
+    /// `value` in bulk, setting bit `i - begin` of `matches` if element `i`
+    /// satisfies `Cond`. Returns false, leaving `matches` unspecified, if
+    /// the condition or the leaf does not support bulk comparison. Equal,
+    /// BeginsWith and EndsWith are supported on small and medium strings.
+    template <class Cond>
+    bool find_matches(StringData, size_t, size_t, uint64_t*) const noexcept
+    {
+        return false;
+    }
+
     size_t lower_bound(StringData value);
 
+    /// An enumerated leaf stores, for each element, the index of its value in
+    /// the table of unique values of the column (see
+    /// Table::enumerate_string_column()). Conditions on such leaves can be
+    /// evaluated on the indexes. The following functions may only be called
+    /// if is_enumerated() returns true.
+    bool is_enumerated() const noexcept
+    {
+        return m_type == Type::enum_strings;
+    }
+    size_t get_num_enum_values() const noexcept;
+    StringData get_enum_value(size_t enum_ndx) const;
+    /// The index of `value` in the table of unique values, or not_found
+    size_t find_enum_index(StringData value) const noexcept;
+    size_t get_enum_index(size_t ndx) const noexcept;
+    size_t find_first_enum_index(size_t enum_ndx, size_t begin, size_t end) const noexcept;
+
     /// Get the specified element without the cost of constructing an
     /// array instance. If an array instance is already available, or
     /// you need to get multiple values, then this method will be
@@ -134,8 +161,47 @@ private:
     std::unique_ptr<ArrayString> m_string_enum_values;
 
     Type upgrade_leaf(size_t value_size);
+    template <class Cond>
+    bool find_leaf_matches(StringData value, size_t begin, size_t end, uint64_t* matches) const noexcept;
 };
 
+template <>
+bool ArrayString::find_matches<Equal>(StringData, size_t, size_t, uint64_t*) const noexcept;
+template <>
+bool ArrayString::find_matches<BeginsWith>(StringData, size_t, size_t, uint64_t*) const noexcept;
+template <>
+bool ArrayString::find_matches<EndsWith>(StringData, size_t, size_t, uint64_t*) const noexcept;
+
+inline size_t ArrayString::get_num_enum_values() const noexcept
+{
+    REALM_ASSERT_DEBUG(is_enumerated());
+    return m_string_enum_values->size();
+}
+
+inline StringData ArrayString::get_enum_value(size_t enum_ndx) const
+{
+    REALM_ASSERT_DEBUG(is_enumerated());
+    return m_string_enum_values->get(enum_ndx);
+}
+
+inline size_t ArrayString::find_enum_index(StringData value) const noexcept
+{
+    REALM_ASSERT_DEBUG(is_enumerated());
+    return m_string_enum_values->find_first(value, 0, m_string_enum_values->size());
+}
+
+inline size_t ArrayString::get_enum_index(size_t ndx) const noexcept
+{
+    REALM_ASSERT_DEBUG(is_enumerated());
+    return size_t(static_cast<ArrayInteger*>(m_arr)->get(ndx));
+}
+
+inline size_t ArrayString::find_first_enum_index(size_t enum_ndx, size_t begin, size_t end) const noexcept
+{
+    REALM_ASSERT_DEBUG(is_enumerated());
+    return static_cast<ArrayInteger*>(m_arr)->find_first(int64_t(enum_ndx), begin, end);
+}
+
 inline StringData ArrayString::get(const char* header, size_t ndx, Allocator& alloc) noexcept
 {
     bool long_strings = Array::get_hasrefs_from_header(header);
@@ -30,6 +30,7 @@
 #include <realm/array_string_short.hpp>
 #include <realm/impl/destroy_guard.hpp>
 #include <realm/column_integer.hpp>
+#include <realm/query_conditions.hpp>
 
 using namespace realm;
 
@@ -53,6 +54,37 @@ size_t round_up(size_t size)
     return size;
 }
 
+// Compare every element of width sizeof(Word) * num_words with a pattern, a word at a time. Only the bytes selected
+// by the mask take part. If max_padding is given, the element must also have at most that many padding bytes, which
+// rules out elements shorter than the pattern and nulls.
+template <class Word, size_t num_words>
+void match_elements(const char* data, size_t begin, size_t end, const char* pattern_bytes, const char* mask_bytes,
+                    size_t max_padding, uint64_t* matches) noexcept
+{
+    constexpr size_t width = sizeof(Word) * num_words;
+    Word pattern[num_words];
+    Word mask[num_words];
+    std::memcpy(pattern, pattern_bytes, width);
+    std::memcpy(mask, mask_bytes, width);
+
+    for (size_t i = begin; i < end; ++i) {
+        const char* element = data + i * width;
+        Word diff = 0;
+        for (size_t w = 0; w < num_words; ++w) {
+            Word v;
+            std::memcpy(&v, element + w * sizeof(Word), sizeof(Word));
+            diff |= (v ^ pattern[w]) & mask[w];
+        }
+        bool match = (diff == 0) && size_t(static_cast<unsigned char>(element[width - 1])) <= max_padding;
+        matches[(i - begin) / 64] |= uint64_t(match) << ((i - begin) % 64);
+    }
+}
+
+inline size_t first_match(uint64_t matches)
+{
+    return size_t(fast_popcount64(int64_t((matches & (~matches + 1)) - 1)));
+}
+
 } // anonymous namespace
 
 bool ArrayStringShort::is_null(size_t ndx) const
@@ -258,20 +290,92 @@ size_t ArrayStringShort::find_first(StringData value, size_t begin, size_t end)
         }
     }
     else {
-        for (size_t i = begin; i != end; ++i) {
-            const char* data = m_data + (i * m_width);
-            if (memcmp(data, value.data(), value_size) == 0) {
-                size_t data_size = (m_width - 1) - data[m_width - 1];
-                if (data_size == value_size) {
-                    return i;
-                }
-            }
+        // Compare the elements 64 at a time
+        for (size_t chunk_begin = begin; chunk_begin < end; chunk_begin += 64) {
+            size_t chunk_end = std::min(end, chunk_begin + 64);
+            uint64_t matches;
+            find_matches<Equal>(value, chunk_begin, chunk_end, &matches);
+            if (matches)
+                return chunk_begin + first_match(matches);
         }
     }
 
     return not_found;
 }
 
+template <class Cond>
+void ArrayStringShort::find_matches(StringData value, size_t begin, size_t end, uint64_t* matches) const noexcept
+{
+    static_assert(std::is_same<Cond, Equal>::value || std::is_same<Cond, BeginsWith>::value ||
+                      std::is_same<Cond, EndsWith>::value,
+                  "Unsupported condition");
+    REALM_ASSERT_DEBUG(!value.is_null() && value.size() > 0);
+    REALM_ASSERT_DEBUG(begin <= end && end <= m_size);
+    std::fill(matches, matches + (end - begin + 63) / 64, 0);
+
+    // A width of zero means that all elements are null or empty, and every element is shorter than the width
+    const size_t value_size = value.size();
+    if (m_width <= value_size)
+        return;
+
+    if (std::is_same<Cond, EndsWith>::value) {
+        // The position of the suffix depends on the size of each element
+        for (size_t i = begin; i < end; ++i) {
+            const char* element = m_data + i * m_width;
+            size_t padding = static_cast<unsigned char>(element[m_width - 1]);
+            // A null element has m_width bytes of padding
+            if (padding + value_size < m_width &&
+                std::memcmp(element + (m_width - 1 - padding - value_size), value.data(), value_size) == 0)
+                matches[(i - begin) / 64] |= uint64_t(1) << ((i - begin) % 64);
+        }
+        return;
+    }
+
+    // Elements are zero padded and end with the number of padding bytes, so the elements equal to 'value' are
+    // those matching 'value' in the first value_size bytes and having exactly m_width - 1 - value_size padding
+    // bytes. For BeginsWith the padding may be shorter.
+    char pattern[max_width] = {};
+    char mask[max_width] = {};
+    std::memcpy(pattern, value.data(), value_size);
+    std::fill(mask, mask + value_size, char(0xFF));
+    size_t max_padding = m_width - 1 - value_size;
+    if (std::is_same<Cond, Equal>::value) {
+        pattern[m_width - 1] = char(max_padding);
+        mask[m_width - 1] = char(0xFF);
+    }
+
+    switch (m_width) {
+        case 4:
+            match_elements<uint32_t, 1>(m_data, begin, end, pattern, mask, max_padding, matches);
+            break;
+        case 8:
+            match_elements<uint64_t, 1>(m_data, begin, end, pattern, mask, max_padding, matches);
+            break;
+        case 16:
+            match_elements<uint64_t, 2>(m_data, begin, end, pattern, mask, max_padding, matches);
+            break;
+        case 32:
+            match_elements<uint64_t, 4>(m_data, begin, end, pattern, mask, max_padding, matches);
+            break;
+        case 64:
+            match_elements<uint64_t, 8>(m_data, begin, end, pattern, mask, max_padding, matches);
+            break;
+        default:
+            // Widths of 1 and 2 only hold strings of at most one byte
+            for (size_t i = begin; i < end; ++i) {
+                const char* element = m_data + i * m_width;
+                size_t padding = static_cast<unsigned char>(element[m_width - 1]);
+                if (element[0] == value[0] && padding <= max_padding)
+                    matches[(i - begin) / 64] |= uint64_t(1) << ((i - begin) % 64);
+            }
+            break;
+    }
+}
+
+template void ArrayStringShort::find_matches<Equal>(StringData, size_t, size_t, uint64_t*) const noexcept;
+template void ArrayStringShort::find_matches<BeginsWith>(StringData, size_t, size_t, uint64_t*) const noexcept;
+template void ArrayStringShort::find_matches<EndsWith>(StringData, size_t, size_t, uint64_t*) const noexcept;
+
 void ArrayStringShort::find_all(IntegerColumn& result, StringData value, size_t add_offset, size_t begin, size_t end)
 {
     size_t begin_2 = begin;
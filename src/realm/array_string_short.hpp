@@ -65,6 +65,14 @@ public:
     void find_all(IntegerColumn& result, StringData value, size_t add_offset = 0, size_t begin = 0,
                   size_t end = npos);
 
+    /// Compare the elements in [begin, end) with a non-null, non-empty
+    /// `value` in bulk. Bit `i - begin` of `matches`, an array of
+    /// `(end - begin + 63) / 64` words, is set if element `i` satisfies the
+    /// condition, and cleared otherwise. `Cond` is Equal, BeginsWith or
+    /// EndsWith.
+    template <class Cond>
+    void find_matches(StringData value, size_t begin, size_t end, uint64_t* matches) const noexcept;
+
     /// Compare two string arrays for equality.
     bool compare_string(const ArrayStringShort&) const noexcept;
 
@@ -102,6 +102,14 @@ public:
 
     size_t find_first(Timestamp value, size_t begin, size_t end) const noexcept;
 
+    // See Array::try_encode()
+    bool try_encode()
+    {
+        bool encoded = m_seconds.try_encode();           // Throws
+        encoded = m_nanoseconds.try_encode() || encoded; // Throws
+        return encoded;
+    }
+
     void verify() const;
 
 private:
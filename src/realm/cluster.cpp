@@ -27,10 +27,14 @@
 #include "realm/array_key.hpp"
 #include "realm/array_backlink.hpp"
 #include "realm/index_string.hpp"
+#include "realm/index_ordered.hpp"
+#include "realm/index_substring.hpp"
 #include "realm/column_type_traits.hpp"
 #include "realm/replication.hpp"
+#include "realm/impl/destroy_guard.hpp"
 #include <iostream>
 #include <cmath>
+#include <unordered_set>
 
 using namespace realm;
 
@@ -63,6 +67,16 @@ namespace realm {
  * The inner nodes are organized in the way that the main array has a ref to the
  * (optional) key array in position 0 and the subtree depth in position 1. After
  * that follows refs to the subordinate nodes.
+ *
+ * If the context flag is set, the last position holds a ref to a zone map, which
+ * summarizes the values of the children (only used for nodes whose children are
+ * leaves). It is an integer array starting with the number of summarized columns
+ * followed by their keys. Then follows a row per child, consisting of the size
+ * of the child plus one, or zero if the row is not valid, and the minimum, the
+ * maximum and the number of nulls of each column. A row is invalidated when the
+ * child is copied on write, and summarized anew when the transaction commits.
+ * Zone maps belong to file format version 11, as every writer must invalidate
+ * them, and they are dropped when a file of an earlier version is upgraded.
  */
 class ClusterNodeInner : public ClusterNode {
 public:
@@ -86,10 +100,13 @@ public:
 
     bool traverse(ClusterTree::TraverseFunction func, int64_t) const;
     void update(ClusterTree::UpdateFunction func, int64_t);
+    void compress_integer_leaves(int64_t);
+    void update_zone_maps(const std::vector<ColKey>& cols, int64_t);
+    void drop_zone_maps();
 
     size_t node_size() const override
     {
-        return Array::size() - s_first_node_index;
+        return Array::size() - s_first_node_index - (has_zone_map() ? 1 : 0);
     }
     size_t get_tree_size() const override
     {
@@ -132,6 +149,8 @@ public:
 
     void dump_objects(int64_t key_offset, std::string lead) const override;
 
+    void update_child_ref(size_t ndx, ref_type new_ref) override;
+
 private:
     static constexpr size_t s_key_ref_index = 0;
     static constexpr size_t s_sub_tree_depth_index = 1;
@@ -181,11 +200,26 @@ private:
     void _insert_child_ref(size_t ndx, ref_type ref)
     {
         Array::insert(ndx + s_first_node_index, from_ref(ref));
+        insert_zone_map_row(ndx);
     }
     void _erase_child_ref(size_t ndx)
     {
         Array::erase(ndx + s_first_node_index);
+        erase_zone_map_row(ndx);
+    }
+
+    bool has_zone_map() const noexcept
+    {
+        return Array::get_context_flag();
+    }
+    size_t zone_map_ndx() const noexcept
+    {
+        return Array::size() - 1;
     }
+    void init_zone_map(Array& zone_map);
+    void insert_zone_map_row(size_t ndx);
+    void erase_zone_map_row(size_t ndx);
+    void drop_zone_map();
     void move(size_t ndx, ClusterNode* new_node, int64_t key_adj) override;
 
     template <class T, class F>
@@ -581,7 +615,13 @@ void ClusterNodeInner::add(ref_type ref, int64_t key_value)
             m_keys.add(key_value);
         }
     }
-    Array::add(from_ref(ref));
+    if (has_zone_map()) {
+        Array::insert(zone_map_ndx(), from_ref(ref));
+        insert_zone_map_row(node_size() - 1);
+    }
+    else {
+        Array::add(from_ref(ref));
+    }
 }
 
 // Find leaf that contains the object identified by key. If this does not exist return the
@@ -655,6 +695,9 @@ void ClusterNodeInner::dump_objects(int64_t key_offset, std::string lead) const
 void ClusterNodeInner::move(size_t ndx, ClusterNode* new_node, int64_t key_adj)
 {
     auto new_cluster_node_inner = static_cast<ClusterNodeInner*>(new_node);
+    // Moving children between inner nodes is rare, so the zone maps are just summarized anew
+    drop_zone_map();
+    new_cluster_node_inner->drop_zone_map();
     for (size_t i = ndx; i < node_size(); i++) {
         new_cluster_node_inner->Array::add(_get_child_ref(i));
     }
@@ -690,6 +733,7 @@ size_t ClusterNodeInner::update_sub_tree_size()
 bool ClusterNodeInner::traverse(ClusterTree::TraverseFunction func, int64_t key_offset) const
 {
     auto sz = node_size();
+    const char* zone_map = has_zone_map() ? m_alloc.translate(Array::get_as_ref(zone_map_ndx())) : nullptr;
 
     for (unsigned i = 0; i < sz; i++) {
         ref_type ref = _get_child_ref(i);
@@ -700,6 +744,7 @@ bool ClusterNodeInner::traverse(ClusterTree::TraverseFunction func, int64_t key_
         if (child_is_leaf) {
             Cluster leaf(offs, m_alloc, m_tree_top);
             leaf.init(mem);
+            leaf.set_zone_map(zone_map, i);
             if (func(&leaf)) {
                 return true;
             }
@@ -740,6 +785,276 @@ void ClusterNodeInner::update(ClusterTree::UpdateFunction func, int64_t key_offs
     }
 }
 
+void ClusterNodeInner::compress_integer_leaves(int64_t key_offset)
+{
+    auto sz = node_size();
+
+    for (unsigned i = 0; i < sz; i++) {
+        ref_type ref = _get_child_ref(i);
+        // Subtrees not modified by the transaction are read-only as a whole
+        if (m_alloc.is_read_only(ref))
+            continue;
+        char* header = m_alloc.translate(ref);
+        bool child_is_leaf = !Array::get_is_inner_bptree_node_from_header(header);
+        MemRef mem(header, ref, m_alloc);
+        int64_t offs = (m_keys.is_attached() ? m_keys.get(i) : i << m_shift_factor) + key_offset;
+        if (child_is_leaf) {
+            Cluster leaf(offs, m_alloc, m_tree_top);
+            leaf.init(mem);
+            leaf.set_parent(this, i + s_first_node_index);
+            leaf.compress_integer_leaves(); // Throws
+        }
+        else {
+            ClusterNodeInner node(m_alloc, m_tree_top);
+            node.init(mem);
+            node.set_parent(this, i + s_first_node_index);
+            node.compress_integer_leaves(offs); // Throws
+        }
+    }
+}
+
+namespace {
+
+void include_in_range(ValueRange& range, int64_t key)
+{
+    range.min = std::min(range.min, key);
+    range.max = std::max(range.max, key);
+}
+
+template <class T>
+void get_float_range(const Cluster& cluster, ColKey col, ValueRange& range)
+{
+    BasicArray<T> leaf(cluster.get_alloc());
+    cluster.init_leaf(col, &leaf);
+    bool nullable = col.get_attrs().test(col_attr_Nullable);
+    for (size_t i = 0, sz = leaf.size(); i < sz; i++) {
+        T v = leaf.get(i);
+        if (nullable && null::is_null_float(v)) {
+            range.null_count++;
+        }
+        else if (std::isnan(v)) {
+            // NaN does not order with other values, so nothing can be ruled out
+            include_in_range(range, std::numeric_limits<int64_t>::min());
+            include_in_range(range, std::numeric_limits<int64_t>::max());
+        }
+        else {
+            include_in_range(range, zone_map_key(v));
+        }
+    }
+}
+
+void summarize_leaf_column(const Cluster& cluster, ColKey col, ValueRange& range)
+{
+    range.min = std::numeric_limits<int64_t>::max();
+    range.max = std::numeric_limits<int64_t>::min();
+    range.null_count = 0;
+    range.size = cluster.node_size();
+
+    switch (col.get_type()) {
+        case col_type_Int:
+            if (col.get_attrs().test(col_attr_Nullable)) {
+                ArrayIntNull leaf(cluster.get_alloc());
+                cluster.init_leaf(col, &leaf);
+                for (size_t i = 0; i < range.size; i++) {
+                    auto v = leaf.get(i);
+                    if (v) {
+                        include_in_range(range, *v);
+                    }
+                    else {
+                        range.null_count++;
+                    }
+                }
+            }
+            else {
+                ArrayInteger leaf(cluster.get_alloc());
+                cluster.init_leaf(col, &leaf);
+                leaf.minimum(range.min);
+                leaf.maximum(range.max);
+            }
+            break;
+        case col_type_Float:
+            get_float_range<float>(cluster, col, range);
+            break;
+        case col_type_Double:
+            get_float_range<double>(cluster, col, range);
+            break;
+        case col_type_Timestamp: {
+            ArrayTimestamp leaf(cluster.get_alloc());
+            cluster.init_leaf(col, &leaf);
+            for (size_t i = 0; i < range.size; i++) {
+                Timestamp v = leaf.get(i);
+                if (v.is_null()) {
+                    range.null_count++;
+                }
+                else {
+                    include_in_range(range, zone_map_key(v));
+                }
+            }
+            break;
+        }
+        default:
+            REALM_UNREACHABLE();
+    }
+}
+
+} // anonymous namespace
+
+void ClusterNodeInner::update_child_ref(size_t ndx, ref_type new_ref)
+{
+    Array::update_child_ref(ndx, new_ref);
+
+    // A child is copied on write when it is first modified by a transaction,
+    // which is when its summary becomes invalid
+    if (has_zone_map() && ndx >= s_first_node_index && ndx < zone_map_ndx()) {
+        Array zone_map(m_alloc);
+        init_zone_map(zone_map);
+        size_t num_cols = size_t(zone_map.get(0));
+        size_t pos = 1 + num_cols + (ndx - s_first_node_index) * (1 + 3 * num_cols);
+        if (zone_map.get(pos) != 0)
+            zone_map.set(pos, 0); // Throws
+    }
+}
+
+void ClusterNodeInner::init_zone_map(Array& zone_map)
+{
+    zone_map.set_parent(this, zone_map_ndx());
+    zone_map.init_from_parent();
+}
+
+void ClusterNodeInner::insert_zone_map_row(size_t ndx)
+{
+    if (!has_zone_map())
+        return;
+    Array zone_map(m_alloc);
+    init_zone_map(zone_map);
+    size_t num_cols = size_t(zone_map.get(0));
+    size_t row_size = 1 + 3 * num_cols;
+    size_t pos = 1 + num_cols + ndx * row_size;
+    // The new row is not valid until the child is summarized
+    for (size_t i = 0; i < row_size; i++)
+        zone_map.insert(pos, 0); // Throws
+}
+
+void ClusterNodeInner::erase_zone_map_row(size_t ndx)
+{
+    if (!has_zone_map())
+        return;
+    Array zone_map(m_alloc);
+    init_zone_map(zone_map);
+    size_t num_cols = size_t(zone_map.get(0));
+    size_t row_size = 1 + 3 * num_cols;
+    size_t pos = 1 + num_cols + ndx * row_size;
+    zone_map.erase(pos, pos + row_size); // Throws
+}
+
+void ClusterNodeInner::drop_zone_map()
+{
+    if (!has_zone_map())
+        return;
+    size_t ndx = zone_map_ndx();
+    Array::destroy(Array::get_as_ref(ndx), m_alloc);
+    Array::erase(ndx); // Throws
+    Array::set_context_flag(false);
+}
+
+void ClusterNodeInner::drop_zone_maps()
+{
+    if (m_sub_tree_depth > 1) {
+        auto sz = node_size();
+        for (unsigned i = 0; i < sz; i++) {
+            ref_type ref = _get_child_ref(i);
+            ClusterNodeInner node(m_alloc, m_tree_top);
+            node.init(MemRef(m_alloc.translate(ref), ref, m_alloc));
+            node.set_parent(this, i + s_first_node_index);
+            node.drop_zone_maps(); // Throws
+        }
+        return;
+    }
+    drop_zone_map(); // Throws
+}
+
+void ClusterNodeInner::update_zone_maps(const std::vector<ColKey>& cols, int64_t key_offset)
+{
+    auto sz = node_size();
+
+    if (m_sub_tree_depth > 1) {
+        for (unsigned i = 0; i < sz; i++) {
+            ref_type ref = _get_child_ref(i);
+            // Subtrees not modified by the transaction are read-only as a whole
+            if (m_alloc.is_read_only(ref))
+                continue;
+            int64_t offs = (m_keys.is_attached() ? m_keys.get(i) : i << m_shift_factor) + key_offset;
+            ClusterNodeInner node(m_alloc, m_tree_top);
+            node.init(MemRef(m_alloc.translate(ref), ref, m_alloc));
+            node.set_parent(this, i + s_first_node_index);
+            node.update_zone_maps(cols, offs); // Throws
+        }
+        return;
+    }
+
+    if (cols.empty()) {
+        drop_zone_map(); // Throws
+        return;
+    }
+
+    // The rows still valid are kept if the same columns are summarized
+    size_t num_cols = cols.size();
+    size_t row_size = 1 + 3 * num_cols;
+    Array old_zone_map(m_alloc);
+    bool reuse = false;
+    if (has_zone_map()) {
+        init_zone_map(old_zone_map);
+        reuse = size_t(old_zone_map.get(0)) == num_cols;
+        for (size_t c = 0; reuse && c < num_cols; c++)
+            reuse = old_zone_map.get(1 + c) == cols[c].value;
+    }
+
+    std::vector<int64_t> values;
+    values.reserve(1 + num_cols + sz * row_size);
+    values.push_back(int64_t(num_cols));
+    for (auto col : cols)
+        values.push_back(col.value);
+    bool modified = !reuse;
+    for (unsigned i = 0; i < sz; i++) {
+        size_t old_pos = 1 + num_cols + i * row_size;
+        if (reuse && old_zone_map.get(old_pos) != 0) {
+            for (size_t j = 0; j < row_size; j++)
+                values.push_back(old_zone_map.get(old_pos + j));
+            continue;
+        }
+        ref_type ref = _get_child_ref(i);
+        int64_t offs = (m_keys.is_attached() ? m_keys.get(i) : i << m_shift_factor) + key_offset;
+        Cluster leaf(offs, m_alloc, m_tree_top);
+        leaf.init(MemRef(m_alloc.translate(ref), ref, m_alloc));
+        values.push_back(int64_t(leaf.node_size() + 1));
+        for (auto col : cols) {
+            ValueRange range;
+            summarize_leaf_column(leaf, col, range);
+            values.push_back(range.min);
+            values.push_back(range.max);
+            values.push_back(int64_t(range.null_count));
+        }
+        modified = true;
+    }
+    if (!modified)
+        return;
+
+    Array zone_map(m_alloc);
+    zone_map.create(Array::type_Normal); // Throws
+    _impl::ShallowArrayDestroyGuard dg(&zone_map);
+    for (auto v : values)
+        zone_map.add(v); // Throws
+    dg.release();
+    if (has_zone_map()) {
+        old_zone_map.destroy();
+        Array::set_as_ref(zone_map_ndx(), zone_map.get_ref());
+    }
+    else {
+        Array::add(from_ref(zone_map.get_ref())); // Throws
+        Array::set_context_flag(true);
+    }
+}
+
 int64_t ClusterNodeInner::get_last_key_value() const
 {
     auto last_ndx = node_size() - 1;
@@ -1504,6 +1819,74 @@ void Cluster::upgrade_string_to_enum(ColKey col_key, ArrayString& keys)
     Array::destroy_deep(ref, m_alloc);
 }
 
+template <class T>
+inline void Cluster::do_compress(ColKey col_key)
+{
+    auto col_ndx = col_key.get_index().val + s_first_col_index;
+    T leaf(m_alloc);
+    leaf.set_parent(this, col_ndx);
+    leaf.init_from_parent();
+    leaf.try_encode(); // Throws
+}
+
+void Cluster::compress_integer_leaves()
+{
+    auto compress_column = [&](ColKey col_key) {
+        auto attr = col_key.get_attrs();
+        // Leaves not modified by the transaction are left alone
+        if (attr.test(col_attr_List) ||
+            m_alloc.is_read_only(Array::get_as_ref(col_key.get_index().val + s_first_col_index)))
+            return false;
+
+        switch (col_key.get_type()) {
+            case col_type_Int:
+                if (attr.test(col_attr_Nullable)) {
+                    do_compress<ArrayIntNull>(col_key);
+                }
+                else {
+                    do_compress<ArrayInteger>(col_key);
+                }
+                break;
+            case col_type_Timestamp:
+                do_compress<ArrayTimestamp>(col_key);
+                break;
+            default:
+                break;
+        }
+        return false;
+    };
+    m_tree_top.get_owner()->for_each_and_every_column(compress_column);
+}
+
+bool Cluster::get_value_range(ColKey col, ValueRange& range) const noexcept
+{
+    if (!m_zone_map)
+        return false;
+    size_t num_cols = size_t(Array::get(m_zone_map, 0));
+    size_t c = 0;
+    while (c < num_cols && Array::get(m_zone_map, 1 + c) != col.value)
+        c++;
+    if (c == num_cols)
+        return false;
+    size_t pos = 1 + num_cols + m_zone_map_row * (1 + 3 * num_cols);
+    int64_t size = Array::get(m_zone_map, pos);
+    // An invalid row is zero. Versions of Realm which do not maintain the
+    // zone maps can not open the file, so a valid row matches the leaf.
+    if (size_t(size) != node_size() + 1)
+        return false;
+    pos += 1 + 3 * c;
+    range.min = Array::get(m_zone_map, pos);
+    range.max = Array::get(m_zone_map, pos + 1);
+    range.null_count = size_t(Array::get(m_zone_map, pos + 2));
+    range.size = size_t(size) - 1;
+    return true;
+}
+
+void Cluster::summarize_column(ColKey col, ValueRange& range) const
+{
+    summarize_leaf_column(*this, col, range);
+}
+
 void Cluster::init_leaf(ColKey col_key, ArrayPayload* leaf) const
 {
     auto col_ndx = col_key.get_index();
@@ -1830,6 +2213,12 @@ void ClusterTree::clear(CascadeState& state)
         if (StringIndex* index = m_owner->get_search_index(col_key)) {
             index->clear();
         }
+        if (OrderedIndex* index = m_owner->get_ordered_index(col_key)) {
+            index->clear();
+        }
+        if (SubstringIndex* index = m_owner->get_substring_index(col_key)) {
+            index->clear();
+        }
     }
 
     if (state.m_group) {
@@ -1919,10 +2308,43 @@ Obj ClusterTree::insert(ObjKey k, const FieldValues& values)
                         index->insert(k, init_value.get<Timestamp>());
                     }
                     break;
+                case col_type_Float:
+                    if (init_value.is_null()) {
+                        index->insert(k, nullable ? util::none : util::make_optional(0.0f));
+                    }
+                    else {
+                        index->insert(k, init_value.get<float>());
+                    }
+                    break;
+                case col_type_Double:
+                    if (init_value.is_null()) {
+                        index->insert(k, nullable ? util::none : util::make_optional(0.0));
+                    }
+                    else {
+                        index->insert(k, init_value.get<double>());
+                    }
+                    break;
                 default:
                     break;
             }
         }
+        if (OrderedIndex* index = table->get_ordered_index(col_key)) {
+            bool nullable = col_key.get_attrs().test(col_attr_Nullable);
+            if (!init_value.is_null()) {
+                index->insert(k, init_value);
+            }
+            else if (col_key.get_type() == col_type_Int) {
+                index->insert(k, ArrayIntNull::default_value(nullable));
+            }
+            else {
+                index->insert(k, ArrayTimestamp::default_value(nullable));
+            }
+        }
+        if (SubstringIndex* index = table->get_substring_index(col_key)) {
+            // The default values, null and the empty string, have no trigrams
+            if (!init_value.is_null())
+                index->insert(k, init_value.get<String>());
+        }
         return false;
     };
     get_owner()->for_each_public_column(insert_in_column);
@@ -1995,6 +2417,12 @@ void ClusterTree::erase(ObjKey k, CascadeState& state)
         if (StringIndex* index = m_owner->get_search_index(col_key)) {
             index->erase(k);
         }
+        if (OrderedIndex* index = m_owner->get_ordered_index(col_key)) {
+            index->erase(k);
+        }
+        if (SubstringIndex* index = m_owner->get_substring_index(col_key)) {
+            index->erase(k);
+        }
     }
 
     size_t root_size = m_root->erase(k, state);
@@ -2045,6 +2473,29 @@ bool ClusterTree::traverse(TraverseFunction func) const
     }
 }
 
+void ClusterTree::get_leaf_locations(std::vector<LeafLocation>& locations) const
+{
+    traverse([&locations](const Cluster* cluster) {
+        locations.push_back({cluster->get_ref(), cluster->get_offset(), cluster->node_size(),
+                             cluster->get_zone_map(), cluster->get_zone_map_row()});
+        return false;
+    });
+}
+
+bool ClusterTree::traverse(const LeafLocation* begin, const LeafLocation* end, TraverseFunction func) const
+{
+    Cluster leaf(0, m_alloc, *this);
+    for (auto it = begin; it != end; ++it) {
+        leaf.set_offset(it->offset);
+        leaf.init(MemRef(m_alloc.translate(it->ref), it->ref, m_alloc));
+        leaf.set_zone_map(it->zone_map, it->zone_map_row);
+        if (func(&leaf)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void ClusterTree::update(UpdateFunction func)
 {
     if (m_root->is_leaf()) {
@@ -2055,6 +2506,44 @@ void ClusterTree::update(UpdateFunction func)
     }
 }
 
+void ClusterTree::compress_integer_leaves()
+{
+    // The nodes modified by the transaction, and only those, are writable
+    if (get_alloc().is_read_only(m_root->get_ref()))
+        return;
+    if (m_root->is_leaf()) {
+        static_cast<Cluster*>(m_root.get())->compress_integer_leaves(); // Throws
+    }
+    else {
+        static_cast<ClusterNodeInner*>(m_root.get())->compress_integer_leaves(0); // Throws
+    }
+}
+
+void ClusterTree::update_zone_maps()
+{
+    // A single leaf has no parent node to hold a zone map
+    if (get_alloc().is_read_only(m_root->get_ref()) || m_root->is_leaf())
+        return;
+
+    std::vector<ColKey> cols;
+    m_owner->for_each_public_column([&cols](ColKey col_key) {
+        if (!col_key.get_attrs().test(col_attr_List)) {
+            auto type = col_key.get_type();
+            if (type == col_type_Int || type == col_type_Float || type == col_type_Double ||
+                type == col_type_Timestamp)
+                cols.push_back(col_key);
+        }
+        return false;
+    });
+    static_cast<ClusterNodeInner*>(m_root.get())->update_zone_maps(cols, 0); // Throws
+}
+
+void ClusterTree::drop_zone_maps()
+{
+    if (!m_root->is_leaf())
+        static_cast<ClusterNodeInner*>(m_root.get())->drop_zone_maps(); // Throws
+}
+
 void ClusterTree::enumerate_string_column(ColKey col_key)
 {
     Allocator& alloc = get_alloc();
@@ -2092,6 +2581,24 @@ void ClusterTree::enumerate_string_column(ColKey col_key)
     update(upgrade);
 }
 
+size_t ClusterTree::count_unique_strings(ColKey col_key, size_t limit) const
+{
+    // The strings stay valid during the traversal, as the tree is not modified
+    std::unordered_set<StringData> values;
+    ArrayString leaf(get_alloc());
+    traverse([col_key, limit, &leaf, &values](const Cluster* cluster) {
+        cluster->init_leaf(col_key, &leaf);
+        size_t sz = leaf.size();
+        for (size_t i = 0; i < sz; i++) {
+            values.insert(leaf.get(i)); // Throws
+            if (values.size() > limit)
+                return true; // Stop
+        }
+        return false; // Continue
+    });
+    return values.size();
+}
+
 std::unique_ptr<ClusterNode> ClusterTree::get_node(ref_type ref) const
 {
     std::unique_ptr<ClusterNode> node;
@@ -49,6 +49,57 @@ struct FieldValue {
 
 using FieldValues = std::vector<FieldValue>;
 
+/// The range of the values of a column in a leaf, as summarized by the zone
+/// map of its parent node. The values are represented by zone_map_key().
+struct ValueRange {
+    int64_t min;
+    int64_t max;
+    size_t null_count;
+    size_t size;
+};
+
+/// Statistics of the values of a column, taken from the zone maps of its
+/// table, or from a sample of its leaves if it has none. The value ranges of
+/// the summarized leaves form a histogram of the column, from which the number
+/// of objects matching a condition can be estimated.
+struct ColumnStatistics {
+    std::vector<ValueRange> ranges;
+    /// Number of objects in the summarized leaves
+    size_t num_summarized = 0;
+    /// Number of objects in the table
+    size_t num_objects = 0;
+};
+
+/// Zone maps represent values by integers that order as the values do, except
+/// that a Timestamp is represented by its seconds only. -0.0 is represented as
+/// 0.0, as they compare equal.
+inline int64_t zone_map_key(int64_t value)
+{
+    return value;
+}
+
+inline int64_t zone_map_key(double value)
+{
+    if (value == 0)
+        value = 0;
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    // Negative values order in reverse when taken as sign-magnitude integers
+    constexpr uint64_t sign_bit = uint64_t(1) << 63;
+    bits = (bits & sign_bit) ? ~bits : bits | sign_bit;
+    return int64_t(bits ^ sign_bit);
+}
+
+inline int64_t zone_map_key(float value)
+{
+    return zone_map_key(double(value));
+}
+
+inline int64_t zone_map_key(Timestamp value)
+{
+    return value.get_seconds();
+}
+
 class ClusterNode : public Array {
 public:
     // This structure is used to bring information back to the upper nodes when
@@ -250,10 +301,33 @@ public:
     size_t erase(ObjKey k, CascadeState& state) override;
     void nullify_incoming_links(ObjKey key, CascadeState& state) override;
     void upgrade_string_to_enum(ColKey col, ArrayString& keys);
+    // See ClusterTree::compress_integer_leaves()
+    void compress_integer_leaves();
 
     void init_leaf(ColKey col, ArrayPayload* leaf) const;
     void add_leaf(ColKey col, ref_type ref);
 
+    /// Get the range of the values in column \a col, if summarized by the
+    /// zone map of the parent node through which this leaf was reached. See
+    /// DBOptions::enable_zone_maps.
+    bool get_value_range(ColKey col, ValueRange& range) const noexcept;
+    /// Get the range of the values in column \a col, which must be an Int,
+    /// Float, Double or Timestamp column, by reading them.
+    void summarize_column(ColKey col, ValueRange& range) const;
+    void set_zone_map(const char* header, size_t row) noexcept
+    {
+        m_zone_map = header;
+        m_zone_map_row = row;
+    }
+    const char* get_zone_map() const noexcept
+    {
+        return m_zone_map;
+    }
+    size_t get_zone_map_row() const noexcept
+    {
+        return m_zone_map_row;
+    }
+
     void verify() const;
     void dump_objects(int64_t key_offset, std::string lead) const override;
 
@@ -261,6 +335,9 @@ private:
     static constexpr size_t s_key_ref_or_size_index = 0;
     static constexpr size_t s_first_col_index = 1;
 
+    const char* m_zone_map = nullptr;
+    size_t m_zone_map_row = 0;
+
     size_t get_size_in_compact_form() const
     {
         return size_t(Array::get(s_key_ref_or_size_index)) >> 1; // Size is stored as tagged value
@@ -278,6 +355,8 @@ private:
     void do_move(size_t ndx, ColKey col, Cluster* to);
     template <class T>
     void do_erase(size_t ndx, ColKey col);
+    template <class T>
+    void do_compress(ColKey col);
     void remove_backlinks(ObjKey origin_key, ColKey col, const std::vector<ObjKey>& keys, CascadeState& state) const;
     void do_erase_key(size_t ndx, ColKey col, CascadeState& state);
     void do_insert_key(size_t ndx, ColKey col, Mixed init_val, ObjKey origin_key);
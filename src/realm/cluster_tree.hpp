@@ -141,7 +141,32 @@ public:
     // Visit all leaves and call the supplied function. The function can modify the leaf.
     void update(UpdateFunction func);
 
+    // Position of a leaf in the tree. Can be used to create independent accessors
+    // for the leaf, e.g. from worker threads when the tree is frozen.
+    struct LeafLocation {
+        ref_type ref;
+        uint64_t offset;
+        size_t size;
+        // Zone map summarizing the leaf, see Cluster::get_value_range()
+        const char* zone_map;
+        size_t zone_map_row;
+    };
+    // Collect the locations of all leaves in key order
+    void get_leaf_locations(std::vector<LeafLocation>& locations) const;
+    // Visit the leaves at the given locations and call the supplied function. Stop when
+    // function returns true. Not allowed to modify the tree
+    bool traverse(const LeafLocation* begin, const LeafLocation* end, TraverseFunction func) const;
+
     void enumerate_string_column(ColKey col_key);
+    // Encode the integer and timestamp leaves modified by the current write
+    // transaction where that makes them smaller, see Array::try_encode()
+    void compress_integer_leaves();
+    // Summarize the values of the leaves modified by the current write
+    // transaction in the zone maps of their parent nodes
+    void update_zone_maps();
+    // Remove all zone maps, which an earlier version may have left stale
+    void drop_zone_maps();
+    size_t count_unique_strings(ColKey col_key, size_t limit) const;
     void dump_objects()
     {
         m_root->dump_objects(0, "");
@@ -19,9 +19,11 @@
 #include <algorithm>
 #include <atomic>
 #include <cerrno>
+#include <exception>
 #include <fcntl.h>
 #include <realm/db.hpp>
 #include <iostream>
+#include <iterator>
 #include <mutex>
 #include <sstream>
 #include <type_traits>
@@ -1015,6 +1017,7 @@ void DB::do_open(const std::string& path, bool no_create_file, bool is_backend,
             ref_type top_ref;
             try {
                 top_ref = alloc.attach_file(path, cfg); // Throws
+                m_incomplete_commit_discarded = alloc.incomplete_commit_discarded();
                 if (top_ref) {
                     alloc.note_reader_start(this);
                     auto handler = [this, &alloc]() noexcept {
@@ -1057,7 +1060,7 @@ void DB::do_open(const std::string& path, bool no_create_file, bool is_backend,
             bool file_format_ok = false;
             // In shared mode (Realm file opened via a SharedGroup instance) this
             // version of the core library is able to open Realms using file format
-            // versions from 2 to 9. Please see Group::get_file_format_version() for
+            // versions from 6 to 11. Please see Group::get_file_format_version() for
             // information about the individual file format versions.
             switch (current_file_format_version) {
                 case 0:
@@ -1068,6 +1071,7 @@ void DB::do_open(const std::string& path, bool no_create_file, bool is_backend,
                 case 8:
                 case 9:
                 case 10:
+                case 11:
                     file_format_ok = true;
                     break;
             }
@@ -1305,6 +1309,15 @@ void DB::do_open(const std::string& path, bool no_create_file, bool is_backend,
         close();
         throw;
     }
+
+    m_group_commit = options.enable_group_commit && options.durability == Durability::Full;
+    m_group_commit_max_delay = options.group_commit_max_delay;
+    m_commit_checksum = options.enable_commit_checksum && options.durability == Durability::Full;
+    m_auto_enumeration = options.enable_auto_enumeration;
+    m_integer_compression = options.enable_integer_compression;
+    m_zone_maps = options.enable_zone_maps;
+    m_online_compaction = options.enable_online_compaction;
+    m_online_compaction_work_limit = options.online_compaction_work_limit;
 }
 
 
@@ -1493,6 +1506,13 @@ void DB::release_all_read_locks() noexcept
         atomic_double_dec(r.count);
     }
     m_local_locks_held.clear();
+    for (auto& shared : m_shared_read_locks) {
+        if (uint32_t refs = shared.m_refs.exchange(0, std::memory_order_relaxed)) {
+            m_transaction_count -= int(refs);
+            const Ringbuffer::ReadCount& r = r_info->readers.get(shared.m_info.m_reader_idx);
+            atomic_double_dec(r.count);
+        }
+    }
 }
 
 // Note: close() and close_internal() may be called from the DB::~DB().
@@ -1512,6 +1532,12 @@ void DB::close_internal(std::unique_lock<InterprocessMutex> lock, bool allow_ope
         std::lock_guard<std::recursive_mutex> local_lock(m_mutex);
         if (m_write_transaction_open)
             throw LogicError(LogicError::wrong_transact_state);
+    }
+    // Outstanding async commits must be flushed first, as they hold on to the
+    // snapshot currently selected by the file header
+    stop_sync_thread(); // Throws
+    {
+        std::lock_guard<std::recursive_mutex> local_lock(m_mutex);
         if (!allow_open_read_transactions && m_transaction_count)
             throw LogicError(LogicError::wrong_transact_state);
     }
@@ -1530,6 +1556,7 @@ void DB::close_internal(std::unique_lock<InterprocessMutex> lock, bool allow_ope
             info->sync_agent_present = 0; // Set to false
         }
         release_all_read_locks();
+        m_durable_read_lock = util::none;
         --info->num_participants;
         bool end_of_session = info->num_participants == 0;
         // std::cerr << "closing" << std::endl;
@@ -1789,7 +1816,17 @@ void DB::upgrade_file_format(bool allow_file_format_upgrade, int target_file_for
         // concurrent SharedGroup object.
         REALM_ASSERT(current_hist_schema_version_2 == current_hist_schema_version ||
                      current_hist_schema_version_2 == target_hist_schema_version);
-        bool need_hist_schema_upgrade = (current_hist_schema_version_2 < target_hist_schema_version);
+        // A history which has not been created yet will be created with the
+        // target schema version. The top array of an old file may lack the
+        // slot for the history schema version, so only the history type is
+        // looked at here.
+        _impl::History::version_type version;
+        int stored_hist_type;
+        int stored_hist_schema_version;
+        _impl::GroupFriend::get_version_and_history_info(m_alloc, _impl::GroupFriend::get_top_ref(*wt), version,
+                                                         stored_hist_type, stored_hist_schema_version);
+        bool need_hist_schema_upgrade = (current_hist_schema_version_2 < target_hist_schema_version &&
+                                         stored_hist_type != Replication::hist_None);
         if (need_hist_schema_upgrade) {
             if (!allow_file_format_upgrade)
                 throw FileFormatUpgradeRequired("Database upgrade required but prohibited", this->m_db_path);
@@ -1830,6 +1867,13 @@ void DB::upgrade_file_format(bool allow_file_format_upgrade, int target_file_for
 
 void DB::release_read_lock(ReadLockInfo& read_lock) noexcept
 {
+    if (read_lock.m_shared) {
+        // The slot is released before the transaction count, so that no slot
+        // is in use while m_transaction_count is zero (see grab_read_lock())
+        if (release_shared_read_lock(m_shared_read_locks[read_lock.m_reader_idx % s_num_shared_read_locks]))
+            --m_transaction_count;
+        return;
+    }
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
     bool found_match = false;
     // simple linear search and move-last-over if a match is found.
@@ -1854,8 +1898,91 @@ void DB::release_read_lock(ReadLockInfo& read_lock) noexcept
 }
 
 
+bool DB::release_shared_read_lock(SharedReadLock& shared) noexcept
+{
+    uint32_t refs = shared.m_refs.load(std::memory_order_relaxed);
+    while (refs > 1) {
+        if (shared.m_refs.compare_exchange_weak(refs, refs - 1, std::memory_order_release,
+                                                std::memory_order_relaxed))
+            return true;
+    }
+    // Dropping the last reference must not race with the slot being reused
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    if (shared.m_refs.load(std::memory_order_relaxed) == 0) {
+        REALM_ASSERT(!is_attached());
+        // it's OK, someone called close() and all locks where released
+        return false;
+    }
+    if (shared.m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        SharedInfo* r_info = m_reader_map.get_addr();
+        const Ringbuffer::ReadCount& r = r_info->readers.get(shared.m_info.m_reader_idx);
+        atomic_double_dec(r.count);
+    }
+    return true;
+}
+
+
+bool DB::try_grab_shared_read_lock(ReadLockInfo& read_lock, uint_fast32_t reader_idx, version_type version) noexcept
+{
+    SharedReadLock& shared = m_shared_read_locks[reader_idx % s_num_shared_read_locks];
+    uint32_t refs = shared.m_refs.load(std::memory_order_relaxed);
+    do {
+        if (refs == 0)
+            return false;
+    } while (!shared.m_refs.compare_exchange_weak(refs, refs + 1, std::memory_order_acquire,
+                                                  std::memory_order_relaxed));
+    // The slot cannot be reused while we hold a reference, but it may have
+    // been reused for another entry before we got it
+    if (shared.m_info.m_reader_idx != reader_idx ||
+        (version != std::numeric_limits<version_type>::max() && shared.m_info.m_version != version)) {
+        release_shared_read_lock(shared);
+        return false;
+    }
+    read_lock = shared.m_info;
+    return true;
+}
+
+
+void DB::share_read_lock(ReadLockInfo& read_lock) noexcept
+{
+    SharedReadLock& shared = m_shared_read_locks[read_lock.m_reader_idx % s_num_shared_read_locks];
+    if (shared.m_refs.load(std::memory_order_relaxed) == 0) {
+        read_lock.m_shared = true;
+        shared.m_info = read_lock;
+        shared.m_refs.store(1, std::memory_order_release);
+        return;
+    }
+    if (shared.m_info.m_reader_idx == read_lock.m_reader_idx && shared.m_info.m_version == read_lock.m_version) {
+        // Another transaction shared this entry after we failed to, so our own
+        // count on the entry is not needed. m_refs cannot drop to zero without m_mutex.
+        shared.m_refs.fetch_add(1, std::memory_order_relaxed);
+        SharedInfo* r_info = m_reader_map.get_addr();
+        atomic_double_dec(r_info->readers.get(read_lock.m_reader_idx).count);
+        read_lock.m_shared = true;
+        return;
+    }
+    read_lock.m_shared = false;
+    m_local_locks_held.emplace_back(read_lock);
+}
+
+
 void DB::grab_read_lock(ReadLockInfo& read_lock, VersionID version_id)
 {
+    // Fast path: if a transaction of this DB already reads the requested
+    // snapshot, share its lock. The transaction count is taken first, so that
+    // once compact() or close() has observed it to be zero under m_mutex, all
+    // slots are unused and no transaction can start without m_mutex.
+    REALM_ASSERT_RELEASE(is_attached());
+    ++m_transaction_count;
+    {
+        bool latest = version_id.version == std::numeric_limits<version_type>::max();
+        // The ringbuffer header is within m_file_map, which is never remapped
+        uint_fast32_t reader_idx = latest ? m_file_map.get_addr()->readers.last() : version_id.index;
+        if (try_grab_shared_read_lock(read_lock, reader_idx, version_id.version))
+            return;
+    }
+    --m_transaction_count;
+
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
     REALM_ASSERT_RELEASE(is_attached());
     if (version_id.version == std::numeric_limits<version_type>::max()) {
@@ -1875,7 +2002,7 @@ void DB::grab_read_lock(ReadLockInfo& read_lock, VersionID version_id)
             read_lock.m_version = r.version;
             read_lock.m_top_ref = to_size_t(r.current_top);
             read_lock.m_file_size = to_size_t(r.filesize);
-            m_local_locks_held.emplace_back(read_lock);
+            share_read_lock(read_lock);
             ++m_transaction_count;
             // REALM_ASSERT(m_alloc.matches_section_boundary(read_lock.m_file_size));
             REALM_ASSERT(read_lock.m_file_size > read_lock.m_top_ref);
@@ -1913,7 +2040,7 @@ void DB::grab_read_lock(ReadLockInfo& read_lock, VersionID version_id)
         read_lock.m_version = r.version;
         read_lock.m_top_ref = to_size_t(r.current_top);
         read_lock.m_file_size = to_size_t(r.filesize);
-        m_local_locks_held.emplace_back(read_lock);
+        share_read_lock(read_lock);
         ++m_transaction_count;
         // REALM_ASSERT(m_alloc.matches_section_boundary(read_lock.m_file_size));
         REALM_ASSERT(read_lock.m_file_size > read_lock.m_top_ref);
@@ -2029,13 +2156,20 @@ void DB::do_end_write() noexcept
     info->next_served++;
     m_pick_next_writer.notify_all();
 
-    std::lock_guard<std::recursive_mutex> local_lock(m_mutex);
-    m_write_transaction_open = false;
-    m_writemutex.unlock();
+    {
+        std::lock_guard<std::recursive_mutex> local_lock(m_mutex);
+        m_write_transaction_open = false;
+        m_writemutex.unlock();
+    }
+
+    // A flush postponed while this writer was busy need not wait any longer,
+    // also when the transaction was rolled back
+    std::lock_guard<std::mutex> lock(m_group_commit_mutex);
+    m_group_commit_cond.notify_all();
 }
 
 
-Replication::version_type DB::do_commit(Transaction& transaction)
+Replication::version_type DB::do_commit(Transaction& transaction, bool defer_sync)
 {
     version_type current_version;
     {
@@ -2045,25 +2179,255 @@ Replication::version_type DB::do_commit(Transaction& transaction)
     }
     version_type new_version = current_version + 1;
 
-    if (Replication* repl = get_replication()) {
-        // If Replication::prepare_commit() fails, then the entire transaction
-        // fails. The application then has the option of terminating the
-        // transaction with a call to SharedGroup::rollback(), which in turn
-        // must call Replication::abort_transact().
-        new_version = repl->prepare_commit(current_version); // Throws
+    SharedInfo* info = m_file_map.get_addr();
+    defer_sync = defer_sync && Durability(info->durability) == Durability::Full;
+    bool grabbed_durable_read_lock = false;
+    if (defer_sync) {
+        std::lock_guard<std::mutex> lock(m_group_commit_mutex);
+        if (!m_durable_read_lock) {
+            // No commit is waiting for a flush, so the snapshot this transaction
+            // is based on is the one selected by the file header. It must stay
+            // intact until the header selects a newer snapshot.
+            ReadLockInfo read_lock;
+            grab_read_lock(read_lock, VersionID(transaction.m_read_lock.m_version,
+                                                transaction.m_read_lock.m_reader_idx)); // Throws
+            m_durable_read_lock = read_lock;
+            grabbed_durable_read_lock = true;
+        }
+    }
+
+    try {
+        if (Replication* repl = get_replication()) {
+            // If Replication::prepare_commit() fails, then the entire transaction
+            // fails. The application then has the option of terminating the
+            // transaction with a call to SharedGroup::rollback(), which in turn
+            // must call Replication::abort_transact().
+            new_version = repl->prepare_commit(current_version); // Throws
+            try {
+                low_level_commit(new_version, transaction, defer_sync); // Throws
+            }
+            catch (...) {
+                repl->abort_transact();
+                throw;
+            }
+            repl->finalize_commit();
+        }
+        else {
+            low_level_commit(new_version, transaction, defer_sync); // Throws
+        }
+    }
+    catch (...) {
+        if (grabbed_durable_read_lock) {
+            std::lock_guard<std::mutex> lock(m_group_commit_mutex);
+            release_read_lock(*m_durable_read_lock);
+            m_durable_read_lock = util::none;
+        }
+        throw;
+    }
+    return new_version;
+}
+
+
+void DB::wait_for_durable(version_type version)
+{
+    std::unique_lock<std::mutex> lock(m_group_commit_mutex);
+    // A pending flush may be waiting for this commit
+    m_group_commit_cond.notify_all();
+    while (m_durable_version < version) {
+        if (m_group_commit_flushing) {
+            m_group_commit_cond.wait(lock);
+            continue;
+        }
+
+        // Nobody is flushing, so it is up to this thread. Postpone the flush
+        // while other writers of this DB are busy, so that their commits can be
+        // covered by it too.
+        m_group_commit_flushing = true;
+        auto deadline = std::chrono::steady_clock::now() + m_group_commit_max_delay;
+        auto has_pending_writers = [&] {
+            if (m_num_waiting_writers > 0)
+                return true;
+            std::lock_guard<std::recursive_mutex> local_lock(m_mutex);
+            return m_write_transaction_open;
+        };
+        while (has_pending_writers()) {
+            if (m_group_commit_cond.wait_until(lock, deadline) == std::cv_status::timeout)
+                break;
+        }
+
+        lock.unlock();
+        auto flushing_guard = make_scope_exit([&]() noexcept {
+            lock.lock();
+            m_group_commit_flushing = false;
+            m_group_commit_cond.notify_all();
+        });
+        flush_group_commit(); // Throws
+    }
+}
+
+
+void DB::wait_for_group_commit(version_type version)
+{
+    try {
+        wait_for_durable(version); // Throws
+    }
+    catch (...) {
+        std::throw_with_nested(CommitNotDurable(version));
+    }
+}
+
+
+void DB::flush_group_commit()
+{
+    // Holding the write lock ensures that no commit is in progress. Writers
+    // that queued up before this point will get to commit first, and are then
+    // covered by this flush.
+    do_begin_write(); // Throws
+    auto end_write_guard = make_scope_exit([this]() noexcept {
+        do_end_write();
+    });
+
+    version_type version;
+    ref_type top_ref;
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        SharedInfo* r_info = m_reader_map.get_addr();
+        uint_fast32_t index = r_info->readers.last();
+        if (grow_reader_mapping(index)) // Throws
+            r_info = m_reader_map.get_addr();
+        const Ringbuffer::ReadCount& r = r_info->readers.get(index);
+        version = r.version;
+        top_ref = ref_type(r.current_top);
+    }
+    bool needs_flush;
+    {
+        std::lock_guard<std::mutex> lock(m_group_commit_mutex);
+        needs_flush = version > m_durable_version;
+    }
+    if (needs_flush)
+        GroupWriter::select_snapshot(m_alloc, top_ref, get_file_format_version()); // Throws
+    group_commit_synced(version);
+}
+
+
+void DB::group_commit_synced(version_type version) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_group_commit_mutex);
+    if (m_durable_read_lock) {
+        release_read_lock(*m_durable_read_lock);
+        m_durable_read_lock = util::none;
+    }
+    if (version > m_durable_version)
+        m_durable_version = version;
+    m_group_commit_cond.notify_all();
+}
+
+
+bool DB::prepare_async_commit()
+{
+    SharedInfo* info = m_file_map.get_addr();
+    if (Durability(info->durability) != Durability::Full)
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_group_commit_mutex);
+    // Only writers add entries, so the reserved space stays available until
+    // add_async_commit() is called
+    m_async_commits.reserve(m_async_commits.size() + 1); // Throws
+    if (!m_sync_thread.joinable()) {
+        m_sync_thread = std::thread([this] {
+            run_sync_thread();
+        }); // Throws
+    }
+    return true;
+}
+
+
+void DB::add_async_commit(version_type version, AsyncCommitCallback callback, DBRef db) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_group_commit_mutex);
+    REALM_ASSERT(m_async_commits.size() < m_async_commits.capacity());
+    m_async_commits.push_back({version, std::move(callback), std::move(db)});
+    m_group_commit_cond.notify_all();
+}
+
+
+void DB::run_sync_thread()
+{
+    // Set if the DB detaches the thread, after which it must not be touched
+    bool detached = false;
+    std::unique_lock<std::mutex> lock(m_group_commit_mutex);
+    m_sync_thread_detached = &detached;
+    for (;;) {
+        m_group_commit_cond.wait(lock, [&] {
+            return m_stop_sync_thread || !m_async_commits.empty();
+        });
+        if (m_async_commits.empty())
+            return;
+
+        // Commits by different threads may have been queued out of order
+        version_type version = 0;
+        for (auto& commit : m_async_commits)
+            version = std::max(version, commit.version);
+        lock.unlock();
+        std::exception_ptr error;
         try {
-            low_level_commit(new_version, transaction); // Throws
+            wait_for_durable(version); // Throws
         }
         catch (...) {
-            repl->abort_transact();
-            throw;
+            error = std::current_exception();
         }
-        repl->finalize_commit();
+        lock.lock();
+
+        // Report everything which is durable now, or everything we tried to
+        // make durable if that failed. The flush may have picked up commits
+        // queued in the meantime.
+        std::vector<AsyncCommit> completed;
+        auto it = std::partition(m_async_commits.begin(), m_async_commits.end(), [&](const AsyncCommit& commit) {
+            return commit.version > (error ? version : m_durable_version);
+        });
+        std::move(it, m_async_commits.end(), std::back_inserter(completed));
+        m_async_commits.erase(it, m_async_commits.end());
+        std::sort(completed.begin(), completed.end(), [](const AsyncCommit& a, const AsyncCommit& b) {
+            return a.version < b.version;
+        });
+        lock.unlock();
+        for (auto& commit : completed) {
+            if (commit.callback)
+                commit.callback(commit.version, error);
+        }
+        // The callbacks may have released the last reference to the DB other
+        // than those of the completed commits. The DB is then destroyed here,
+        // on this thread, once all the callbacks have returned.
+        completed.clear();
+        if (detached)
+            return;
+        lock.lock();
     }
-    else {
-        low_level_commit(new_version, transaction); // Throws
+}
+
+
+void DB::stop_sync_thread()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_group_commit_mutex);
+        if (!m_sync_thread.joinable())
+            return;
+        if (m_sync_thread.get_id() == std::this_thread::get_id()) {
+            // The queued commits keep the DB alive, so this is an explicit
+            // close() from a callback, which can not wait for them
+            if (!m_async_commits.empty())
+                throw LogicError(LogicError::wrong_transact_state);
+            // The DB is closed or destroyed by the sync thread itself, after it
+            // has invoked the last callbacks. It can not join itself, so it is
+            // left to end on its own.
+            *m_sync_thread_detached = true;
+            m_sync_thread.detach();
+            return;
+        }
+        m_stop_sync_thread = true;
+        m_group_commit_cond.notify_all();
     }
-    return new_version;
+    m_sync_thread.join();
 }
 
 
@@ -2074,9 +2438,16 @@ DB::version_type Transaction::commit_and_continue_as_read()
     if (m_transact_stage != DB::transact_Writing)
         throw LogicError(LogicError::wrong_transact_state);
 
+    if (db->m_auto_enumeration)
+        enumerate_low_cardinality_columns(); // Throws
+    if (db->m_integer_compression)
+        compress_integer_leaves(); // Throws
+    if (db->m_zone_maps)
+        update_zone_maps(); // Throws
     flush_accessors_for_commit();
 
-    DB::version_type version = db->do_commit(*this); // Throws
+    bool group_commit = db->m_group_commit;
+    DB::version_type version = db->do_commit(*this, group_commit); // Throws
 
     // advance read lock but dont update accessors:
     // As this is done under lock, along with the addition above of the newest commit,
@@ -2099,6 +2470,9 @@ DB::version_type Transaction::commit_and_continue_as_read()
     m_history = nullptr;
     set_transact_stage(DB::transact_Reading);
 
+    if (group_commit)
+        db->wait_for_group_commit(version); // Throws
+
     return version;
 }
 
@@ -2157,7 +2531,59 @@ DB::version_type DB::get_version_of_latest_snapshot()
 }
 
 
-void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction)
+void DB::setup_evacuation(GroupWriter& out)
+{
+    out.enable_trimming();
+    if (!m_evacuation_limit) {
+        // Start evacuating when the file is more than twice the size needed by
+        // the data and the space held by readers, plus some room to move it in,
+        // according to the figures of the previous commit
+        size_t file_size = out.get_logical_file_size();
+        if (m_free_space > file_size || m_locked_space > m_free_space)
+            return;
+        size_t used = file_size - m_free_space;
+        size_t headroom = std::max(used / 4, size_t(64 * 1024));
+        size_t limit = util::round_up_to_page_size(used + m_locked_space + headroom);
+        if (2 * limit > file_size || limit >= m_failed_evacuation_limit)
+            return;
+        m_evacuation_limit = limit;
+        m_evacuation_progress.clear();
+        m_evacuated_in_pass = 0;
+        m_evacuation_scanned = false;
+    }
+    size_t work_limit = m_evacuation_scanned ? 0 : m_online_compaction_work_limit;
+    out.set_evacuation(m_evacuation_limit, work_limit, m_evacuation_progress);
+}
+
+void DB::update_evacuation(GroupWriter& out)
+{
+    if (!m_evacuation_limit)
+        return;
+    if (out.evacuation_aborted()) {
+        m_failed_evacuation_limit = m_evacuation_limit;
+        m_evacuation_limit = 0;
+        return;
+    }
+    if (out.get_logical_file_size() <= m_evacuation_limit) {
+        // Done, the file has been trimmed down to the limit
+        m_failed_evacuation_limit = std::numeric_limits<size_t>::max();
+        m_evacuation_limit = 0;
+        return;
+    }
+    if (m_evacuation_scanned)
+        return;
+    m_evacuated_in_pass += out.get_evacuated_size();
+    if (m_evacuation_progress.empty()) {
+        // A pass over the whole group is complete. Data may have been missed
+        // if the group changed shape in the meantime, so another pass is made
+        // unless this one moved nothing.
+        m_evacuation_scanned = m_evacuated_in_pass == 0;
+        m_evacuated_in_pass = 0;
+    }
+}
+
+
+void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction, bool defer_sync)
 {
     SharedInfo* info = m_file_map.get_addr();
 
@@ -2196,6 +2622,10 @@ void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction)
     // info->readers.dump();
     GroupWriter out(transaction, Durability(info->durability)); // Throws
     out.set_versions(new_version, oldest_version);
+    if (m_commit_checksum)
+        out.enable_commit_checksum();
+    if (m_online_compaction)
+        setup_evacuation(out);
     ref_type new_top_ref;
     // Recursively write all changed arrays to end of file
     {
@@ -2203,18 +2633,32 @@ void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction)
         std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
         new_top_ref = out.write_group();                         // Throws
     }
+    if (m_online_compaction)
+        update_evacuation(out);
     {
         // protect access to shared variables and m_reader_mapping from here
         std::lock_guard<std::recursive_mutex> lock_guard(m_mutex);
         m_free_space = out.get_free_space_size();
         m_locked_space = out.get_locked_space_size();
-        m_used_space = out.get_file_size() - m_free_space;
+        m_used_space = out.get_logical_file_size() - m_free_space;
         // std::cout << "Writing version " << new_version << ", Topptr " << new_top_ref
         //     << " Read lock at version " << oldest_version << std::endl;
         switch (Durability(info->durability)) {
             case Durability::Full:
             case Durability::Unsafe:
+                // With group commit, the file header is updated later by
+                // flush_group_commit(), together with other deferred commits.
+                if (defer_sync)
+                    break;
                 out.commit(new_top_ref); // Throws
+#ifndef _WIN32
+                // Space trimmed off the end of the file by the writer is not
+                // used by any version still being read, nor by the one now
+                // selected by the file header
+                if (m_online_compaction && !m_alloc.get_file().get_encryption_key() &&
+                    out.get_logical_file_size() < out.get_file_size())
+                    m_alloc.get_file().resize(out.get_logical_file_size()); // Throws
+#endif
                 break;
             case Durability::MemOnly:
             case Durability::Async:
@@ -2269,6 +2713,8 @@ void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction)
 
         m_new_commit_available.notify_all();
     }
+    if (!defer_sync && Durability(info->durability) == Durability::Full)
+        group_commit_synced(new_version);
 }
 
 #ifdef REALM_DEBUG
@@ -2457,6 +2903,28 @@ size_t Transaction::get_commit_size() const
 }
 
 DB::version_type Transaction::commit()
+{
+    // Ending the transaction releases the DB
+    DBRef db_ref = db;
+    bool group_commit = db_ref && db_ref->m_group_commit;
+    DB::version_type new_version = commit_and_end(group_commit); // Throws
+    if (group_commit)
+        db_ref->wait_for_group_commit(new_version); // Throws
+    return new_version;
+}
+
+DB::version_type Transaction::commit_async(DB::AsyncCommitCallback on_durable)
+{
+    bool queued;
+    DB::version_type new_version = commit_and_end(true, &on_durable, &queued); // Throws
+    // If the commit was not handed to the sync thread, it is already as
+    // durable as it gets
+    if (!queued && on_durable)
+        on_durable(new_version, nullptr);
+    return new_version;
+}
+
+DB::version_type Transaction::commit_and_end(bool defer_sync, DB::AsyncCommitCallback* on_durable, bool* queued)
 {
     if (!is_attached())
         throw LogicError(LogicError::wrong_transact_state);
@@ -2466,9 +2934,26 @@ DB::version_type Transaction::commit()
     REALM_ASSERT(is_attached());
 
     // before committing, allow any accessors at group level or below to sync
+    if (db->m_auto_enumeration)
+        enumerate_low_cardinality_columns(); // Throws
+    if (db->m_integer_compression)
+        compress_integer_leaves(); // Throws
+    if (db->m_zone_maps)
+        update_zone_maps(); // Throws
     flush_accessors_for_commit();
 
-    DB::version_type new_version = db->do_commit(*this); // Throws
+    // Make room for the callback before committing, so that queueing it cannot
+    // fail afterwards
+    bool queue_callback = on_durable && db->prepare_async_commit(); // Throws
+
+    DB::version_type new_version = db->do_commit(*this, defer_sync); // Throws
+
+    // Queueing while the write lock is held ensures that the callbacks are
+    // invoked in version order
+    if (queue_callback)
+        db->add_async_commit(new_version, std::move(*on_durable), db);
+    if (queued)
+        *queued = queue_callback;
 
     // We need to set m_read_lock in order for wait_for_change to work.
     // To set it, we grab a readlock on the latest available snapshot
@@ -2486,6 +2971,68 @@ DB::version_type Transaction::commit()
     return new_version;
 }
 
+void Transaction::enumerate_low_cardinality_columns()
+{
+    constexpr size_t min_table_size = 1000;
+    constexpr size_t min_objects_per_value = 16;
+    constexpr size_t max_unique_values = 256;
+
+    for (Table* table : m_table_accessors) {
+        if (!table)
+            continue;
+        size_t table_size = table->size();
+        if (table_size < min_table_size)
+            continue;
+        for (ColKey col_key : table->get_column_keys()) {
+            if (col_key.get_type() != col_type_String || col_key.get_attrs().test(col_attr_List) ||
+                table->is_enumerated(col_key))
+                continue;
+
+            auto column = std::make_pair(table->get_key(), col_key);
+            {
+                std::lock_guard<std::mutex> lock(db->m_auto_enumeration_mutex);
+                auto it = db->m_high_cardinality_columns.find(column);
+                if (it != db->m_high_cardinality_columns.end() && table_size < 2 * it->second)
+                    continue;
+            }
+
+            // Counting gives up after the limit, so columns with many distinct values are rejected quickly
+            size_t limit = std::min(max_unique_values, table_size / min_objects_per_value);
+            if (table->count_unique_strings(col_key, limit) <= limit) {
+                table->enumerate_string_column(col_key); // Throws
+            }
+            else {
+                std::lock_guard<std::mutex> lock(db->m_auto_enumeration_mutex);
+                db->m_high_cardinality_columns[column] = table_size;
+            }
+        }
+    }
+}
+
+void Transaction::compress_integer_leaves()
+{
+    // The encoding was introduced with file format version 11. A file is
+    // upgraded when opened, so this only skips commits made as part of the
+    // upgrade itself.
+    if (get_file_format_version() < 11)
+        return;
+    for (Table* table : m_table_accessors) {
+        if (table)
+            table->compress_integer_leaves(); // Throws
+    }
+}
+
+void Transaction::update_zone_maps()
+{
+    // See compress_integer_leaves()
+    if (get_file_format_version() < 11)
+        return;
+    for (Table* table : m_table_accessors) {
+        if (table)
+            table->update_zone_maps(); // Throws
+    }
+}
+
 void Transaction::commit_and_continue_writing()
 {
     if (!is_attached())
@@ -2496,6 +3043,12 @@ void Transaction::commit_and_continue_writing()
     REALM_ASSERT(is_attached());
 
     // before committing, allow any accessors at group level or below to sync
+    if (db->m_auto_enumeration)
+        enumerate_low_cardinality_columns(); // Throws
+    if (db->m_integer_compression)
+        compress_integer_leaves(); // Throws
+    if (db->m_zone_maps)
+        update_zone_maps(); // Throws
     flush_accessors_for_commit();
 
     db->do_commit(*this); // Throws
@@ -2539,22 +3092,33 @@ DB::VersionID Transaction::get_version_of_current_transaction()
 
 TransactionRef DB::start_write(bool nonblocking)
 {
-    if (nonblocking) {
-        bool succes = do_try_begin_write();
-        if (!succes) {
-            return TransactionRef();
-        }
-    }
-    else {
-        do_begin_write();
-    }
+    bool attached;
     {
-        std::lock_guard<std::recursive_mutex> local_lock(m_mutex);
-        if (!is_attached()) {
-            do_end_write();
-            throw LogicError(LogicError::wrong_transact_state);
+        // Let a pending group commit flush know that there is a writer on the
+        // way. It is counted until the transaction is marked as open, so that
+        // the flush sees one or the other.
+        ++m_num_waiting_writers;
+        auto waiting_guard = make_scope_exit([this]() noexcept {
+            --m_num_waiting_writers;
+        });
+        if (nonblocking) {
+            bool succes = do_try_begin_write();
+            if (!succes) {
+                return TransactionRef();
+            }
         }
-        m_write_transaction_open = true;
+        else {
+            do_begin_write();
+        }
+        std::lock_guard<std::recursive_mutex> local_lock(m_mutex);
+        attached = is_attached();
+        if (attached)
+            m_write_transaction_open = true;
+    }
+    // do_end_write() must not be called with m_mutex held
+    if (!attached) {
+        do_end_write();
+        throw LogicError(LogicError::wrong_transact_state);
     }
     ReadLockInfo read_lock;
     Transaction* tr;
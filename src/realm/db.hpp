@@ -19,9 +19,16 @@
 #ifndef REALM_GROUP_SHARED_HPP
 #define REALM_GROUP_SHARED_HPP
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
 #include <functional>
 #include <cstdint>
 #include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <realm/util/features.h>
 #include <realm/util/thread.hpp>
 #include <realm/util/interprocess_condvar.hpp>
@@ -42,6 +49,7 @@ class WriteLogCollector;
 
 class Transaction;
 using TransactionRef = std::shared_ptr<Transaction>;
+class GroupWriter;
 
 /// Thrown by DB::create() if the lock file is already open in another
 /// process which can't share mutexes with this process
@@ -209,9 +217,21 @@ public:
     using version_type = _impl::History::version_type;
     using VersionID = realm::VersionID;
 
+    /// Invoked by the sync thread of the DB when a commit made by
+    /// Transaction::commit_async() has been written to stable storage, or when
+    /// doing so has failed, in which case the exception is passed along. The
+    /// version is the one returned by commit_async().
+    using AsyncCommitCallback = std::function<void(version_type, std::exception_ptr)>;
+
     /// Returns the version of the latest snapshot.
     version_type get_version_of_latest_snapshot();
 
+    /// Returns the path of the Realm file
+    const std::string& get_path() const noexcept
+    {
+        return m_db_path;
+    }
+
     /// Thrown by start_read() if the specified version does not correspond to a
     /// bound (AKA tethered) snapshot.
     struct BadVersion;
@@ -244,6 +264,15 @@ public:
         transact_Frozen,
     };
 
+    /// Returns true if this DB began the session, and found that the last
+    /// commit to the file was left incomplete by a crash. The previous commit
+    /// was used instead, and the last one is lost. See
+    /// DBOptions::enable_commit_checksum.
+    bool incomplete_commit_discarded() const noexcept
+    {
+        return m_incomplete_commit_discarded;
+    }
+
     /// Report the number of distinct versions currently stored in the database.
     /// Note: the database only cleans up versions as part of commit, so ending
     /// a read transaction will not immediately release any versions.
@@ -367,7 +396,7 @@ protected:
 
 private:
     std::recursive_mutex m_mutex;
-    int m_transaction_count = 0;
+    std::atomic<int> m_transaction_count{0};
     SlabAlloc m_alloc;
     Replication* m_replication = nullptr;
     struct SharedInfo;
@@ -377,15 +406,30 @@ private:
         uint_fast32_t m_reader_idx = 0;
         ref_type m_top_ref = 0;
         size_t m_file_size = 0;
+        // True if the lock is a reference to one of m_shared_read_locks rather
+        // than an entry in m_local_locks_held
+        bool m_shared = false;
     };
     class ReadLockGuard;
 
+    // A lock on a ringbuffer entry shared by all transactions of this DB that
+    // read the same snapshot. Slot i may only hold entries whose index modulo
+    // s_num_shared_read_locks is i. Taking and dropping references to a slot
+    // that is in use does not require m_mutex, but m_info is only changed, and
+    // m_refs only taken to or from zero, under m_mutex.
+    struct SharedReadLock {
+        std::atomic<uint32_t> m_refs{0};
+        ReadLockInfo m_info;
+    };
+    static constexpr size_t s_num_shared_read_locks = 16;
+
     // Member variables
     size_t m_free_space = 0;
     size_t m_locked_space = 0;
     size_t m_used_space = 0;
     uint_fast32_t m_local_max_entry = 0; // highest version observed by this DB
-    std::vector<ReadLockInfo> m_local_locks_held; // tracks all read locks held by this DB
+    std::vector<ReadLockInfo> m_local_locks_held; // tracks read locks not shared through m_shared_read_locks
+    SharedReadLock m_shared_read_locks[s_num_shared_read_locks];
     util::File m_file;
     util::File::Map<SharedInfo> m_file_map; // Never remapped, provides access to everything but the ringbuffer
     util::File::Map<SharedInfo> m_reader_map; // provides access to ringbuffer, remapped as needed when it grows
@@ -412,6 +456,60 @@ private:
     std::function<void(int, int)> m_upgrade_callback;
 
     std::shared_ptr<metrics::Metrics> m_metrics;
+    // See DBOptions::enable_commit_checksum
+    bool m_commit_checksum = false;
+    bool m_incomplete_commit_discarded = false;
+
+    // See DBOptions::enable_auto_enumeration. For the columns found to have too
+    // many distinct values, the size of the table at the time, protected by
+    // m_auto_enumeration_mutex.
+    bool m_auto_enumeration = false;
+    std::mutex m_auto_enumeration_mutex;
+    std::map<std::pair<TableKey, ColKey>, size_t> m_high_cardinality_columns;
+    // See DBOptions::enable_integer_compression
+    bool m_integer_compression = false;
+    // See DBOptions::enable_zone_maps
+    bool m_zone_maps = false;
+
+    // Online compaction state, see DBOptions::enable_online_compaction. Only
+    // accessed while holding the write lock. While m_evacuation_limit is set,
+    // commits move data from beyond it, continuing from m_evacuation_progress,
+    // until a pass over the whole group moves nothing. Then the space beyond
+    // the limit is only waiting to be trimmed off the file.
+    bool m_online_compaction = false;
+    size_t m_online_compaction_work_limit = 0;
+    size_t m_evacuation_limit = 0;
+    std::vector<size_t> m_evacuation_progress;
+    size_t m_evacuated_in_pass = 0;
+    bool m_evacuation_scanned = false;
+    // Limit of the last evacuation which ran out of space below the limit
+    size_t m_failed_evacuation_limit = std::numeric_limits<size_t>::max();
+
+    // Group commit state, see DBOptions::enable_group_commit. While commits
+    // are waiting for a flush, m_durable_read_lock protects the snapshot
+    // selected by the file header from having its space reused.
+    bool m_group_commit = false;
+    std::chrono::microseconds m_group_commit_max_delay;
+    std::mutex m_group_commit_mutex;
+    std::condition_variable m_group_commit_cond;
+    bool m_group_commit_flushing = false;
+    std::atomic<int> m_num_waiting_writers{0};
+    version_type m_durable_version = 0;
+    util::Optional<ReadLockInfo> m_durable_read_lock;
+
+    // Commits made by Transaction::commit_async() which are waiting for the
+    // sync thread, protected by m_group_commit_mutex. Each one keeps the DB
+    // alive until its callback has been invoked.
+    struct AsyncCommit {
+        version_type version;
+        AsyncCommitCallback callback;
+        DBRef db;
+    };
+    std::vector<AsyncCommit> m_async_commits;
+    std::thread m_sync_thread;
+    bool m_stop_sync_thread = false;
+    bool* m_sync_thread_detached = nullptr;
+
     /// Attach this DB instance to the specified database file.
     ///
     /// While at least one instance of DB exists for a specific
@@ -492,19 +590,59 @@ private:
     // release_read_lock for locks already released must be avoided.
     void release_all_read_locks() noexcept;
 
+    // Start or continue online compaction as part of a commit, see
+    // DBOptions::enable_online_compaction. Called with the write lock held,
+    // before and after GroupWriter::write_group().
+    void setup_evacuation(GroupWriter&);
+    void update_evacuation(GroupWriter&);
+
+    // Take a reference to the shared read lock on ringbuffer entry 'reader_idx'
+    // without taking m_mutex. If 'version' is not the maximum value, the entry
+    // must also hold that version. Returns false if there is no such lock.
+    bool try_grab_shared_read_lock(ReadLockInfo&, uint_fast32_t reader_idx, version_type version) noexcept;
+    // Share a read lock just obtained from the ringbuffer, unless its slot is
+    // taken by another entry. Must be called with m_mutex locked.
+    void share_read_lock(ReadLockInfo&) noexcept;
+    // Drop a reference to a shared read lock. Returns false if the lock had
+    // already been released by release_all_read_locks().
+    bool release_shared_read_lock(SharedReadLock&) noexcept;
+
     /// return true if write transaction can commence, false otherwise.
     bool do_try_begin_write();
     void do_begin_write();
-    version_type do_commit(Transaction&);
+    version_type do_commit(Transaction&, bool defer_sync = false);
+    // Must not be called with m_mutex or m_group_commit_mutex held
     void do_end_write() noexcept;
 
+    // Group commit: wait until the specified version has been made durable,
+    // performing the flush if no other thread is doing so.
+    void wait_for_durable(version_type);
+    // Same as wait_for_durable(), but a failure to flush is reported as
+    // CommitNotDurable, as the version has been committed already.
+    void wait_for_group_commit(version_type);
+    // Flush the file and select the latest snapshot in the file header. Must
+    // not be called with the write lock held.
+    void flush_group_commit();
+    // Record that the latest snapshot has been selected in the file header.
+    // Must be called with the write lock held.
+    void group_commit_synced(version_type) noexcept;
+    // Hand a commit made by Transaction::commit_async() over to the sync
+    // thread. prepare_async_commit() must be called before the commit, and
+    // returns false if the commit will not need to be flushed.
+    bool prepare_async_commit();
+    void add_async_commit(version_type, AsyncCommitCallback, DBRef) noexcept;
+    void run_sync_thread();
+    // Wait for the sync thread to complete all async commits, and stop it.
+    // When called on the sync thread, the thread is detached instead.
+    void stop_sync_thread();
+
     // make sure the given index is within the currently mapped area.
     // if not, expand the mapped area. Returns true if the area is expanded.
     bool grow_reader_mapping(uint_fast32_t index);
 
     // Must be called only by someone that has a lock on the write
     // mutex.
-    void low_level_commit(uint_fast64_t new_version, Transaction& transaction);
+    void low_level_commit(uint_fast64_t new_version, Transaction& transaction, bool defer_sync);
 
     void do_async_commits();
 
@@ -563,6 +701,24 @@ public:
     size_t get_commit_size() const;
 
     DB::version_type commit();
+
+    /// Commit like commit(), but return as soon as the new version has become
+    /// visible to readers, without waiting for it to reach stable storage. The
+    /// data is flushed by a background thread owned by the DB, which then calls
+    /// \a on_durable. The commits made this way are flushed together where
+    /// possible, and a commit is never reported as durable before the commits
+    /// preceding it.
+    ///
+    /// Unless the durability is Durability::Full, there is nothing to flush,
+    /// and \a on_durable is called before commit_async() returns.
+    ///
+    /// Closing the DB waits for all outstanding async commits, and a queued
+    /// commit keeps the DB alive until its callback has been invoked. The
+    /// callback may release the last reference to the DB, which is then
+    /// destroyed by the background thread. Calling DB::close() from a callback
+    /// while other async commits are outstanding throws LogicError.
+    DB::version_type commit_async(DB::AsyncCommitCallback on_durable = {});
+
     void rollback();
     void end_read();
 
@@ -633,8 +789,16 @@ private:
     bool internal_advance_read(O* observer, VersionID target_version, _impl::History&, bool);
     void set_transact_stage(DB::TransactStage stage) noexcept;
     void do_end_read() noexcept;
+    DB::version_type commit_and_end(bool defer_sync, DB::AsyncCommitCallback* on_durable = nullptr,
+                                    bool* queued = nullptr);
     void commit_and_continue_writing();
     void initialize_replication();
+    // See DBOptions::enable_auto_enumeration
+    void enumerate_low_cardinality_columns();
+    // See DBOptions::enable_integer_compression
+    void compress_integer_leaves();
+    // See DBOptions::enable_zone_maps
+    void update_zone_maps();
 
     DBRef db;
     mutable std::unique_ptr<_impl::History> m_history_read;
@@ -19,6 +19,7 @@
 #ifndef REALM_GROUP_SHARED_OPTIONS_HPP
 #define REALM_GROUP_SHARED_OPTIONS_HPP
 
+#include <chrono>
 #include <functional>
 #include <string>
 
@@ -101,6 +102,99 @@ struct DBOptions {
     /// is exceeded without being consumed, only the most recent entries will be stored.
     size_t metrics_buffer_size;
 
+    /// If \a enable_group_commit is set to `true`, and the durability is
+    /// Durability::Full, commits made through this DB by concurrent writers are
+    /// made durable together: A committing thread publishes its new version to
+    /// readers right away, but instead of flushing the file itself it waits for
+    /// a single flush which covers every version committed in the meantime.
+    /// Each commit still returns only once its own version is on disk, but the
+    /// number of flushes per commit drops when writers are queued up.
+    ///
+    /// A version is therefore visible before it is durable: Readers in any
+    /// process may see it, and writers may build on it, while the flush is
+    /// still pending. If the system crashes before the flush, such versions are
+    /// lost although they may have been read. If the flush fails, the commit
+    /// throws CommitNotDurable, and the version stays visible.
+    ///
+    /// Transaction::commit_and_continue_writing() always flushes by itself, as
+    /// it keeps the write lock.
+    bool enable_group_commit = false;
+
+    /// When group commit is enabled, this is the longest time the flush will be
+    /// postponed to wait for other writers to commit. The flush is started
+    /// early when no other writer is waiting to start a write transaction.
+    std::chrono::microseconds group_commit_max_delay = std::chrono::milliseconds(2);
+
+    /// If \a enable_commit_checksum is set to `true`, and the durability is
+    /// Durability::Full, every commit writes a small record of the file ranges
+    /// it has written, protected by a checksum, and marks this in the file
+    /// header. When the previous commit carries such a record too, the commit
+    /// is made durable with a single sync instead of two: The header is
+    /// updated together with the data, and if a crash leaves the new commit
+    /// incomplete, this is detected when the file is opened, and the previous
+    /// commit is used instead, and DB::incomplete_commit_discarded() returns
+    /// true.
+    ///
+    /// The commit records require file format version 11, so versions of
+    /// Realm which predate this option refuse to open the file.
+    bool enable_commit_checksum = false;
+
+    /// If \a enable_auto_enumeration is set to `true`, String columns with few
+    /// distinct values are switched to enumerated storage, as by
+    /// Table::enumerate_string_column(), when a write transaction is
+    /// committed. Each distinct value is then stored once per column, and each
+    /// object refers to it by a small integer, which equality and IN
+    /// conditions and distinct compare instead of the strings.
+    ///
+    /// A column qualifies when its table has at least 1000 objects, and it
+    /// has at most one distinct value per 16 objects, and at most 256 in
+    /// total. Only the tables accessed by the transaction are considered, and
+    /// a column which does not qualify is not considered again by this DB
+    /// until its table has doubled in size.
+    bool enable_auto_enumeration = false;
+
+    /// If \a enable_integer_compression is set to `true`, the leaves of Int
+    /// and Timestamp columns modified by a write transaction are stored with
+    /// frame-of-reference encoding when it is committed, if that makes them
+    /// smaller: Each value is stored as its offset from the smallest value in
+    /// the leaf, using as few bits as the largest offset requires. Queries and
+    /// aggregates work directly on the encoded values. An encoded leaf is
+    /// decoded the first time it is modified.
+    ///
+    /// The encoding requires file format version 11, so versions of Realm
+    /// which predate this option refuse to open the file.
+    bool enable_integer_compression = false;
+
+    /// If \a enable_zone_maps is set to `true`, the smallest and largest value
+    /// and the number of nulls of each Int, Float, Double and Timestamp column
+    /// are kept for each leaf of the tables modified by a write transaction,
+    /// when it is committed. Queries with conditions comparing such a column
+    /// to a constant then skip the leaves which can not hold a match, so a
+    /// query on a range of an ascending column, as in an append-mostly time
+    /// series, only reads the leaves holding the range.
+    ///
+    /// The summaries are stored in the inner nodes of the tables. They require
+    /// file format version 11, so versions of Realm which predate this option
+    /// refuse to open the file.
+    bool enable_zone_maps = false;
+
+    /// If \a enable_online_compaction is set to `true`, the file is compacted
+    /// gradually by ordinary write transactions, instead of only by
+    /// DB::compact(), which needs exclusive access. When more than half of the
+    /// file is free space, an evacuation limit is chosen a little above the
+    /// space the data needs, and each commit moves up to
+    /// \a online_compaction_work_limit bytes of data from beyond the limit to
+    /// free space below it. Once the space beyond the limit is no longer used
+    /// by any version still being read, it is cut off the end of the file.
+    ///
+    /// On Windows, and for encrypted files, the file is not truncated, but the
+    /// space cut off is not used again until the file needs to grow.
+    bool enable_online_compaction = false;
+
+    /// The number of bytes of unmodified data each commit examines for online
+    /// compaction.
+    size_t online_compaction_work_limit = 1024 * 1024;
+
     /// sys_tmp_dir will be used if the temp_dir is empty when creating SharedGroupOptions.
     /// It must be writable and allowed to create pipe/fifo file on it.
     /// set_sys_tmp_dir is not a thread-safe call and it is only supposed to be called once
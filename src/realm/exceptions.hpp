@@ -19,6 +19,7 @@
 #ifndef REALM_EXCEPTIONS_HPP
 #define REALM_EXCEPTIONS_HPP
 
+#include <cstdint>
 #include <stdexcept>
 
 #include <realm/util/features.h>
@@ -103,6 +104,24 @@ public:
     /// runtime_error::what() returns the msg provided in the constructor.
 };
 
+/// Thrown by a commit with DBOptions::enable_group_commit set, when the new
+/// version was committed and made visible to readers, but flushing it to disk
+/// failed. The transaction has ended as after a successful commit, and the
+/// next commit flushes the version again. The exception which made the flush
+/// fail is nested in this one.
+class CommitNotDurable : public std::runtime_error {
+public:
+    CommitNotDurable(uint_fast64_t version);
+
+    uint_fast64_t get_version() const noexcept
+    {
+        return m_version;
+    }
+
+private:
+    uint_fast64_t m_version;
+};
+
 /// Thrown when a key can not be used (either not found or already existing
 /// when trying to create a new object)
 class InvalidKey : public std::runtime_error {
@@ -350,6 +369,12 @@ inline OutOfDiskSpace::OutOfDiskSpace(const std::string& msg)
 {
 }
 
+inline CommitNotDurable::CommitNotDurable(uint_fast64_t version)
+    : std::runtime_error("Committed version could not be made durable")
+    , m_version(version)
+{
+}
+
 inline SerialisationError::SerialisationError(const std::string& msg)
     : std::runtime_error(msg)
 {
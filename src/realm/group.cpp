@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <set>
 #include <fstream>
+#include <thread>
 
 #ifdef REALM_DEBUG
 #include <iostream>
@@ -31,6 +32,7 @@
 #include <realm/util/miscellaneous.hpp>
 #include <realm/util/thread.hpp>
 #include <realm/impl/destroy_guard.hpp>
+#include <realm/impl/parallel_array_writer.hpp>
 #include <realm/utilities.hpp>
 #include <realm/exceptions.hpp>
 #include <realm/group_writer.hpp>
@@ -316,7 +318,7 @@ int Group::get_target_file_format_version_for_session(int /* current_file_format
     // Please see Group::get_file_format_version() for information about the
     // individual file format versions.
 
-    return 10;
+    return 11;
 }
 
 void Group::get_version_and_history_info(const Array& top, _impl::History::version_type& version, int& history_type,
@@ -374,7 +376,7 @@ void Transaction::upgrade_file_format(int target_file_format_version)
     // Be sure to revisit the following upgrade logic when a new file format
     // version is introduced. The following assert attempt to help you not
     // forget it.
-    REALM_ASSERT_EX(target_file_format_version == 10, target_file_format_version);
+    REALM_ASSERT_EX(target_file_format_version == 11, target_file_format_version);
 
     int current_file_format_version = get_file_format_version();
     REALM_ASSERT(current_file_format_version < target_file_format_version);
@@ -382,16 +384,17 @@ void Transaction::upgrade_file_format(int target_file_format_version)
     // SharedGroup::do_open() must ensure this. Be sure to revisit the
     // following upgrade logic when SharedGroup::do_open() is changed (or
     // vice versa).
-    REALM_ASSERT_EX(current_file_format_version >= 5 && current_file_format_version <= 9,
+    REALM_ASSERT_EX(current_file_format_version >= 5 && current_file_format_version <= 10,
                     current_file_format_version);
 
 
     // Upgrade from version prior to 7 (new history schema version in top array)
     if (current_file_format_version <= 6 && target_file_format_version >= 7) {
         // If top array size is 9, then add the missing 10th element containing
-        // the history schema version.
+        // the history schema version. An upgrade of the history schema, which
+        // is done first, adds it too.
         std::size_t top_size = m_top.size();
-        REALM_ASSERT(top_size <= 9);
+        REALM_ASSERT(top_size <= 10);
         if (top_size == 9) {
             int initial_history_schema_version = 0;
             m_top.add(initial_history_schema_version); // Throws
@@ -435,6 +438,16 @@ void Transaction::upgrade_file_format(int target_file_format_version)
         }
         remove_pk_table();
     }
+
+    // Upgrade from version 10 (structures not maintained by earlier versions).
+    // Offset encoded integer arrays are new in version 11, and need nothing.
+    if (current_file_format_version <= 10 && target_file_format_version >= 11) {
+        for (size_t t = 0; t < m_table_names.size(); t++) {
+            auto table = get_table(m_table_names.get(t));
+            table->rebuild_optional_indexes(); // Throws
+            table->drop_zone_maps();           // Throws
+        }
+    }
 }
 
 void Group::open(ref_type top_ref, const std::string& file_path)
@@ -454,7 +467,7 @@ void Group::open(ref_type top_ref, const std::string& file_path)
         case 0:
             file_format_ok = (top_ref == 0);
             break;
-        case 10:
+        case 11:
             file_format_ok = true;
             break;
     }
@@ -1011,6 +1024,13 @@ public:
     }
     ref_type write_tables(_impl::OutputStream& out) override
     {
+        // Large groups are serialised on all cores. The output is the same.
+        size_t used_space = m_group.get_used_space();
+        size_t num_threads = std::thread::hardware_concurrency();
+        if (used_space >= s_parallel_write_threshold && num_threads > 1) {
+            return _impl::write_array_parallel(m_group.m_tables.get_ref(), m_group.m_tables.get_alloc(), out,
+                                               num_threads, used_space); // Throws
+        }
         bool deep = true;                                           // Deep
         bool only_if_modified = false;                              // Always
         return m_group.m_tables.write(out, deep, only_if_modified); // Throws
@@ -1046,6 +1066,8 @@ public:
     }
 
 private:
+    static constexpr size_t s_parallel_write_threshold = 4 * 1024 * 1024;
+
     const Group& m_group;
     bool m_should_write_history;
 };
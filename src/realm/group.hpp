@@ -813,6 +813,15 @@ private:
     ///  10 Memory mapping changes which require special treatment of large files
     ///     of preceeding versions.
     ///
+    ///  11 Structures which must be maintained by every writer: the ordered
+    ///     and substring indexes in extra slots of the table top array, the
+    ///     zone maps in the inner nodes of the tables, and the commit record
+    ///     flag in the file header (which an earlier writer would leave set for
+    ///     a commit without a record). Also integer arrays stored as offsets
+    ///     from a base value (NodeHeader::wtype_Offset). A file of version 10
+    ///     is upgraded by rebuilding any such index and dropping any zone map,
+    ///     since an earlier version may have left them stale.
+    ///
     /// IMPORTANT: When introducing a new file format version, be sure to review
     /// the file validity checks in Group::open() and SharedGroup::do_open, the file
     /// format selection logic in
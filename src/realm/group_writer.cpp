@@ -261,12 +261,23 @@ GroupWriter::GroupWriter(Group& group, Durability dura)
 
 GroupWriter::~GroupWriter() = default;
 
+void GroupWriter::enable_commit_checksum() noexcept
+{
+    REALM_ASSERT(m_group.m_is_shared);
+    m_commit_checksum = true;
+}
+
 size_t GroupWriter::get_file_size() const noexcept
 {
     auto sz = to_size_t(m_alloc.get_file().get_size());
     return sz;
 }
 
+size_t GroupWriter::get_logical_file_size() const noexcept
+{
+    return to_size_t(m_group.m_top.get(2) / 2);
+}
+
 void GroupWriter::sync_all_mappings()
 {
     if (m_durability == Durability::Unsafe)
@@ -331,9 +342,22 @@ ref_type GroupWriter::write_group()
     // that has been release during the current transaction (or since the last
     // commit), as that would lead to clobbering of the previous database
     // version.
-    bool deep = true, only_if_modified = true;
-    ref_type names_ref = m_group.m_table_names.write(*this, deep, only_if_modified); // Throws
-    ref_type tables_ref = m_group.m_tables.write(*this, deep, only_if_modified);     // Throws
+    //
+    // The roots are visited in the order of the evacuation progress path:
+    // table names, tables and history.
+    std::vector<size_t> no_progress;
+    if (!m_evacuation_progress)
+        m_evacuation_progress = &no_progress;
+    const std::vector<size_t>& progress = *m_evacuation_progress;
+    size_t start = progress.empty() ? 0 : progress[0];
+    auto write_root = [&](size_t root_ndx, ref_type ref) {
+        if (root_ndx < start && m_alloc.is_read_only(ref))
+            return ref;
+        m_evacuation_path.assign(1, root_ndx);
+        return write_tree(ref, !progress.empty() && root_ndx == start); // Throws
+    };
+    ref_type names_ref = write_root(0, m_group.m_table_names.get_ref()); // Throws
+    ref_type tables_ref = write_root(1, m_group.m_tables.get_ref());     // Throws
 
     int_fast64_t value_1 = from_ref(names_ref);
     int_fast64_t value_2 = from_ref(tables_ref);
@@ -348,12 +372,14 @@ ref_type GroupWriter::write_group()
         // In nonshared mode, history must already have been discarded by GroupWriter constructor.
         REALM_ASSERT(is_shared);
         if (ref_type history_ref = top.get_as_ref(8)) {
-            Allocator& alloc = top.get_alloc();
-            ref_type new_history_ref = Array::write(history_ref, alloc, *this, only_if_modified); // Throws
+            ref_type new_history_ref = write_root(2, history_ref); // Throws
             int_fast64_t value_3 = from_ref(new_history_ref);
             top.set(8, value_3); // Throws
         }
     }
+    if (m_evacuation_limit && !m_evacuation_suspended)
+        m_evacuation_progress->clear();
+    m_evacuation_progress = nullptr;
 
 #if REALM_ALLOC_DEBUG
     std::cout << "    Freelist size after allocations: " << m_size_map.size() << std::endl;
@@ -384,6 +410,7 @@ ref_type GroupWriter::write_group()
 #endif
     max_free_list_size += free_read_only_size;
     max_free_list_size += m_not_free_in_file.size();
+    max_free_list_size += m_free_beyond_limit.size();
     // The final allocation of free space (i.e., the call to
     // reserve_free_space() below) may add extra entries to the free-lists.
     // We reserve room for the worst case scenario, which is as follows:
@@ -402,10 +429,19 @@ ref_type GroupWriter::write_group()
     // bigger databases the space required for free lists will be relatively less.
     max_free_list_size += 10;
 
+    // The commit record is kept in the free-lists as space released by this
+    // commit, so that it is not overwritten before the next commit is durable.
+    size_t max_record_size = 0;
+    if (m_commit_checksum) {
+        max_free_list_size += 1;
+        max_record_size = Array::get_max_byte_size(2 * (m_written_ranges.size() + 1));
+    }
+
     // If current size is less than 128 MB, the database need not expand above 2 GB
     // which means that the positions and sizes can still be in 32 bit.
     int size_per_entry = ((top.get(2) >> 1) < 0x8000000 ? 8 : 16) + (is_shared ? 8 : 0);
-    size_t max_free_space_needed = Array::get_max_byte_size(top.size()) + size_per_entry * max_free_list_size;
+    size_t max_free_space_needed =
+        Array::get_max_byte_size(top.size()) + size_per_entry * max_free_list_size + max_record_size;
 
 #if REALM_ALLOC_DEBUG
     std::cout << "    Allocating file space for freelists:" << std::endl;
@@ -415,8 +451,8 @@ ref_type GroupWriter::write_group()
     // using the maximum size possible, we still do not end up with a zero size
     // free-space chunk as we deduct the actually used size from it.
     auto reserve = reserve_free_space(max_free_space_needed + 8); // Throws
-    size_t reserve_pos = reserve->second;
-    size_t reserve_size = reserve->first;
+    size_t reserve_pos = m_size_map.get_ref(reserve);
+    size_t reserve_size = m_size_map.get_size(reserve);
 
     // At this point we have allocated all the space we need, so we can add to
     // the free-lists any free space created during the current transaction (or
@@ -429,6 +465,14 @@ ref_type GroupWriter::write_group()
     // Function returns index of element holding the space reserved for the free
     // lists in the file.
     size_t reserve_ndx = recreate_freelist(reserve_pos);
+    if (m_commit_checksum) {
+        // Placeholder for the commit record, which goes right before what is
+        // left of the reserved chunk. The final values are not larger.
+        m_free_positions.insert(reserve_ndx, int_fast64_t(reserve_pos));       // Throws
+        m_free_lengths.insert(reserve_ndx, int_fast64_t(max_record_size));     // Throws
+        m_free_versions.insert(reserve_ndx, int_fast64_t(m_current_version)); // Throws
+        ++reserve_ndx;
+    }
 
 #if REALM_ALLOC_DEBUG
     std::cout << "    Freelist size after merge: " << m_free_positions.size()
@@ -482,6 +526,31 @@ ref_type GroupWriter::write_group()
     // Get final sizes
     size_t top_byte_size = top.get_byte_size();
     ref_type end_ref = top_ref + top_byte_size;
+
+    // The commit record lists every range written by this commit, except for
+    // the top array and the record itself, which are covered by the checksum
+    // implicitly.
+    Array record(Allocator::get_default());
+    _impl::DestroyGuard<Array> record_guard;
+    ref_type record_ref = end_ref;
+    size_t record_size = 0;
+    if (m_commit_checksum) {
+        record.create(Array::type_Normal); // Throws
+        record_guard.reset(&record);
+        for (const auto& range : m_written_ranges) {
+            record.add(int_fast64_t(range.first));  // Throws
+            record.add(int_fast64_t(range.second)); // Throws
+        }
+        record.add(int_fast64_t(free_positions_ref));            // Throws
+        record.add(int_fast64_t(top_ref - free_positions_ref)); // Throws
+        record_size = record.get_byte_size();
+        REALM_ASSERT_3(record_size, <=, max_record_size);
+        end_ref += record_size;
+        m_free_positions.set(reserve_ndx - 1, int_fast64_t(record_ref)); // Throws
+        m_free_lengths.set(reserve_ndx - 1, int_fast64_t(record_size));  // Throws
+        m_free_space_size += record_size;
+        m_locked_space_size += record_size;
+    }
     REALM_ASSERT_3(size_t(end_ref), <=, reserve_pos + max_free_space_needed);
 
     // Deduct the used space from the reserved chunk. Note that we have made
@@ -516,12 +585,103 @@ ref_type GroupWriter::write_group()
 
     // Write top
     write_array_at(window, top_ref, top.get_header(), top_byte_size); // Throws
+
+    if (m_commit_checksum) {
+        write_array_at(window, record_ref, record.get_header(), record_size); // Throws
+        char* record_addr = window->translate(record_ref);
+        m_checksum.update(start_addr, top_ref - free_positions_ref);
+        m_checksum.update_array(window->translate(top_ref), top_byte_size);
+        m_checksum.update_array(record_addr, record_size);
+        uint32_t checksum = m_checksum.get();
+        memcpy(record_addr, &checksum, sizeof checksum);
+    }
     window->encryption_write_barrier(start_addr, used);
     // Return top_ref so that it can be saved in lock file used for coordination
     return top_ref;
 }
 
 
+ref_type GroupWriter::write_tree(ref_type ref, bool on_progress_path)
+{
+    bool modified = !m_alloc.is_read_only(ref);
+    if (!modified) {
+        if (m_evacuation_limit == 0)
+            return ref;
+        if (m_evacuation_work >= m_evacuation_work_limit) {
+            if (!m_evacuation_suspended) {
+                *m_evacuation_progress = m_evacuation_path;
+                m_evacuation_suspended = true;
+            }
+            return ref;
+        }
+    }
+
+    Array array(m_alloc);
+    array.init_from_ref(ref);
+    bool move = !modified && ref >= m_evacuation_limit;
+    if (!modified)
+        m_evacuation_work += array.get_byte_size();
+
+    if (!array.has_refs()) {
+        if (!modified && !move)
+            return ref;
+        ref_type new_ref = array.write(*this, false, false); // Throws
+        if (move) {
+            m_evacuated_size += array.get_byte_size();
+            m_alloc.free_(ref, array.get_header());
+        }
+        return new_ref;
+    }
+
+    // Children before the progress position of an unmodified node were
+    // visited by a previous commit
+    const std::vector<size_t>& progress = *m_evacuation_progress;
+    size_t depth = m_evacuation_path.size();
+    bool resume = on_progress_path && progress.size() > depth;
+    size_t start = resume ? progress[depth] : 0;
+
+    // The copy is only made once it is known to be needed
+    Array new_array(Allocator::get_default());
+    _impl::ShallowArrayDestroyGuard dg;
+    size_t n = array.size();
+    auto make_copy = [&](size_t num_values) {
+        Array::Type type = array.is_inner_bptree_node() ? Array::type_InnerBptreeNode : Array::type_HasRefs;
+        new_array.create(type, array.get_context_flag()); // Throws
+        dg.reset(&new_array);
+        for (size_t i = 0; i < num_values; ++i)
+            new_array.add(array.get(i)); // Throws
+    };
+    if (modified || move)
+        make_copy(0); // Throws
+
+    m_evacuation_path.push_back(0);
+    for (size_t i = 0; i < n; ++i) {
+        int_fast64_t value = array.get(i);
+        bool is_ref = (value != 0 && (value & 1) == 0);
+        if (is_ref && (i >= start || !m_alloc.is_read_only(to_ref(value)))) {
+            m_evacuation_path.back() = i;
+            ref_type new_subref = write_tree(to_ref(value), resume && i == start); // Throws
+            if (!new_array.is_attached() && new_subref != to_ref(value))
+                make_copy(i); // Throws
+            value = from_ref(new_subref);
+        }
+        if (new_array.is_attached())
+            new_array.add(value); // Throws
+    }
+    m_evacuation_path.pop_back();
+
+    if (!new_array.is_attached())
+        return ref;
+    ref_type new_ref = new_array.write(*this, false, false); // Throws
+    if (!modified) {
+        if (move)
+            m_evacuated_size += array.get_byte_size();
+        m_alloc.free_(ref, array.get_header());
+    }
+    return new_ref;
+}
+
+
 void GroupWriter::read_in_freelist()
 {
     FreeList free_in_file;
@@ -566,23 +726,54 @@ void GroupWriter::read_in_freelist()
     }
 
     free_in_file.merge_adjacent_entries_in_freelist();
-    // Previous step produces - potentially - some entries with size of zero. These
+    if (m_trimming)
+        trim_free_tail(free_in_file);
+    if (m_evacuation_limit) {
+        for (auto& elem : free_in_file) {
+            if (elem.size == 0 || elem.ref + elem.size <= m_evacuation_limit)
+                continue;
+            size_t ref = std::max(elem.ref, m_evacuation_limit);
+            m_free_beyond_limit.emplace_back(ref, elem.ref + elem.size - ref);
+            elem.size = ref - elem.ref;
+        }
+    }
+    // Previous steps produce - potentially - some entries with size of zero. These
     // entries will be skipped in the next step.
     free_in_file.move_free_in_file_to_size_map(m_size_map);
 }
 
+void GroupWriter::trim_free_tail(FreeList& free_in_file)
+{
+    size_t logical_file_size = get_logical_file_size();
+    auto last = std::find_if(free_in_file.rbegin(), free_in_file.rend(), [](auto& elem) {
+        return elem.size != 0;
+    });
+    if (last == free_in_file.rend() || last->ref + last->size != logical_file_size ||
+        last->size < logical_file_size / 4)
+        return;
+    size_t new_file_size = util::round_up_to_page_size(last->ref);
+    if (new_file_size >= logical_file_size)
+        return;
+    last->size = new_file_size - last->ref;
+    m_group.m_top.set(2, 1 + 2 * uint64_t(new_file_size)); // Throws
+}
+
 size_t GroupWriter::recreate_freelist(size_t reserve_pos)
 {
     std::vector<FreeSpaceEntry> free_in_file;
     auto& new_free_space = m_group.m_alloc.get_free_read_only(); // Throws
-    auto nb_elements = m_size_map.size() + m_not_free_in_file.size() + new_free_space.size();
+    auto nb_elements =
+        m_size_map.size() + m_free_beyond_limit.size() + m_not_free_in_file.size() + new_free_space.size();
     free_in_file.reserve(nb_elements);
 
     size_t reserve_ndx = realm::npos;
     bool is_shared = m_group.m_is_shared;
 
-    for (const auto& entry : m_size_map) {
-        free_in_file.emplace_back(entry.second, entry.first, 0);
+    m_size_map.for_each([&](size_t ref, size_t size) {
+        free_in_file.emplace_back(ref, size, 0);
+    });
+    for (const auto& free_space : m_free_beyond_limit) {
+        free_in_file.emplace_back(free_space.first, free_space.second, 0);
     }
 
     {
@@ -601,6 +792,8 @@ size_t GroupWriter::recreate_freelist(size_t reserve_pos)
     }
 
     REALM_ASSERT(free_in_file.size() == nb_elements);
+    // The free-list is stored in order of position, and the chunks come out
+    // of the size bins in no particular order
     std::sort(begin(free_in_file), end(free_in_file), [](auto& a, auto& b) { return a.ref < b.ref; });
 
     {
@@ -671,18 +864,114 @@ void GroupWriter::FreeList::merge_adjacent_entries_in_freelist()
     }
 }
 
-void GroupWriter::FreeList::move_free_in_file_to_size_map(std::multimap<size_t, size_t>& size_map)
+void GroupWriter::FreeList::move_free_in_file_to_size_map(FreeSpaceBins& size_map)
 {
+    size_map.reserve(size());
     for (auto& elem : *this) {
         // Skip elements merged in 'merge_adjacent_entries_in_freelist'
         if (elem.size) {
             REALM_ASSERT_RELEASE_EX(!(elem.size & 7), elem.size);
             REALM_ASSERT_RELEASE_EX(!(elem.ref & 7), elem.ref);
-            size_map.emplace(elem.size, elem.ref);
+            size_map.add(elem.ref, elem.size); // Throws
         }
     }
 }
 
+GroupWriter::FreeSpaceBins::FreeSpaceBins()
+    : m_bins(get_bin(std::numeric_limits<size_t>::max() & ~size_t(7)) + 1)
+{
+}
+
+size_t GroupWriter::FreeSpaceBins::get_bin(size_t size) noexcept
+{
+    REALM_ASSERT_DEBUG(size >= 8 && !(size & 7));
+    if (size <= s_small_limit)
+        return size / 8 - 1;
+    size_t log = size_t(realm::log2(size));
+    size_t sub_bin = (size >> (log - 2)) & 3;
+    return s_num_small_bins + (log - size_t(realm::log2(s_small_limit))) * 4 + sub_bin;
+}
+
+void GroupWriter::FreeSpaceBins::reserve(size_t num_chunks)
+{
+    m_chunks.reserve(num_chunks); // Throws
+}
+
+auto GroupWriter::FreeSpaceBins::add(size_t ref, size_t size) -> Handle
+{
+    REALM_ASSERT_RELEASE_EX(size && !(size & 7), size);
+    Handle h;
+    if (m_unused.empty()) {
+        h = m_chunks.size();
+        m_chunks.push_back({}); // Throws
+    }
+    else {
+        h = m_unused.back();
+        m_unused.pop_back();
+    }
+    auto& bin = m_bins[get_bin(size)];
+    m_chunks[h] = {ref, size, bin.size()};
+    bin.push_back(h); // Throws
+    return h;
+}
+
+void GroupWriter::FreeSpaceBins::remove(Handle h)
+{
+    Chunk& chunk = m_chunks[h];
+    auto& bin = m_bins[get_bin(chunk.size)];
+    Handle last = bin.back();
+    bin[chunk.pos_in_bin] = last;
+    m_chunks[last].pos_in_bin = chunk.pos_in_bin;
+    bin.pop_back();
+    chunk.size = 0;
+    m_unused.push_back(h); // Throws
+}
+
+template <class F>
+auto GroupWriter::FreeSpaceBins::find(size_t size, F find_section, size_t& section_pos) const -> Handle
+{
+    // A chunk of the exact size is always preferred. Small sizes have a bin
+    // of their own, larger ones share it with chunks of nearby sizes.
+    for (Handle h : m_bins[get_bin(size)]) {
+        if (m_chunks[h].size == size) {
+            if (size_t pos = find_section(h)) {
+                section_pos = pos;
+                return h;
+            }
+        }
+    }
+
+    // Otherwise take the smallest chunk of at least twice the size. The bins
+    // are ordered by size class, so the first bin holding a usable chunk
+    // holds the smallest one.
+    for (size_t b = get_bin(2 * size); b < m_bins.size(); ++b) {
+        Handle best = end;
+        size_t best_size = std::numeric_limits<size_t>::max();
+        for (Handle h : m_bins[b]) {
+            size_t chunk_size = m_chunks[h].size;
+            if (chunk_size < 2 * size || chunk_size >= best_size)
+                continue;
+            if (size_t pos = find_section(h)) {
+                best = h;
+                best_size = chunk_size;
+                section_pos = pos;
+            }
+        }
+        if (best != end)
+            return best;
+    }
+    return end;
+}
+
+template <class F>
+void GroupWriter::FreeSpaceBins::for_each(F func) const
+{
+    for (auto& chunk : m_chunks) {
+        if (chunk.size)
+            func(chunk.ref, chunk.size);
+    }
+}
+
 size_t GroupWriter::get_free_space(size_t size)
 {
     REALM_ASSERT_3(size % 8, ==, 0); // 8-byte alignment
@@ -690,20 +979,20 @@ size_t GroupWriter::get_free_space(size_t size)
     auto p = reserve_free_space(size);
 
     // Claim space from identified chunk
-    size_t chunk_pos = p->second;
-    size_t chunk_size = p->first;
+    size_t chunk_pos = m_size_map.get_ref(p);
+    size_t chunk_size = m_size_map.get_size(p);
     REALM_ASSERT_3(chunk_size, >=, size);
     REALM_ASSERT_RELEASE_EX(!(chunk_pos & 7), chunk_pos);
     REALM_ASSERT_RELEASE_EX(!(chunk_size & 7), chunk_size);
 
     size_t rest = chunk_size - size;
-    m_size_map.erase(p);
+    m_size_map.remove(p);
     if (rest > 0) {
         // Allocating part of chunk - this alway happens from the beginning
         // of the chunk. The call to reserve_free_space may split chunks
         // in order to make sure that it returns a chunk from which allocation
         // can be done from the beginning
-        m_size_map.emplace(rest, chunk_pos + size);
+        m_size_map.add(chunk_pos + size, rest); // Throws
     }
     return chunk_pos;
 }
@@ -711,34 +1000,39 @@ size_t GroupWriter::get_free_space(size_t size)
 
 inline GroupWriter::FreeListElement GroupWriter::split_freelist_chunk(FreeListElement it, size_t alloc_pos)
 {
-    size_t start_pos = it->second;
-    size_t chunk_size = it->first;
-    m_size_map.erase(it);
+    size_t start_pos = m_size_map.get_ref(it);
+    size_t chunk_size = m_size_map.get_size(it);
+    m_size_map.remove(it);
     REALM_ASSERT_RELEASE_EX(alloc_pos > start_pos, alloc_pos, start_pos);
 
     REALM_ASSERT_RELEASE_EX(!(alloc_pos & 7), alloc_pos);
     size_t size_first = alloc_pos - start_pos;
     size_t size_second = chunk_size - size_first;
-    m_size_map.emplace(size_first, start_pos);
-    return m_size_map.emplace(size_second, alloc_pos);
+    m_size_map.add(start_pos, size_first);         // Throws
+    return m_size_map.add(alloc_pos, size_second); // Throws
 }
 
 GroupWriter::FreeListElement GroupWriter::search_free_space_in_free_list_element(FreeListElement it, size_t size)
 {
     SlabAlloc& alloc = m_group.m_alloc;
-    size_t chunk_size = it->first;
+    size_t chunk_size = m_size_map.get_size(it);
 
     // search through the chunk, finding a place within it,
     // where an allocation will not cross a mmap boundary
-    size_t start_pos = it->second;
+    size_t start_pos = m_size_map.get_ref(it);
     size_t alloc_pos = alloc.find_section_in_range(start_pos, chunk_size, size);
     if (alloc_pos == 0) {
-        return m_size_map.end();
+        return FreeSpaceBins::end;
     }
+    return allocate_from_free_list_element(it, alloc_pos);
+}
+
+GroupWriter::FreeListElement GroupWriter::allocate_from_free_list_element(FreeListElement it, size_t alloc_pos)
+{
     // we found a place - if it's not at the beginning of the chunk,
     // we split the chunk so that the allocation can be done from the
     // beginning of the second chunk.
-    if (alloc_pos != start_pos) {
+    if (alloc_pos != m_size_map.get_ref(it)) {
         it = split_freelist_chunk(it, alloc_pos);
     }
     // Match found!
@@ -747,31 +1041,37 @@ GroupWriter::FreeListElement GroupWriter::search_free_space_in_free_list_element
 
 GroupWriter::FreeListElement GroupWriter::search_free_space_in_part_of_freelist(size_t size)
 {
-    auto it = m_size_map.lower_bound(size);
-    while (it != m_size_map.end()) {
-        // Accept either a perfect match or a block that is twice the size. Tests have shown
-        // that this is a good strategy.
-        if (it->first == size || it->first >= 2 * size) {
-            auto ret = search_free_space_in_free_list_element(it, size);
-            if (ret != m_size_map.end()) {
-                return ret;
-            }
-            ++it;
-        }
-        else {
-            // If block was too small, search for the first that is at least twice as big.
-            it = m_size_map.lower_bound(2 * size);
-        }
-    }
-    // No match
-    return m_size_map.end();
+    // Accept either a perfect match or a block that is twice the size. Tests have shown
+    // that this is a good strategy.
+    SlabAlloc& alloc = m_group.m_alloc;
+    size_t alloc_pos = 0;
+    auto it = m_size_map.find(
+        size,
+        [&](FreeListElement h) {
+            return alloc.find_section_in_range(m_size_map.get_ref(h), m_size_map.get_size(h), size);
+        },
+        alloc_pos);
+    if (it == FreeSpaceBins::end)
+        return it;
+    return allocate_from_free_list_element(it, alloc_pos);
 }
 
 
 GroupWriter::FreeListElement GroupWriter::reserve_free_space(size_t size)
 {
     auto chunk = search_free_space_in_part_of_freelist(size);
-    while (chunk == m_size_map.end()) {
+    if (chunk == FreeSpaceBins::end && !m_free_beyond_limit.empty()) {
+        // Using the space beyond the evacuation limit is better than growing
+        // the file, but there is no point in moving anything more
+        for (const auto& free_space : m_free_beyond_limit) {
+            m_size_map.add(free_space.first, free_space.second); // Throws
+        }
+        m_free_beyond_limit.clear();
+        m_evacuation_aborted = true;
+        m_evacuation_work_limit = 0;
+        chunk = search_free_space_in_part_of_freelist(size);
+    }
+    while (chunk == FreeSpaceBins::end) {
         // No free space, so we have to extend the file.
         auto new_chunk = extend_free_space(size);
         chunk = search_free_space_in_free_list_element(new_chunk, size);
@@ -847,7 +1147,7 @@ GroupWriter::FreeListElement GroupWriter::extend_free_space(size_t requested_siz
     size_t chunk_size = new_file_size - logical_file_size;
     REALM_ASSERT_RELEASE_EX(!(chunk_size & 7), chunk_size);
     REALM_ASSERT_RELEASE(chunk_size != 0);
-    auto it = m_size_map.emplace(chunk_size, logical_file_size);
+    auto it = m_size_map.add(logical_file_size, chunk_size); // Throws
 
     // Update the logical file size
     m_group.m_top.set(2, 1 + 2 * uint64_t(new_file_size)); // Throws
@@ -873,6 +1173,15 @@ ref_type GroupWriter::write_array(const char* data, size_t size, uint32_t checks
     window->encryption_read_barrier(dest_addr, size);
     memcpy(dest_addr, &checksum, 4);
     memcpy(dest_addr + 4, data + 4, size - 4);
+    if (m_commit_checksum) {
+        m_checksum.update(dest_addr, size);
+        if (!m_written_ranges.empty() && m_written_ranges.back().first + m_written_ranges.back().second == pos) {
+            m_written_ranges.back().second += size;
+        }
+        else {
+            m_written_ranges.emplace_back(pos, size); // Throws
+        }
+    }
     window->encryption_write_barrier(dest_addr, size);
     // return ref of the written array
     ref_type ref = to_ref(pos);
@@ -898,42 +1207,82 @@ void GroupWriter::write_array_at(MapWindow* window, ref_type ref, const char* da
 void GroupWriter::commit(ref_type new_top_ref)
 {
     MapWindow* window = get_window(0, sizeof(SlabAlloc::Header));
-    SlabAlloc::Header& file_header = *reinterpret_cast<SlabAlloc::Header*>(window->translate(0));
-    window->encryption_read_barrier(&file_header, sizeof file_header);
+
+    // When running the test suite, device synchronization is disabled
+    bool disable_sync = get_disable_sync_to_disk() || m_durability == Durability::Unsafe;
+
+#if REALM_METRICS
+    std::unique_ptr<MetricTimer> fsync_timer = Metrics::report_fsync_time(m_group);
+#endif // REALM_METRICS
+
+    // The header window is one of the cached windows, so it is synced along
+    // with the data when the commit needs only a single sync
+    write_top_ref(*window, new_top_ref, m_group.get_file_format_version(), disable_sync, m_commit_checksum, [&] {
+        sync_all_mappings();
+    });
+}
+
+
+void GroupWriter::select_snapshot(SlabAlloc& alloc, ref_type top_ref, int file_format_version)
+{
+    // When running the test suite, device synchronization is disabled
+    bool disable_sync = get_disable_sync_to_disk();
+    MapWindow window(page_size(), alloc.get_file(), 0, sizeof(SlabAlloc::Header));
+    bool commit_checksum = false;
+    write_top_ref(window, top_ref, file_format_version, disable_sync, commit_checksum, [&] {
+        // The snapshot was written by earlier commits, possibly through
+        // mappings which no longer exist, so the whole file must be flushed
+        alloc.get_file().sync(); // Throws
+    });
+}
+
+
+void GroupWriter::write_top_ref(MapWindow& window, ref_type new_top_ref, int file_format_version, bool disable_sync,
+                                bool commit_checksum, util::FunctionRef<void()> sync_data)
+{
+    SlabAlloc::Header& file_header = *reinterpret_cast<SlabAlloc::Header*>(window.translate(0));
+    window.encryption_read_barrier(&file_header, sizeof file_header);
 
     // One bit of the flags field selects which of the two top ref slots are in
     // use (same for file format version slots). The current value of the bit
     // reflects the currently bound snapshot, so we need to invert it for the
-    // new snapshot. Other bits must remain unchanged.
+    // new snapshot. Another bit tells whether the new snapshot has a commit
+    // record. Other bits must remain unchanged.
     unsigned old_flags = file_header.m_flags;
     unsigned new_flags = old_flags ^ SlabAlloc::flags_SelectBit;
     int slot_selector = ((new_flags & SlabAlloc::flags_SelectBit) != 0 ? 1 : 0);
+    if (commit_checksum) {
+        new_flags |= SlabAlloc::flags_CommitChecksum;
+    }
+    else {
+        new_flags &= ~unsigned(SlabAlloc::flags_CommitChecksum);
+    }
+
+    // If the new commit turns out to be incomplete after a crash, the
+    // previous one is used instead, provided it can be validated itself. In
+    // that case there is no need to sync the data before the header.
+    int old_slot_selector = 1 - slot_selector;
+    bool single_sync = commit_checksum && (old_flags & SlabAlloc::flags_CommitChecksum) != 0 &&
+                       file_header.m_file_format[old_slot_selector] >= SlabAlloc::commit_record_file_format_version;
 
     // Update top ref and file format version
-    int file_format_version = m_group.get_file_format_version();
     using type_1 = std::remove_reference<decltype(file_header.m_file_format[0])>::type;
     REALM_ASSERT(!util::int_cast_has_overflow<type_1>(file_format_version));
     // only write the file format field if necessary (optimization)
     if (type_1(file_format_version) != file_header.m_file_format[slot_selector]) {
         file_header.m_file_format[slot_selector] = type_1(file_format_version);
-        window->encryption_write_barrier(&file_header.m_file_format[slot_selector],
-                                         sizeof(file_header.m_file_format[slot_selector]));
+        window.encryption_write_barrier(&file_header.m_file_format[slot_selector],
+                                        sizeof(file_header.m_file_format[slot_selector]));
     }
 
-    // When running the test suite, device synchronization is disabled
-    bool disable_sync = get_disable_sync_to_disk() || m_durability == Durability::Unsafe;
     file_header.m_top_ref[slot_selector] = new_top_ref;
 
-#if REALM_METRICS
-    std::unique_ptr<MetricTimer> fsync_timer = Metrics::report_fsync_time(m_group);
-#endif // REALM_METRICS
-
     // Make sure that that all data relating to the new snapshot is written to
     // stable storage before flipping the slot selector
-    window->encryption_write_barrier(&file_header.m_top_ref[slot_selector], 
-                                     sizeof(file_header.m_top_ref[slot_selector]));
-    if (!disable_sync)
-        sync_all_mappings();
+    window.encryption_write_barrier(&file_header.m_top_ref[slot_selector],
+                                    sizeof(file_header.m_top_ref[slot_selector]));
+    if (!disable_sync && !single_sync)
+        sync_data();
 
     // Flip the slot selector bit.
     using type_2 = std::remove_reference<decltype(file_header.m_flags)>::type;
@@ -941,9 +1290,15 @@ void GroupWriter::commit(ref_type new_top_ref)
 
     // Write new selector to disk
     // FIXME: we might optimize this to write of a single page?
-    window->encryption_write_barrier(&file_header.m_flags, sizeof(file_header.m_flags));
-    if (!disable_sync)
-        window->sync();
+    window.encryption_write_barrier(&file_header.m_flags, sizeof(file_header.m_flags));
+    if (!disable_sync) {
+        if (single_sync) {
+            sync_data();
+        }
+        else {
+            window.sync();
+        }
+    }
 }
 
 
@@ -21,10 +21,12 @@
 
 #include <cstdint> // unint8_t etc
 #include <utility>
-#include <map>
+#include <vector>
 
 #include <realm/util/file.hpp>
+#include <realm/util/function_ref.hpp>
 #include <realm/alloc.hpp>
+#include <realm/alloc_slab.hpp>
 #include <realm/impl/array_writer.hpp>
 #include <realm/array_integer.hpp>
 #include <realm/db_options.hpp>
@@ -58,6 +60,28 @@ public:
 
     void set_versions(uint64_t current, uint64_t read_lock) noexcept;
 
+    /// Write a commit record along with the new snapshot, from which
+    /// SlabAlloc can tell if all of the commit made it to disk. When the
+    /// previous commit was also written with a record, commit() then needs to
+    /// sync the file only once, as an interrupted commit is detected on open
+    /// and the previous snapshot is used instead. Requires transactional mode.
+    void enable_commit_checksum() noexcept;
+
+    /// Move the array nodes which lie at or beyond \a limit in the file to free
+    /// space below it, as part of write_group(), and do not allocate space at
+    /// or beyond it. Modified nodes are always written below the limit.
+    /// Unmodified nodes are visited in tree order, starting from the position
+    /// in \a progress, until the combined size of the visited nodes reaches
+    /// \a work_limit. \a progress is then set to where the next commit should
+    /// continue, or cleared if the end of the group was reached. If there is not
+    /// enough free space below the limit, space beyond it is used after all,
+    /// and evacuation_aborted() returns true.
+    void set_evacuation(size_t limit, size_t work_limit, std::vector<size_t>& progress) noexcept;
+
+    /// Allow write_group() to reduce the logical file size, when a quarter or
+    /// more of the file at its end is free in every version still in use.
+    void enable_trimming() noexcept;
+
     /// Write all changed array nodes into free space.
     ///
     /// Returns the new top ref. When in full durability mode, call
@@ -69,6 +93,12 @@ public:
     /// returned by write_group().
     void commit(ref_type new_top_ref);
 
+    /// Flush the file to physical medium, then select the specified top ref
+    /// in the file header, then flush again. For use when commits have
+    /// written their data without calling commit(). The caller must hold the
+    /// write lock.
+    static void select_snapshot(SlabAlloc&, ref_type top_ref, int file_format_version);
+
     size_t get_file_size() const noexcept;
 
     ref_type write_array(const char*, size_t, uint32_t) override;
@@ -87,6 +117,20 @@ public:
         return m_locked_space_size;
     }
 
+    size_t get_logical_file_size() const noexcept;
+
+    /// The size of the nodes moved by write_group() because of the evacuation
+    /// limit.
+    size_t get_evacuated_size() const noexcept
+    {
+        return m_evacuated_size;
+    }
+
+    bool evacuation_aborted() const noexcept
+    {
+        return m_evacuation_aborted;
+    }
+
 private:
     class MapWindow;
     Group& m_group;
@@ -112,21 +156,94 @@ private:
         size_t size;
         uint64_t released_at_version;
     };
+    // The chunks of free space available for allocation during the commit,
+    // segregated into bins by size class. Sizes up to 1KiB have a bin of
+    // their own, larger sizes are divided into 4 bins per power of two, so
+    // finding a chunk only needs to look through one or two bins instead of
+    // searching all of the free space.
+    class FreeSpaceBins {
+    public:
+        using Handle = size_t;
+        static constexpr Handle end = Handle(-1);
+
+        FreeSpaceBins();
+        Handle add(size_t ref, size_t size);
+        void remove(Handle);
+        size_t get_ref(Handle h) const noexcept
+        {
+            return m_chunks[h].ref;
+        }
+        size_t get_size(Handle h) const noexcept
+        {
+            return m_chunks[h].size;
+        }
+        size_t size() const noexcept
+        {
+            return m_chunks.size() - m_unused.size();
+        }
+        void reserve(size_t num_chunks);
+
+        // Find a chunk which is either exactly 'size' bytes, or else the
+        // smallest one at least twice as big, for which find_section(handle)
+        // returns a non-zero position. That position is stored in
+        // 'section_pos'.
+        template <class F>
+        Handle find(size_t size, F find_section, size_t& section_pos) const;
+
+        template <class F>
+        void for_each(F func) const;
+
+    private:
+        struct Chunk {
+            size_t ref;
+            size_t size; // Zero for unused entries
+            size_t pos_in_bin;
+        };
+        std::vector<Chunk> m_chunks;
+        std::vector<Handle> m_unused;
+        std::vector<std::vector<Handle>> m_bins;
+
+        static constexpr size_t s_small_limit = 1024;
+        static constexpr size_t s_num_small_bins = s_small_limit / 8;
+        static size_t get_bin(size_t size) noexcept;
+    };
     class FreeList : public std::vector<FreeSpaceEntry> {
     public:
         FreeList() = default;
         // Merge adjacent chunks
         void merge_adjacent_entries_in_freelist();
-        // Copy free space entries to structure where entries are sorted by size
-        void move_free_in_file_to_size_map(std::multimap<size_t, size_t>& size_map);
+        // Copy free space entries to structure where entries are binned by size
+        void move_free_in_file_to_size_map(FreeSpaceBins& size_map);
     };
     //  m_free_in_file;
     std::vector<FreeSpaceEntry> m_not_free_in_file;
-    std::multimap<size_t, size_t> m_size_map;
-    using FreeListElement = std::multimap<size_t, size_t>::iterator;
+    FreeSpaceBins m_size_map;
+    using FreeListElement = FreeSpaceBins::Handle;
+
+    // Evacuation state, see set_evacuation(). m_evacuation_path holds the
+    // position of the node being written, as indexes of the root and of each
+    // child on the way to it.
+    size_t m_evacuation_limit = 0;
+    size_t m_evacuation_work_limit = 0;
+    size_t m_evacuation_work = 0;
+    size_t m_evacuated_size = 0;
+    bool m_evacuation_aborted = false;
+    bool m_evacuation_suspended = false;
+    std::vector<size_t>* m_evacuation_progress = nullptr;
+    std::vector<size_t> m_evacuation_path;
+    // Free space at or beyond the evacuation limit, kept out of m_size_map
+    std::vector<std::pair<size_t, size_t>> m_free_beyond_limit;
+    bool m_trimming = false;
 
     void read_in_freelist();
     size_t recreate_freelist(size_t reserve_pos);
+    // Remove the free space at the end of the file from the free list and
+    // reduce the logical file size accordingly, if it is big enough
+    void trim_free_tail(FreeList&);
+    // Write the node tree at 'ref' as Array::write() does when only writing
+    // modified nodes, but also move nodes beyond the evacuation limit. Returns
+    // the new ref.
+    ref_type write_tree(ref_type ref, bool on_progress_path);
     // Currently cached memory mappings. We keep as many as 16 1MB windows
     // open for writing. The allocator will favor sequential allocation
     // from a modest number of windows, depending upon fragmentation, so
@@ -144,6 +261,20 @@ private:
     // Sync all cached memory mappings
     void sync_all_mappings();
 
+    bool m_commit_checksum = false;
+    SlabAlloc::CommitChecksum m_checksum;
+    // Ranges written by write_array() during the commit, in the order they
+    // were written. Adjacent ranges are merged.
+    std::vector<std::pair<size_t, size_t>> m_written_ranges;
+
+    // Write the top ref and file format version into the unused slot of the
+    // file header, call sync_data(), then flip the slot selector and sync the
+    // header. If 'commit_checksum' is set and the currently selected commit
+    // has a commit record too, the slot selector is flipped right away and
+    // only sync_data() is called, so it must cover the header as well.
+    static void write_top_ref(MapWindow& header_window, ref_type new_top_ref, int file_format_version,
+                              bool disable_sync, bool commit_checksum, util::FunctionRef<void()> sync_data);
+
     /// Allocate a chunk of free space of the specified size. The
     /// specified size must be 8-byte aligned. Extend the file if
     /// required. The returned chunk is removed from the amount of
@@ -167,6 +298,7 @@ private:
     FreeListElement reserve_free_space(size_t size);
 
     FreeListElement search_free_space_in_free_list_element(FreeListElement element, size_t size);
+    FreeListElement allocate_from_free_list_element(FreeListElement element, size_t alloc_pos);
 
     /// Search only a range of the free list for a block as big as the
     /// specified size. Return a pair with index and size of the found chunk.
@@ -197,6 +329,19 @@ inline void GroupWriter::set_versions(uint64_t current, uint64_t read_lock) noex
     m_readlock_version = read_lock;
 }
 
+inline void GroupWriter::set_evacuation(size_t limit, size_t work_limit, std::vector<size_t>& progress) noexcept
+{
+    REALM_ASSERT(limit % 8 == 0);
+    m_evacuation_limit = limit;
+    m_evacuation_work_limit = work_limit;
+    m_evacuation_progress = &progress;
+}
+
+inline void GroupWriter::enable_trimming() noexcept
+{
+    m_trimming = true;
+}
+
 } // namespace realm
 
 #endif // REALM_GROUP_WRITER_HPP
@@ -21,6 +21,8 @@
 #include <realm/db.hpp>
 #include <realm/replication.hpp>
 #include <realm/history.hpp>
+#include <realm/util/buffer.hpp>
+#include <realm/util/compression.hpp>
 
 using namespace realm;
 
@@ -28,7 +30,19 @@ using namespace realm;
 namespace {
 
 // As new schema versions come into existence, describe them here.
-constexpr int g_history_schema_version = 0;
+//
+//  0  Initial version
+//
+//  1  History entries may be compressed. A compressed entry starts with a zero
+//     byte, which can not start a changeset, followed by the size of the
+//     changeset as a base 128 varint, and then the block produced by
+//     util::compression::compress(). Other entries are stored as they are.
+constexpr int g_history_schema_version = 1;
+
+// Changesets smaller than this are stored uncompressed
+constexpr size_t g_min_compressed_changeset_size = 64;
+
+constexpr char g_compressed_changeset_marker = 0;
 
 
 /// This class is a basis for implementing the Replication API for the purpose
@@ -41,9 +55,10 @@ constexpr int g_history_schema_version = 0;
 /// History::update_early_from_top_ref()).
 class InRealmHistory : public _impl::History {
 public:
-    void initialize(Allocator* alloc)
+    void initialize(Allocator* alloc, bool compress_changesets)
     {
         m_alloc = alloc;
+        m_compress_changesets = compress_changesets;
         m_base_version = 0;
         m_size = 0;
         m_changesets = nullptr;
@@ -79,13 +94,18 @@ public:
     void update_from_ref_and_version(ref_type, version_type) override;
     // void update_early_from_top_ref(version_type, size_t, ref_type) override;
     // void update_from_parent(version_type) override;
-    void get_changesets(version_type, version_type, BinaryIterator*) const noexcept override;
+    void get_changesets(version_type, version_type, BinaryIterator*) const override;
+    version_type get_oldest_available_version() const noexcept override
+    {
+        return m_base_version;
+    }
     void set_oldest_bound_version(version_type) override;
 
     void verify() const override;
 
 private:
     Allocator* m_alloc = nullptr;
+    bool m_compress_changesets = false;
     /// Version on which the first changeset in the history is based, or if the
     /// history is empty, the version associatede with currently bound
     /// snapshot. In general, the version associatede with currently bound
@@ -110,9 +130,65 @@ private:
     /// dynamically allocated root node accessor, and the type of the required
     /// root node accessor depends on the size of the B+-tree.
     std::unique_ptr<BinaryColumn> m_changesets;
+
+    /// Buffer for compressing the added changeset
+    util::AppendBuffer<char> m_compressed;
+
+    /// The compressed entries passed out by the latest call to
+    /// get_changesets(), decompressed. The compressed data of an entry stored
+    /// in more than one chunk is collected in m_compressed_entry.
+    mutable std::vector<util::AppendBuffer<char>> m_decompressed;
+    mutable util::AppendBuffer<char> m_compressed_entry;
+
+    /// Returns false if the changeset does not compress well enough to be
+    /// worth it.
+    bool compress(BinaryData changeset);
+    BinaryData decompress(BinaryData entry, util::AppendBuffer<char>& buffer) const;
 };
 
 
+bool InRealmHistory::compress(BinaryData changeset)
+{
+    size_t size = changeset.size();
+    // The compressed entry must be smaller than the changeset
+    m_compressed.resize(size); // Throws
+    char* out = m_compressed.data();
+    *out++ = g_compressed_changeset_marker;
+    for (size_t v = size; ; v >>= 7) {
+        if (v < 0x80) {
+            *out++ = char(v);
+            break;
+        }
+        *out++ = char(0x80 | (v & 0x7F));
+    }
+    size_t header_size = size_t(out - m_compressed.data());
+    size_t compressed_size = util::compression::compress(changeset.data(), size, out, size - header_size - 1);
+    if (compressed_size == 0)
+        return false;
+    m_compressed.resize(header_size + compressed_size);
+    return true;
+}
+
+
+BinaryData InRealmHistory::decompress(BinaryData entry, util::AppendBuffer<char>& buffer) const
+{
+    const char* in = entry.data() + 1;
+    const char* in_end = entry.data() + entry.size();
+    size_t size = 0;
+    for (int shift = 0;; shift += 7) {
+        REALM_ASSERT_RELEASE(in != in_end && shift < 64);
+        unsigned char b = static_cast<unsigned char>(*in++);
+        size |= size_t(b & 0x7F) << shift;
+        if (b < 0x80)
+            break;
+    }
+    buffer.resize(size); // Throws
+    bool valid = util::compression::decompress(in, size_t(in_end - in), buffer.data(), size);
+    REALM_ASSERT_RELEASE(valid);
+    return BinaryData(buffer.data(), size);
+}
+
+
 InRealmHistory::version_type InRealmHistory::add_changeset(BinaryData changeset)
 {
     prepare_for_write();
@@ -124,6 +200,10 @@ InRealmHistory::version_type InRealmHistory::add_changeset(BinaryData changeset)
     if (changeset.is_null()) {
         m_changesets->add(BinaryData("", 0)); // Throws
     }
+    else if (m_compress_changesets && changeset.size() >= g_min_compressed_changeset_size &&
+             compress(changeset)) { // Throws
+        m_changesets->add(BinaryData(m_compressed.data(), m_compressed.size())); // Throws
+    }
     else {
         m_changesets->add(changeset); // Throws
     }
@@ -134,7 +214,7 @@ InRealmHistory::version_type InRealmHistory::add_changeset(BinaryData changeset)
 
 
 void InRealmHistory::get_changesets(version_type begin_version, version_type end_version,
-                                    BinaryIterator* buffer) const noexcept
+                                    BinaryIterator* buffer) const
 {
     REALM_ASSERT(begin_version <= end_version);
     REALM_ASSERT(begin_version >= m_base_version);
@@ -145,8 +225,26 @@ void InRealmHistory::get_changesets(version_type begin_version, version_type end
                  !util::int_cast_has_overflow<size_t>(offset_version_type));
     size_t n = size_t(n_version_type);
     size_t offset = size_t(offset_version_type);
-    for (size_t i = 0; i < n; ++i)
-        buffer[i] = BinaryIterator(m_changesets.get(), offset + i);
+    if (m_decompressed.size() < n)
+        m_decompressed.resize(n); // Throws
+    for (size_t i = 0; i < n; ++i) {
+        BinaryIterator iter(m_changesets.get(), offset + i);
+        BinaryData entry = iter.get_next();
+        if (entry.size() == 0 || entry[0] != g_compressed_changeset_marker) {
+            buffer[i] = BinaryIterator(m_changesets.get(), offset + i);
+            continue;
+        }
+        // Entries larger than a blob are stored in several chunks
+        BinaryData chunk = iter.get_next();
+        if (chunk.size() > 0) {
+            m_compressed_entry.clear();
+            m_compressed_entry.append(entry.data(), entry.size()); // Throws
+            for (; chunk.size() > 0; chunk = iter.get_next())
+                m_compressed_entry.append(chunk.data(), chunk.size()); // Throws
+            entry = BinaryData(m_compressed_entry.data(), m_compressed_entry.size());
+        }
+        buffer[i] = BinaryIterator(decompress(entry, m_decompressed[i])); // Throws
+    }
 }
 
 
@@ -208,8 +306,9 @@ class InRealmHistoryImpl : public TrivialReplication {
 public:
     using version_type = TrivialReplication::version_type;
 
-    InRealmHistoryImpl(std::string realm_path)
+    InRealmHistoryImpl(std::string realm_path, bool compress_changesets)
         : TrivialReplication(realm_path)
+        , m_compress_changesets(compress_changesets)
     {
     }
 
@@ -217,7 +316,7 @@ public:
     {
         TrivialReplication::initialize(db); // Throws
         Allocator& alloc = db.get_alloc();
-        m_history.initialize(&alloc); // Throws
+        m_history.initialize(&alloc, m_compress_changesets); // Throws
     }
 
     void initiate_session(version_type) override
@@ -256,17 +355,15 @@ public:
 
     bool is_upgradable_history_schema(int stored_schema_version) const noexcept override
     {
-        // Never called because only one schema version exists so far.
-        static_cast<void>(stored_schema_version);
-        REALM_ASSERT(false);
-        return false;
+        return stored_schema_version == 0;
     }
 
     void upgrade_history_schema(int stored_schema_version) override
     {
-        // Never called because only one schema version exists so far.
+        // Uncompressed entries are valid in schema version 1, so there is
+        // nothing to convert.
         static_cast<void>(stored_schema_version);
-        REALM_ASSERT(false);
+        REALM_ASSERT(stored_schema_version == 0);
     }
 
     _impl::History* _get_history_write() override
@@ -277,11 +374,12 @@ public:
     std::unique_ptr<_impl::History> _create_history_read() override
     {
         auto hist = std::make_unique<InRealmHistory>();
-        hist->initialize(m_history.get_alloc());
+        hist->initialize(m_history.get_alloc(), m_compress_changesets);
         return std::move(hist);
     }
 
 private:
+    const bool m_compress_changesets;
     InRealmHistory m_history;
 };
 
@@ -290,9 +388,9 @@ private:
 
 namespace realm {
 
-std::unique_ptr<Replication> make_in_realm_history(const std::string& realm_path)
+std::unique_ptr<Replication> make_in_realm_history(const std::string& realm_path, bool compress_changesets)
 {
-    return std::unique_ptr<InRealmHistoryImpl>(new InRealmHistoryImpl(realm_path)); // Throws
+    return std::unique_ptr<InRealmHistoryImpl>(new InRealmHistoryImpl(realm_path, compress_changesets)); // Throws
 }
 
 } // namespace realm
@@ -27,7 +27,10 @@
 
 namespace realm {
 
-std::unique_ptr<Replication> make_in_realm_history(const std::string& realm_path);
+/// If \a compress_changesets is true, the changesets added to the history are
+/// stored compressed when that makes them smaller. Histories written with and
+/// without compression can be read either way.
+std::unique_ptr<Replication> make_in_realm_history(const std::string& realm_path, bool compress_changesets = false);
 
 } // namespace realm
 
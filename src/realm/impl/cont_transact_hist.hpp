@@ -20,6 +20,7 @@
 #define REALM_IMPL_CONT_TRANSACT_HIST_HPP
 
 #include <cstdint>
+#include <limits>
 #include <memory>
 
 #include <realm/column_binary.hpp>
@@ -74,9 +75,19 @@ public:
     /// initiation of commit operation), and only after a successful invocation
     /// of update_early_from_top_ref(). In that case, the caller may assume that
     /// the memory references stay valid for the remainder of the transaction
-    /// (up until initiation of the commit operation).
-    virtual void get_changesets(version_type begin_version, version_type end_version, BinaryIterator* buffer) const
-        noexcept = 0;
+    /// (up until initiation of the commit operation). Histories which store
+    /// changesets compressed may instead hand out memory that is only valid
+    /// until the next invocation of get_changesets().
+    virtual void get_changesets(version_type begin_version, version_type end_version, BinaryIterator* buffer) const = 0;
+
+    /// Get the oldest version that can be passed as `begin_version` to
+    /// get_changesets() in the current transaction. Histories that do not
+    /// keep track of this return the maximum version, meaning that no earlier
+    /// version can be asked for.
+    virtual version_type get_oldest_available_version() const noexcept
+    {
+        return std::numeric_limits<version_type>::max();
+    }
 
     /// \brief Specify the version of the oldest bound snapshot.
     ///
@@ -0,0 +1,357 @@
+/*************************************************************************
+ *
+ * Copyright 2021 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <realm/array.hpp>
+#include <realm/impl/destroy_guard.hpp>
+#include <realm/impl/parallel_array_writer.hpp>
+#include <realm/util/scope_exit.hpp>
+
+using namespace realm;
+using namespace realm::_impl;
+
+
+namespace {
+
+constexpr size_t g_chunk_size = 4 * 1024 * 1024; // Approximate bytes per chunk
+constexpr size_t g_min_chunks_per_thread = 4;
+constexpr size_t g_chunks_in_flight_per_thread = 4;
+constexpr size_t g_max_cut_depth = 16;
+
+// Refs within a chunk buffer are offsets plus this, so that they are never
+// mistaken for null refs.
+constexpr size_t g_buffer_base = 8;
+
+inline bool is_ref(int_fast64_t value) noexcept
+{
+    return value != 0 && (value & 1) == 0;
+}
+
+class BufferWriter : public ArrayWriterBase {
+public:
+    BufferWriter(std::vector<char>& buffer)
+        : m_buffer(buffer)
+    {
+    }
+
+    ref_type write_array(const char* data, size_t size, uint32_t checksum) override
+    {
+        ref_type ref = ref_type(m_buffer.size() + g_buffer_base);
+        const char* cksum_bytes = reinterpret_cast<const char*>(&checksum);
+        m_buffer.insert(m_buffer.end(), cksum_bytes, cksum_bytes + 4); // Throws
+        m_buffer.insert(m_buffer.end(), data + 4, data + size);        // Throws
+        return ref;
+    }
+
+private:
+    std::vector<char>& m_buffer;
+};
+
+// A range of consecutive subtrees below the cut, serialised together
+struct Chunk {
+    size_t begin, end;
+    std::vector<char> buffer;
+    std::vector<size_t> subtree_ends; // Offset in the buffer where each subtree ends
+    bool done = false;
+    std::exception_ptr error;
+};
+
+class ParallelArrayWriter {
+public:
+    ParallelArrayWriter(Allocator& alloc, ArrayWriterBase& out)
+        : m_alloc(alloc)
+        , m_out(out)
+    {
+    }
+
+    ref_type write(ref_type ref, size_t num_threads, size_t size_hint);
+
+private:
+    Allocator& m_alloc;
+    ArrayWriterBase& m_out;
+
+    size_t m_cut_depth = 0;
+    std::vector<ref_type> m_subtrees; // Roots of the subtrees below the cut, in write order
+    std::vector<Chunk> m_chunks;
+
+    // Protected by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    size_t m_next_chunk = 0;   // Next chunk to be claimed by a worker
+    size_t m_num_appended = 0; // Number of chunks appended to the output
+    bool m_stop = false;
+
+    size_t m_max_in_flight = 0;
+    bool m_have_workers = false;
+
+    // State of the chunk being appended
+    size_t m_next_subtree = 0;
+    size_t m_offset = 0;
+    std::vector<std::pair<ref_type, ref_type>> m_relocated; // Ref in the buffer, ref in the output
+
+    void find_cut(ref_type ref, size_t target);
+    void work();
+    void serialize(Chunk&);
+    ref_type write_above_cut(ref_type ref, size_t depth);
+    ref_type append_next_subtree();
+    ref_type rebuild(const char* header);
+};
+
+
+ref_type ParallelArrayWriter::write(ref_type ref, size_t num_threads, size_t size_hint)
+{
+    size_t target = std::max(num_threads * g_min_chunks_per_thread, size_hint / g_chunk_size);
+    find_cut(ref, target); // Throws
+    if (num_threads < 1 || m_subtrees.size() < 2)
+        return Array::write(ref, m_alloc, m_out, false); // Throws
+
+    size_t num_subtrees = m_subtrees.size();
+    size_t num_chunks = std::min(num_subtrees, target);
+    m_chunks.resize(num_chunks); // Throws
+    for (size_t i = 0; i < num_chunks; ++i) {
+        m_chunks[i].begin = i * num_subtrees / num_chunks;
+        m_chunks[i].end = (i + 1) * num_subtrees / num_chunks;
+    }
+    m_max_in_flight = num_threads * g_chunks_in_flight_per_thread;
+
+    std::vector<std::thread> threads;
+    auto stop_workers = util::make_scope_exit([&]() noexcept {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        for (auto& thread : threads)
+            thread.join();
+    });
+    threads.reserve(num_threads); // Throws
+    for (size_t i = 0; i < num_threads; ++i) {
+        try {
+            threads.emplace_back([this] {
+                work();
+            });
+        }
+        catch (const std::system_error&) {
+            // Out of threads, make do with the ones we have
+            break;
+        }
+    }
+    m_have_workers = !threads.empty();
+
+    return write_above_cut(ref, 0); // Throws
+}
+
+
+// Cut the tree at the shallowest depth that has at least `target` nodes, or
+// that is the last one with any nodes.
+void ParallelArrayWriter::find_cut(ref_type ref, size_t target)
+{
+    std::vector<ref_type> level = {ref};
+    while (level.size() < target && m_cut_depth < g_max_cut_depth) {
+        std::vector<ref_type> next;
+        for (ref_type node_ref : level) {
+            Array node(m_alloc);
+            node.init_from_ref(node_ref);
+            if (!node.has_refs())
+                continue;
+            size_t size = node.size();
+            for (size_t i = 0; i < size; ++i) {
+                int_fast64_t value = node.get(i);
+                if (is_ref(value))
+                    next.push_back(to_ref(value)); // Throws
+            }
+        }
+        if (next.empty())
+            break;
+        level = std::move(next);
+        ++m_cut_depth;
+    }
+    m_subtrees = std::move(level);
+}
+
+
+void ParallelArrayWriter::work()
+{
+    for (;;) {
+        Chunk* chunk;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [&] {
+                return m_stop || m_next_chunk == m_chunks.size() ||
+                       m_next_chunk < m_num_appended + m_max_in_flight;
+            });
+            if (m_stop || m_next_chunk == m_chunks.size())
+                return;
+            chunk = &m_chunks[m_next_chunk++];
+        }
+        std::exception_ptr error;
+        try {
+            serialize(*chunk); // Throws
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            chunk->error = error;
+            chunk->done = true;
+        }
+        m_cond.notify_all();
+    }
+}
+
+
+void ParallelArrayWriter::serialize(Chunk& chunk)
+{
+    BufferWriter writer(chunk.buffer);
+    chunk.subtree_ends.reserve(chunk.end - chunk.begin); // Throws
+    for (size_t i = chunk.begin; i < chunk.end; ++i) {
+        Array::write(m_subtrees[i], m_alloc, writer, false); // Throws
+        chunk.subtree_ends.push_back(chunk.buffer.size());
+    }
+}
+
+
+// Same as Array::do_write_deep(), except that the subtrees below the cut are
+// taken from the chunks.
+ref_type ParallelArrayWriter::write_above_cut(ref_type ref, size_t depth)
+{
+    if (depth == m_cut_depth)
+        return append_next_subtree(); // Throws
+
+    Array array(m_alloc);
+    array.init_from_ref(ref);
+    bool deep = false;             // Shallow
+    bool only_if_modified = false; // Always
+    if (!array.has_refs())
+        return array.write(m_out, deep, only_if_modified); // Throws
+
+    Array new_array(Allocator::get_default());
+    Array::Type type = array.is_inner_bptree_node() ? Array::type_InnerBptreeNode : Array::type_HasRefs;
+    new_array.create(type, array.get_context_flag()); // Throws
+    ShallowArrayDestroyGuard dg(&new_array);
+    size_t size = array.size();
+    for (size_t i = 0; i < size; ++i) {
+        int_fast64_t value = array.get(i);
+        if (is_ref(value))
+            value = from_ref(write_above_cut(to_ref(value), depth + 1)); // Throws
+        new_array.add(value);                                            // Throws
+    }
+    new_array.clear_padding();
+    return new_array.write(m_out, deep, only_if_modified); // Throws
+}
+
+
+ref_type ParallelArrayWriter::append_next_subtree()
+{
+    size_t subtree = m_next_subtree++;
+    size_t chunk_ndx = m_num_appended;
+    Chunk& chunk = m_chunks[chunk_ndx];
+    REALM_ASSERT(subtree >= chunk.begin && subtree < chunk.end);
+
+    if (subtree == chunk.begin) {
+        if (m_have_workers) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [&] {
+                return chunk.done;
+            });
+        }
+        else {
+            serialize(chunk); // Throws
+        }
+        if (chunk.error)
+            std::rethrow_exception(chunk.error);
+        m_offset = 0;
+        m_relocated.clear();
+    }
+
+    // The arrays of the subtree are in the order in which they were written,
+    // so every ref points to an array that has already been appended.
+    size_t end = chunk.subtree_ends[subtree - chunk.begin];
+    ref_type ref = 0;
+    while (m_offset < end) {
+        const char* header = chunk.buffer.data() + m_offset;
+        size_t byte_size = NodeHeader::get_byte_size_from_header(header);
+        if (NodeHeader::get_hasrefs_from_header(header)) {
+            ref = rebuild(header); // Throws
+        }
+        else {
+            uint32_t checksum;
+            std::memcpy(&checksum, header, sizeof checksum);
+            ref = m_out.write_array(header, byte_size, checksum); // Throws
+        }
+        m_relocated.emplace_back(ref_type(m_offset + g_buffer_base), ref); // Throws
+        m_offset += byte_size;
+    }
+
+    if (subtree + 1 == chunk.end) {
+        std::vector<char>().swap(chunk.buffer);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_num_appended;
+        }
+        m_cond.notify_all();
+    }
+    return ref;
+}
+
+
+// Write an array holding refs with the refs replaced by those of the arrays
+// in the output, exactly as Array::do_write_deep() would have built it.
+ref_type ParallelArrayWriter::rebuild(const char* header)
+{
+    Array new_array(Allocator::get_default());
+    Array::Type type =
+        NodeHeader::get_is_inner_bptree_node_from_header(header) ? Array::type_InnerBptreeNode : Array::type_HasRefs;
+    new_array.create(type, NodeHeader::get_context_flag_from_header(header)); // Throws
+    ShallowArrayDestroyGuard dg(&new_array);
+    size_t size = NodeHeader::get_size_from_header(header);
+    for (size_t i = 0; i < size; ++i) {
+        int_fast64_t value = Array::get(header, i);
+        if (is_ref(value)) {
+            ref_type buffer_ref = to_ref(value);
+            auto i_2 = std::lower_bound(m_relocated.begin(), m_relocated.end(),
+                                        std::make_pair(buffer_ref, ref_type(0)));
+            REALM_ASSERT(i_2 != m_relocated.end() && i_2->first == buffer_ref);
+            value = from_ref(i_2->second);
+        }
+        new_array.add(value); // Throws
+    }
+    new_array.clear_padding();
+    bool deep = false;             // Shallow
+    bool only_if_modified = false; // Always
+    return new_array.write(m_out, deep, only_if_modified); // Throws
+}
+
+} // anonymous namespace
+
+
+ref_type _impl::write_array_parallel(ref_type ref, Allocator& alloc, ArrayWriterBase& out, size_t num_threads,
+                                     size_t size_hint)
+{
+    ParallelArrayWriter writer(alloc, out);
+    return writer.write(ref, num_threads, size_hint); // Throws
+}
@@ -0,0 +1,53 @@
+/*************************************************************************
+ *
+ * Copyright 2021 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_IMPL_PARALLEL_ARRAY_WRITER_HPP
+#define REALM_IMPL_PARALLEL_ARRAY_WRITER_HPP
+
+#include <cstddef>
+
+#include <realm/alloc.hpp>
+#include <realm/impl/array_writer.hpp>
+
+namespace realm {
+namespace _impl {
+
+/// Write the array at \a ref and everything it refers to, producing exactly
+/// the same output as `Array::write(ref, alloc, out, false)`.
+///
+/// The tree is cut at the shallowest depth that has enough nodes to keep
+/// \a num_threads worker threads busy. Consecutive subtrees below the cut are
+/// grouped into chunks, which the workers serialise into memory buffers. The
+/// calling thread writes the part of the tree above the cut, and appends the
+/// chunks to \a out in order as they become ready. Only arrays holding refs
+/// need to be rebuilt when a chunk is appended, since the refs they contain
+/// depend on where the chunk ends up. Leaf arrays, which make up most of the
+/// data, are copied as they are. The number of chunks held in memory at any
+/// time is bounded.
+///
+/// \a size_hint is the approximate number of bytes that will be written,
+/// and is used to choose the size of the chunks.
+///
+/// The arrays must not be modified while they are written.
+ref_type write_array_parallel(ref_type ref, Allocator& alloc, ArrayWriterBase& out, size_t num_threads,
+                              size_t size_hint);
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_IMPL_PARALLEL_ARRAY_WRITER_HPP
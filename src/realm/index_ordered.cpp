@@ -0,0 +1,254 @@
+/*************************************************************************
+ *
+ * Copyright 2021 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <algorithm>
+
+#include <realm/index_ordered.hpp>
+#include <realm/impl/destroy_guard.hpp>
+
+using namespace realm;
+
+OrderedIndex::OrderedIndex(const ClusterColumn& target_column, Allocator& alloc)
+    : m_top(alloc)
+    , m_int_values(alloc)
+    , m_timestamp_values(alloc)
+    , m_keys(alloc)
+    , m_target_column(target_column)
+    , m_type(target_column.get_data_type())
+{
+    REALM_ASSERT(type_supported(m_type));
+    m_top.create(Array::type_HasRefs); // Throws
+    _impl::DeepArrayDestroyGuard dg(&m_top);
+    m_top.add(0); // Throws
+    m_top.add(0); // Throws
+
+    values().set_parent(&m_top, s_values_ndx);
+    values().create(); // Throws
+    m_keys.set_parent(&m_top, s_keys_ndx);
+    m_keys.create(); // Throws
+    dg.release();
+}
+
+OrderedIndex::OrderedIndex(ref_type ref, ArrayParent* parent, size_t ndx_in_parent,
+                           const ClusterColumn& target_column, Allocator& alloc)
+    : m_top(alloc)
+    , m_int_values(alloc)
+    , m_timestamp_values(alloc)
+    , m_keys(alloc)
+    , m_target_column(target_column)
+    , m_type(target_column.get_data_type())
+{
+    REALM_ASSERT(type_supported(m_type));
+    m_top.init_from_ref(ref);
+    m_top.set_parent(parent, ndx_in_parent);
+    init_trees();
+}
+
+void OrderedIndex::set_parent(ArrayParent* parent, size_t ndx_in_parent) noexcept
+{
+    m_top.set_parent(parent, ndx_in_parent);
+}
+
+void OrderedIndex::refresh_accessor_tree(const ClusterColumn& target_column)
+{
+    m_top.init_from_parent();
+    m_target_column = target_column;
+    init_trees();
+}
+
+BPlusTreeBase& OrderedIndex::values() const
+{
+    if (m_type == type_Int)
+        return m_int_values;
+    return m_timestamp_values;
+}
+
+void OrderedIndex::init_trees() const
+{
+    BPlusTreeBase& v = values();
+    v.set_parent(const_cast<Array*>(&m_top), s_values_ndx);
+    v.init_from_parent();
+    m_keys.set_parent(const_cast<Array*>(&m_top), s_keys_ndx);
+    m_keys.init_from_parent();
+    m_needs_refresh = false;
+}
+
+Mixed OrderedIndex::get_value(size_t ndx) const
+{
+    ensure_attached();
+    if (m_type == type_Int)
+        return Mixed(m_int_values.get(ndx));
+    return Mixed(m_timestamp_values.get(ndx));
+}
+
+void OrderedIndex::insert_value(size_t ndx, Mixed value)
+{
+    if (m_type == type_Int) {
+        m_int_values.insert(ndx, value.is_null() ? util::none : util::make_optional(value.get_int())); // Throws
+    }
+    else {
+        m_timestamp_values.insert(ndx, value.is_null() ? Timestamp() : value.get_timestamp()); // Throws
+    }
+}
+
+size_t OrderedIndex::find_position(Mixed value, ObjKey key) const
+{
+    size_t lo = 0;
+    size_t hi = m_keys.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = get_value(mid).compare(value);
+        if (cmp < 0 || (cmp == 0 && m_keys.get(mid) < key)) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+size_t OrderedIndex::lower_bound(Mixed value) const
+{
+    ensure_attached();
+    size_t lo = 0;
+    size_t hi = m_keys.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (get_value(mid).compare(value) < 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+size_t OrderedIndex::upper_bound(Mixed value) const
+{
+    ensure_attached();
+    size_t lo = 0;
+    size_t hi = m_keys.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (get_value(mid).compare(value) <= 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void OrderedIndex::build()
+{
+    ensure_attached();
+    REALM_ASSERT(m_keys.size() == 0);
+
+    // Sorting up front and appending is much cheaper than inserting the entries one by one
+    ColKey col_key = get_column_key();
+    std::vector<std::pair<Mixed, ObjKey>> entries;
+    entries.reserve(m_target_column.size());
+    for (auto it = m_target_column.begin(), end = m_target_column.end(); it != end; ++it) {
+        entries.emplace_back(it->get_any(col_key), it->get_key());
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        int cmp = a.first.compare(b.first);
+        return cmp < 0 || (cmp == 0 && a.second < b.second);
+    });
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        insert_value(i, entries[i].first); // Throws
+        m_keys.add(entries[i].second);     // Throws
+    }
+}
+
+void OrderedIndex::insert(ObjKey key, Mixed value)
+{
+    ensure_attached();
+    size_t ndx = find_position(value, key);
+    insert_value(ndx, value); // Throws
+    m_keys.insert(ndx, key);  // Throws
+}
+
+void OrderedIndex::set(ObjKey key, Mixed new_value)
+{
+    ensure_attached();
+    Mixed old_value = m_target_column.get_value(key);
+    if (old_value == new_value)
+        return;
+
+    erase(key);
+    insert(key, new_value); // Throws
+}
+
+void OrderedIndex::erase(ObjKey key)
+{
+    ensure_attached();
+    Mixed value = m_target_column.get_value(key);
+    size_t ndx = find_position(value, key);
+    REALM_ASSERT(ndx < m_keys.size() && m_keys.get(ndx) == key);
+    if (m_type == type_Int) {
+        m_int_values.erase(ndx);
+    }
+    else {
+        m_timestamp_values.erase(ndx);
+    }
+    m_keys.erase(ndx);
+}
+
+void OrderedIndex::clear()
+{
+    ensure_attached();
+    if (m_type == type_Int) {
+        m_int_values.clear();
+    }
+    else {
+        m_timestamp_values.clear();
+    }
+    m_keys.clear();
+}
+
+void OrderedIndex::find_all(std::vector<ObjKey>& result, size_t begin, size_t end) const
+{
+    ensure_attached();
+    REALM_ASSERT(begin <= end && end <= m_keys.size());
+    size_t first = result.size();
+    result.reserve(first + (end - begin));
+    for (size_t i = begin; i < end; ++i) {
+        result.push_back(m_keys.get(i));
+    }
+    std::sort(result.begin() + first, result.end());
+}
+
+void OrderedIndex::verify() const
+{
+#ifdef REALM_DEBUG
+    ensure_attached();
+    values().verify();
+    m_keys.verify();
+    REALM_ASSERT(values().size() == m_keys.size());
+    REALM_ASSERT(m_keys.size() == m_target_column.size());
+    for (size_t i = 1; i < m_keys.size(); ++i) {
+        int cmp = get_value(i - 1).compare(get_value(i));
+        REALM_ASSERT(cmp < 0 || (cmp == 0 && m_keys.get(i - 1) < m_keys.get(i)));
+    }
+#endif
+}
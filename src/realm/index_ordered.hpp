@@ -0,0 +1,153 @@
+/*************************************************************************
+ *
+ * Copyright 2021 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_INDEX_ORDERED_HPP
+#define REALM_INDEX_ORDERED_HPP
+
+#include <vector>
+
+#include <realm/array.hpp>
+#include <realm/array_integer.hpp>
+#include <realm/array_key.hpp>
+#include <realm/array_timestamp.hpp>
+#include <realm/bplustree.hpp>
+#include <realm/index_string.hpp>
+#include <realm/mixed.hpp>
+
+/*
+The OrderedIndex class keeps the values of an Int or Timestamp column in sorted order, so that range conditions
+(Greater, Less, ...) and sorting on the column can be answered without visiting every object.
+
+The index consists of two B+ trees of equal size, referenced from a top array:
+
+    [0] values    (BPlusTree<util::Optional<int64_t>> for Int, BPlusTree<Timestamp> for Timestamp)
+    [1] keys      (BPlusTree<ObjKey>)
+
+Entry i states that the object with key keys[i] has the value values[i]. Entries are ordered by value, with nulls
+before all other values, and then by object key, so every entry has a unique position that can be found by binary
+search.
+
+The trees are indexed by position, not by value, so the binary search looks up each probed entry from the root.
+Finding a position therefore costs O(log^2 n), and an insert or erase additionally shifts the entries of one leaf.
+This keeps the index built from the existing BPlusTree, at the price of a constant factor over a tree searched by
+value.
+*/
+
+namespace realm {
+
+class OrderedIndex {
+public:
+    OrderedIndex(const ClusterColumn& target_column, Allocator&);
+    OrderedIndex(ref_type, ArrayParent*, size_t ndx_in_parent, const ClusterColumn& target_column, Allocator&);
+
+    ColKey get_column_key() const
+    {
+        return m_target_column.get_column_key();
+    }
+
+    static bool type_supported(DataType type)
+    {
+        return (type == type_Int || type == type_Timestamp);
+    }
+
+    // Accessor concept:
+    void destroy() noexcept;
+    void set_parent(ArrayParent* parent, size_t ndx_in_parent) noexcept;
+    void update_from_parent(size_t old_baseline) noexcept;
+    void refresh_accessor_tree(const ClusterColumn& target_column);
+    ref_type get_ref() const noexcept;
+
+    // OrderedIndex interface. set() and erase() look up the current value of the object in the column, so they
+    // must be called before the column itself is modified.
+
+    // Fill an empty index with the current contents of the column
+    void build();
+    void insert(ObjKey key, Mixed value);
+    void set(ObjKey key, Mixed new_value);
+    void erase(ObjKey key);
+    void clear();
+
+    size_t size() const;
+    Mixed get_value(size_t ndx) const;
+    ObjKey get_key(size_t ndx) const;
+
+    // Position of the first entry whose value is not less than (lower_bound) or greater than (upper_bound) 'value'
+    size_t lower_bound(Mixed value) const;
+    size_t upper_bound(Mixed value) const;
+
+    // Add the keys of the entries in [begin, end) to 'result', sorted by key
+    void find_all(std::vector<ObjKey>& result, size_t begin, size_t end) const;
+
+    void verify() const;
+
+private:
+    Array m_top;
+    mutable BPlusTree<util::Optional<int64_t>> m_int_values;
+    mutable BPlusTree<Timestamp> m_timestamp_values;
+    mutable BPlusTree<ObjKey> m_keys;
+    mutable bool m_needs_refresh = false;
+    ClusterColumn m_target_column;
+    DataType m_type;
+
+    static constexpr size_t s_values_ndx = 0;
+    static constexpr size_t s_keys_ndx = 1;
+
+    BPlusTreeBase& values() const;
+    void init_trees() const;
+    void ensure_attached() const
+    {
+        if (REALM_UNLIKELY(m_needs_refresh))
+            init_trees();
+    }
+    void insert_value(size_t ndx, Mixed value);
+    // Position of the first entry not ordered before (value, key)
+    size_t find_position(Mixed value, ObjKey key) const;
+};
+
+inline void OrderedIndex::destroy() noexcept
+{
+    m_top.destroy_deep();
+}
+
+inline ref_type OrderedIndex::get_ref() const noexcept
+{
+    return m_top.get_ref();
+}
+
+inline void OrderedIndex::update_from_parent(size_t old_baseline) noexcept
+{
+    // The tree accessors can not be reattached without allocating, so that is postponed until next use
+    if (m_top.update_from_parent(old_baseline))
+        m_needs_refresh = true;
+}
+
+inline size_t OrderedIndex::size() const
+{
+    ensure_attached();
+    return m_keys.size();
+}
+
+inline ObjKey OrderedIndex::get_key(size_t ndx) const
+{
+    ensure_attached();
+    return m_keys.get(ndx);
+}
+
+} // namespace realm
+
+#endif // REALM_INDEX_ORDERED_HPP
@@ -54,6 +54,11 @@ bool ClusterColumn::is_nullable() const
     return m_column_key.get_attrs().test(col_attr_Nullable);
 }
 
+Mixed ClusterColumn::get_value(ObjKey key) const
+{
+    return m_cluster_tree->get(key).get_any(m_column_key);
+}
+
 StringData ClusterColumn::get_index_data(ObjKey key, StringConversionBuffer& buffer) const
 {
     ConstObj obj = m_cluster_tree->get(key);
@@ -87,6 +92,26 @@ StringData ClusterColumn::get_index_data(ObjKey key, StringConversionBuffer& buf
         GetIndexData<Timestamp> stringifier;
         return stringifier.get_index_data(obj.get<Timestamp>(m_column_key), buffer);
     }
+    else if (type == type_Float) {
+        if (is_nullable()) {
+            GetIndexData<Optional<float>> stringifier;
+            return stringifier.get_index_data(obj.get<Optional<float>>(m_column_key), buffer);
+        }
+        else {
+            GetIndexData<float> stringifier;
+            return stringifier.get_index_data(obj.get<float>(m_column_key), buffer);
+        }
+    }
+    else if (type == type_Double) {
+        if (is_nullable()) {
+            GetIndexData<Optional<double>> stringifier;
+            return stringifier.get_index_data(obj.get<Optional<double>>(m_column_key), buffer);
+        }
+        else {
+            GetIndexData<double> stringifier;
+            return stringifier.get_index_data(obj.get<double>(m_column_key), buffer);
+        }
+    }
     // It should not be possible to reach this line through public Core API
     REALM_ASSERT_RELEASE(false);
     return {};
@@ -19,7 +19,9 @@
 #ifndef REALM_INDEX_STRING_HPP
 #define REALM_INDEX_STRING_HPP
 
+#include <cmath>
 #include <cstring>
+#include <limits>
 #include <memory>
 #include <array>
 
@@ -143,6 +145,7 @@ public:
     }
     bool is_nullable() const;
     StringData get_index_data(ObjKey key, StringConversionBuffer& buffer) const;
+    Mixed get_value(ObjKey key) const;
 
 private:
     const ClusterTree* m_cluster_tree;
@@ -165,11 +168,12 @@ public:
     template <class T>
     static bool type_supported()
     {
-        return realm::is_any<T, int64_t, int, StringData, bool, Timestamp>::value;
+        return realm::is_any<T, int64_t, int, StringData, bool, Timestamp, float, double>::value;
     }
     static bool type_supported(realm::DataType type)
     {
-        return (type == type_Int || type == type_String || type == type_Bool || type == type_Timestamp);
+        return (type == type_Int || type == type_String || type == type_Bool || type == type_Timestamp ||
+                type == type_Float || type == type_Double);
     }
 
     static ref_type create_empty(Allocator& alloc);
@@ -394,21 +398,34 @@ struct GetIndexData<util::Optional<T>> {
     }
 };
 
+// Floating point values are indexed by their bit pattern. -0 and +0 compare equal, so they share the key of +0,
+// and all NaNs share one key so that objects holding a NaN can still be found when they are updated or erased.
+// NaN never compares equal to anything, so lookups for NaN must bypass the index (see is_nan_lookup()).
 template <>
 struct GetIndexData<float> {
-    static StringData get_index_data(float, StringConversionBuffer&)
+    static StringData get_index_data(float value, StringConversionBuffer& buffer)
     {
-        REALM_ASSERT_RELEASE(false); // LCOV_EXCL_LINE; Index on float not supported
-        return {};
+        if (value == 0)
+            value = 0;
+        else if (std::isnan(value))
+            value = std::numeric_limits<float>::quiet_NaN();
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return GetIndexData<int64_t>::get_index_data(int64_t(bits), buffer);
     }
 };
 
 template <>
 struct GetIndexData<double> {
-    static StringData get_index_data(double, StringConversionBuffer&)
+    static StringData get_index_data(double value, StringConversionBuffer& buffer)
     {
-        REALM_ASSERT_RELEASE(false); // LCOV_EXCL_LINE; Index on float not supported
-        return {};
+        if (value == 0)
+            value = 0;
+        else if (std::isnan(value))
+            value = std::numeric_limits<double>::quiet_NaN();
+        int64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return GetIndexData<int64_t>::get_index_data(bits, buffer);
     }
 };
 
@@ -434,6 +451,29 @@ inline StringData to_str(T&& value, StringConversionBuffer& buffer)
     return GetIndexData<typename std::remove_reference<T>::type>::get_index_data(value, buffer);
 }
 
+// NaN does not compare equal to anything, so looking it up in an index must not find the objects holding NaN
+template <class T>
+inline bool is_nan_lookup(const T&)
+{
+    return false;
+}
+
+inline bool is_nan_lookup(float value)
+{
+    return std::isnan(value);
+}
+
+inline bool is_nan_lookup(double value)
+{
+    return std::isnan(value);
+}
+
+template <class T>
+inline bool is_nan_lookup(const util::Optional<T>& value)
+{
+    return value && is_nan_lookup(*value);
+}
+
 
 inline StringIndex::StringIndex(const ClusterColumn& target_column, Allocator& alloc)
     : m_array(create_node(alloc, true)) // Throws
@@ -568,6 +608,8 @@ void StringIndex::set(ObjKey key, util::Optional<T> new_value)
 template <class T>
 ObjKey StringIndex::find_first(T value) const
 {
+    if (is_nan_lookup(value))
+        return {};
     // Use direct access method
     StringConversionBuffer buffer;
     return m_array->index_string_find_first(to_str(value, buffer), m_target_column);
@@ -576,6 +618,8 @@ ObjKey StringIndex::find_first(T value) const
 template <class T>
 void StringIndex::find_all(std::vector<ObjKey>& result, T value, bool case_insensitive) const
 {
+    if (is_nan_lookup(value))
+        return;
     // Use direct access method
     StringConversionBuffer buffer;
     return m_array->index_string_find_all(result, to_str(value, buffer), m_target_column, case_insensitive);
@@ -584,6 +628,8 @@ void StringIndex::find_all(std::vector<ObjKey>& result, T value, bool case_insen
 template <class T>
 FindRes StringIndex::find_all_no_copy(T value, InternalFindResult& result) const
 {
+    if (is_nan_lookup(value))
+        return FindRes_not_found;
     // Use direct access method
     StringConversionBuffer buffer;
     return m_array->index_string_find_all_no_copy(to_str(value, buffer), m_target_column, result);
@@ -592,6 +638,8 @@ FindRes StringIndex::find_all_no_copy(T value, InternalFindResult& result) const
 template <class T>
 size_t StringIndex::count(T value) const
 {
+    if (is_nan_lookup(value))
+        return 0;
     // Use direct access method
     StringConversionBuffer buffer;
     return m_array->index_string_count(to_str(value, buffer), m_target_column);
@@ -0,0 +1,367 @@
+/*************************************************************************
+ *
+ * Copyright 2021 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <algorithm>
+#include <iterator>
+
+#include <realm/index_substring.hpp>
+#include <realm/impl/destroy_guard.hpp>
+
+using namespace realm;
+
+namespace {
+
+constexpr int64_t boundary_symbol = 256;
+
+inline int64_t fold_symbol(char c)
+{
+    unsigned char uc = static_cast<unsigned char>(c);
+    return (uc >= 'A' && uc <= 'Z') ? uc + ('a' - 'A') : uc;
+}
+
+inline int64_t make_trigram(int64_t s0, int64_t s1, int64_t s2)
+{
+    return (s0 << 18) | (s1 << 9) | s2;
+}
+
+inline bool is_wildcard(char c)
+{
+    return c == '*' || c == '?';
+}
+
+} // unnamed namespace
+
+SubstringIndex::SubstringIndex(const ClusterColumn& target_column, Allocator& alloc)
+    : m_top(alloc)
+    , m_trigrams(alloc)
+    , m_keys(alloc)
+    , m_target_column(target_column)
+{
+    REALM_ASSERT(type_supported(m_target_column.get_data_type()));
+    m_top.create(Array::type_HasRefs); // Throws
+    _impl::DeepArrayDestroyGuard dg(&m_top);
+    m_top.add(0); // Throws
+    m_top.add(0); // Throws
+
+    m_trigrams.set_parent(&m_top, s_trigrams_ndx);
+    m_trigrams.create(); // Throws
+    m_keys.set_parent(&m_top, s_keys_ndx);
+    m_keys.create(); // Throws
+    dg.release();
+}
+
+SubstringIndex::SubstringIndex(ref_type ref, ArrayParent* parent, size_t ndx_in_parent,
+                               const ClusterColumn& target_column, Allocator& alloc)
+    : m_top(alloc)
+    , m_trigrams(alloc)
+    , m_keys(alloc)
+    , m_target_column(target_column)
+{
+    REALM_ASSERT(type_supported(m_target_column.get_data_type()));
+    m_top.init_from_ref(ref);
+    m_top.set_parent(parent, ndx_in_parent);
+    init_trees();
+}
+
+void SubstringIndex::set_parent(ArrayParent* parent, size_t ndx_in_parent) noexcept
+{
+    m_top.set_parent(parent, ndx_in_parent);
+}
+
+void SubstringIndex::refresh_accessor_tree(const ClusterColumn& target_column)
+{
+    m_top.init_from_parent();
+    m_target_column = target_column;
+    init_trees();
+}
+
+void SubstringIndex::init_trees() const
+{
+    m_trigrams.set_parent(const_cast<Array*>(&m_top), s_trigrams_ndx);
+    m_trigrams.init_from_parent();
+    m_keys.set_parent(const_cast<Array*>(&m_top), s_keys_ndx);
+    m_keys.init_from_parent();
+    m_needs_refresh = false;
+}
+
+void SubstringIndex::get_value_trigrams(StringData value, std::vector<int64_t>& trigrams)
+{
+    trigrams.clear();
+    size_t n = value.size();
+    if (value.is_null() || n == 0)
+        return;
+
+    // Window i covers the symbols i-1, i and i+1 of the value, where the positions outside it are the boundary
+    auto symbol = [&](size_t i) {
+        return (i == 0 || i == n + 1) ? boundary_symbol : fold_symbol(value[i - 1]);
+    };
+    trigrams.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        trigrams.push_back(make_trigram(symbol(i), symbol(i + 1), symbol(i + 2)));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+void SubstringIndex::get_needle_trigrams(StringData upper, StringData lower, bool at_begin, bool at_end,
+                                         std::vector<int64_t>& trigrams)
+{
+    REALM_ASSERT_DEBUG(upper.size() == lower.size());
+
+    // A symbol is only known if both cases of the needle fold to it. Other bytes can match more than one
+    // symbol, so no trigram covering them can be required.
+    std::vector<int64_t> symbols;
+    std::vector<bool> known;
+    symbols.reserve(lower.size() + 2);
+    known.reserve(lower.size() + 2);
+    if (at_begin) {
+        symbols.push_back(boundary_symbol);
+        known.push_back(true);
+    }
+    for (size_t i = 0; i < lower.size(); ++i) {
+        int64_t s = fold_symbol(lower[i]);
+        symbols.push_back(s);
+        known.push_back(s == fold_symbol(upper[i]));
+    }
+    if (at_end) {
+        symbols.push_back(boundary_symbol);
+        known.push_back(true);
+    }
+
+    for (size_t i = 0; i + 2 < symbols.size(); ++i) {
+        if (known[i] && known[i + 1] && known[i + 2])
+            trigrams.push_back(make_trigram(symbols[i], symbols[i + 1], symbols[i + 2]));
+    }
+}
+
+void SubstringIndex::get_pattern_trigrams(StringData upper, StringData lower, std::vector<int64_t>& trigrams)
+{
+    REALM_ASSERT_DEBUG(upper.size() == lower.size());
+
+    // Every run of literal characters between wildcards must occur in a matching string. The first and last runs
+    // are anchored to the ends of the string unless the pattern starts or ends with a wildcard.
+    size_t run_begin = 0;
+    for (size_t i = 0; i <= lower.size(); ++i) {
+        if (i < lower.size() && !is_wildcard(lower[i]))
+            continue;
+        if (i > run_begin) {
+            get_needle_trigrams(upper.substr(run_begin, i - run_begin), lower.substr(run_begin, i - run_begin),
+                                run_begin == 0, i == lower.size(), trigrams);
+        }
+        run_begin = i + 1;
+    }
+}
+
+size_t SubstringIndex::find_position(int64_t trigram, ObjKey key) const
+{
+    size_t lo = 0;
+    size_t hi = m_keys.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int64_t t = m_trigrams.get(mid);
+        if (t < trigram || (t == trigram && m_keys.get(mid) < key)) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+size_t SubstringIndex::lower_bound(int64_t trigram) const
+{
+    size_t lo = 0;
+    size_t hi = m_trigrams.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (m_trigrams.get(mid) < trigram) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+size_t SubstringIndex::key_lower_bound(size_t lo, size_t hi, ObjKey key) const
+{
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (m_keys.get(mid) < key) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void SubstringIndex::build()
+{
+    ensure_attached();
+    REALM_ASSERT(m_keys.size() == 0);
+
+    // Sorting up front and appending is much cheaper than inserting the entries one by one
+    ColKey col_key = get_column_key();
+    std::vector<std::pair<int64_t, ObjKey>> entries;
+    std::vector<int64_t> trigrams;
+    for (auto it = m_target_column.begin(), end = m_target_column.end(); it != end; ++it) {
+        get_value_trigrams(it->get<StringData>(col_key), trigrams);
+        for (int64_t t : trigrams) {
+            entries.emplace_back(t, it->get_key());
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+
+    for (auto& entry : entries) {
+        m_trigrams.add(entry.first); // Throws
+        m_keys.add(entry.second);    // Throws
+    }
+}
+
+void SubstringIndex::insert(ObjKey key, StringData value)
+{
+    ensure_attached();
+    std::vector<int64_t> trigrams;
+    get_value_trigrams(value, trigrams);
+    for (int64_t t : trigrams) {
+        size_t ndx = find_position(t, key);
+        m_trigrams.insert(ndx, t); // Throws
+        m_keys.insert(ndx, key);   // Throws
+    }
+}
+
+void SubstringIndex::set(ObjKey key, Mixed new_value)
+{
+    ensure_attached();
+    Mixed old_value = m_target_column.get_value(key);
+    std::vector<int64_t> old_trigrams;
+    std::vector<int64_t> new_trigrams;
+    if (!old_value.is_null())
+        get_value_trigrams(old_value.get_string(), old_trigrams);
+    if (!new_value.is_null())
+        get_value_trigrams(new_value.get_string(), new_trigrams);
+
+    // Only the trigrams that are not in both values need to be touched
+    std::vector<int64_t> removed;
+    std::vector<int64_t> added;
+    std::set_difference(old_trigrams.begin(), old_trigrams.end(), new_trigrams.begin(), new_trigrams.end(),
+                        std::back_inserter(removed));
+    std::set_difference(new_trigrams.begin(), new_trigrams.end(), old_trigrams.begin(), old_trigrams.end(),
+                        std::back_inserter(added));
+    for (int64_t t : removed) {
+        size_t ndx = find_position(t, key);
+        REALM_ASSERT(ndx < m_keys.size() && m_keys.get(ndx) == key);
+        m_trigrams.erase(ndx);
+        m_keys.erase(ndx);
+    }
+    for (int64_t t : added) {
+        size_t ndx = find_position(t, key);
+        m_trigrams.insert(ndx, t); // Throws
+        m_keys.insert(ndx, key);   // Throws
+    }
+}
+
+void SubstringIndex::erase(ObjKey key)
+{
+    ensure_attached();
+    Mixed value = m_target_column.get_value(key);
+    if (value.is_null())
+        return;
+
+    std::vector<int64_t> trigrams;
+    get_value_trigrams(value.get_string(), trigrams);
+    for (int64_t t : trigrams) {
+        size_t ndx = find_position(t, key);
+        REALM_ASSERT(ndx < m_keys.size() && m_keys.get(ndx) == key);
+        m_trigrams.erase(ndx);
+        m_keys.erase(ndx);
+    }
+}
+
+void SubstringIndex::clear()
+{
+    ensure_attached();
+    m_trigrams.clear();
+    m_keys.clear();
+}
+
+bool SubstringIndex::find_candidates(std::vector<int64_t> trigrams, std::vector<ObjKey>& result,
+                                     size_t max_candidates) const
+{
+    ensure_attached();
+    if (trigrams.empty())
+        return false;
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+    // The range of entries holding each trigram, most selective first
+    std::vector<std::pair<size_t, size_t>> ranges;
+    ranges.reserve(trigrams.size());
+    for (int64_t t : trigrams) {
+        size_t begin = lower_bound(t);
+        size_t end = lower_bound(t + 1);
+        ranges.emplace_back(begin, end);
+    }
+    std::sort(ranges.begin(), ranges.end(), [](const auto& a, const auto& b) {
+        return a.second - a.first < b.second - b.first;
+    });
+
+    result.clear();
+    size_t num_candidates = ranges[0].second - ranges[0].first;
+    if (num_candidates > max_candidates)
+        return false;
+    result.reserve(num_candidates);
+    for (size_t i = ranges[0].first; i < ranges[0].second; ++i) {
+        result.push_back(m_keys.get(i));
+    }
+
+    size_t num_lookups = (ranges.size() < s_max_lookups) ? ranges.size() : s_max_lookups;
+    for (size_t r = 1; r < num_lookups && !result.empty(); ++r) {
+        size_t lo = ranges[r].first;
+        size_t hi = ranges[r].second;
+        auto out = result.begin();
+        for (ObjKey key : result) {
+            lo = key_lower_bound(lo, hi, key);
+            if (lo == hi)
+                break;
+            if (m_keys.get(lo) == key)
+                *out++ = key;
+        }
+        result.erase(out, result.end());
+    }
+    return true;
+}
+
+void SubstringIndex::verify() const
+{
+#ifdef REALM_DEBUG
+    ensure_attached();
+    m_trigrams.verify();
+    m_keys.verify();
+    REALM_ASSERT(m_trigrams.size() == m_keys.size());
+    for (size_t i = 1; i < m_keys.size(); ++i) {
+        int64_t t0 = m_trigrams.get(i - 1);
+        int64_t t1 = m_trigrams.get(i);
+        REALM_ASSERT(t0 < t1 || (t0 == t1 && m_keys.get(i - 1) < m_keys.get(i)));
+    }
+#endif
+}
@@ -0,0 +1,157 @@
+/*************************************************************************
+ *
+ * Copyright 2021 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_INDEX_SUBSTRING_HPP
+#define REALM_INDEX_SUBSTRING_HPP
+
+#include <vector>
+
+#include <realm/array.hpp>
+#include <realm/array_integer.hpp>
+#include <realm/array_key.hpp>
+#include <realm/bplustree.hpp>
+#include <realm/index_string.hpp>
+#include <realm/mixed.hpp>
+
+/*
+The SubstringIndex class maps the trigrams (sequences of three bytes) occurring in the values of a String column to
+the objects holding them, so that substring conditions (Contains, BeginsWith, EndsWith, Like and their case
+insensitive variants) can be answered by verifying a small set of candidate objects instead of every object.
+
+Trigrams are taken after folding the ASCII letters to lower case, so the same index serves case sensitive and case
+insensitive conditions. Each value is padded with a boundary symbol at both ends, so "abc" has the trigrams "^ab",
+"abc" and "bc$", which lets prefix and suffix conditions use the index for needles shorter than three bytes. A
+trigram is stored as an integer of three 9 bit symbols, where 0-255 are bytes and 256 is the boundary.
+
+The index consists of two B+ trees of equal size, referenced from a top array:
+
+    [0] trigrams  (BPlusTree<Int>)
+    [1] keys      (BPlusTree<ObjKey>)
+
+Entry i states that the value of the object with key keys[i] contains the trigram trigrams[i]. Entries are ordered
+by trigram and then by object key, so the objects containing a trigram are a contiguous range sorted by key. Null
+strings have no trigrams.
+*/
+
+namespace realm {
+
+class SubstringIndex {
+public:
+    SubstringIndex(const ClusterColumn& target_column, Allocator&);
+    SubstringIndex(ref_type, ArrayParent*, size_t ndx_in_parent, const ClusterColumn& target_column, Allocator&);
+
+    ColKey get_column_key() const
+    {
+        return m_target_column.get_column_key();
+    }
+
+    static bool type_supported(DataType type)
+    {
+        return type == type_String;
+    }
+
+    // Accessor concept:
+    void destroy() noexcept;
+    void set_parent(ArrayParent* parent, size_t ndx_in_parent) noexcept;
+    void update_from_parent(size_t old_baseline) noexcept;
+    void refresh_accessor_tree(const ClusterColumn& target_column);
+    ref_type get_ref() const noexcept;
+
+    // SubstringIndex interface. set() and erase() look up the current value of the object in the column, so they
+    // must be called before the column itself is modified.
+
+    // Fill an empty index with the current contents of the column
+    void build();
+    void insert(ObjKey key, StringData value);
+    void set(ObjKey key, Mixed new_value);
+    void erase(ObjKey key);
+    void clear();
+
+    // Number of (trigram, key) entries
+    size_t size() const;
+
+    // The trigrams that a string containing the needle must contain. 'upper' and 'lower' are the upper and lower
+    // case versions of the needle, which must have the same size; pass the needle as both for a case sensitive
+    // search. If 'at_begin' or 'at_end' is set, the needle must occur at the beginning or end of the string.
+    static void get_needle_trigrams(StringData upper, StringData lower, bool at_begin, bool at_end,
+                                    std::vector<int64_t>& trigrams);
+    // The trigrams that a string matching a Like pattern must contain
+    static void get_pattern_trigrams(StringData upper, StringData lower, std::vector<int64_t>& trigrams);
+
+    // Set 'result' to the keys of the objects containing all of 'trigrams', sorted by key. Objects not matching the
+    // condition the trigrams were taken from may be included. Returns false, leaving 'result' unspecified, if there
+    // are no trigrams or the candidates could not be limited to at most 'max_candidates'.
+    bool find_candidates(std::vector<int64_t> trigrams, std::vector<ObjKey>& result, size_t max_candidates) const;
+
+    void verify() const;
+
+private:
+    Array m_top;
+    mutable BPlusTree<int64_t> m_trigrams;
+    mutable BPlusTree<ObjKey> m_keys;
+    mutable bool m_needs_refresh = false;
+    ClusterColumn m_target_column;
+
+    static constexpr size_t s_trigrams_ndx = 0;
+    static constexpr size_t s_keys_ndx = 1;
+    // Intersecting the candidates with further trigrams has diminishing returns, as they are verified anyway
+    static constexpr size_t s_max_lookups = 8;
+
+    void init_trees() const;
+    void ensure_attached() const
+    {
+        if (REALM_UNLIKELY(m_needs_refresh))
+            init_trees();
+    }
+    // The distinct trigrams of a value, sorted
+    static void get_value_trigrams(StringData value, std::vector<int64_t>& trigrams);
+    // Position of the first entry not ordered before (trigram, key)
+    size_t find_position(int64_t trigram, ObjKey key) const;
+    // Position of the first entry whose trigram is not less than 'trigram'
+    size_t lower_bound(int64_t trigram) const;
+    // Position of the first entry in [lo, hi) whose key is not less than 'key'. The entries in the range must have
+    // the same trigram.
+    size_t key_lower_bound(size_t lo, size_t hi, ObjKey key) const;
+};
+
+inline void SubstringIndex::destroy() noexcept
+{
+    m_top.destroy_deep();
+}
+
+inline ref_type SubstringIndex::get_ref() const noexcept
+{
+    return m_top.get_ref();
+}
+
+inline void SubstringIndex::update_from_parent(size_t old_baseline) noexcept
+{
+    // The tree accessors can not be reattached without allocating, so that is postponed until next use
+    if (m_top.update_from_parent(old_baseline))
+        m_needs_refresh = true;
+}
+
+inline size_t SubstringIndex::size() const
+{
+    ensure_attached();
+    return m_keys.size();
+}
+
+} // namespace realm
+
+#endif // REALM_INDEX_SUBSTRING_HPP
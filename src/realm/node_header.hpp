@@ -19,6 +19,8 @@
 #ifndef REALM_NODE_HEADER_HPP
 #define REALM_NODE_HEADER_HPP
 
+#include <cstring>
+
 #include <realm/util/assert.hpp>
 
 namespace realm {
@@ -49,6 +51,8 @@ public:
         wtype_Bits = 0,     // width indicates how many bits every element occupies
         wtype_Multiply = 1, // width indicates how many bytes every element occupies
         wtype_Ignore = 2,   // each element is 1 byte
+        wtype_Offset = 3,   // as wtype_Bits, but elements are offsets from a 64 bit base stored after them
+                            // (file format version 11 and later)
     };
 
     static const int header_size = 8; // Number of bytes used by header
@@ -197,6 +201,23 @@ public:
         h[2] = uchar(value >> 3 & 0x000000FF);
     }
 
+    // The base of a wtype_Offset node follows the 8-byte aligned offsets
+    static int64_t get_base_from_header(const char* header) noexcept
+    {
+        REALM_ASSERT_DEBUG(get_wtype_from_header(header) == wtype_Offset);
+        size_t offset = calc_byte_size(wtype_Bits, get_size_from_header(header), get_width_from_header(header));
+        int64_t base;
+        memcpy(&base, header + offset, sizeof base);
+        return base;
+    }
+
+    static void set_base_in_header(int64_t base, char* header) noexcept
+    {
+        REALM_ASSERT_DEBUG(get_wtype_from_header(header) == wtype_Offset);
+        size_t offset = calc_byte_size(wtype_Bits, get_size_from_header(header), get_width_from_header(header));
+        memcpy(header + offset, &base, sizeof base);
+    }
+
     static size_t get_byte_size_from_header(const char* header) noexcept
     {
         size_t size = get_size_from_header(header);
@@ -226,6 +247,13 @@ public:
             case wtype_Ignore:
                 num_bytes = size;
                 break;
+            case wtype_Offset: {
+                REALM_ASSERT_3(size, <, 0x1000000);
+                size_t num_bits = size * width;
+                num_bytes = (((num_bits + 7) >> 3) + 7) & ~size_t(7);
+                num_bytes += 8; // The base
+                break;
+            }
         }
 
         // Ensure 8-byte alignment
@@ -28,6 +28,8 @@
 #include "realm/array_backlink.hpp"
 #include "realm/column_type_traits.hpp"
 #include "realm/index_string.hpp"
+#include "realm/index_ordered.hpp"
+#include "realm/index_substring.hpp"
 #include "realm/cluster_tree.hpp"
 #include "realm/spec.hpp"
 #include "realm/table_view.hpp"
@@ -261,6 +263,8 @@ int64_t ConstObj::_get<int64_t>(ColKey::Idx col_ndx) const
 
     ref_type ref = to_ref(Array::get(m_mem.get_addr(), col_ndx.val + 1));
     char* header = alloc.translate(ref);
+    if (REALM_UNLIKELY(Array::get_wtype_from_header(header) == Array::wtype_Offset))
+        return Array::get(header, m_row_ndx);
     int width = Array::get_width_from_header(header);
     char* data = Array::get_data_from_header(header);
     REALM_TEMPEX(return get_direct, width, (data, m_row_ndx));
@@ -343,6 +347,21 @@ BinaryData ConstObj::_get<BinaryData>(ColKey::Idx col_ndx) const
     return ArrayBinary::get(alloc.translate(ref), m_row_ndx, alloc);
 }
 
+size_t ConstObj::get_enum_index(ColKey col_key) const
+{
+    m_table->report_invalid_key(col_key);
+    REALM_ASSERT(m_table->is_enumerated(col_key));
+    auto col_ndx = col_key.get_index();
+    auto& alloc = _get_alloc();
+    if (alloc.get_storage_version() != m_storage_version) {
+        update();
+    }
+
+    // The leaf of an enumerated column is a plain integer array of the indexes
+    ref_type ref = to_ref(Array::get(m_mem.get_addr(), col_ndx.val + 1));
+    return size_t(Array::get(alloc.translate(ref), m_row_ndx));
+}
+
 Mixed ConstObj::get_any(ColKey col_key) const
 {
     m_table->report_invalid_key(col_key);
@@ -806,6 +825,9 @@ Obj& Obj::set<int64_t>(ColKey col_key, int64_t value, bool is_default)
     if (StringIndex* index = m_table->get_search_index(col_key)) {
         index->set<int64_t>(m_key, value);
     }
+    if (OrderedIndex* index = m_table->get_ordered_index(col_key)) {
+        index->set(m_key, value);
+    }
 
     Allocator& alloc = get_alloc();
     alloc.bump_content_version();
@@ -864,6 +886,9 @@ Obj& Obj::add_int(ColKey col_key, int64_t value)
             if (StringIndex* index = m_table->get_search_index(col_key)) {
                 index->set<int64_t>(m_key, new_val);
             }
+            if (OrderedIndex* index = m_table->get_ordered_index(col_key)) {
+                index->set(m_key, new_val);
+            }
             values.set(m_row_ndx, new_val);
         }
         else {
@@ -879,6 +904,9 @@ Obj& Obj::add_int(ColKey col_key, int64_t value)
         if (StringIndex* index = m_table->get_search_index(col_key)) {
             index->set<int64_t>(m_key, new_val);
         }
+        if (OrderedIndex* index = m_table->get_ordered_index(col_key)) {
+            index->set(m_key, new_val);
+        }
         values.set(m_row_ndx, new_val);
     }
 
@@ -984,7 +1012,19 @@ Obj& Obj::set(ColKey col_key, T value, bool is_default)
     ensure_writeable();
 
     if (StringIndex* index = m_table->get_search_index(col_key)) {
-        index->set<T>(m_key, value);
+        // A nullable float or double column stores null as a NaN, which must not be indexed as NaN
+        if (value_is_null(value)) {
+            index->set(m_key, null{});
+        }
+        else {
+            index->set<T>(m_key, value);
+        }
+    }
+    if (OrderedIndex* index = m_table->get_ordered_index(col_key)) {
+        index->set(m_key, value);
+    }
+    if (SubstringIndex* index = m_table->get_substring_index(col_key)) {
+        index->set(m_key, value);
     }
 
     Allocator& alloc = get_alloc();
@@ -1276,6 +1316,12 @@ Obj& Obj::set_null(ColKey col_key, bool is_default)
         if (StringIndex* index = m_table->get_search_index(col_key)) {
             index->set(m_key, null{});
         }
+        if (OrderedIndex* index = m_table->get_ordered_index(col_key)) {
+            index->set(m_key, Mixed());
+        }
+        if (SubstringIndex* index = m_table->get_substring_index(col_key)) {
+            index->set(m_key, Mixed());
+        }
 
         switch (col_type) {
             case col_type_Int:
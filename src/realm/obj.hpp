@@ -102,6 +102,9 @@ public:
     U get(ColKey col_key) const;
 
     Mixed get_any(ColKey col_key) const;
+    // The index of the value in the table of unique values of an enumerated String column (see
+    // Table::enumerate_string_column()). Objects have equal values exactly if they have the same index.
+    size_t get_enum_index(ColKey col_key) const;
 
     template <typename U>
     U get(StringData col_name) const
@@ -19,9 +19,55 @@
 #include <realm/obj_list.hpp>
 #include <realm/table.hpp>
 #include <realm/sort_descriptor.hpp>
+#include <realm/index_ordered.hpp>
 
 using namespace realm;
 
+namespace {
+
+// Gather the rows of a view in the order of a single column sort by walking the ordered index on the column,
+// stopping once 'limit' rows are found. Objects with equal values are kept in view order by the sort, and in key
+// order by the index, so 'view_keys' must be strictly increasing. Returns false if walking the index is likely to be
+// slower than sorting, which is the case if the view only holds a small part of the table.
+bool sort_by_ordered_index(const OrderedIndex& index, bool ascending, const std::vector<ObjKey>& view_keys,
+                           size_t limit, BaseDescriptor::IndexPairs& index_pairs)
+{
+    size_t sz = view_keys.size();
+    size_t index_size = index.size();
+    limit = std::min(limit, sz);
+    // Roughly how many index entries must be visited to find 'limit' rows of the view
+    size_t expected_visits = (limit == sz) ? index_size : std::min(index_size, limit * (index_size / sz + 1));
+    if (expected_visits > 4 * sz)
+        return false;
+
+    index_pairs.reserve(limit);
+    auto visit = [&](size_t ndx) {
+        ObjKey key = index.get_key(ndx);
+        auto it = std::lower_bound(view_keys.begin(), view_keys.end(), key);
+        if (it != view_keys.end() && *it == key)
+            index_pairs.emplace_back(key, it - view_keys.begin());
+    };
+
+    if (ascending) {
+        for (size_t ndx = 0; ndx < index_size && index_pairs.size() < limit; ++ndx)
+            visit(ndx);
+    }
+    else {
+        // Visit groups of equal values from the end, but the entries within each group in key order
+        size_t group_end = index_size;
+        while (group_end > 0 && index_pairs.size() < limit) {
+            size_t group_begin = index.lower_bound(index.get_value(group_end - 1));
+            for (size_t ndx = group_begin; ndx < group_end && index_pairs.size() < limit; ++ndx)
+                visit(ndx);
+            group_end = group_begin;
+        }
+    }
+    index_pairs.m_removed_by_limit = sz - index_pairs.size();
+    return true;
+}
+
+} // anonymous namespace
+
 size_t ObjList::size() const
 {
     return m_key_values->size();
@@ -41,33 +87,104 @@ void ObjList::do_sort(const DescriptorOrdering& ordering)
     if (sz == 0)
         return;
 
+    const int num_descriptors = int(ordering.size());
+    int desc_ndx = 0;
+
     // Gather the current rows into a container we can use std algorithms on
     size_t detached_ref_count = 0;
     BaseDescriptor::IndexPairs index_pairs;
-    index_pairs.reserve(sz);
-    // always put any detached refs at the end of the sort
-    // FIXME: reconsider if this is the right thing to do
-    // FIXME: consider specialized implementations in derived classes
-    // (handling detached refs is not required in linkviews)
-    for (size_t t = 0; t < sz; t++) {
-        ObjKey key = get_key(t);
-        if (m_table->is_valid(key)) {
-            index_pairs.emplace_back(key, t);
+
+    if (ordering.get_type(0) == DescriptorType::Sort) {
+        // A single column sort on a column with an ordered index can read the order from the index
+        auto sort_descr = static_cast<const SortDescriptor*>(ordering[0]);
+        const OrderedIndex* index = nullptr;
+        if (sort_descr->get_column_count() == 1 && !sort_descr->has_links())
+            index = m_table->get_ordered_index(sort_descr->get_column_keys(0)[0]);
+        if (index) {
+            std::vector<ObjKey> view_keys;
+            view_keys.reserve(sz);
+            for (size_t t = 0; t < sz; t++) {
+                ObjKey key = get_key(t);
+                if (!m_table->is_valid(key) || (t > 0 && !(view_keys.back() < key))) {
+                    view_keys.clear();
+                    break;
+                }
+                view_keys.push_back(key);
+            }
+            bool has_limit = num_descriptors >= 2 && ordering.get_type(1) == DescriptorType::Limit;
+            size_t limit = has_limit ? static_cast<const LimitDescriptor*>(ordering[1])->get_limit() : size_t(-1);
+            if (view_keys.size() == sz &&
+                sort_by_ordered_index(*index, *sort_descr->is_ascending(0), view_keys, limit, index_pairs)) {
+                // Renumber like SortDescriptor::execute() does when more descriptors follow
+                for (size_t i = 0; i < index_pairs.size(); ++i)
+                    index_pairs[i].index_in_view = i;
+                desc_ndx = has_limit ? 2 : 1;
+            }
         }
-        else
-            ++detached_ref_count;
     }
 
-    const int num_descriptors = int(ordering.size());
-    for (int desc_ndx = 0; desc_ndx < num_descriptors; ++desc_ndx) {
+    if (desc_ndx == 0 && num_descriptors >= 2 && ordering.get_type(0) == DescriptorType::Sort &&
+        ordering.get_type(1) == DescriptorType::Limit) {
+        auto sort_descr = static_cast<const SortDescriptor*>(ordering[0]);
+        size_t limit = static_cast<const LimitDescriptor*>(ordering[1])->get_limit();
+        if (limit < sz && !sort_descr->has_links()) {
+            // Only the first 'limit' rows in sorted order survive the limit, so select them with a bounded heap
+            // while gathering. The heap is ordered so that its front is the last of the rows kept so far.
+            BaseDescriptor::Sorter predicate = sort_descr->sorter(get_parent(), index_pairs);
+            index_pairs.reserve(limit);
+            for (size_t t = 0; t < sz; t++) {
+                ObjKey key = get_key(t);
+                if (!m_table->is_valid(key)) {
+                    ++detached_ref_count;
+                    continue;
+                }
+                BaseDescriptor::IndexPair index(key, t);
+                predicate.cache_first_column(index);
+                if (index_pairs.size() < limit) {
+                    index_pairs.push_back(std::move(index));
+                    std::push_heap(index_pairs.begin(), index_pairs.end(), std::ref(predicate));
+                }
+                else if (limit > 0 && predicate(index, index_pairs.front())) {
+                    std::pop_heap(index_pairs.begin(), index_pairs.end(), std::ref(predicate));
+                    index_pairs.back() = std::move(index);
+                    std::push_heap(index_pairs.begin(), index_pairs.end(), std::ref(predicate));
+                }
+            }
+            std::sort_heap(index_pairs.begin(), index_pairs.end(), std::ref(predicate));
+            index_pairs.m_removed_by_limit = sz - detached_ref_count - index_pairs.size();
+
+            // Renumber like SortDescriptor::execute() does when more descriptors follow
+            for (size_t i = 0; i < index_pairs.size(); ++i)
+                index_pairs[i].index_in_view = i;
+            desc_ndx = 2;
+        }
+    }
+
+    if (desc_ndx == 0) {
+        index_pairs.reserve(sz);
+        // always put any detached refs at the end of the sort
+        // FIXME: reconsider if this is the right thing to do
+        // FIXME: consider specialized implementations in derived classes
+        // (handling detached refs is not required in linkviews)
+        for (size_t t = 0; t < sz; t++) {
+            ObjKey key = get_key(t);
+            if (m_table->is_valid(key)) {
+                index_pairs.emplace_back(key, t);
+            }
+            else
+                ++detached_ref_count;
+        }
+    }
+
+    for (; desc_ndx < num_descriptors; ++desc_ndx) {
         const BaseDescriptor* base_descr = ordering[desc_ndx];
         const BaseDescriptor* next = ((desc_ndx + 1) < num_descriptors) ? ordering[desc_ndx + 1] : nullptr;
         BaseDescriptor::Sorter predicate = base_descr->sorter(get_parent(), index_pairs);
 
         // Sorting can be specified by multiple columns, so that if two entries in the first column are
-        // identical, then the rows are ordered according to the second column, and so forth. For the
-        // first column, we cache all the payload of fields of the view in a std::vector<Mixed>
-        predicate.cache_first_column(index_pairs);
+        // identical, then the rows are ordered according to the second column, and so forth. The
+        // payload of all the columns is extracted up front so the comparisons need not look up objects.
+        predicate.cache_columns(index_pairs);
 
         base_descr->execute(index_pairs, predicate, next);
     }
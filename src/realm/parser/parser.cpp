@@ -156,9 +156,18 @@ struct agg_none
 struct agg_shortcut_pred : sor<agg_any, agg_all, agg_none> {
 };
 
+// list of values eg: {1, 2, $0}
+struct list_begin : one<'{'> {
+};
+struct list_element : sor<dq_string, sq_string, timestamp, number, argument, true_value, false_value, null_value,
+                          base64> {
+};
+struct value_list : seq<list_begin, pad<opt<list<list_element, one<','>, blank>>, blank>, one<'}'>> {
+};
+
 // expressions and operators
 struct expr : sor<dq_string, sq_string, timestamp, number, argument, true_value, false_value, null_value, base64,
-                  collection_operator_match, subquery, key_path> {
+                  value_list, collection_operator_match, subquery, key_path> {
 };
 struct case_insensitive : TAOCPP_PEGTL_ISTRING("[c]") {};
 
@@ -274,6 +283,8 @@ struct ParserState
     bool negate_next = false;
     Predicate::Type next_type = Predicate::Type::And;
     Expression* last_expression = nullptr;
+    // the list being parsed, which the following values are added to
+    Expression* current_list = nullptr;
 
     void add_collection_aggregate_expression()
     {
@@ -291,6 +302,10 @@ struct ParserState
 
     void add_expression(Expression && exp)
     {
+        if (current_list) {
+            current_list->list.push_back(std::move(exp));
+            return;
+        }
         Predicate *current = last_predicate();
         if (current->type == Predicate::Type::Comparison && current->cmpr.expr[1].type == parser::Expression::Type::None) {
             current->cmpr.expr[1] = std::move(exp);
@@ -402,6 +417,27 @@ EXPRESSION_ACTION(null_value, Expression::Type::Null)
 EXPRESSION_ACTION(argument_index, Expression::Type::Argument)
 EXPRESSION_ACTION(base64, Expression::Type::Base64)
 
+template <>
+struct action<list_begin> {
+    template <typename Input>
+    static void apply(const Input& in, ParserState& state)
+    {
+        DEBUG_PRINT_TOKEN(in.string() + "<BEGIN LIST>");
+        state.add_expression(Expression(Expression::Type::List));
+        state.current_list = state.last_expression;
+    }
+};
+
+template <>
+struct action<value_list> {
+    template <typename Input>
+    static void apply(const Input& in, ParserState& state)
+    {
+        DEBUG_PRINT_TOKEN(in.string() + "<END LIST>");
+        state.current_list = nullptr;
+    }
+};
+
 template<> struct action< timestamp >
 {
     template< typename Input >
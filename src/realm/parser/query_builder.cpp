@@ -693,11 +693,77 @@ bool is_property_operation(parser::Expression::Type type)
     return type == parser::Expression::Type::KeyPath || type == parser::Expression::Type::SubQuery;
 }
 
+void add_comparison_to_query(Query& query, const Predicate& pred, Arguments& args, parser::KeyPathMapping& mapping);
+
+// "property IN {value, value, ...}" is a lookup of the values in a hash set if the property is a column of the
+// queried table which supports it, and otherwise the equivalent chain of ORed equality comparisons
+void add_list_comparison_to_query(Query& query, const Predicate& pred, Arguments& args,
+                                  parser::KeyPathMapping& mapping)
+{
+    const Predicate::Comparison& cmpr = pred.cmpr;
+    realm_precondition(is_property_operation(cmpr.expr[0].type),
+                       "The expression preceeding 'IN' a list of values must be a keypath");
+    realm_precondition(cmpr.compare_type == Predicate::ComparisonType::Unspecified,
+                       "A list of values can not be compared with 'ANY', 'ALL' or 'NONE'");
+    const std::vector<parser::Expression>& elements = cmpr.expr[1].list;
+
+    ExpressionContainer lhs(query, cmpr.expr[0], args, mapping);
+    if (lhs.type == ExpressionContainer::ExpressionInternal::exp_Property &&
+        cmpr.option == Predicate::OperatorOption::None && lhs.get_property().link_chain.size() == 1) {
+        ColKey col_key = lhs.get_property().get_dest_col_key();
+        DataType type = lhs.get_property().get_dest_type();
+        if (!col_key.get_attrs().test(col_attr_List) &&
+            (type == type_Int || type == type_String || type == type_Timestamp)) {
+            std::vector<Mixed> values;
+            values.reserve(elements.size());
+            for (auto& element : elements) {
+                ValueExpression value(&args, &element);
+                if (value.is_null()) {
+                    values.emplace_back();
+                }
+                else if (type == type_Int) {
+                    values.emplace_back(value.value_of_type_for_query<Int>());
+                }
+                else if (type == type_String) {
+                    values.emplace_back(value.value_of_type_for_query<StringData>());
+                }
+                else {
+                    values.emplace_back(value.value_of_type_for_query<Timestamp>());
+                }
+            }
+            query.in(col_key, values);
+            return;
+        }
+    }
+
+    query.group();
+    for (auto& element : elements) {
+        Predicate equal(Predicate::Type::Comparison);
+        equal.cmpr = cmpr;
+        equal.cmpr.op = Predicate::Operator::Equal;
+        equal.cmpr.expr[1] = element;
+        query.Or();
+        add_comparison_to_query(query, equal, args, mapping);
+    }
+    if (elements.empty()) {
+        query.and_query(std::unique_ptr<realm::Expression>(new FalseExpression));
+    }
+    query.end_group();
+}
+
 void add_comparison_to_query(Query& query, const Predicate& pred, Arguments& args, parser::KeyPathMapping& mapping)
 {
     Predicate::Comparison cmpr = pred.cmpr;
     auto lhs_type = cmpr.expr[0].type, rhs_type = cmpr.expr[1].type;
 
+    realm_precondition(lhs_type != parser::Expression::Type::List,
+                       "A list of values is only supported following 'IN'");
+    if (rhs_type == parser::Expression::Type::List) {
+        realm_precondition(cmpr.op == Predicate::Operator::In, "A list of values is only supported following 'IN'");
+        add_list_comparison_to_query(query, pred, args, mapping);
+        return;
+    }
+
     if (!is_property_operation(lhs_type) && !is_property_operation(rhs_type)) {
         // value vs value expressions are not supported (ex: 2 < 3 or null != null)
         throw std::logic_error("Predicate expressions must compare a keypath and another keypath or a constant value");
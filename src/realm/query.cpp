@@ -25,13 +25,169 @@
 #include <realm/query_expression.hpp>
 #include <realm/table_view.hpp>
 #include <realm/table_tpl.hpp>
+#include <realm/util/scope_exit.hpp>
 
 #include <algorithm>
+#include <exception>
+#include <system_error>
+#include <thread>
 
 
 using namespace realm;
 using namespace realm::metrics;
 
+namespace {
+
+// Minimum number of objects each worker thread must be given before a query is
+// split over several threads. Below this, thread startup dominates.
+constexpr size_t s_min_objects_per_query_thread = 4 * REALM_MAX_BPNODE_SIZE;
+
+// The leaves of a cluster tree divided into contiguous ranges to be evaluated
+// concurrently. The ranges follow key order, so per-range results can be merged
+// in range order to produce the same result as a sequential traversal.
+class ClusterPartitions {
+public:
+    using LeafLocation = ClusterTree::LeafLocation;
+
+    ClusterPartitions(const ClusterTree& tree, size_t max_partitions)
+        : m_tree(tree)
+    {
+        if (max_partitions < 2 || tree.size() < 2 * s_min_objects_per_query_thread) {
+            // Single partition, handled by the caller as a plain traversal
+            m_bounds = {0, 0};
+            return;
+        }
+        tree.get_leaf_locations(m_leaves);
+        size_t num_objects = tree.size();
+        size_t num_partitions = std::min(max_partitions, num_objects / s_min_objects_per_query_thread);
+
+        // Split into ranges holding roughly the same number of objects
+        m_bounds.push_back(0);
+        size_t accumulated = 0;
+        for (size_t i = 0; i + 1 < m_leaves.size() && m_bounds.size() < num_partitions; ++i) {
+            accumulated += m_leaves[i].size;
+            if (accumulated >= num_objects / num_partitions * m_bounds.size())
+                m_bounds.push_back(i + 1);
+        }
+        m_bounds.push_back(m_leaves.size());
+    }
+
+    size_t size() const
+    {
+        return m_bounds.size() - 1;
+    }
+
+    bool traverse(size_t partition, ClusterTree::TraverseFunction func) const
+    {
+        const LeafLocation* leaves = m_leaves.data();
+        return m_tree.traverse(leaves + m_bounds[partition], leaves + m_bounds[partition + 1], func);
+    }
+
+    // Call 'func' with the index of each partition, each on its own thread. The
+    // calling thread handles the first partition. Exceptions thrown by 'func'
+    // are rethrown here once all threads have completed.
+    template <class F>
+    void run(F func) const
+    {
+        size_t n = size();
+        std::vector<std::exception_ptr> errors(n);
+        auto worker = [&func, &errors](size_t partition) {
+            try {
+                func(partition);
+            }
+            catch (...) {
+                errors[partition] = std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(n - 1);
+        {
+            auto join_all = util::make_scope_exit([&threads]() noexcept {
+                for (auto& t : threads)
+                    t.join();
+            });
+            for (size_t i = 1; i < n; ++i) {
+                try {
+                    threads.emplace_back(worker, i);
+                }
+                catch (const std::system_error&) {
+                    // Out of threads, do the work here instead
+                    worker(i);
+                }
+            }
+            worker(0);
+        }
+        for (auto& e : errors) {
+            if (e)
+                std::rethrow_exception(e);
+        }
+    }
+
+private:
+    const ClusterTree& m_tree;
+    std::vector<LeafLocation> m_leaves;
+    std::vector<size_t> m_bounds;
+};
+
+// Each worker thread evaluates its own copy of the node tree, as the nodes cache
+// leaf accessors and statistics while evaluating.
+std::unique_ptr<ParentNode> clone_for_worker(const ParentNode& root)
+{
+    std::unique_ptr<ParentNode> node = root.clone();
+    node->init();
+    std::vector<ParentNode*> vec;
+    node->gather_children(vec);
+    return node;
+}
+
+// Merge the state of a worker into the final state. Workers must be merged in
+// partition order to report the same min/max object as sequential evaluation.
+template <Action action>
+struct QueryStateMerger;
+
+template <>
+struct QueryStateMerger<act_Sum> {
+    template <class R>
+    static void merge(QueryState<R>& dst, const QueryState<R>& src)
+    {
+        dst.m_state += src.m_state;
+        dst.m_match_count += src.m_match_count;
+    }
+};
+
+template <>
+struct QueryStateMerger<act_Count> : QueryStateMerger<act_Sum> {
+};
+
+template <>
+struct QueryStateMerger<act_Max> {
+    template <class R>
+    static void merge(QueryState<R>& dst, const QueryState<R>& src)
+    {
+        if (src.m_match_count && src.m_state > dst.m_state) {
+            dst.m_state = src.m_state;
+            dst.m_minmax_index = src.m_minmax_index;
+        }
+        dst.m_match_count += src.m_match_count;
+    }
+};
+
+template <>
+struct QueryStateMerger<act_Min> {
+    template <class R>
+    static void merge(QueryState<R>& dst, const QueryState<R>& src)
+    {
+        if (src.m_match_count && src.m_state < dst.m_state) {
+            dst.m_state = src.m_state;
+            dst.m_minmax_index = src.m_minmax_index;
+        }
+        dst.m_match_count += src.m_match_count;
+    }
+};
+
+} // anonymous namespace
+
 Query::Query()
 {
     create();
@@ -97,6 +253,7 @@ Query::Query(const Query& source)
     : error_code(source.error_code)
     , m_groups(source.m_groups)
     , m_table(source.m_table)
+    , m_num_threads(source.m_num_threads)
 {
     if (source.m_owned_source_table_view) {
         m_owned_source_table_view = source.m_owned_source_table_view->clone();
@@ -121,6 +278,7 @@ Query& Query::operator=(const Query& source)
     if (this != &source) {
         m_groups = source.m_groups;
         m_table = source.m_table;
+        m_num_threads = source.m_num_threads;
 
         if (source.m_owned_source_table_view) {
             m_owned_source_table_view = source.m_owned_source_table_view->clone();
@@ -166,6 +324,7 @@ Query::Query(const Query* source, Transaction* tr, PayloadPolicy policy)
         m_view = m_source_link_list.get();
     }
     m_groups = source->m_groups;
+    m_num_threads = source->m_num_threads;
     if (source->m_table)
         set_table(tr->import_copy_of(source->m_table));
     // otherwise: empty query.
@@ -625,6 +784,38 @@ Query& Query::links_to(ColKey origin_column, const std::vector<ObjKey>& target_k
     return *this;
 }
 
+Query& Query::in(ColKey column_key, const std::vector<Mixed>& values)
+{
+    m_table->check_column(column_key);
+    if (column_key.get_attrs().test(col_attr_List))
+        throw LogicError{LogicError::type_mismatch};
+
+    std::unique_ptr<ParentNode> node;
+    switch (DataType(column_key.get_type())) {
+        case type_Int:
+            if (column_key.get_attrs().test(col_attr_Nullable)) {
+                node.reset(new InNode<ArrayIntNull>(column_key, values));
+            }
+            else {
+                node.reset(new InNode<ArrayInteger>(column_key, values));
+            }
+            break;
+        case type_String:
+            node.reset(new InNode<ArrayString>(column_key, values));
+            break;
+        case type_Timestamp:
+            node.reset(new InNode<ArrayTimestamp>(column_key, values));
+            break;
+        case type_Link:
+            node.reset(new InNode<ArrayKey>(column_key, values));
+            break;
+        default:
+            throw LogicError{LogicError::type_mismatch};
+    }
+    add_node(std::move(node));
+    return *this;
+}
+
 // int64 constant vs column
 Query& Query::equal(ColKey column_key, int64_t value)
 {
@@ -879,6 +1070,11 @@ bool Query::eval_object(ConstObj& obj) const
     return true;
 }
 
+bool Query::may_read_other_objects() const
+{
+    return has_conditions() && root_node()->may_read_other_objects();
+}
+
 template <Action action, typename T, typename R>
 R Query::aggregate(ColKey column_key, size_t* resultcount, ObjKey* return_ndx) const
 {
@@ -912,24 +1108,61 @@ R Query::aggregate(ColKey column_key, size_t* resultcount, ObjKey* return_ndx) c
             }
             // no index, traverse cluster tree
             node = pn;
-            LeafType leaf(m_table.unchecked_ptr()->get_alloc());
             bool nullable = m_table->is_nullable(column_key);
 
-            for (size_t c = 0; c < node->m_children.size(); c++)
-                node->m_children[c]->aggregate_local_prepare(action, ColumnTypeTraits<T>::id, nullable);
+            ClusterPartitions partitions(m_table.unchecked_ptr()->m_clusters, get_max_worker_threads());
+            if (partitions.size() > 1) {
+                std::vector<std::unique_ptr<ParentNode>> nodes;
+                std::vector<QueryState<ResultType>> states;
+                states.reserve(partitions.size());
+                for (size_t i = 0; i < partitions.size(); i++) {
+                    nodes.push_back(clone_for_worker(*pn));
+                    states.emplace_back(action);
+                }
 
-            auto f = [column_key, &leaf, &node, &st, this](const Cluster* cluster) {
-                size_t e = cluster->node_size();
-                node->set_cluster(cluster);
-                cluster->init_leaf(column_key, &leaf);
-                st.m_key_offset = cluster->get_offset();
-                st.m_key_values = cluster->get_key_array();
-                aggregate_internal(node, &st, 0, e, &leaf);
-                // Continue
-                return false;
-            };
+                partitions.run([&](size_t i) {
+                    ParentNode* worker_node = nodes[i].get();
+                    QueryState<ResultType>* worker_st = &states[i];
+                    LeafType worker_leaf(m_table.unchecked_ptr()->get_alloc());
+                    for (auto child : worker_node->m_children)
+                        child->aggregate_local_prepare(action, ColumnTypeTraits<T>::id, nullable);
+
+                    partitions.traverse(i, [&](const Cluster* cluster) {
+                        if (!worker_node->may_match(cluster))
+                            return false;
+                        worker_node->set_cluster(cluster);
+                        cluster->init_leaf(column_key, &worker_leaf);
+                        worker_st->m_key_offset = cluster->get_offset();
+                        worker_st->m_key_values = cluster->get_key_array();
+                        aggregate_internal(worker_node, worker_st, 0, cluster->node_size(), &worker_leaf);
+                        // Continue
+                        return false;
+                    });
+                });
 
-            m_table.unchecked_ptr()->traverse_clusters(f);
+                for (auto& worker_st : states)
+                    QueryStateMerger<action>::merge(st, worker_st);
+            }
+            else {
+                LeafType leaf(m_table.unchecked_ptr()->get_alloc());
+                for (size_t c = 0; c < node->m_children.size(); c++)
+                    node->m_children[c]->aggregate_local_prepare(action, ColumnTypeTraits<T>::id, nullable);
+
+                auto f = [column_key, &leaf, &node, &st, this](const Cluster* cluster) {
+                    if (!node->may_match(cluster))
+                        return false;
+                    size_t e = cluster->node_size();
+                    node->set_cluster(cluster);
+                    cluster->init_leaf(column_key, &leaf);
+                    st.m_key_offset = cluster->get_offset();
+                    st.m_key_values = cluster->get_key_array();
+                    aggregate_internal(node, &st, 0, e, &leaf);
+                    // Continue
+                    return false;
+                };
+
+                m_table.unchecked_ptr()->traverse_clusters(f);
+            }
         }
         else {
             for (size_t t = 0; t < m_view->size(); t++) {
@@ -952,6 +1185,23 @@ R Query::aggregate(ColKey column_key, size_t* resultcount, ObjKey* return_ndx) c
     }
 }
 
+Query& Query::set_num_threads(size_t num_threads)
+{
+    if (num_threads == 0)
+        num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    m_num_threads = num_threads;
+    return *this;
+}
+
+size_t Query::get_max_worker_threads() const
+{
+    // Only a frozen transaction guarantees that the accessors reached by the
+    // nodes are never refreshed while the workers are running.
+    if (m_num_threads > 1 && m_table->is_frozen())
+        return m_num_threads;
+    return 1;
+}
+
 size_t Query::find_best_node(ParentNode* pn) const
 {
     auto score_compare = [](const ParentNode* a, const ParentNode* b) { return a->cost() < b->cost(); };
@@ -1248,6 +1498,8 @@ ObjKey Query::find()
         auto node = root_node();
         ObjKey key;
         auto f = [&node, &key](const Cluster* cluster) {
+            if (!node->may_match(cluster))
+                return false;
             size_t end = cluster->node_size();
             node->set_cluster(cluster);
             size_t res = node->find_first(0, end);
@@ -1340,6 +1592,48 @@ void Query::find_all(ConstTableView& ret, size_t begin, size_t end, size_t limit
             }
             // no index on best node (and likely no index at all), descend B+-tree
             node = pn;
+            if (begin == 0 && end == m_table->size() && limit == size_t(-1)) {
+                ClusterPartitions partitions(m_table.unchecked_ptr()->m_clusters, get_max_worker_threads());
+                if (partitions.size() > 1) {
+                    std::vector<std::unique_ptr<ParentNode>> nodes;
+                    std::vector<std::unique_ptr<KeyColumn>> results;
+                    auto destroy_results = util::make_scope_exit([&results]() noexcept {
+                        for (auto& keys : results)
+                            keys->destroy();
+                    });
+                    for (size_t i = 0; i < partitions.size(); i++) {
+                        nodes.push_back(clone_for_worker(*pn));
+                        results.push_back(std::make_unique<KeyColumn>(Allocator::get_default()));
+                        results.back()->create();
+                    }
+
+                    partitions.run([&](size_t i) {
+                        ParentNode* worker_node = nodes[i].get();
+                        QueryState<int64_t> worker_st(act_FindAll, results[i].get());
+                        for (auto child : worker_node->m_children)
+                            child->aggregate_local_prepare(act_FindAll, type_Int, false);
+
+                        partitions.traverse(i, [&](const Cluster* cluster) {
+                            if (!worker_node->may_match(cluster))
+                                return false;
+                            worker_node->set_cluster(cluster);
+                            worker_st.m_key_offset = cluster->get_offset();
+                            worker_st.m_key_values = cluster->get_key_array();
+                            aggregate_internal(worker_node, &worker_st, 0, cluster->node_size(), nullptr);
+                            // Continue
+                            return false;
+                        });
+                    });
+
+                    // Partitions are in key order, so the results can simply be concatenated
+                    for (auto& keys : results) {
+                        for (auto key : keys->get_all())
+                            ret.m_key_values->add(key);
+                    }
+                    return;
+                }
+            }
+
             QueryState<int64_t> st(act_FindAll, ret.m_key_values, limit);
 
             for (size_t c = 0; c < node->m_children.size(); c++)
@@ -1351,10 +1645,12 @@ void Query::find_all(ConstTableView& ret, size_t begin, size_t end, size_t limit
                     if (e > end) {
                         e = end;
                     }
-                    node->set_cluster(cluster);
-                    st.m_key_offset = cluster->get_offset();
-                    st.m_key_values = cluster->get_key_array();
-                    aggregate_internal(node, &st, begin, e, nullptr);
+                    if (node->may_match(cluster)) {
+                        node->set_cluster(cluster);
+                        st.m_key_offset = cluster->get_offset();
+                        st.m_key_values = cluster->get_key_array();
+                        aggregate_internal(node, &st, begin, e, nullptr);
+                    }
                     begin = 0;
                 }
                 else {
@@ -1427,12 +1723,47 @@ size_t Query::do_count(size_t limit) const
         }
         // no index, descend down the B+-tree instead
         node = pn;
+        if (limit == size_t(-1)) {
+            ClusterPartitions partitions(m_table.unchecked_ptr()->m_clusters, get_max_worker_threads());
+            if (partitions.size() > 1) {
+                std::vector<std::unique_ptr<ParentNode>> nodes;
+                std::vector<size_t> counts(partitions.size());
+                for (size_t i = 0; i < partitions.size(); i++)
+                    nodes.push_back(clone_for_worker(*pn));
+
+                partitions.run([&](size_t i) {
+                    ParentNode* worker_node = nodes[i].get();
+                    QueryState<int64_t> worker_st(act_Count);
+                    for (auto child : worker_node->m_children)
+                        child->aggregate_local_prepare(act_Count, type_Int, false);
+
+                    partitions.traverse(i, [&](const Cluster* cluster) {
+                        if (!worker_node->may_match(cluster))
+                            return false;
+                        worker_node->set_cluster(cluster);
+                        worker_st.m_key_offset = cluster->get_offset();
+                        worker_st.m_key_values = cluster->get_key_array();
+                        aggregate_internal(worker_node, &worker_st, 0, cluster->node_size(), nullptr);
+                        // Continue
+                        return false;
+                    });
+                    counts[i] = size_t(worker_st.m_state);
+                });
+
+                for (auto c : counts)
+                    cnt += c;
+                return cnt;
+            }
+        }
+
         QueryState<int64_t> st(act_Count, limit);
 
         for (size_t c = 0; c < node->m_children.size(); c++)
             node->m_children[c]->aggregate_local_prepare(act_Count, type_Int, false);
 
         auto f = [&node, &st, this](const Cluster* cluster) {
+            if (!node->may_match(cluster))
+                return false;
             size_t e = cluster->node_size();
             node->set_cluster(cluster);
             st.m_key_offset = cluster->get_offset();
@@ -1528,136 +1859,6 @@ size_t Query::remove()
     return rows;
 }
 
-#if REALM_MULTITHREAD_QUERY
-TableView Query::find_all_multi(size_t start, size_t end)
-{
-    static_cast<void>(start);
-    static_cast<void>(end);
-
-    // Initialization
-    init();
-    ts.next_job = start;
-    ts.end_job = end;
-    ts.done_job = 0;
-    ts.count = 0;
-    ts.table = &table;
-    ts.node = first[0];
-
-    // Signal all threads to start
-    pthread_mutex_unlock(&ts.jobs_mutex);
-    pthread_cond_broadcast(&ts.jobs_cond);
-
-    // Wait until all threads have completed
-    pthread_mutex_lock(&ts.completed_mutex);
-    while (ts.done_job < ts.end_job)
-        pthread_cond_wait(&ts.completed_cond, &ts.completed_mutex);
-    pthread_mutex_lock(&ts.jobs_mutex);
-    pthread_mutex_unlock(&ts.completed_mutex);
-
-    TableView tv(*m_table);
-
-    // Sort search results because user expects ascending order
-    sort(ts.chunks.begin(), ts.chunks.end(), &Query::comp);
-    for (size_t i = 0; i < ts.chunks.size(); ++i) {
-        const size_t from = ts.chunks[i].m_root_node;
-        const size_t upto = (i == ts.chunks.size() - 1) ? size_t(-1) : ts.chunks[i + 1].m_root_node;
-        size_t first = ts.chunks[i].second;
-
-        while (first < ts.results.size() && ts.results[first] < upto && ts.results[first] >= from) {
-            tv.get_ref_column().add(ts.results[first]);
-            ++first;
-        }
-    }
-
-    return move(tv);
-}
-
-int Query::set_threads(unsigned int threadcount)
-{
-#if defined(_WIN32) || defined(__WIN32__) || defined(_WIN64)
-    pthread_win32_process_attach_np();
-#endif
-    pthread_mutex_init(&ts.result_mutex, nullptr);
-    pthread_cond_init(&ts.completed_cond, nullptr);
-    pthread_mutex_init(&ts.jobs_mutex, nullptr);
-    pthread_mutex_init(&ts.completed_mutex, nullptr);
-    pthread_cond_init(&ts.jobs_cond, nullptr);
-
-    pthread_mutex_lock(&ts.jobs_mutex);
-
-    for (size_t i = 0; i < m_threadcount; ++i)
-        pthread_detach(threads[i]);
-
-    for (size_t i = 0; i < threadcount; ++i) {
-        int r = pthread_create(&threads[i], nullptr, query_thread, (void*)&ts);
-        if (r != 0)
-            REALM_ASSERT(false); // todo
-    }
-    m_threadcount = threadcount;
-    return 0;
-}
-
-
-void* Query::query_thread(void* arg)
-{
-    static_cast<void>(arg);
-    thread_state* ts = static_cast<thread_state*>(arg);
-
-    std::vector<size_t> res;
-    std::vector<pair<size_t, size_t>> chunks;
-
-    for (;;) {
-        // Main waiting loop that waits for a query to start
-        pthread_mutex_lock(&ts->jobs_mutex);
-        while (ts->next_job == ts->end_job)
-            pthread_cond_wait(&ts->jobs_cond, &ts->jobs_mutex);
-        pthread_mutex_unlock(&ts->jobs_mutex);
-
-        for (;;) {
-            // Pick a job
-            pthread_mutex_lock(&ts->jobs_mutex);
-            if (ts->next_job == ts->end_job)
-                break;
-            const size_t chunk = min(ts->end_job - ts->next_job, thread_chunk_size);
-            const size_t mine = ts->next_job;
-            ts->next_job += chunk;
-            size_t r = mine - 1;
-            const size_t end = mine + chunk;
-
-            pthread_mutex_unlock(&ts->jobs_mutex);
-
-            // Execute job
-            for (;;) {
-                r = ts->node->find_first(r + 1, end);
-                if (r == end)
-                    break;
-                res.push_back(r);
-            }
-
-            // Append result in common queue shared by all threads.
-            pthread_mutex_lock(&ts->result_mutex);
-            ts->done_job += chunk;
-            if (res.size() > 0) {
-                ts->chunks.push_back(std::pair<size_t, size_t>(mine, ts->results.size()));
-                ts->count += res.size();
-                for (size_t i = 0; i < res.size(); i++) {
-                    ts->results.push_back(res[i]);
-                }
-                res.clear();
-            }
-            pthread_mutex_unlock(&ts->result_mutex);
-
-            // Signal main thread that we might have compleeted
-            pthread_mutex_lock(&ts->completed_mutex);
-            pthread_cond_signal(&ts->completed_cond);
-            pthread_mutex_unlock(&ts->completed_mutex);
-        }
-    }
-    return 0;
-}
-
-#endif // REALM_MULTITHREADQUERY
-
 std::string Query::validate()
 {
     if (!m_groups.size())
@@ -26,18 +26,11 @@
 #include <string>
 #include <vector>
 
-#define REALM_MULTITHREAD_QUERY 0
-
-#if REALM_MULTITHREAD_QUERY
-// FIXME: Use our C++ thread abstraction API since it provides a much
-// higher level of encapsulation and safety.
-#include <pthread.h>
-#endif
-
 #include <realm/obj_list.hpp>
 #include <realm/table_ref.hpp>
 #include <realm/binary_data.hpp>
 #include <realm/timestamp.hpp>
+#include <realm/mixed.hpp>
 #include <realm/handover_defs.hpp>
 #include <realm/util/serializer.hpp>
 
@@ -100,6 +93,10 @@ public:
     // Find links that point to specific target objects
     Query& links_to(ColKey column_key, const std::vector<ObjKey>& target_obj);
 
+    // Find objects whose value in a column is one of 'values', which may include null. Supported for Int, String,
+    // Timestamp and Link columns; the values must be of the type of the column, ObjKey for links.
+    Query& in(ColKey column_key, const std::vector<Mixed>& values);
+
     // Conditions: null
     Query& equal(ColKey column_key, null);
     Query& not_equal(ColKey column_key, null);
@@ -248,12 +245,19 @@ public:
     // Deletion
     size_t remove();
 
-#if REALM_MULTITHREAD_QUERY
     // Multi-threading
-    TableView find_all_multi(size_t start = 0, size_t end = size_t(-1));
-    ConstTableView find_all_multi(size_t start = 0, size_t end = size_t(-1)) const;
-    int set_threads(unsigned int threadcount);
-#endif
+    //
+    // When the query is bound to a table of a frozen transaction, find_all(),
+    // count() and the aggregates may split the table's clusters over up to
+    // 'num_threads' threads. The results are the same as for single-threaded
+    // execution. Restricting views, limits and index lookups are always
+    // evaluated on the calling thread. A value of 0 selects the number of
+    // hardware threads.
+    Query& set_num_threads(size_t num_threads);
+    size_t get_num_threads() const
+    {
+        return m_num_threads;
+    }
 
     ConstTableRef& get_table()
     {
@@ -280,6 +284,10 @@ public:
 
     bool eval_object(ConstObj& obj) const;
 
+    // True if whether an object matches may depend on other objects than that one, such as the targets of its
+    // links, or on the contents of its lists.
+    bool may_read_other_objects() const;
+
 private:
     void create();
 
@@ -332,6 +340,7 @@ private:
     template <Action action, typename T, typename R>
     R aggregate(ColKey column_key, size_t* resultcount = nullptr, ObjKey* return_ndx = nullptr) const;
 
+    size_t get_max_worker_threads() const;
     size_t find_best_node(ParentNode* pn) const;
     void aggregate_internal(ParentNode* pn, QueryStateBase* st, size_t start, size_t end,
                             ArrayPayload* source_column) const;
@@ -373,6 +382,8 @@ private:
     LnkLstPtr m_source_link_list;                  // link lists are owned by the query.
     ConstTableView* m_source_table_view = nullptr; // table views are not refcounted, and not owned by the query.
     std::unique_ptr<ConstTableView> m_owned_source_table_view; // <--- except when indicated here
+
+    size_t m_num_threads = 1;
 };
 
 // Implementation:
@@ -41,7 +41,7 @@ ParentNode::ParentNode(const ParentNode& from)
 size_t ParentNode::find_first(size_t start, size_t end)
 {
     size_t sz = m_children.size();
-    size_t current_cond = 0;
+    size_t current_cond = m_first_cond;
     size_t nb_cond_to_test = sz;
 
     while (REALM_LIKELY(start < end)) {
@@ -67,6 +67,42 @@ size_t ParentNode::find_first(size_t start, size_t end)
     return not_found;
 }
 
+void ParentNode::find_matches(size_t start, size_t end, MatchBitmap& matches)
+{
+    matches.reset(start, end);
+    find_matches_local(start, end, matches);
+
+    MatchBitmap child_matches;
+    for (ParentNode* child = m_child.get(); child; child = child->m_child.get()) {
+        size_t num_matches = matches.count();
+        if (num_matches == 0)
+            return;
+        // When few rows remain, testing them one by one is cheaper than evaluating the condition for the whole range
+        if (num_matches * 16 < end - start) {
+            for (size_t r = matches.find_first(start, end); r != not_found; r = matches.find_first(r + 1, end)) {
+                if (child->find_first_local(r, r + 1) != r)
+                    matches.clear(r);
+            }
+        }
+        else {
+            child_matches.reset(start, end);
+            child->find_matches_local(start, end, child_matches);
+            matches &= child_matches;
+        }
+    }
+}
+
+void ParentNode::find_matches_local(size_t start, size_t end, MatchBitmap& matches)
+{
+    while (start < end) {
+        size_t m = find_first_local(start, end);
+        if (m == not_found)
+            break;
+        matches.set(m);
+        start = m + 1;
+    }
+}
+
 bool ParentNode::match(ConstObj& obj)
 {
     auto cb = [this](const Cluster* cluster, size_t row) {
@@ -222,6 +258,7 @@ void StringNodeEqualBase::init()
     if (m_has_search_index) {
         // Will set m_index_matches, m_index_matches_destroy, m_results_start and m_results_end
         _search_index_init();
+        m_dD = double(m_table->size()) / (m_results_end - m_results_start + 1.0);
     }
 }
 
@@ -329,9 +366,51 @@ void StringNode<Equal>::consume_condition(StringNode<Equal>* other)
     }
 }
 
+void StringNode<Equal>::init()
+{
+    StringNodeEqualBase::init();
+    m_enum_needles_resolved = false;
+}
+
+void StringNode<Equal>::resolve_enum_needles()
+{
+    // The table of unique values is shared by all leaves of the column, and it does not change while the query
+    // runs, so this is done once, on the first enumerated leaf
+    if (m_needles.empty()) {
+        m_enum_index = m_leaf_ptr->find_enum_index(m_value);
+    }
+    else {
+        size_t num_values = m_leaf_ptr->get_num_enum_values();
+        m_enum_matches.assign(num_values, false);
+        for (size_t i = 0; i < num_values; ++i)
+            m_enum_matches[i] = m_needles.count(m_leaf_ptr->get_enum_value(i)) != 0;
+    }
+    m_enum_needles_resolved = true;
+}
+
 size_t StringNode<Equal>::_find_first_local(size_t start, size_t end)
 {
+    if (m_leaf_ptr->is_enumerated()) {
+        // Compare the indexes into the table of unique values instead of the strings
+        if (!m_enum_needles_resolved)
+            resolve_enum_needles();
+        end = std::min(end, m_leaf_ptr->size());
+        if (m_needles.empty()) {
+            if (m_enum_index == not_found)
+                return not_found;
+            return m_leaf_ptr->find_first_enum_index(m_enum_index, start, end);
+        }
+        for (size_t i = start; i < end; ++i) {
+            if (m_enum_matches[m_leaf_ptr->get_enum_index(i)])
+                return i;
+        }
+        return not_found;
+    }
+
     if (m_needles.empty()) {
+        size_t res;
+        if (m_value && !m_value->empty() && find_first_match<Equal>(start, end, res))
+            return res;
         return m_leaf_ptr->find_first(m_value, start, end);
     }
     else {
@@ -420,7 +499,15 @@ size_t StringNode<EqualIns>::_find_first_local(size_t start, size_t end)
 
 size_t NotNode::find_first_local(size_t start, size_t end)
 {
-    if (start <= m_known_range_start && end >= m_known_range_end) {
+    if (m_matches.covers(start, end)) {
+        return m_matches.find_first(start, end);
+    }
+    else if (end - start >= bitmap_min_rows) {
+        m_condition->find_matches(start, end, m_matches);
+        m_matches.invert();
+        return m_matches.find_first(start, end);
+    }
+    else if (start <= m_known_range_start && end >= m_known_range_end) {
         return find_first_covers_known(start, end);
     }
     else if (start >= m_known_range_start && end <= m_known_range_end) {
@@ -589,6 +676,11 @@ void ExpressionNode::collect_dependencies(std::vector<TableKey>& tables) const
     m_expression->collect_dependencies(tables);
 }
 
+bool ExpressionNode::may_read_other_objects_local() const
+{
+    return m_expression->may_read_other_objects();
+}
+
 size_t ExpressionNode::find_first_local(size_t start, size_t end)
 {
     return m_expression->find_first(start, end);
@@ -604,3 +696,36 @@ ExpressionNode::ExpressionNode(const ExpressionNode& from)
     , m_expression(from.m_expression->clone())
 {
 }
+
+template <>
+size_t InNode<ArrayString>::find_first_local(size_t start, size_t end)
+{
+    if (m_has_search_index)
+        return (start < end) ? m_index_evaluator.find_first_local(m_cluster, start, end) : not_found;
+
+    const Values& values = *m_values;
+    if (m_leaf_ptr->is_enumerated()) {
+        // The table of unique values is shared by all leaves of the column, so it is resolved once
+        if (!m_enum_matches_resolved) {
+            size_t num_values = m_leaf_ptr->get_num_enum_values();
+            m_enum_matches.assign(num_values, false);
+            for (size_t i = 0; i < num_values; ++i) {
+                StringData value = m_leaf_ptr->get_enum_value(i);
+                m_enum_matches[i] = value.is_null() ? values.has_null : values.set.count(value) != 0;
+            }
+            m_enum_matches_resolved = true;
+        }
+        for (size_t i = start; i < end; ++i) {
+            if (m_enum_matches[m_leaf_ptr->get_enum_index(i)])
+                return i;
+        }
+        return not_found;
+    }
+
+    for (size_t i = start; i < end; ++i) {
+        StringData value = m_leaf_ptr->get(i);
+        if (value.is_null() ? values.has_null : values.set.count(value) != 0)
+            return i;
+    }
+    return not_found;
+}
@@ -54,6 +54,10 @@ find_first_local(n, n + 1) is a function that can be used to test a single row o
 this is very simplified. There are other statistical arguments to the methods, and also, find_first_local() can be
 called from a callback function called by an integer Array.
 
+OrNode and NotNode combine the results of other conditions. When asked for a range of at least bitmap_min_rows rows,
+they evaluate their conditions for the whole range into a MatchBitmap with find_matches(), and combine the bitmaps a
+word at a time before answering find_first_local() from the result.
+
 
 Template arguments in methods:
 ----------------------------------------------------------------------------------------------------
@@ -89,6 +93,7 @@ AggregateState      State of the aggregate - contains a state variable that stor
 #include <sstream>
 #include <string>
 #include <array>
+#include <cmath>
 
 #include <realm/array_basic.hpp>
 #include <realm/array_key.hpp>
@@ -109,6 +114,8 @@ AggregateState      State of the aggregate - contains a state variable that stor
 #include <realm/util/string_buffer.hpp>
 #include <realm/utilities.hpp>
 #include <realm/index_string.hpp>
+#include <realm/index_ordered.hpp>
+#include <realm/index_substring.hpp>
 
 #include <map>
 #include <unordered_set>
@@ -137,6 +144,150 @@ const size_t bitwidth_time_unit = 64;
 typedef bool (*CallbackDummy)(int64_t);
 using Evaluator = util::FunctionRef<bool(ConstObj& obj)>;
 
+// Minimum number of rows for which OrNode and NotNode evaluate their conditions into a MatchBitmap instead of
+// searching them one match at a time. Narrower ranges are typically single rows probed for another condition.
+const size_t bitmap_min_rows = 64;
+
+// The rows matching a condition within the range [begin, end) of the rows of a cluster, one bit per row. Bitmaps of
+// the same range are combined a word at a time, so an OR, AND or NOT of conditions costs a few instructions per 64
+// rows on top of the evaluation of the conditions themselves.
+class MatchBitmap {
+public:
+    // Set the range of the bitmap, with no rows matching
+    void reset(size_t begin, size_t end)
+    {
+        REALM_ASSERT_DEBUG(begin <= end);
+        m_begin = begin;
+        m_end = end;
+        m_words.assign((end - begin + 63) / 64, 0);
+    }
+
+    size_t begin() const noexcept
+    {
+        return m_begin;
+    }
+
+    size_t end() const noexcept
+    {
+        return m_end;
+    }
+
+    bool covers(size_t begin, size_t end) const noexcept
+    {
+        return m_begin <= begin && end <= m_end && m_begin < m_end;
+    }
+
+    void set(size_t row) noexcept
+    {
+        REALM_ASSERT_DEBUG(row >= m_begin && row < m_end);
+        size_t i = row - m_begin;
+        m_words[i / 64] |= uint64_t(1) << (i % 64);
+    }
+
+    void clear(size_t row) noexcept
+    {
+        REALM_ASSERT_DEBUG(row >= m_begin && row < m_end);
+        size_t i = row - m_begin;
+        m_words[i / 64] &= ~(uint64_t(1) << (i % 64));
+    }
+
+    bool get(size_t row) const noexcept
+    {
+        REALM_ASSERT_DEBUG(row >= m_begin && row < m_end);
+        size_t i = row - m_begin;
+        return (m_words[i / 64] >> (i % 64)) & 1;
+    }
+
+    void set_all() noexcept
+    {
+        std::fill(m_words.begin(), m_words.end(), ~uint64_t(0));
+        clear_unused_bits();
+    }
+
+    bool none() const noexcept
+    {
+        for (auto w : m_words) {
+            if (w)
+                return false;
+        }
+        return true;
+    }
+
+    bool all() const noexcept
+    {
+        size_t n = m_end - m_begin;
+        for (size_t i = 0; i < n / 64; ++i) {
+            if (~m_words[i])
+                return false;
+        }
+        return n % 64 == 0 || m_words.back() == (uint64_t(1) << (n % 64)) - 1;
+    }
+
+    size_t count() const noexcept
+    {
+        size_t n = 0;
+        for (auto w : m_words)
+            n += size_t(fast_popcount64(int64_t(w)));
+        return n;
+    }
+
+    // The bitmaps must have the same range
+    MatchBitmap& operator|=(const MatchBitmap& other) noexcept
+    {
+        REALM_ASSERT_DEBUG(m_begin == other.m_begin && m_end == other.m_end);
+        for (size_t i = 0; i < m_words.size(); ++i)
+            m_words[i] |= other.m_words[i];
+        return *this;
+    }
+
+    MatchBitmap& operator&=(const MatchBitmap& other) noexcept
+    {
+        REALM_ASSERT_DEBUG(m_begin == other.m_begin && m_end == other.m_end);
+        for (size_t i = 0; i < m_words.size(); ++i)
+            m_words[i] &= other.m_words[i];
+        return *this;
+    }
+
+    void invert() noexcept
+    {
+        for (auto& w : m_words)
+            w = ~w;
+        clear_unused_bits();
+    }
+
+    // The first matching row in [start, end), which must be within the range of the bitmap
+    size_t find_first(size_t start, size_t end) const noexcept
+    {
+        REALM_ASSERT_DEBUG(start >= m_begin && end <= m_end);
+        if (start >= end)
+            return not_found;
+        size_t i = start - m_begin;
+        size_t n = end - m_begin;
+        for (size_t w = i / 64; w * 64 < n; ++w) {
+            uint64_t bits = m_words[w];
+            if (w == i / 64)
+                bits &= ~uint64_t(0) << (i % 64);
+            if (bits) {
+                size_t s = w * 64 + size_t(fast_popcount64(int64_t((bits & (0 - bits)) - 1)));
+                return s < n ? m_begin + s : not_found;
+            }
+        }
+        return not_found;
+    }
+
+private:
+    size_t m_begin = 0;
+    size_t m_end = 0;
+    std::vector<uint64_t> m_words;
+
+    void clear_unused_bits() noexcept
+    {
+        size_t n = m_end - m_begin;
+        if (n % 64)
+            m_words.back() &= (uint64_t(1) << (n % 64)) - 1;
+    }
+};
+
 class ParentNode {
     typedef ParentNode ThisType;
 
@@ -162,6 +313,14 @@ public:
         m_children = v;
         m_children.erase(m_children.begin() + i);
         m_children.insert(m_children.begin(), this);
+
+        // The nodes are initialized before they are gathered, so the cost estimates are known. find_first() starts
+        // with the condition expected to skip the most objects.
+        m_first_cond = 0;
+        for (size_t c = 1; c < m_children.size(); c++) {
+            if (m_children[c]->cost() < m_children[m_first_cond]->cost())
+                m_first_cond = c;
+        }
     }
 
     double cost() const
@@ -211,12 +370,48 @@ public:
         cluster_changed();
     }
 
+    // Check if objects in 'cluster' may match this and the following conditions, according to the zone map
+    // summarizing the cluster, if any. If not, the cluster can be skipped.
+    bool may_match(const Cluster* cluster) const
+    {
+        if (!may_match_local(cluster))
+            return false;
+        return !m_child || m_child->may_match(cluster);
+    }
+
+    virtual bool may_match_local(const Cluster*) const
+    {
+        return true;
+    }
+
+    // Check if whether an object matches this and the following conditions may depend on other objects than that
+    // one, such as the targets of its links, or on the contents of its lists
+    bool may_read_other_objects() const
+    {
+        if (may_read_other_objects_local())
+            return true;
+        return m_child && m_child->may_read_other_objects();
+    }
+
+    virtual bool may_read_other_objects_local() const
+    {
+        return false;
+    }
+
     virtual void collect_dependencies(std::vector<TableKey>&) const
     {
     }
 
     virtual size_t find_first_local(size_t start, size_t end) = 0;
 
+    // Set 'matches' to the rows in [start, end) matching this and the following conditions. The conditions are
+    // evaluated one at a time over the whole range and combined with a word wide AND.
+    void find_matches(size_t start, size_t end, MatchBitmap& matches);
+
+    // Set the bits in 'matches', whose range must include [start, end), of the rows in [start, end) matching this
+    // condition. The default implementation collects the results of find_first_local().
+    virtual void find_matches_local(size_t start, size_t end, MatchBitmap& matches);
+
     virtual void aggregate_local_prepare(Action TAction, DataType col_id, bool nullable);
 
     template <Action TAction, class LeafType>
@@ -304,6 +499,7 @@ public:
 
     std::unique_ptr<ParentNode> m_child;
     std::vector<ParentNode*> m_children;
+    size_t m_first_cond = 0; // Index in m_children of the condition find_first() starts with
     std::string m_condition_column_name;
     mutable ColKey m_condition_column_key = ColKey(); // Column of search criteria
 
@@ -435,6 +631,365 @@ protected:
     ArrayPayload* m_source_column = nullptr;
 };
 
+// The keys of the objects found through a search index, sorted by key. Keeps track of how far the query engine has
+// got while visiting the clusters, so that find_first_local() can be served without looking at the column.
+class IndexEvaluator {
+public:
+    void init()
+    {
+        m_results_ndx = 0;
+        m_last_start_key = ObjKey();
+    }
+
+    std::vector<ObjKey>& results()
+    {
+        return m_results;
+    }
+
+    size_t find_first_local(const Cluster* cluster, size_t start, size_t end)
+    {
+        ObjKey first_key = cluster->get_real_key(start);
+        if (first_key < m_last_start_key) {
+            // We are not advancing through the clusters. We basically don't know where we are,
+            // so just start over from the beginning.
+            auto it = std::lower_bound(m_results.begin(), m_results.end(), first_key);
+            m_results_ndx = (it == m_results.end()) ? realm::npos : (it - m_results.begin());
+        }
+        m_last_start_key = first_key;
+
+        if (m_results_ndx < m_results.size()) {
+            auto actual_key = m_results[m_results_ndx];
+            // skip through keys which are in "earlier" leafs than the one selected by start..end:
+            while (first_key > actual_key) {
+                m_results_ndx++;
+                if (m_results_ndx == m_results.size())
+                    return not_found;
+                actual_key = m_results[m_results_ndx];
+            }
+
+            // if actual key is bigger than last key, it is not in this leaf
+            ObjKey last_key = cluster->get_real_key(end - 1);
+            if (actual_key > last_key)
+                return not_found;
+
+            // key is known to be in this leaf, so find key whithin leaf keys
+            return cluster->lower_bound_key(ObjKey(actual_key.value - cluster->get_offset()));
+        }
+        return not_found;
+    }
+
+    void index_based_aggregate(const Table* table, size_t limit, Evaluator evaluator) const
+    {
+        for (size_t t = 0; t < m_results.size() && limit > 0; ++t) {
+            auto obj = table->get_object(m_results[t]);
+            if (evaluator(obj)) {
+                --limit;
+            }
+        }
+    }
+
+private:
+    std::vector<ObjKey> m_results;
+    size_t m_results_ndx = 0;
+    ObjKey m_last_start_key;
+};
+
+// Range [begin, end) of the entries in an ordered index matching a condition against a non-null value. Returns false
+// if the condition can not be answered by the index.
+template <class TConditionFunction>
+inline bool ordered_index_range(const OrderedIndex&, Mixed, size_t&, size_t&)
+{
+    return false;
+}
+
+template <>
+inline bool ordered_index_range<Greater>(const OrderedIndex& index, Mixed value, size_t& begin, size_t& end)
+{
+    begin = index.upper_bound(value);
+    end = index.size();
+    return true;
+}
+
+template <>
+inline bool ordered_index_range<GreaterEqual>(const OrderedIndex& index, Mixed value, size_t& begin, size_t& end)
+{
+    begin = index.lower_bound(value);
+    end = index.size();
+    return true;
+}
+
+template <>
+inline bool ordered_index_range<Less>(const OrderedIndex& index, Mixed value, size_t& begin, size_t& end)
+{
+    // Nulls are ordered first, and never match
+    begin = index.upper_bound(Mixed());
+    end = index.lower_bound(value);
+    return true;
+}
+
+template <>
+inline bool ordered_index_range<LessEqual>(const OrderedIndex& index, Mixed value, size_t& begin, size_t& end)
+{
+    begin = index.upper_bound(Mixed());
+    end = index.upper_bound(value);
+    return true;
+}
+
+// Look up the objects matching a range condition through the ordered index on the column, if there is one. Every
+// match found this way costs an object lookup, so the index is only used if it rules out most of the table; in that
+// case the matches are stored in 'evaluator', 'dD' is set to the average distance between them and true is returned.
+template <class TConditionFunction>
+bool init_ordered_index_evaluator(const Table* table, ColKey col_key, Mixed value, IndexEvaluator& evaluator,
+                                  double& dD)
+{
+    evaluator.results().clear();
+    if (value.is_null() || !table->valid_column(col_key))
+        return false;
+    const OrderedIndex* index = table->get_ordered_index(col_key);
+    if (!index)
+        return false;
+
+    size_t begin = 0;
+    size_t end = 0;
+    if (!ordered_index_range<TConditionFunction>(*index, value, begin, end))
+        return false;
+    size_t num_matches = (begin < end) ? end - begin : 0;
+    if (num_matches > index->size() / 4)
+        return false;
+
+    index->find_all(evaluator.results(), begin, begin + num_matches);
+    evaluator.init();
+    dD = double(index->size()) / (num_matches + 1.0);
+    return true;
+}
+
+// Check if a leaf whose values are summarized by 'range' may hold a value matching a condition against the value
+// represented by 'key', see zone_map_key(). Conditions that zone maps can not help with are assumed to match.
+template <class TConditionFunction>
+inline bool range_may_match(const ValueRange&, int64_t)
+{
+    return true;
+}
+
+template <>
+inline bool range_may_match<Equal>(const ValueRange& range, int64_t key)
+{
+    return range.min <= key && key <= range.max;
+}
+
+template <>
+inline bool range_may_match<NotEqual>(const ValueRange& range, int64_t key)
+{
+    return range.null_count > 0 || range.min != key || range.max != key;
+}
+
+template <>
+inline bool range_may_match<Greater>(const ValueRange& range, int64_t key)
+{
+    return range.max > key;
+}
+
+template <>
+inline bool range_may_match<GreaterEqual>(const ValueRange& range, int64_t key)
+{
+    return range.max >= key;
+}
+
+template <>
+inline bool range_may_match<Less>(const ValueRange& range, int64_t key)
+{
+    return range.min < key;
+}
+
+template <>
+inline bool range_may_match<LessEqual>(const ValueRange& range, int64_t key)
+{
+    return range.min <= key;
+}
+
+// As range_may_match(), for a condition against null
+template <class TConditionFunction>
+inline bool range_may_match_null(const ValueRange&)
+{
+    return true;
+}
+
+template <>
+inline bool range_may_match_null<Equal>(const ValueRange& range)
+{
+    return range.null_count > 0;
+}
+
+template <>
+inline bool range_may_match_null<NotEqual>(const ValueRange& range)
+{
+    return range.null_count < range.size;
+}
+
+template <class TConditionFunction>
+inline bool value_may_match(const ValueRange& range, int64_t value)
+{
+    return range_may_match<TConditionFunction>(range, value);
+}
+
+template <class TConditionFunction>
+inline bool value_may_match(const ValueRange& range, util::Optional<int64_t> value)
+{
+    return value ? range_may_match<TConditionFunction>(range, *value) : range_may_match_null<TConditionFunction>(range);
+}
+
+// Timestamps are summarized by their seconds, so strict comparisons must include the bounds, and values not equal
+// to a timestamp can not be ruled out
+template <class TConditionFunction>
+struct SecondsCondition {
+    using type = TConditionFunction;
+};
+
+template <>
+struct SecondsCondition<Greater> {
+    using type = GreaterEqual;
+};
+
+template <>
+struct SecondsCondition<Less> {
+    using type = LessEqual;
+};
+
+template <>
+struct SecondsCondition<NotEqual> {
+    using type = void;
+};
+
+// The fraction of the values in a leaf summarized by 'range' which are less than 'key', assuming that they are
+// spread evenly over the range
+inline double range_fraction_below(const ValueRange& range, double key)
+{
+    double fraction = (key - double(range.min)) / (double(range.max) - double(range.min) + 1.0);
+    return std::min(std::max(fraction, 0.0), 1.0);
+}
+
+// Estimate the number of values in a leaf summarized by 'range' which match a condition against the value
+// represented by 'key'. Returns a negative number if no estimate can be made.
+template <class TConditionFunction>
+inline double estimate_range_matches(const ValueRange&, int64_t)
+{
+    return -1;
+}
+
+template <>
+inline double estimate_range_matches<Equal>(const ValueRange& range, int64_t key)
+{
+    if (key < range.min || key > range.max)
+        return 0;
+    double num_values = double(range.size - range.null_count);
+    // The number of distinct values is bounded by the width of the range
+    double num_distinct = std::min(num_values, double(range.max) - double(range.min) + 1.0);
+    return num_values / num_distinct;
+}
+
+template <>
+inline double estimate_range_matches<NotEqual>(const ValueRange& range, int64_t key)
+{
+    return double(range.size) - estimate_range_matches<Equal>(range, key);
+}
+
+template <>
+inline double estimate_range_matches<Less>(const ValueRange& range, int64_t key)
+{
+    if (range.min > range.max)
+        return 0;
+    return double(range.size - range.null_count) * range_fraction_below(range, double(key));
+}
+
+template <>
+inline double estimate_range_matches<LessEqual>(const ValueRange& range, int64_t key)
+{
+    if (range.min > range.max)
+        return 0;
+    return double(range.size - range.null_count) * range_fraction_below(range, double(key) + 1.0);
+}
+
+template <>
+inline double estimate_range_matches<Greater>(const ValueRange& range, int64_t key)
+{
+    if (range.min > range.max)
+        return 0;
+    return double(range.size - range.null_count) * (1.0 - range_fraction_below(range, double(key) + 1.0));
+}
+
+template <>
+inline double estimate_range_matches<GreaterEqual>(const ValueRange& range, int64_t key)
+{
+    if (range.min > range.max)
+        return 0;
+    return double(range.size - range.null_count) * (1.0 - range_fraction_below(range, double(key)));
+}
+
+// As estimate_range_matches(), for a condition against null
+template <class TConditionFunction>
+inline double estimate_range_matches_null(const ValueRange&)
+{
+    return -1;
+}
+
+template <>
+inline double estimate_range_matches_null<Equal>(const ValueRange& range)
+{
+    return double(range.null_count);
+}
+
+template <>
+inline double estimate_range_matches_null<NotEqual>(const ValueRange& range)
+{
+    return double(range.size - range.null_count);
+}
+
+template <class TConditionFunction>
+inline double estimate_value_matches(const ValueRange& range, int64_t value)
+{
+    return estimate_range_matches<TConditionFunction>(range, value);
+}
+
+template <class TConditionFunction>
+inline double estimate_value_matches(const ValueRange& range, util::Optional<int64_t> value)
+{
+    return value ? estimate_range_matches<TConditionFunction>(range, *value)
+                 : estimate_range_matches_null<TConditionFunction>(range);
+}
+
+// Estimate the average distance between the objects matching a condition on a column from the statistics of the
+// column, see Table::get_column_statistics(). 'estimate' is called with the value range of each sampled leaf and
+// returns the estimated number of matches in the leaf, or a negative number if no estimate can be made. Returns false,
+// leaving 'dD' unchanged, if there are no statistics or no estimate can be made.
+template <class F>
+bool estimate_match_distance(const Table* table, ColKey col_key, F estimate, double& dD)
+{
+    if (!table->valid_column(col_key))
+        return false;
+    auto stats = table->get_column_statistics(col_key);
+    if (!stats)
+        return false;
+    // A sample of evenly spaced leaves is enough for an estimate, and keeps the cost of initializing a condition
+    // independent of the size of the table
+    constexpr size_t max_samples = 64;
+    size_t num_ranges = stats->ranges.size();
+    size_t step = (num_ranges + max_samples - 1) / max_samples;
+    double num_matches = 0;
+    size_t num_sampled = 0;
+    for (size_t i = 0; i < num_ranges; i += step) {
+        auto& range = stats->ranges[i];
+        double n = estimate(range);
+        if (n < 0)
+            return false;
+        num_matches += n;
+        num_sampled += range.size;
+    }
+    // Leaves not sampled are assumed to be like the others
+    num_matches *= double(stats->num_objects) / double(num_sampled);
+    dD = double(stats->num_objects) / (num_matches + 1.0);
+    return true;
+}
+
 template <class LeafType>
 class IntegerNodeBase : public ColumnNodeBase {
     using ThisType = IntegerNodeBase<LeafType>;
@@ -639,6 +1194,34 @@ public:
     {
     }
 
+    void init() override
+    {
+        BaseType::init();
+        m_has_search_index = init_ordered_index_evaluator<TConditionFunction>(
+            this->m_table.unchecked_ptr(), this->m_condition_column_key, Mixed(this->m_value), m_index_evaluator,
+            this->m_dD);
+        if (m_has_search_index) {
+            this->m_dT = 0;
+        }
+        else {
+            auto value = this->m_value;
+            estimate_match_distance(
+                this->m_table.unchecked_ptr(), this->m_condition_column_key,
+                [value](const ValueRange& range) { return estimate_value_matches<TConditionFunction>(range, value); },
+                this->m_dD);
+        }
+    }
+
+    bool has_search_index() const override
+    {
+        return m_has_search_index;
+    }
+
+    void index_based_aggregate(size_t limit, Evaluator evaluator) override
+    {
+        m_index_evaluator.index_based_aggregate(this->m_table.unchecked_ptr(), limit, evaluator);
+    }
+
     void aggregate_local_prepare(Action action, DataType col_id, bool is_nullable) override
     {
         this->m_fastmode_disabled = (col_id == type_Float || col_id == type_Double);
@@ -657,9 +1240,34 @@ public:
 
     size_t find_first_local(size_t start, size_t end) override
     {
+        if (m_has_search_index)
+            return (start < end) ? m_index_evaluator.find_first_local(this->m_cluster, start, end) : not_found;
         return this->m_leaf_ptr->template find_first<TConditionFunction>(this->m_value, start, end);
     }
 
+    void find_matches_local(size_t start, size_t end, MatchBitmap& matches) override
+    {
+        if (m_has_search_index || start >= end) {
+            ParentNode::find_matches_local(start, end, matches);
+            return;
+        }
+        // Collect all matches in one pass of the array search
+        auto cb = [&matches](int64_t i) {
+            matches.set(size_t(i));
+            return true;
+        };
+        this->m_leaf_ptr->template find<TConditionFunction, act_CallbackIdx>(this->m_value, start, end, 0, nullptr,
+                                                                              cb);
+    }
+
+    bool may_match_local(const Cluster* cluster) const override
+    {
+        ValueRange range;
+        if (!cluster->get_value_range(this->m_condition_column_key, range))
+            return true;
+        return value_may_match<TConditionFunction>(range, this->m_value);
+    }
+
     std::string describe(util::serializer::SerialisationState& state) const override
     {
         return state.describe_column(ParentNode::m_table, ColumnNodeBase::m_condition_column_key) + " " +
@@ -675,6 +1283,10 @@ public:
     {
         return std::unique_ptr<ParentNode>(new ThisType(*this));
     }
+
+private:
+    IndexEvaluator m_index_evaluator;
+    bool m_has_search_index = false;
 };
 
 template <class LeafType>
@@ -699,12 +1311,27 @@ public:
 
         if (has_search_index()) {
             // _search_index_init();
-            m_result.clear();
+            m_index_evaluator.results().clear();
             auto index = ParentNode::m_table->get_search_index(ParentNode::m_condition_column_key);
-            index->find_all(m_result, BaseType::m_value);
-            m_result_get = 0;
-            m_last_start_key = ObjKey();
+            index->find_all(m_index_evaluator.results(), BaseType::m_value);
+            m_index_evaluator.init();
             IntegerNodeBase<LeafType>::m_dT = 0;
+            IntegerNodeBase<LeafType>::m_dD =
+                double(ParentNode::m_table->size()) / (m_index_evaluator.results().size() + 1.0);
+        }
+        else {
+            auto value = BaseType::m_value;
+            const auto& needles = m_needles;
+            estimate_match_distance(ParentNode::m_table.unchecked_ptr(), ParentNode::m_condition_column_key,
+                                    [value, &needles](const ValueRange& range) {
+                                        if (needles.empty())
+                                            return estimate_value_matches<Equal>(range, value);
+                                        double n = 0;
+                                        for (auto& needle : needles)
+                                            n += estimate_value_matches<Equal>(range, needle);
+                                        return n;
+                                    },
+                                    IntegerNodeBase<LeafType>::m_dD);
         }
     }
 
@@ -725,12 +1352,7 @@ public:
 
     void index_based_aggregate(size_t limit, Evaluator evaluator) override
     {
-        for (size_t t = 0; t < m_result.size() && limit > 0; ++t) {
-            auto obj = this->m_table->get_object(m_result[t]);
-            if (evaluator(obj)) {
-                --limit;
-            }
-        }
+        m_index_evaluator.index_based_aggregate(this->m_table.unchecked_ptr(), limit, evaluator);
     }
 
     void aggregate_local_prepare(Action action, DataType col_id, bool is_nullable) override
@@ -755,35 +1377,7 @@ public:
 
         if (start < end) {
             if (has_search_index()) {
-                ObjKey first_key = BaseType::m_cluster->get_real_key(start);
-                if (first_key < m_last_start_key) {
-                    // We are not advancing through the clusters. We basically don't know where we are,
-                    // so just start over from the beginning.
-                    auto it = std::lower_bound(m_result.begin(), m_result.end(), first_key);
-                    m_result_get = (it == m_result.end()) ? realm::npos : (it - m_result.begin());
-                }
-                m_last_start_key = first_key;
-
-                if (m_result_get < m_result.size()) {
-                    auto actual_key = m_result[m_result_get];
-                    // skip through keys which are in "earlier" leafs than the one selected by start..end:
-                    while (first_key > actual_key) {
-                        m_result_get++;
-                        if (m_result_get == m_result.size())
-                            return not_found;
-                        actual_key = m_result[m_result_get];
-                    }
-
-                    // if actual key is bigger than last key, it is not in this leaf
-                    ObjKey last_key = BaseType::m_cluster->get_real_key(end - 1);
-                    if (actual_key > last_key)
-                        return not_found;
-
-                    // key is known to be in this leaf, so find key whithin leaf keys
-                    return BaseType::m_cluster->lower_bound_key(
-                        ObjKey(actual_key.value - BaseType::m_cluster->get_offset()));
-                }
-                return not_found;
+                return m_index_evaluator.find_first_local(BaseType::m_cluster, start, end);
             }
 
             if (m_nb_needles) {
@@ -802,6 +1396,33 @@ public:
         return s;
     }
 
+    void find_matches_local(size_t start, size_t end, MatchBitmap& matches) override
+    {
+        if (m_nb_needles || start >= end || has_search_index()) {
+            ParentNode::find_matches_local(start, end, matches);
+            return;
+        }
+        auto cb = [&matches](int64_t i) {
+            matches.set(size_t(i));
+            return true;
+        };
+        this->m_leaf_ptr->template find<Equal, act_CallbackIdx>(this->m_value, start, end, 0, nullptr, cb);
+    }
+
+    bool may_match_local(const Cluster* cluster) const override
+    {
+        ValueRange range;
+        if (!cluster->get_value_range(this->m_condition_column_key, range))
+            return true;
+        if (m_needles.empty())
+            return value_may_match<Equal>(range, this->m_value);
+        for (auto& needle : m_needles) {
+            if (value_may_match<Equal>(range, needle))
+                return true;
+        }
+        return false;
+    }
+
     std::string describe(util::serializer::SerialisationState& state) const override
     {
         REALM_ASSERT(this->m_condition_column_key);
@@ -833,10 +1454,8 @@ public:
 
 private:
     std::unordered_set<TConditionValue> m_needles;
-    std::vector<ObjKey> m_result;
+    IndexEvaluator m_index_evaluator;
     size_t m_nb_needles = 0;
-    size_t m_result_get = 0;
-    ObjKey m_last_start_key;
 
     IntegerNode(const IntegerNode<LeafType, Equal>& from)
         : BaseType(from)
@@ -909,10 +1528,58 @@ public:
     {
         ParentNode::init();
         m_dD = 100.0;
+
+        // Only equality can be answered by the search index. A nullable column stores null as a special NaN, so
+        // that is looked up as null, while any other NaN will find nothing.
+        m_has_search_index = false;
+        if (std::is_same<TConditionFunction, Equal>::value && m_table->valid_column(m_condition_column_key)) {
+            if (StringIndex* index = m_table->get_search_index(m_condition_column_key)) {
+                auto& results = m_index_evaluator.results();
+                results.clear();
+                if (null::is_null_float(m_value)) {
+                    index->find_all(results, null{});
+                }
+                else {
+                    index->find_all(results, m_value);
+                }
+                m_index_evaluator.init();
+                m_has_search_index = true;
+                m_dD = double(m_table->size()) / (results.size() + 1.0);
+            }
+        }
+        m_dT = m_has_search_index ? 0.0 : 1.0;
+        if (m_has_search_index)
+            return;
+
+        if (null::is_null_float(m_value)) {
+            estimate_match_distance(
+                m_table.unchecked_ptr(), m_condition_column_key,
+                [](const ValueRange& range) { return estimate_range_matches_null<TConditionFunction>(range); }, m_dD);
+        }
+        else if (!std::isnan(m_value)) {
+            int64_t key = zone_map_key(m_value);
+            estimate_match_distance(
+                m_table.unchecked_ptr(), m_condition_column_key,
+                [key](const ValueRange& range) { return estimate_range_matches<TConditionFunction>(range, key); },
+                m_dD);
+        }
+    }
+
+    bool has_search_index() const override
+    {
+        return m_has_search_index;
+    }
+
+    void index_based_aggregate(size_t limit, Evaluator evaluator) override
+    {
+        m_index_evaluator.index_based_aggregate(m_table.unchecked_ptr(), limit, evaluator);
     }
 
     size_t find_first_local(size_t start, size_t end) override
     {
+        if (m_has_search_index)
+            return (start < end) ? m_index_evaluator.find_first_local(m_cluster, start, end) : not_found;
+
         TConditionFunction cond;
 
         auto find = [&](bool nullability) {
@@ -933,6 +1600,19 @@ public:
             return find(false);
     }
 
+    bool may_match_local(const Cluster* cluster) const override
+    {
+        ValueRange range;
+        if (!cluster->get_value_range(m_condition_column_key, range))
+            return true;
+        if (null::is_null_float(m_value))
+            return range_may_match_null<TConditionFunction>(range);
+        // NaN does not order with other values
+        if (std::isnan(m_value))
+            return true;
+        return range_may_match<TConditionFunction>(range, zone_map_key(m_value));
+    }
+
     std::string describe(util::serializer::SerialisationState& state) const override
     {
         REALM_ASSERT(m_condition_column_key);
@@ -963,6 +1643,8 @@ protected:
     LeafCacheStorage m_leaf_cache_storage;
     LeafPtr m_array_ptr;
     const LeafType* m_leaf_ptr = nullptr;
+    IndexEvaluator m_index_evaluator;
+    bool m_has_search_index = false;
 };
 
 template <class T, class TConditionFunction>
@@ -1281,11 +1963,58 @@ class TimestampNode : public TimestampNodeBase {
 public:
     using TimestampNodeBase::TimestampNodeBase;
 
+    void init() override
+    {
+        TimestampNodeBase::init();
+        m_has_search_index = init_ordered_index_evaluator<TConditionFunction>(
+            m_table.unchecked_ptr(), m_condition_column_key, Mixed(m_value), m_index_evaluator, m_dD);
+        if (m_has_search_index) {
+            m_dT = 0;
+        }
+        else if (m_value.is_null()) {
+            estimate_match_distance(
+                m_table.unchecked_ptr(), m_condition_column_key,
+                [](const ValueRange& range) { return estimate_range_matches_null<TConditionFunction>(range); }, m_dD);
+        }
+        else {
+            // The statistics only hold the seconds, which is precise enough for an estimate
+            int64_t seconds = m_value.get_seconds();
+            estimate_match_distance(
+                m_table.unchecked_ptr(), m_condition_column_key,
+                [seconds](const ValueRange& range) {
+                    return estimate_range_matches<TConditionFunction>(range, seconds);
+                },
+                m_dD);
+        }
+    }
+
+    bool has_search_index() const override
+    {
+        return m_has_search_index;
+    }
+
+    void index_based_aggregate(size_t limit, Evaluator evaluator) override
+    {
+        m_index_evaluator.index_based_aggregate(m_table.unchecked_ptr(), limit, evaluator);
+    }
+
     size_t find_first_local(size_t start, size_t end) override
     {
+        if (m_has_search_index)
+            return (start < end) ? m_index_evaluator.find_first_local(m_cluster, start, end) : not_found;
         return m_leaf_ptr->find_first<TConditionFunction>(m_value, start, end);
     }
 
+    bool may_match_local(const Cluster* cluster) const override
+    {
+        ValueRange range;
+        if (!cluster->get_value_range(m_condition_column_key, range))
+            return true;
+        if (m_value.is_null())
+            return range_may_match_null<TConditionFunction>(range);
+        return range_may_match<typename SecondsCondition<TConditionFunction>::type>(range, zone_map_key(m_value));
+    }
+
     std::string describe(util::serializer::SerialisationState& state) const override
     {
         REALM_ASSERT(m_condition_column_key);
@@ -1297,8 +2026,75 @@ public:
     {
         return std::unique_ptr<ParentNode>(new TimestampNode(*this));
     }
+
+private:
+    IndexEvaluator m_index_evaluator;
+    bool m_has_search_index = false;
 };
 
+// The trigrams that every string matching a condition against 'value' contains, used to look up candidates in a
+// SubstringIndex. 'upper' and 'lower' are the upper and lower case versions of 'value'. No trigrams are added for
+// conditions that the index can not answer.
+template <class TConditionFunction>
+inline void substring_index_trigrams(StringData, StringData, StringData, std::vector<int64_t>&)
+{
+}
+
+template <>
+inline void substring_index_trigrams<Contains>(StringData value, StringData, StringData,
+                                               std::vector<int64_t>& trigrams)
+{
+    SubstringIndex::get_needle_trigrams(value, value, false, false, trigrams);
+}
+
+template <>
+inline void substring_index_trigrams<ContainsIns>(StringData, StringData upper, StringData lower,
+                                                  std::vector<int64_t>& trigrams)
+{
+    SubstringIndex::get_needle_trigrams(upper, lower, false, false, trigrams);
+}
+
+template <>
+inline void substring_index_trigrams<BeginsWith>(StringData value, StringData, StringData,
+                                                 std::vector<int64_t>& trigrams)
+{
+    SubstringIndex::get_needle_trigrams(value, value, true, false, trigrams);
+}
+
+template <>
+inline void substring_index_trigrams<BeginsWithIns>(StringData, StringData upper, StringData lower,
+                                                    std::vector<int64_t>& trigrams)
+{
+    SubstringIndex::get_needle_trigrams(upper, lower, true, false, trigrams);
+}
+
+template <>
+inline void substring_index_trigrams<EndsWith>(StringData value, StringData, StringData,
+                                               std::vector<int64_t>& trigrams)
+{
+    SubstringIndex::get_needle_trigrams(value, value, false, true, trigrams);
+}
+
+template <>
+inline void substring_index_trigrams<EndsWithIns>(StringData, StringData upper, StringData lower,
+                                                  std::vector<int64_t>& trigrams)
+{
+    SubstringIndex::get_needle_trigrams(upper, lower, false, true, trigrams);
+}
+
+template <>
+inline void substring_index_trigrams<Like>(StringData value, StringData, StringData, std::vector<int64_t>& trigrams)
+{
+    SubstringIndex::get_pattern_trigrams(value, value, trigrams);
+}
+
+template <>
+inline void substring_index_trigrams<LikeIns>(StringData, StringData upper, StringData lower,
+                                              std::vector<int64_t>& trigrams)
+{
+    SubstringIndex::get_pattern_trigrams(upper, lower, trigrams);
+}
+
 class StringNodeBase : public ParentNode {
 public:
     using TConditionValue = StringData;
@@ -1326,6 +2122,8 @@ public:
         m_array_ptr = LeafPtr(new (&m_leaf_cache_storage) ArrayString(m_table.unchecked_ptr()->get_alloc()));
         m_cluster->init_leaf(this->m_condition_column_key, m_array_ptr.get());
         m_leaf_ptr = m_array_ptr.get();
+        m_leaf_matches_computed.clear();
+        m_leaf_matches_supported = true;
     }
 
     void init() override
@@ -1366,6 +2164,10 @@ public:
 protected:
     util::Optional<std::string> m_value;
 
+    // Candidates found through a substring index on the column, if m_has_substring_index is set
+    IndexEvaluator m_index_evaluator;
+    bool m_has_substring_index = false;
+
     using LeafCacheStorage = typename std::aligned_storage<sizeof(ArrayString), alignof(ArrayString)>::type;
     using LeafPtr = std::unique_ptr<ArrayString, PlacementDelete>;
     LeafCacheStorage m_leaf_cache_storage;
@@ -1382,6 +2184,93 @@ protected:
     {
         return m_leaf_ptr->get(s);
     }
+
+    // Match bitmaps of the current leaf, computed in blocks of 64 elements on demand, when the condition is
+    // evaluated for a whole leaf at a time (see ArrayString::find_matches()). A block is computed once, so a node
+    // that is asked for one element at a time, as when it is not the first condition, does not rescan the leaf.
+    std::vector<uint64_t> m_leaf_matches;
+    std::vector<bool> m_leaf_matches_computed;
+    bool m_leaf_matches_supported = true;
+
+    // Find the first element in [start, end) of the current leaf satisfying 'Cond' for the node value, which must
+    // be non-null and non-empty. Returns false if the leaf does not support bulk comparison.
+    template <class Cond>
+    bool find_first_match(size_t start, size_t end, size_t& result)
+    {
+        if (!m_leaf_matches_supported)
+            return false;
+        size_t leaf_size = m_leaf_ptr->size();
+        if (m_leaf_matches_computed.empty()) {
+            size_t num_blocks = (leaf_size + 63) / 64;
+            m_leaf_matches.resize(num_blocks);
+            m_leaf_matches_computed.assign(num_blocks, false);
+        }
+
+        StringData value(m_value);
+        end = std::min(end, leaf_size);
+        for (size_t block = start / 64; block * 64 < end; ++block) {
+            size_t block_begin = block * 64;
+            if (!m_leaf_matches_computed[block]) {
+                size_t block_end = std::min(block_begin + 64, leaf_size);
+                if (!m_leaf_ptr->find_matches<Cond>(value, block_begin, block_end, &m_leaf_matches[block])) {
+                    m_leaf_matches_supported = false;
+                    return false;
+                }
+                m_leaf_matches_computed[block] = true;
+            }
+            uint64_t bits = m_leaf_matches[block];
+            if (start > block_begin)
+                bits &= ~uint64_t(0) << (start - block_begin);
+            if (bits) {
+                size_t s = block_begin + size_t(fast_popcount64(int64_t((bits & (0 - bits)) - 1)));
+                result = s < end ? s : not_found;
+                return true;
+            }
+        }
+        result = not_found;
+        return true;
+    }
+
+    // Look up the candidates for a condition through the substring index on the column, if there is one. As for
+    // the ordered index, every candidate costs an object lookup, so the index is only used if it rules out most of
+    // the table.
+    template <class TConditionFunction>
+    void init_substring_index(StringData upper, StringData lower)
+    {
+        m_has_substring_index = false;
+        m_index_evaluator.results().clear();
+        const Table* table = m_table.unchecked_ptr();
+        if (!m_value || upper.size() != lower.size() || !table->valid_column(m_condition_column_key))
+            return;
+        const SubstringIndex* index = table->get_substring_index(m_condition_column_key);
+        if (!index)
+            return;
+
+        std::vector<int64_t> trigrams;
+        substring_index_trigrams<TConditionFunction>(StringData(m_value), upper, lower, trigrams);
+        size_t table_size = table->size();
+        if (!index->find_candidates(std::move(trigrams), m_index_evaluator.results(), table_size / 4))
+            return;
+        m_index_evaluator.init();
+        m_dD = double(table_size) / (m_index_evaluator.results().size() + 1.0);
+        m_dT = 0;
+        m_has_substring_index = true;
+    }
+
+    // Find the first candidate in [start, end) for which 'matches' holds for the value
+    template <class Predicate>
+    size_t find_first_candidate(size_t start, size_t end, Predicate matches)
+    {
+        while (start < end) {
+            size_t s = m_index_evaluator.find_first_local(m_cluster, start, end);
+            if (s == not_found)
+                return not_found;
+            if (matches(get_string(s)))
+                return s;
+            start = s + 1;
+        }
+        return not_found;
+    }
 };
 
 // Conditions for strings. Note that Equal is specialized later in this file!
@@ -1409,12 +2298,34 @@ public:
         m_dD = 100.0;
 
         StringNodeBase::init();
+        init_substring_index<TConditionFunction>(m_ucase, m_lcase);
+        m_bulk_scan = (std::is_same<TConditionFunction, BeginsWith>::value ||
+                       std::is_same<TConditionFunction, EndsWith>::value) &&
+                      m_value && !m_value->empty() && !m_has_substring_index;
+    }
+
+    bool has_search_index() const override
+    {
+        return m_has_substring_index;
+    }
+
+    void index_based_aggregate(size_t limit, Evaluator evaluator) override
+    {
+        m_index_evaluator.index_based_aggregate(m_table.unchecked_ptr(), limit, evaluator);
     }
 
     size_t find_first_local(size_t start, size_t end) override
     {
         TConditionFunction cond;
 
+        if (m_has_substring_index) {
+            return find_first_candidate(start, end, [&](StringData t) {
+                return cond(StringData(m_value), m_ucase.c_str(), m_lcase.c_str(), t);
+            });
+        }
+        size_t res;
+        if (m_bulk_scan && find_first_match<TConditionFunction>(start, end, res))
+            return res;
         for (size_t s = start; s < end; ++s) {
             StringData t = get_string(s);
 
@@ -1444,6 +2355,8 @@ public:
 protected:
     std::string m_ucase;
     std::string m_lcase;
+    // Evaluate the condition a leaf at a time, see find_first_match()
+    bool m_bulk_scan = false;
 };
 
 // Specialization for Contains condition on Strings - we specialize because we can utilize Boyer-Moore
@@ -1476,13 +2389,29 @@ public:
         m_dD = 100.0;
 
         StringNodeBase::init();
+        StringData value(m_value);
+        init_substring_index<Contains>(value, value);
     }
 
+    bool has_search_index() const override
+    {
+        return m_has_substring_index;
+    }
+
+    void index_based_aggregate(size_t limit, Evaluator evaluator) override
+    {
+        m_index_evaluator.index_based_aggregate(m_table.unchecked_ptr(), limit, evaluator);
+    }
 
     size_t find_first_local(size_t start, size_t end) override
     {
         Contains cond;
 
+        if (m_has_substring_index) {
+            return find_first_candidate(start, end, [&](StringData t) {
+                return cond(StringData(m_value), m_charmap, t);
+            });
+        }
         for (size_t s = start; s < end; ++s) {
             StringData t = get_string(s);
 
@@ -1555,13 +2484,28 @@ public:
         m_dD = 100.0;
 
         StringNodeBase::init();
+        init_substring_index<ContainsIns>(m_ucase, m_lcase);
     }
 
+    bool has_search_index() const override
+    {
+        return m_has_substring_index;
+    }
+
+    void index_based_aggregate(size_t limit, Evaluator evaluator) override
+    {
+        m_index_evaluator.index_based_aggregate(m_table.unchecked_ptr(), limit, evaluator);
+    }
 
     size_t find_first_local(size_t start, size_t end) override
     {
         ContainsIns cond;
 
+        if (m_has_substring_index) {
+            return find_first_candidate(start, end, [&](StringData t) {
+                return cond(StringData(m_value), m_ucase.c_str(), m_lcase.c_str(), m_charmap, t);
+            });
+        }
         for (size_t s = start; s < end; ++s) {
             StringData t = get_string(s);
             // The current behaviour is to return all results when querying for a null string.
@@ -1668,6 +2612,7 @@ public:
                              m_table.unchecked_ptr()->get_primary_key_column() == m_condition_column_key;
     }
 
+    void init() override;
     void _search_index_init() override;
 
     void consume_condition(StringNode<Equal>* other);
@@ -1730,6 +2675,13 @@ private:
     size_t _find_first_local(size_t start, size_t end) override;
     std::unordered_set<StringData> m_needles;
     std::vector<StringBuffer> m_needle_storage;
+
+    // On enumerated leaves, the needle is represented by its index in the table of unique values of the column
+    // (m_enum_index, not_found if absent), and a set of needles by a flag per unique value (m_enum_matches)
+    void resolve_enum_needles();
+    bool m_enum_needles_resolved = false;
+    size_t m_enum_index = not_found;
+    std::vector<bool> m_enum_matches;
 };
 
 
@@ -1851,6 +2803,8 @@ public:
 
         m_was_match.clear();
         m_was_match.resize(m_conditions.size(), false);
+
+        m_matches.reset(0, 0);
     }
 
     std::string describe(util::serializer::SerialisationState& state) const override
@@ -1877,6 +2831,15 @@ public:
         }
     }
 
+    bool may_read_other_objects_local() const override
+    {
+        for (const auto& cond : m_conditions) {
+            if (cond->may_read_other_objects())
+                return true;
+        }
+        return false;
+    }
+
     void init() override
     {
         ParentNode::init();
@@ -1912,6 +2875,14 @@ public:
         if (start >= end)
             return not_found;
 
+        // Wide ranges are searched by evaluating each condition for the whole range and combining the results
+        if (m_matches.covers(start, end))
+            return m_matches.find_first(start, end);
+        if (end - start >= bitmap_min_rows) {
+            evaluate_matches(start, end);
+            return m_matches.find_first(start, end);
+        }
+
         size_t index = not_found;
 
         for (size_t c = 0; c < m_conditions.size(); ++c) {
@@ -2007,6 +2978,21 @@ private:
     // is a matching index if m_was_match is true
     std::vector<size_t> m_last;
     std::vector<bool> m_was_match;
+
+    // The rows of the current cluster matching any condition, for the range last evaluated
+    MatchBitmap m_matches;
+    MatchBitmap m_condition_matches;
+
+    void evaluate_matches(size_t start, size_t end)
+    {
+        m_matches.reset(start, end);
+        for (auto& condition : m_conditions) {
+            condition->find_matches(start, end, m_condition_matches);
+            m_matches |= m_condition_matches;
+            if (m_matches.all())
+                break;
+        }
+    }
 };
 
 
@@ -2030,6 +3016,7 @@ public:
         m_known_range_start = 0;
         m_known_range_end = 0;
         m_first_in_known_range = not_found;
+        m_matches.reset(0, 0);
     }
 
     void init() override
@@ -2079,6 +3066,11 @@ public:
         }
     }
 
+    bool may_read_other_objects_local() const override
+    {
+        return m_condition && m_condition->may_read_other_objects();
+    }
+
 
     std::unique_ptr<ParentNode> clone() const override
     {
@@ -2101,6 +3093,8 @@ private:
     size_t m_known_range_start;
     size_t m_known_range_end;
     size_t m_first_in_known_range;
+    // The rows of the current cluster not matching the condition, for the range last evaluated as a whole
+    MatchBitmap m_matches;
 
     bool evaluate_at(size_t rowndx);
     void update_known(size_t start, size_t end, size_t first);
@@ -2244,6 +3238,7 @@ public:
     void table_changed() override;
     void cluster_changed() override;
     void collect_dependencies(std::vector<TableKey>&) const override;
+    bool may_read_other_objects_local() const override;
 
     virtual std::string describe(util::serializer::SerialisationState& state) const override;
 
@@ -2307,6 +3302,12 @@ public:
         return "==";
     }
 
+    // Conditions on links are conservatively treated like those following them
+    bool may_read_other_objects_local() const override
+    {
+        return true;
+    }
+
     size_t find_first_local(size_t start, size_t end) override
     {
         if (m_column_type == type_Link) {
@@ -2364,6 +3365,282 @@ private:
     }
 };
 
+
+// The leaf types of the columns supported by InNode. get() returns false if the element is null, from_mixed()
+// converts a non-null value of the condition, keeping a copy of strings in 'strings', and find_all() looks up a
+// value in the search index on the column.
+template <class LeafType>
+struct InNodeTraits;
+
+template <>
+struct InNodeTraits<ArrayInteger> {
+    using ValueType = int64_t;
+    using Hash = std::hash<int64_t>;
+
+    static bool get(const ArrayInteger& leaf, size_t ndx, int64_t& value)
+    {
+        value = leaf.get(ndx);
+        return true;
+    }
+
+    static int64_t from_mixed(Mixed value, std::vector<std::string>&)
+    {
+        if (value.get_type() != type_Int)
+            throw LogicError(LogicError::type_mismatch);
+        return value.get_int();
+    }
+
+    static void find_all(const StringIndex& index, int64_t value, std::vector<ObjKey>& results)
+    {
+        index.find_all(results, value);
+    }
+};
+
+template <>
+struct InNodeTraits<ArrayIntNull> : InNodeTraits<ArrayInteger> {
+    static bool get(const ArrayIntNull& leaf, size_t ndx, int64_t& value)
+    {
+        auto v = leaf.get(ndx);
+        if (!v)
+            return false;
+        value = *v;
+        return true;
+    }
+};
+
+template <>
+struct InNodeTraits<ArrayString> {
+    using ValueType = StringData;
+    using Hash = std::hash<StringData>;
+
+    static bool get(const ArrayString& leaf, size_t ndx, StringData& value)
+    {
+        value = leaf.get(ndx);
+        return !value.is_null();
+    }
+
+    static StringData from_mixed(Mixed value, std::vector<std::string>& strings)
+    {
+        if (value.get_type() != type_String)
+            throw LogicError(LogicError::type_mismatch);
+        StringData str = value.get_string();
+        strings.emplace_back(str.data(), str.size());
+        return StringData(strings.back());
+    }
+
+    static void find_all(const StringIndex& index, StringData value, std::vector<ObjKey>& results)
+    {
+        index.find_all(results, value);
+    }
+};
+
+template <>
+struct InNodeTraits<ArrayTimestamp> {
+    using ValueType = Timestamp;
+
+    struct Hash {
+        size_t operator()(const Timestamp& value) const noexcept
+        {
+            return std::hash<int64_t>()(value.get_seconds()) ^ std::hash<int32_t>()(value.get_nanoseconds());
+        }
+    };
+
+    static bool get(const ArrayTimestamp& leaf, size_t ndx, Timestamp& value)
+    {
+        value = leaf.get(ndx);
+        return !value.is_null();
+    }
+
+    static Timestamp from_mixed(Mixed value, std::vector<std::string>&)
+    {
+        if (value.get_type() != type_Timestamp)
+            throw LogicError(LogicError::type_mismatch);
+        return value.get_timestamp();
+    }
+
+    static void find_all(const StringIndex& index, Timestamp value, std::vector<ObjKey>& results)
+    {
+        index.find_all(results, value);
+    }
+};
+
+template <>
+struct InNodeTraits<ArrayKey> {
+    using ValueType = ObjKey;
+    using Hash = std::hash<ObjKey>;
+
+    static bool get(const ArrayKey& leaf, size_t ndx, ObjKey& value)
+    {
+        value = leaf.get(ndx);
+        return bool(value);
+    }
+
+    static ObjKey from_mixed(Mixed value, std::vector<std::string>&)
+    {
+        if (value.get_type() != type_Link)
+            throw LogicError(LogicError::type_mismatch);
+        return value.get<ObjKey>();
+    }
+
+    static void find_all(const StringIndex&, ObjKey, std::vector<ObjKey>&)
+    {
+        REALM_UNREACHABLE(); // Link columns have no search index
+    }
+};
+
+// Match the objects whose value in a column is one of a set of values, which may include null. The values are
+// looked up in a hash set, or through the search index on the column if there are few of them compared to the
+// number of objects. The set is not modified after construction, so it is shared by the copies of the node.
+template <class LeafType>
+class InNode : public ParentNode {
+public:
+    using Traits = InNodeTraits<LeafType>;
+    using ValueType = typename Traits::ValueType;
+
+    InNode(ColKey column_key, const std::vector<Mixed>& values)
+    {
+        m_condition_column_key = column_key;
+        m_dT = 10.0;
+
+        auto v = std::make_shared<Values>();
+        v->strings.reserve(values.size());
+        v->set.reserve(values.size());
+        for (auto& value : values) {
+            if (value.is_null()) {
+                v->has_null = true;
+                continue;
+            }
+            ValueType val = Traits::from_mixed(value, v->strings);
+            if (v->set.insert(val).second)
+                v->ordered.push_back(val);
+        }
+        m_values = std::move(v);
+    }
+
+    void cluster_changed() override
+    {
+        m_array_ptr = nullptr;
+        m_array_ptr = LeafPtr(new (&m_leaf_cache_storage) LeafType(m_table.unchecked_ptr()->get_alloc()));
+        m_cluster->init_leaf(this->m_condition_column_key, m_array_ptr.get());
+        m_leaf_ptr = m_array_ptr.get();
+    }
+
+    void init() override
+    {
+        ParentNode::init();
+
+        const Table* table = m_table.unchecked_ptr();
+        size_t num_values = m_values->set.size() + (m_values->has_null ? 1 : 0);
+        // Assume that most of the values are held by one object, as for a list of ids
+        m_dD = std::max(double(table->size()) / (num_values + 1.0), 1.0);
+        m_enum_matches_resolved = false;
+
+        // An index lookup costs about as much as scanning a few tens of objects
+        m_has_search_index = table->has_search_index(m_condition_column_key) && num_values * 32 < table->size();
+        if (m_has_search_index) {
+            auto index = table->get_search_index(m_condition_column_key);
+            auto& results = m_index_evaluator.results();
+            results.clear();
+            for (auto& value : m_values->ordered)
+                Traits::find_all(*index, value, results);
+            if (m_values->has_null)
+                index->find_all(results, null{});
+            std::sort(results.begin(), results.end());
+            m_index_evaluator.init();
+            m_dT = 0;
+            m_dD = double(table->size()) / (results.size() + 1.0);
+        }
+        else {
+            m_dT = 10.0;
+        }
+    }
+
+    bool has_search_index() const override
+    {
+        return m_has_search_index;
+    }
+
+    void index_based_aggregate(size_t limit, Evaluator evaluator) override
+    {
+        m_index_evaluator.index_based_aggregate(m_table.unchecked_ptr(), limit, evaluator);
+    }
+
+    size_t find_first_local(size_t start, size_t end) override
+    {
+        if (m_has_search_index)
+            return (start < end) ? m_index_evaluator.find_first_local(m_cluster, start, end) : not_found;
+
+        const Values& values = *m_values;
+        ValueType value;
+        for (size_t i = start; i < end; ++i) {
+            if (Traits::get(*m_leaf_ptr, i, value) ? values.set.count(value) != 0 : values.has_null)
+                return i;
+        }
+        return not_found;
+    }
+
+    std::string describe(util::serializer::SerialisationState& state) const override
+    {
+        REALM_ASSERT(m_condition_column_key);
+        std::string desc = state.describe_column(ParentNode::m_table, m_condition_column_key) + " " +
+                           describe_condition() + " {";
+        bool is_first = true;
+        for (auto& value : m_values->ordered) {
+            if (!is_first)
+                desc += ", ";
+            desc += util::serializer::print_value(value);
+            is_first = false;
+        }
+        if (m_values->has_null)
+            desc += is_first ? "NULL" : ", NULL";
+        return desc + "}";
+    }
+
+    std::string describe_condition() const override
+    {
+        return "IN";
+    }
+
+    std::unique_ptr<ParentNode> clone() const override
+    {
+        return std::unique_ptr<ParentNode>(new InNode(*this));
+    }
+
+    InNode(const InNode& from)
+        : ParentNode(from)
+        , m_values(from.m_values)
+    {
+    }
+
+private:
+    struct Values {
+        std::unordered_set<ValueType, typename Traits::Hash> set;
+        // The values in the order given, without duplicates
+        std::vector<ValueType> ordered;
+        // Storage of the string values
+        std::vector<std::string> strings;
+        bool has_null = false;
+    };
+    std::shared_ptr<const Values> m_values;
+
+    bool m_has_search_index = false;
+    IndexEvaluator m_index_evaluator;
+
+    // Whether each value of an enumerated string column is in the set, see find_first_local()
+    std::vector<bool> m_enum_matches;
+    bool m_enum_matches_resolved = false;
+
+    using LeafCacheStorage = typename std::aligned_storage<sizeof(LeafType), alignof(LeafType)>::type;
+    using LeafPtr = std::unique_ptr<LeafType, PlacementDelete>;
+    LeafCacheStorage m_leaf_cache_storage;
+    LeafPtr m_array_ptr;
+    const LeafType* m_leaf_ptr = nullptr;
+};
+
+// Enumerated leaves are matched by the index into the table of unique values
+template <>
+size_t InNode<ArrayString>::find_first_local(size_t start, size_t end);
+
 } // namespace realm
 
 #endif // REALM_QUERY_ENGINE_HPP
@@ -353,6 +353,12 @@ public:
     virtual void collect_dependencies(std::vector<TableKey>&) const
     {
     }
+    // Whether evaluating the expression for an object may read other objects than that one, or the lists of it.
+    // Assumed unless known otherwise.
+    virtual bool may_read_other_objects() const
+    {
+        return true;
+    }
     virtual ConstTableRef get_base_table() const = 0;
     virtual std::string description(util::serializer::SerialisationState& state) const = 0;
 
@@ -400,6 +406,13 @@ public:
     {
     }
 
+    // Whether evaluating the expression for an object may read other objects than that one, or the lists of it.
+    // Assumed unless known otherwise.
+    virtual bool may_read_other_objects() const
+    {
+        return true;
+    }
+
     virtual bool has_constant_evaluation() const
     {
         return false;
@@ -1118,6 +1131,10 @@ struct TrueExpression : Expression {
     void set_cluster(const Cluster*) override
     {
     }
+    bool may_read_other_objects() const override
+    {
+        return false;
+    }
     ConstTableRef get_base_table() const override
     {
         return nullptr;
@@ -1142,6 +1159,10 @@ struct FalseExpression : Expression {
     void set_cluster(const Cluster*) override
     {
     }
+    bool may_read_other_objects() const override
+    {
+        return false;
+    }
     std::string description(util::serializer::SerialisationState&) const override
     {
         return "FALSEPREDICATE";
@@ -1183,6 +1204,11 @@ public:
     Value(const Value&) = default;
     Value& operator=(const Value&) = default;
 
+    bool may_read_other_objects() const override
+    {
+        return false;
+    }
+
     void init(bool from_link_list, size_t values, T v)
     {
         m_storage.init(values, v);
@@ -2054,6 +2080,11 @@ public:
         m_link_map.collect_dependencies(tables);
     }
 
+    bool may_read_other_objects() const override
+    {
+        return links_exist();
+    }
+
     void evaluate(size_t index, ValueBase& destination) override
     {
         Value<T>& d = static_cast<Value<T>&>(destination);
@@ -2513,6 +2544,11 @@ public:
         m_expr->set_cluster(cluster);
     }
 
+    bool may_read_other_objects() const override
+    {
+        return m_expr->may_read_other_objects();
+    }
+
     // Recursively fetch tables of columns in expression tree. Used when user first builds a stand-alone expression
     // and binds it to a Query at a later time
     ConstTableRef get_base_table() const override
@@ -3057,6 +3093,41 @@ inline Query operator!=(null, const Subexpr2<Link>& right)
 }
 
 
+// Look up the objects with the value 'value' in the search index of a column of type T
+template <class T>
+std::enable_if_t<!std::is_floating_point<T>::value> find_all_in_index(const StringIndex& index,
+                                                                      std::vector<ObjKey>& result, Mixed value)
+{
+    T val{};
+    if (!value.is_null()) {
+        val = value.get<T>();
+    }
+    index.find_all(result, val);
+}
+
+// The constant may be of any numeric type. It must be converted the way the query would compare it, so a double
+// that has no exact float representation can not match any value in a float column.
+template <class T>
+std::enable_if_t<std::is_floating_point<T>::value> find_all_in_index(const StringIndex& index,
+                                                                     std::vector<ObjKey>& result, Mixed value)
+{
+    T val;
+    if (value.is_null()) {
+        index.find_all(result, null{});
+        return;
+    }
+    else if (value.get_type() == type_Int) {
+        val = T(value.get_int());
+    }
+    else {
+        double d = (value.get_type() == type_Float) ? double(value.get_float()) : value.get_double();
+        val = T(d);
+        if (double(val) != d)
+            return;
+    }
+    index.find_all(result, val);
+}
+
 template <class T>
 class Columns : public Subexpr2<T> {
 public:
@@ -3135,12 +3206,8 @@ public:
             index->find_all(result, val);
         }
         else {
-            T val{};
-            if (!value.is_null()) {
-                val = value.get<T>();
-            }
             StringIndex* index = m_link_map.get_target_table()->get_search_index(m_column_key);
-            index->find_all(result, val);
+            find_all_in_index<T>(*index, result, value);
         }
 
         for (auto k : result) {
@@ -3156,6 +3223,11 @@ public:
         m_link_map.collect_dependencies(tables);
     }
 
+    bool may_read_other_objects() const override
+    {
+        return links_exist();
+    }
+
     // Recursively fetch tables of columns in expression tree. Used when user first builds a stand-alone expression
     // and binds it to a Query at a later time
     ConstTableRef get_base_table() const override
@@ -3682,6 +3754,11 @@ public:
         m_left->collect_dependencies(tables);
     }
 
+    bool may_read_other_objects() const override
+    {
+        return m_left->may_read_other_objects();
+    }
+
     // Recursively fetch tables of columns in expression tree. Used when user first builds a stand-alone expression
     // and binds it to a Query at a later time
     ConstTableRef get_base_table() const override
@@ -3758,6 +3835,11 @@ public:
         m_right->set_cluster(cluster);
     }
 
+    bool may_read_other_objects() const override
+    {
+        return m_left->may_read_other_objects() || m_right->may_read_other_objects();
+    }
+
     // Recursively fetch tables of columns in expression tree. Used when user first builds a stand-alone expression
     // and
     // binds it to a Query at a later time
@@ -3898,6 +3980,11 @@ public:
         m_right->collect_dependencies(tables);
     }
 
+    bool may_read_other_objects() const override
+    {
+        return m_left->may_read_other_objects() || m_right->may_read_other_objects();
+    }
+
     size_t find_first(size_t start, size_t end) const override
     {
         if (m_has_matches) {
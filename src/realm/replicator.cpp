@@ -0,0 +1,507 @@
+/*************************************************************************
+ *
+ * Copyright 2021 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <realm/replicator.hpp>
+#include <realm/impl/input_stream.hpp>
+#include <realm/impl/transact_log.hpp>
+#include <realm/list.hpp>
+#include <realm/util/file.hpp>
+
+using namespace realm;
+
+
+namespace {
+
+// The progress file holds the magic value followed by two records of
+// (follower version, primary version). The first is the state before the
+// latest follower commit, and the second the state after it, so whichever of
+// them matches the follower tells which primary version it reflects.
+constexpr uint64_t g_progress_magic = 0x52504c4341310000ULL; // "RPLCA1"
+constexpr size_t g_progress_size = 5;
+
+using version_type = Replicator::version_type;
+
+void write_progress(const std::string& path, version_type follower_version, version_type primary_version,
+                    version_type next_follower_version, version_type next_primary_version)
+{
+    uint64_t data[g_progress_size] = {g_progress_magic, follower_version, primary_version, next_follower_version,
+                                      next_primary_version};
+    std::string tmp_path = path + ".tmp";
+    {
+        util::File file(tmp_path, util::File::mode_Write); // Throws
+        file.write(reinterpret_cast<const char*>(data), sizeof data); // Throws
+        file.sync(); // Throws
+    }
+    util::File::move(tmp_path, path); // Throws
+}
+
+struct SchemaChange {
+    enum Kind { insert_table, erase_table, rename_table, insert_column, erase_column, rename_column };
+    Kind kind;
+    TableKey table;
+    ColKey col;
+};
+
+struct ObjectChanges {
+    bool all = false; // Created, or possibly removed
+    std::set<ColKey> columns;
+};
+
+struct TableChanges {
+    bool cleared = false;
+    std::map<ObjKey, ObjectChanges> objects;
+};
+
+// Collects what a sequence of changesets touched. Values are not part of the
+// changesets, so they are copied from the primary afterwards.
+class ChangeCollector : public _impl::NullInstructionObserver {
+public:
+    std::vector<SchemaChange> schema_changes;
+    std::map<TableKey, TableChanges> tables;
+
+    bool select_table(TableKey key)
+    {
+        m_table = key;
+        return true;
+    }
+    bool select_list(ColKey col_key, ObjKey key)
+    {
+        m_list_col = col_key;
+        m_list_obj = key;
+        return true;
+    }
+
+    bool insert_group_level_table(TableKey key)
+    {
+        schema_changes.push_back({SchemaChange::insert_table, key, ColKey()});
+        return true;
+    }
+    bool erase_group_level_table(TableKey key)
+    {
+        schema_changes.push_back({SchemaChange::erase_table, key, ColKey()});
+        return true;
+    }
+    bool rename_group_level_table(TableKey key)
+    {
+        schema_changes.push_back({SchemaChange::rename_table, key, ColKey()});
+        return true;
+    }
+    bool insert_column(ColKey col_key)
+    {
+        schema_changes.push_back({SchemaChange::insert_column, m_table, col_key});
+        return true;
+    }
+    bool erase_column(ColKey col_key)
+    {
+        schema_changes.push_back({SchemaChange::erase_column, m_table, col_key});
+        return true;
+    }
+    bool rename_column(ColKey col_key)
+    {
+        schema_changes.push_back({SchemaChange::rename_column, m_table, col_key});
+        return true;
+    }
+
+    bool create_object(ObjKey key)
+    {
+        tables[m_table].objects[key].all = true;
+        return true;
+    }
+    bool remove_object(ObjKey key)
+    {
+        tables[m_table].objects[key].all = true;
+        return true;
+    }
+    bool clear_table(size_t)
+    {
+        tables[m_table].cleared = true;
+        return true;
+    }
+    bool modify_object(ColKey col_key, ObjKey key)
+    {
+        tables[m_table].objects[key].columns.insert(col_key);
+        return true;
+    }
+
+    bool list_set(size_t)
+    {
+        return list_changed();
+    }
+    bool list_insert(size_t)
+    {
+        return list_changed();
+    }
+    bool list_move(size_t, size_t)
+    {
+        return list_changed();
+    }
+    bool list_swap(size_t, size_t)
+    {
+        return list_changed();
+    }
+    bool list_erase(size_t)
+    {
+        return list_changed();
+    }
+    bool list_clear(size_t)
+    {
+        return list_changed();
+    }
+
+private:
+    TableKey m_table;
+    ColKey m_list_col;
+    ObjKey m_list_obj;
+
+    bool list_changed()
+    {
+        tables[m_table].objects[m_list_obj].columns.insert(m_list_col);
+        return true;
+    }
+};
+
+bool has_table(const Group& group, TableKey key)
+{
+    for (auto k : group.get_table_keys()) {
+        if (k == key)
+            return true;
+    }
+    return false;
+}
+
+bool has_column(const Group& group, TableKey table_key, ColKey col_key)
+{
+    return has_table(group, table_key) && group.get_table(table_key)->valid_column(col_key);
+}
+
+// Unique name used while a table or column may still be renamed or removed
+// later in the batch. Names in the primary are only known at the end of it.
+std::string temp_name(int64_t key)
+{
+    return "!replica." + util::to_string(key);
+}
+
+void check_key(bool matches, const char* what)
+{
+    if (!matches)
+        throw Replicator::ResyncRequired(std::string("The follower assigned a different ") + what +
+                                         " key than the primary");
+}
+
+// Replay the schema changes in order, so that the follower assigns the same
+// table and column keys as the primary did.
+void apply_schema_changes(const Group& primary, Group& follower, const std::vector<SchemaChange>& changes)
+{
+    std::set<TableKey> renamed_tables;
+    std::set<std::pair<TableKey, ColKey>> renamed_columns;
+    for (auto& change : changes) {
+        switch (change.kind) {
+            case SchemaChange::insert_table: {
+                std::string name = temp_name(change.table.value);
+                TableRef table = follower.add_table(name); // Throws
+                check_key(table->get_key() == change.table, "table");
+                renamed_tables.insert(change.table);
+                break;
+            }
+            case SchemaChange::erase_table:
+                if (has_table(follower, change.table))
+                    follower.remove_table(change.table); // Throws
+                break;
+            case SchemaChange::rename_table:
+                if (has_table(follower, change.table)) {
+                    std::string name = temp_name(change.table.value);
+                    follower.rename_table(change.table, name); // Throws
+                    renamed_tables.insert(change.table);
+                }
+                break;
+            case SchemaChange::insert_column: {
+                check_key(has_table(follower, change.table), "table");
+                TableRef table = follower.get_table(change.table);
+                ColumnType type = change.col.get_type();
+                ColumnAttrMask attrs = change.col.get_attrs();
+                std::string name = temp_name(change.col.value);
+                ColKey col_key;
+                if (type == col_type_Link || type == col_type_LinkList) {
+                    // The target is only known if the column still exists
+                    if (!has_column(primary, change.table, change.col))
+                        throw Replicator::ResyncRequired("A link column was added and removed by the primary");
+                    ConstTableRef origin = primary.get_table(change.table);
+                    TableKey target_key = origin->get_link_target(change.col)->get_key();
+                    check_key(has_table(follower, target_key), "table");
+                    col_key = table->add_column_link(DataType(type), name, *follower.get_table(target_key),
+                                                     origin->get_link_type(change.col)); // Throws
+                }
+                else if (attrs.test(col_attr_List)) {
+                    col_key =
+                        table->add_column_list(DataType(type), name, attrs.test(col_attr_Nullable)); // Throws
+                }
+                else {
+                    col_key = table->add_column(DataType(type), name, attrs.test(col_attr_Nullable)); // Throws
+                }
+                check_key(col_key == change.col, "column");
+                renamed_columns.insert({change.table, change.col});
+                break;
+            }
+            case SchemaChange::erase_column:
+                if (has_column(follower, change.table, change.col))
+                    follower.get_table(change.table)->remove_column(change.col); // Throws
+                break;
+            case SchemaChange::rename_column:
+                if (has_column(follower, change.table, change.col)) {
+                    std::string name = temp_name(change.col.value);
+                    follower.get_table(change.table)->rename_column(change.col, name); // Throws
+                    renamed_columns.insert({change.table, change.col});
+                }
+                break;
+        }
+    }
+
+    for (auto key : renamed_tables) {
+        if (has_table(primary, key) && has_table(follower, key))
+            follower.rename_table(key, primary.get_table_name(key)); // Throws
+    }
+    for (auto& entry : renamed_columns) {
+        if (has_column(primary, entry.first, entry.second) && has_column(follower, entry.first, entry.second)) {
+            ConstTableRef origin = primary.get_table(entry.first);
+            follower.get_table(entry.first)->rename_column(entry.second,
+                                                           origin->get_column_name(entry.second)); // Throws
+        }
+    }
+}
+
+std::vector<ColKey> get_column_keys(const Table& table)
+{
+    std::vector<ColKey> keys;
+    table.for_each_and_every_column([&](ColKey col_key) {
+        keys.push_back(col_key);
+        return false;
+    });
+    return keys;
+}
+
+void check_schema(const Group& primary, const Group& follower)
+{
+    auto table_keys = primary.get_table_keys();
+    bool matches = table_keys.size() == follower.get_table_keys().size();
+    for (size_t i = 0; matches && i < table_keys.size(); ++i) {
+        TableKey key = table_keys[i];
+        matches = has_table(follower, key) && primary.get_table_name(key) == follower.get_table_name(key) &&
+                  get_column_keys(*primary.get_table(key)) == get_column_keys(*follower.get_table(key));
+    }
+    if (!matches)
+        throw Replicator::ResyncRequired("The schema of the follower differs from that of the primary");
+}
+
+// Primary keys and search indexes are not part of the changesets, so they are
+// compared directly.
+void sync_table_properties(const Group& primary, Group& follower)
+{
+    const IndexType index_types[] = {IndexType::General, IndexType::Ordered, IndexType::Substring};
+    for (auto key : primary.get_table_keys()) {
+        if (!has_table(follower, key))
+            continue;
+        ConstTableRef origin = primary.get_table(key);
+        TableRef table = follower.get_table(key);
+        if (table->get_primary_key_column() != origin->get_primary_key_column())
+            table->set_primary_key_column(origin->get_primary_key_column()); // Throws
+        origin->for_each_public_column([&](ColKey col_key) {
+            if (!table->valid_column(col_key))
+                return false;
+            for (auto type : index_types) {
+                bool indexed = origin->has_search_index(col_key, type);
+                if (indexed && !table->has_search_index(col_key, type))
+                    table->add_search_index(col_key, type); // Throws
+                else if (!indexed && table->has_search_index(col_key, type))
+                    table->remove_search_index(col_key, type); // Throws
+            }
+            return false;
+        });
+    }
+}
+
+void copy_value(const ConstObj& origin, Obj& obj, ColKey col_key)
+{
+    if (col_key.get_attrs().test(col_attr_List)) {
+        auto origin_list = origin.get_listbase_ptr(col_key);
+        auto list = obj.get_listbase_ptr(col_key);
+        list->clear(); // Throws
+        size_t size = origin_list->size();
+        for (size_t i = 0; i < size; ++i)
+            list->insert_any(i, origin_list->get_any(i)); // Throws
+    }
+    else if (col_key.get_type() == col_type_Link) {
+        obj.set(col_key, origin.get<ObjKey>(col_key)); // Throws
+    }
+    else {
+        obj.set(col_key, origin.get_any(col_key)); // Throws
+    }
+}
+
+void apply_object_changes(const Group& primary, Group& follower, std::map<TableKey, TableChanges>& tables)
+{
+    // Make the set of objects match first, so that links can be copied
+    for (auto& entry : tables) {
+        if (!has_table(primary, entry.first) || !has_table(follower, entry.first))
+            continue;
+        ConstTableRef origin = primary.get_table(entry.first);
+        TableRef table = follower.get_table(entry.first);
+        TableChanges& changes = entry.second;
+        if (changes.cleared) {
+            for (auto& obj : *table)
+                changes.objects[obj.get_key()].all = true;
+            for (auto& obj : *origin)
+                changes.objects[obj.get_key()].all = true;
+        }
+        ColKey pk_col = origin->get_primary_key_column();
+        for (auto& object : changes.objects) {
+            ObjKey key = object.first;
+            bool in_primary = origin->is_valid(key);
+            if (table->is_valid(key) && !in_primary) {
+                table->remove_object(key); // Throws
+            }
+            else if (in_primary && !table->is_valid(key)) {
+                if (pk_col) {
+                    table->create_object(key, {{pk_col, origin->get_object(key).get_any(pk_col)}}); // Throws
+                }
+                else {
+                    table->create_object(key); // Throws
+                }
+                object.second.all = true;
+            }
+        }
+    }
+
+    for (auto& entry : tables) {
+        if (!has_table(primary, entry.first) || !has_table(follower, entry.first))
+            continue;
+        ConstTableRef origin = primary.get_table(entry.first);
+        TableRef table = follower.get_table(entry.first);
+        ColKey pk_col = origin->get_primary_key_column();
+        for (auto& object : entry.second.objects) {
+            ObjKey key = object.first;
+            if (!origin->is_valid(key) || !table->is_valid(key))
+                continue;
+            ConstObj origin_obj = origin->get_object(key);
+            Obj obj = table->get_object(key);
+            auto copy = [&](ColKey col_key) {
+                if (col_key != pk_col && origin->valid_column(col_key) && table->valid_column(col_key))
+                    copy_value(origin_obj, obj, col_key); // Throws
+                return false;
+            };
+            if (object.second.all) {
+                origin->for_each_public_column(copy);
+            }
+            else {
+                for (auto col_key : object.second.columns)
+                    copy(col_key);
+            }
+        }
+    }
+}
+
+} // anonymous namespace
+
+
+TransactionRef Replicator::seed(DB& primary, const std::string& follower_path, const char* encryption_key)
+{
+    TransactionRef source = primary.start_read(); // Throws
+    version_type version = source->get_version_of_current_transaction().version;
+    source->write(follower_path, encryption_key, version, false); // Throws
+    write_progress(follower_path + ".replica", version, version, version, version); // Throws
+    return source;
+}
+
+
+Replicator::Replicator(DBRef primary, DBRef follower)
+    : m_primary(std::move(primary))
+    , m_follower(std::move(follower))
+    , m_progress_path(m_follower->get_path() + ".replica")
+{
+    if (!util::File::exists(m_progress_path))
+        throw ResyncRequired("No replication progress has been recorded for " + m_follower->get_path());
+    uint64_t data[g_progress_size];
+    {
+        util::File file(m_progress_path); // Throws
+        if (file.read(reinterpret_cast<char*>(data), sizeof data) != sizeof data || data[0] != g_progress_magic)
+            throw ResyncRequired("Invalid replication progress file " + m_progress_path);
+    }
+    m_follower_version = m_follower->start_read()->get_version_of_current_transaction().version; // Throws
+    if (m_follower_version == data[3]) {
+        m_primary_version = data[4];
+    }
+    else if (m_follower_version == data[1]) {
+        m_primary_version = data[2];
+    }
+    else {
+        throw ResyncRequired("The follower has been modified");
+    }
+    catch_up(); // Throws
+}
+
+
+Replicator::version_type Replicator::catch_up()
+{
+    TransactionRef source = m_primary->start_read(); // Throws
+    version_type version = source->get_version_of_current_transaction().version;
+    if (version == m_primary_version) {
+        m_source = std::move(source);
+        return m_primary_version;
+    }
+
+    _impl::History* hist = source->get_history();
+    if (!hist)
+        throw LogicError(LogicError::no_history);
+    hist->ensure_updated(version); // Throws
+    if (hist->get_oldest_available_version() > m_primary_version)
+        throw ResyncRequired("The history of the primary no longer contains version " +
+                             util::to_string(m_primary_version));
+    ChangeCollector changes;
+    {
+        _impl::ChangesetInputStream in(*hist, m_primary_version, version);
+        _impl::TransactLogParser parser;
+        parser.parse(in, changes); // Throws
+    }
+
+    TransactionRef target = m_follower->start_write(); // Throws
+    if (target->get_version_of_current_transaction().version != m_follower_version)
+        throw ResyncRequired("The follower has been modified");
+    if (!changes.schema_changes.empty()) {
+        apply_schema_changes(*source, *target, changes.schema_changes); // Throws
+        check_schema(*source, *target); // Throws
+    }
+    sync_table_properties(*source, *target);                 // Throws
+    apply_object_changes(*source, *target, changes.tables); // Throws
+
+    // The follower version of the commit is only known once it is made, so
+    // record the expected one beforehand, and correct it if needed.
+    version_type next_version = m_follower_version + 1;
+    write_progress(m_progress_path, m_follower_version, m_primary_version, next_version, version); // Throws
+    version_type follower_version = target->commit(); // Throws
+    if (follower_version != next_version)
+        write_progress(m_progress_path, follower_version, version, follower_version, version); // Throws
+
+    m_source = std::move(source);
+    m_follower_version = follower_version;
+    m_primary_version = version;
+    return version;
+}
@@ -0,0 +1,106 @@
+/*************************************************************************
+ *
+ * Copyright 2021 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_REPLICATOR_HPP
+#define REALM_REPLICATOR_HPP
+
+#include <stdexcept>
+#include <string>
+
+#include <realm/db.hpp>
+
+namespace realm {
+
+/// Keeps a follower Realm file up to date with a primary Realm file on the
+/// same host, so that read-only work such as analytical queries can be moved
+/// to the follower, which may be on a separate disk.
+///
+/// The follower starts out as a copy of the primary written by seed(). After
+/// that, catch_up() reads the changesets committed to the primary since the
+/// version the follower reflects from the primary's history, and applies them
+/// to the follower in a single write transaction. The changesets identify the
+/// objects, lists and columns that were changed, and their contents are copied
+/// from the latest snapshot of the primary. Several primary commits are thus
+/// combined into one follower commit. Schema changes are replayed in order,
+/// so that table and column keys stay the same on both sides.
+///
+/// The primary must be opened with an in-Realm history (see
+/// make_in_realm_history()). The follower may be opened with any kind of
+/// history, and must not be modified other than through the Replicator.
+///
+/// The primary version reflected by the follower is recorded in a file next
+/// to the follower, named after it with the suffix ".replica". It is updated
+/// atomically with each follower commit, so a new Replicator can resume where
+/// a previous one stopped. While a Replicator exists, it keeps a read
+/// transaction open on the primary, so that the changesets it has yet to
+/// apply stay in the history. If the history of the primary no longer reaches
+/// back to the version the follower reflects, or the follower has been
+/// modified by others, ResyncRequired is thrown, and the follower must be
+/// seeded again.
+///
+/// A Replicator is not thread-safe.
+class Replicator {
+public:
+    using version_type = DB::version_type;
+
+    class ResyncRequired;
+
+    /// Write a copy of the latest snapshot of \a primary to \a follower_path,
+    /// which must not exist, and record the version it reflects. Returns a
+    /// read transaction on the primary at that version. Keeping it until a
+    /// Replicator for the follower has been constructed guarantees that the
+    /// changes committed to the primary in the meantime can be applied.
+    static TransactionRef seed(DB& primary, const std::string& follower_path,
+                               const char* encryption_key = nullptr);
+
+    /// Bring \a follower up to date with \a primary. Throws ResyncRequired if
+    /// that is not possible.
+    Replicator(DBRef primary, DBRef follower);
+
+    /// Apply the changes committed to the primary since the version reflected
+    /// by the follower, and return the version of the primary that the
+    /// follower now reflects.
+    version_type catch_up();
+
+    /// The version of the primary that the follower reflects
+    version_type get_primary_version() const noexcept
+    {
+        return m_primary_version;
+    }
+
+private:
+    DBRef m_primary;
+    DBRef m_follower;
+    std::string m_progress_path;
+    /// Read transaction on the primary at m_primary_version
+    TransactionRef m_source;
+    version_type m_primary_version = 0;
+    version_type m_follower_version = 0;
+};
+
+class Replicator::ResyncRequired : public std::runtime_error {
+public:
+    ResyncRequired(const std::string& msg)
+        : std::runtime_error(msg)
+    {
+    }
+};
+
+} // namespace realm
+
+#endif // REALM_REPLICATOR_HPP
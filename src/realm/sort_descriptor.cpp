@@ -141,12 +141,36 @@ void SortDescriptor::merge_with(SortDescriptor&& other)
 }
 
 
+namespace {
+
+// Compare cached values of a column other than the first one with the same ordering as ConstObj::cmp(),
+// which is used for such columns when they are not cached. That means strings are ordered bytewise.
+inline int compare_cached(const Mixed& a, const Mixed& b)
+{
+    if (!a.is_null() && !b.is_null() && a.get_type() == type_String) {
+        StringData str_a = a.get<StringData>();
+        StringData str_b = b.get<StringData>();
+        return str_a < str_b ? -1 : (str_b < str_a ? 1 : 0);
+    }
+    return a.compare(b);
+}
+
+} // anonymous namespace
+
+Mixed BaseDescriptor::Sorter::SortColumn::get_value(const ConstObj& obj) const
+{
+    if (use_enum_index)
+        return Mixed(int64_t(obj.get_enum_index(col_key)));
+    return obj.get_any(col_key);
+}
+
 BaseDescriptor::Sorter::Sorter(std::vector<std::vector<ColKey>> const& column_lists,
                                std::vector<bool> const& ascending, Table const& root_table, const IndexPairs& indexes)
 {
     REALM_ASSERT(!column_lists.empty());
     REALM_ASSERT_EX(column_lists.size() == ascending.size(), column_lists.size(), ascending.size());
-    size_t translated_size = std::max_element(indexes.begin(), indexes.end())->index_in_view + 1;
+    size_t translated_size =
+        indexes.empty() ? 0 : std::max_element(indexes.begin(), indexes.end())->index_in_view + 1;
 
     m_columns.reserve(column_lists.size());
     for (size_t i = 0; i < column_lists.size(); ++i) {
@@ -198,7 +222,9 @@ BaseDescriptor::Sorter DistinctDescriptor::sorter(Table const& table, const Inde
 {
     REALM_ASSERT(!m_column_keys.empty());
     std::vector<bool> ascending(m_column_keys.size(), true);
-    return Sorter(m_column_keys, ascending, table, indexes);
+    Sorter sorter(m_column_keys, ascending, table, indexes);
+    sorter.use_enum_indexes();
+    return sorter;
 }
 
 void DistinctDescriptor::execute(IndexPairs& v, const Sorter& predicate, const BaseDescriptor* next) const
@@ -240,7 +266,15 @@ BaseDescriptor::Sorter SortDescriptor::sorter(Table const& table, const IndexPai
 
 void SortDescriptor::execute(IndexPairs& v, const Sorter& predicate, const BaseDescriptor* next) const
 {
-    std::sort(v.begin(), v.end(), std::ref(predicate));
+    // If a limit follows, only the entries it keeps need to be in order
+    size_t limit = v.size();
+    if (next && next->get_type() == DescriptorType::Limit)
+        limit = std::min(limit, static_cast<const LimitDescriptor*>(next)->get_limit());
+
+    if (limit < v.size())
+        std::partial_sort(v.begin(), v.begin() + limit, v.end(), std::ref(predicate));
+    else
+        std::sort(v.begin(), v.end(), std::ref(predicate));
 
     // not doing this on the last step is an optimisation
     if (next) {
@@ -275,11 +309,12 @@ void LimitDescriptor::execute(IndexPairs& v, const Sorter&, const BaseDescriptor
 
 // This function must conform to 'is less' predicate - that is:
 // return true if i is strictly smaller than j
-bool BaseDescriptor::Sorter::operator()(IndexPair i, IndexPair j, bool total_ordering) const
+bool BaseDescriptor::Sorter::operator()(const IndexPair& i, const IndexPair& j, bool total_ordering) const
 {
     // Sorting can be specified by multiple columns, so that if two entries in the first column are
     // identical, then the rows are ordered according to the second column, and so forth. For the
-    // first column, all the payload of the View is cached in IndexPair::cached_value.
+    // first column, all the payload of the View is cached in IndexPair::cached_value. The other
+    // columns are cached in SortColumn::cached_values unless the entries were cached one at a time.
     for (size_t t = 0; t < m_columns.size(); t++) {
         if (!m_columns[t].translated_keys.empty()) {
             bool null_i = m_columns[t].is_null[i.index_in_view];
@@ -299,6 +334,10 @@ bool BaseDescriptor::Sorter::operator()(IndexPair i, IndexPair j, bool total_ord
         if (t == 0) {
             c = i.cached_value.compare(j.cached_value);
         }
+        else if (!m_columns[t].cached_values.empty()) {
+            c = compare_cached(m_columns[t].cached_values[i.index_in_view],
+                               m_columns[t].cached_values[j.index_in_view]);
+        }
         else {
             ObjKey key_i = i.key_for_object;
             ObjKey key_j = j.key_for_object;
@@ -322,28 +361,53 @@ bool BaseDescriptor::Sorter::operator()(IndexPair i, IndexPair j, bool total_ord
     return total_ordering ? i.index_in_view < j.index_in_view : 0;
 }
 
-void BaseDescriptor::Sorter::cache_first_column(IndexPairs& v)
+void BaseDescriptor::Sorter::cache_columns(IndexPairs& v)
 {
-    if (m_columns.empty())
+    if (m_columns.empty() || v.empty())
         return;
 
-    auto& col = m_columns[0];
-    ColKey ck = col.col_key;
-    for (size_t i = 0; i < v.size(); i++) {
-        IndexPair& index = v[i];
-        ObjKey key = index.key_for_object;
-
-        if (!col.translated_keys.empty()) {
-            if (col.is_null[i]) {
-                index.cached_value = Mixed();
-                continue;
+    // The first column is cached in the IndexPair itself. The other columns are cached in per column arrays
+    // indexed by index_in_view, so that ties on the first column can be resolved without looking up objects.
+    size_t cache_size = std::max_element(v.begin(), v.end())->index_in_view + 1;
+    for (size_t t = 1; t < m_columns.size(); ++t)
+        m_columns[t].cached_values.resize(cache_size);
+
+    // The object in the root table is looked up once for all the columns not following links
+    auto root_column = std::find_if(m_columns.begin(), m_columns.end(),
+                                    [](const SortColumn& col) { return col.translated_keys.empty(); });
+    const Table* root_table = root_column == m_columns.end() ? nullptr : root_column->table;
+
+    for (IndexPair& index : v) {
+        ConstObj obj = root_table ? root_table->get_object(index.key_for_object) : ConstObj();
+        for (size_t t = 0; t < m_columns.size(); ++t) {
+            auto& col = m_columns[t];
+            Mixed value;
+            if (col.translated_keys.empty()) {
+                value = col.get_value(obj);
             }
-            else {
-                key = col.translated_keys[v[i].index_in_view];
+            else if (!col.is_null[index.index_in_view]) {
+                value = col.get_value(col.table->get_object(col.translated_keys[index.index_in_view]));
             }
+
+            if (t == 0)
+                index.cached_value = value;
+            else
+                col.cached_values[index.index_in_view] = value;
         }
+    }
+}
 
-        index.cached_value = col.table->get_object(key).get_any(ck);
+void BaseDescriptor::Sorter::cache_first_column(IndexPair& index) const
+{
+    REALM_ASSERT_DEBUG(!m_columns.empty() && m_columns[0].translated_keys.empty());
+    auto& col = m_columns[0];
+    index.cached_value = col.get_value(col.table->get_object(index.key_for_object));
+}
+
+void BaseDescriptor::Sorter::use_enum_indexes()
+{
+    for (auto& col : m_columns) {
+        col.use_enum_index = col.col_key.get_type() == col_type_String && col.table->is_enumerated(col.col_key);
     }
 }
 
@@ -78,7 +78,7 @@ public:
         {
         }
 
-        bool operator()(IndexPair i, IndexPair j, bool total_ordering = true) const;
+        bool operator()(const IndexPair& i, const IndexPair& j, bool total_ordering = true) const;
 
         bool has_links() const
         {
@@ -92,7 +92,14 @@ public:
                 return col.is_null.empty() ? false : col.is_null[i.index_in_view];
             });
         }
-        void cache_first_column(IndexPairs& v);
+        // Extract the values of all sort columns for the entries in 'v'
+        void cache_columns(IndexPairs& v);
+        // Cache the first column for a single entry. Only valid if the first column is not reached through links.
+        void cache_first_column(IndexPair& index) const;
+        // Represent the values of enumerated String columns by their index in the table of unique values of the
+        // column, which is cheaper to fetch and compare than the string. The indexes are not ordered like the
+        // strings, so this is only valid when just equality matters, as for distinct.
+        void use_enum_indexes();
 
     private:
         struct SortColumn {
@@ -104,10 +111,14 @@ public:
             }
             std::vector<bool> is_null;
             std::vector<ObjKey> translated_keys;
+            std::vector<Mixed> cached_values;
 
             const Table* table;
             ColKey col_key;
             bool ascending;
+            bool use_enum_index = false;
+
+            Mixed get_value(const ConstObj& obj) const;
         };
         std::vector<SortColumn> m_columns;
         friend class ObjList;
@@ -147,6 +158,24 @@ public:
     }
     void collect_dependencies(const Table* table, std::vector<TableKey>& table_keys) const override;
 
+    size_t get_column_count() const noexcept
+    {
+        return m_column_keys.size();
+    }
+
+    // The chain of columns leading to the ndx'th column. All but the last are Link columns.
+    const std::vector<ColKey>& get_column_keys(size_t ndx) const noexcept
+    {
+        return m_column_keys[ndx];
+    }
+
+    // returns whether any of the columns is reached through a chain of links
+    bool has_links() const noexcept
+    {
+        return std::any_of(m_column_keys.begin(), m_column_keys.end(),
+                           [](const std::vector<ColKey>& columns) { return columns.size() > 1; });
+    }
+
 protected:
     std::vector<std::vector<ColKey>> m_column_keys;
 };
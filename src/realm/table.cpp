@@ -30,6 +30,8 @@
 #include <realm/table.hpp>
 #include <realm/alloc_slab.hpp>
 #include <realm/index_string.hpp>
+#include <realm/index_ordered.hpp>
+#include <realm/index_substring.hpp>
 #include <realm/db.hpp>
 #include <realm/replication.hpp>
 #include <realm/table_view.hpp>
@@ -559,15 +561,43 @@ void Table::populate_search_index(ColKey col_key)
             Timestamp value = o.get<Timestamp>(col_key);
             index->insert(key, value); // Throws
         }
+        else if (type == type_Float) {
+            if (is_nullable(col_key)) {
+                Optional<float> value = o.get<Optional<float>>(col_key);
+                index->insert(key, value); // Throws
+            }
+            else {
+                float value = o.get<float>(col_key);
+                index->insert(key, value); // Throws
+            }
+        }
+        else if (type == type_Double) {
+            if (is_nullable(col_key)) {
+                Optional<double> value = o.get<Optional<double>>(col_key);
+                index->insert(key, value); // Throws
+            }
+            else {
+                double value = o.get<double>(col_key);
+                index->insert(key, value); // Throws
+            }
+        }
         else {
             REALM_ASSERT_RELEASE(false && "Data type does not support search index");
         }
     }
 }
 
-void Table::add_search_index(ColKey col_key)
+void Table::add_search_index(ColKey col_key, IndexType type)
 {
     check_column(col_key);
+    if (type == IndexType::Ordered) {
+        add_ordered_index(col_key);
+        return;
+    }
+    if (type == IndexType::Substring) {
+        add_substring_index(col_key);
+        return;
+    }
     size_t column_ndx = col_key.get_index().val;
 
     // Early-out if already indexed
@@ -602,9 +632,17 @@ void Table::add_search_index(ColKey col_key)
     populate_search_index(col_key);
 }
 
-void Table::remove_search_index(ColKey col_key)
+void Table::remove_search_index(ColKey col_key, IndexType type)
 {
     check_column(col_key);
+    if (type == IndexType::Ordered) {
+        remove_ordered_index(col_key);
+        return;
+    }
+    if (type == IndexType::Substring) {
+        remove_substring_index(col_key);
+        return;
+    }
     auto column_ndx = col_key.get_index();
 
     // Early-out if non-indexed
@@ -627,6 +665,107 @@ void Table::remove_search_index(ColKey col_key)
     m_spec.set_column_attr(spec_ndx, attr); // Throws
 }
 
+void Table::add_ordered_index(ColKey col_key)
+{
+    size_t column_ndx = col_key.get_index().val;
+
+    // Early-out if already indexed
+    if (get_ordered_index(col_key))
+        return;
+
+    if (!OrderedIndex::type_supported(DataType(col_key.get_type())) || col_key.get_attrs().test(col_attr_List))
+        throw LogicError(LogicError::illegal_combination);
+
+    if (!m_ordered_index_refs.is_attached()) {
+        // First ordered index in this table. The slot is only added now, so that tables without ordered
+        // indexes keep the layout read by earlier versions.
+        while (m_top.size() <= top_position_for_ordered_indexes) {
+            m_top.add(0); // Throws
+        }
+        bool context_flag = false;
+        MemRef mem = Array::create_array(Array::type_HasRefs, context_flag, m_index_refs.size(), 0,
+                                         m_top.get_alloc()); // Throws
+        m_ordered_index_refs.init_from_mem(mem);
+        m_ordered_index_refs.update_parent(); // Throws
+        m_ordered_index_accessors.resize(m_leaf_ndx2colkey.size());
+    }
+
+    // Create the index
+    OrderedIndex* index = new OrderedIndex(ClusterColumn(&m_clusters, col_key), get_alloc()); // Throws
+    m_ordered_index_accessors[column_ndx] = index;
+
+    // Insert ref to index
+    index->set_parent(&m_ordered_index_refs, column_ndx);
+    m_ordered_index_refs.set(column_ndx, index->get_ref()); // Throws
+
+    index->build(); // Throws
+}
+
+void Table::remove_ordered_index(ColKey col_key)
+{
+    OrderedIndex* index = get_ordered_index(col_key);
+
+    // Early-out if non-indexed
+    if (!index)
+        return;
+
+    size_t column_ndx = col_key.get_index().val;
+    index->destroy();
+    delete index;
+    m_ordered_index_accessors[column_ndx] = nullptr;
+    m_ordered_index_refs.set(column_ndx, 0);
+}
+
+void Table::add_substring_index(ColKey col_key)
+{
+    size_t column_ndx = col_key.get_index().val;
+
+    // Early-out if already indexed
+    if (get_substring_index(col_key))
+        return;
+
+    if (!SubstringIndex::type_supported(DataType(col_key.get_type())) || col_key.get_attrs().test(col_attr_List))
+        throw LogicError(LogicError::illegal_combination);
+
+    if (!m_substring_index_refs.is_attached()) {
+        // First substring index in this table. As for ordered indexes, the slot is only added now.
+        while (m_top.size() <= top_position_for_substring_indexes) {
+            m_top.add(0); // Throws
+        }
+        bool context_flag = false;
+        MemRef mem = Array::create_array(Array::type_HasRefs, context_flag, m_index_refs.size(), 0,
+                                         m_top.get_alloc()); // Throws
+        m_substring_index_refs.init_from_mem(mem);
+        m_substring_index_refs.update_parent(); // Throws
+        m_substring_index_accessors.resize(m_leaf_ndx2colkey.size());
+    }
+
+    // Create the index
+    SubstringIndex* index = new SubstringIndex(ClusterColumn(&m_clusters, col_key), get_alloc()); // Throws
+    m_substring_index_accessors[column_ndx] = index;
+
+    // Insert ref to index
+    index->set_parent(&m_substring_index_refs, column_ndx);
+    m_substring_index_refs.set(column_ndx, index->get_ref()); // Throws
+
+    index->build(); // Throws
+}
+
+void Table::remove_substring_index(ColKey col_key)
+{
+    SubstringIndex* index = get_substring_index(col_key);
+
+    // Early-out if non-indexed
+    if (!index)
+        return;
+
+    size_t column_ndx = col_key.get_index().val;
+    index->destroy();
+    delete index;
+    m_substring_index_accessors[column_ndx] = nullptr;
+    m_substring_index_refs.set(column_ndx, 0);
+}
+
 void Table::enumerate_string_column(ColKey col_key)
 {
     check_column(col_key);
@@ -637,6 +776,104 @@ void Table::enumerate_string_column(ColKey col_key)
     }
 }
 
+size_t Table::count_unique_strings(ColKey col_key, size_t limit) const
+{
+    check_column(col_key);
+    REALM_ASSERT(col_key.get_type() == col_type_String);
+    return m_clusters.count_unique_strings(col_key, limit);
+}
+
+void Table::compress_integer_leaves()
+{
+    m_clusters.compress_integer_leaves(); // Throws
+}
+
+void Table::update_zone_maps()
+{
+    m_clusters.update_zone_maps(); // Throws
+}
+
+void Table::drop_zone_maps()
+{
+    m_clusters.drop_zone_maps(); // Throws
+}
+
+bool Table::get_column_statistics(ColKey col_key, ColumnStatistics& stats) const
+{
+    auto cached = get_column_statistics(col_key); // Throws
+    if (!cached) {
+        stats.ranges.clear();
+        stats.num_summarized = 0;
+        stats.num_objects = size();
+        return false;
+    }
+    stats = *cached; // Throws
+    return true;
+}
+
+std::shared_ptr<const ColumnStatistics> Table::get_column_statistics(ColKey col_key) const
+{
+    // Gathering the statistics visits every leaf, and is done for each condition when a query is initialized, so
+    // the result is kept for as long as the table is unchanged
+    uint_fast64_t content_version = get_content_version();
+    uint_fast64_t storage_version = get_storage_version();
+    std::lock_guard<std::mutex> lock(m_column_statistics_mutex);
+    auto it = m_column_statistics.find(col_key);
+    if (it != m_column_statistics.end() && it->second.content_version == content_version &&
+        it->second.storage_version == storage_version)
+        return it->second.stats;
+
+    std::shared_ptr<ColumnStatistics> stats;
+    // Zone maps are kept for the whole table or not at all, so the first leaf tells if there is anything to gather
+    bool has_zone_maps = false;
+    traverse_clusters([&](const Cluster* cluster) {
+        has_zone_maps = cluster->get_zone_map() != nullptr;
+        return true; // Stop
+    });
+    if (has_zone_maps) {
+        stats = std::make_shared<ColumnStatistics>(); // Throws
+        stats->num_objects = size();
+        traverse_clusters([&](const Cluster* cluster) {
+            ValueRange range;
+            if (cluster->get_value_range(col_key, range)) {
+                stats->ranges.push_back(range); // Throws
+                stats->num_summarized += range.size;
+            }
+            return false;
+        });
+        if (stats->num_summarized == 0)
+            stats.reset();
+    }
+    ColumnType type = col_key.get_type();
+    bool summarizable = !col_key.get_attrs().test(col_attr_List) &&
+                        (type == col_type_Int || type == col_type_Float || type == col_type_Double ||
+                         type == col_type_Timestamp);
+    if (!stats && summarizable && size() > 0) {
+        // Without zone maps, the values of a sample of evenly spaced leaves are read instead
+        constexpr size_t max_samples = 64;
+        stats = std::make_shared<ColumnStatistics>(); // Throws
+        stats->num_objects = size();
+        size_t step = std::max<size_t>(stats->num_objects / max_samples, 1);
+        size_t next_sample = 0;
+        size_t pos = 0;
+        traverse_clusters([&](const Cluster* cluster) {
+            size_t end = pos + cluster->node_size();
+            if (next_sample < end) {
+                ValueRange range;
+                cluster->summarize_column(col_key, range);
+                stats->ranges.push_back(range); // Throws
+                stats->num_summarized += range.size;
+                while (next_sample < end)
+                    next_sample += step;
+            }
+            pos = end;
+            return false;
+        });
+    }
+    m_column_statistics[col_key] = {content_version, storage_version, stats}; // Throws
+    return stats;
+}
+
 bool Table::is_enumerated(ColKey col_key) const noexcept
 {
     size_t col_ndx = colkey2spec_ndx(col_key);
@@ -724,6 +961,22 @@ ColKey Table::do_insert_root_column(ColKey col_key, ColumnType type, StringData
     else {
         m_index_refs.set(col_ndx, 0);
     }
+    if (m_ordered_index_refs.is_attached()) {
+        if (col_ndx == m_ordered_index_refs.size()) {
+            m_ordered_index_refs.insert(col_ndx, 0);
+        }
+        else {
+            m_ordered_index_refs.set(col_ndx, 0);
+        }
+    }
+    if (m_substring_index_refs.is_attached()) {
+        if (col_ndx == m_substring_index_refs.size()) {
+            m_substring_index_refs.insert(col_ndx, 0);
+        }
+        else {
+            m_substring_index_refs.set(col_ndx, 0);
+        }
+    }
     REALM_ASSERT(col_ndx <= m_opposite_table.size());
     if (col_ndx == m_opposite_table.size()) {
         // m_opposite_table and m_opposite_column are always resized together!
@@ -752,6 +1005,18 @@ void Table::do_erase_root_column(ColKey col_key)
         delete m_index_accessors[col_ndx];
         m_index_accessors[col_ndx] = nullptr;
     }
+    if (OrderedIndex* ordered_index = get_ordered_index(col_key)) {
+        ordered_index->destroy();
+        delete ordered_index;
+        m_ordered_index_accessors[col_ndx] = nullptr;
+        m_ordered_index_refs.set(col_ndx, 0);
+    }
+    if (SubstringIndex* substring_index = get_substring_index(col_key)) {
+        substring_index->destroy();
+        delete substring_index;
+        m_substring_index_accessors[col_ndx] = nullptr;
+        m_substring_index_refs.set(col_ndx, 0);
+    }
     m_opposite_table.set(col_ndx, TableKey().value);
     m_opposite_column.set(col_ndx, ColKey().value);
     m_index_accessors[col_ndx] = nullptr;
@@ -765,6 +1030,14 @@ void Table::do_erase_root_column(ColKey col_key)
         REALM_ASSERT(m_index_accessors.back() == nullptr);
         m_index_accessors.erase(m_index_accessors.end() - 1);
     }
+    while (m_ordered_index_accessors.size() > m_leaf_ndx2colkey.size()) {
+        REALM_ASSERT(m_ordered_index_accessors.back() == nullptr);
+        m_ordered_index_accessors.erase(m_ordered_index_accessors.end() - 1);
+    }
+    while (m_substring_index_accessors.size() > m_leaf_ndx2colkey.size()) {
+        REALM_ASSERT(m_substring_index_accessors.back() == nullptr);
+        m_substring_index_accessors.erase(m_substring_index_accessors.end() - 1);
+    }
 }
 
 LinkType Table::get_link_type(ColKey col_key) const
@@ -804,10 +1077,20 @@ void Table::fully_detach() noexcept
     for (auto& index : m_index_accessors) {
         delete index;
     }
+    for (auto& index : m_ordered_index_accessors) {
+        delete index;
+    }
+    for (auto& index : m_substring_index_accessors) {
+        delete index;
+    }
     m_index_refs.detach();
+    m_ordered_index_refs.detach();
+    m_substring_index_refs.detach();
     m_opposite_table.detach();
     m_opposite_column.detach();
     m_index_accessors.clear();
+    m_ordered_index_accessors.clear();
+    m_substring_index_accessors.clear();
 }
 
 
@@ -826,11 +1109,23 @@ Table::~Table() noexcept
         delete index;
     }
     m_index_accessors.clear();
+    for (auto& index : m_ordered_index_accessors) {
+        delete index;
+    }
+    m_ordered_index_accessors.clear();
+    for (auto& index : m_substring_index_accessors) {
+        delete index;
+    }
+    m_substring_index_accessors.clear();
 }
 
 
-bool Table::has_search_index(ColKey col_key) const noexcept
+bool Table::has_search_index(ColKey col_key, IndexType type) const noexcept
 {
+    if (type == IndexType::Ordered)
+        return get_ordered_index(col_key) != nullptr;
+    if (type == IndexType::Substring)
+        return get_substring_index(col_key) != nullptr;
     return m_index_accessors[col_key.get_index().val] != nullptr;
 }
 
@@ -1767,12 +2062,18 @@ size_t Table::count_int(ColKey col_key, int64_t value) const
 }
 size_t Table::count_float(ColKey col_key, float value) const
 {
+    if (auto index = this->get_search_index(col_key)) {
+        return null::is_null_float(value) ? index->count(null{}) : index->count(value);
+    }
     size_t count;
     aggregate<act_Count, float, float>(col_key, value, &count);
     return count;
 }
 size_t Table::count_double(ColKey col_key, double value) const
 {
+    if (auto index = this->get_search_index(col_key)) {
+        return null::is_null_float(value) ? index->count(null{}) : index->count(value);
+    }
     size_t count;
     aggregate<act_Count, double, double>(col_key, value, &count);
     return count;
@@ -2199,6 +2500,24 @@ void Table::update_from_parent(size_t old_baseline) noexcept
             m_opposite_table.update_from_parent(old_baseline);
         if (m_top.size() > top_position_for_opposite_column)
             m_opposite_column.update_from_parent(old_baseline);
+        if (m_top.size() > top_position_for_ordered_indexes && m_ordered_index_refs.is_attached()) {
+            if (m_ordered_index_refs.update_from_parent(old_baseline)) {
+                for (auto index : m_ordered_index_accessors) {
+                    if (index != nullptr) {
+                        index->update_from_parent(old_baseline);
+                    }
+                }
+            }
+        }
+        if (m_top.size() > top_position_for_substring_indexes && m_substring_index_refs.is_attached()) {
+            if (m_substring_index_refs.update_from_parent(old_baseline)) {
+                for (auto index : m_substring_index_accessors) {
+                    if (index != nullptr) {
+                        index->update_from_parent(old_baseline);
+                    }
+                }
+            }
+        }
         refresh_content_version();
     }
     m_alloc.bump_storage_version();
@@ -2356,6 +2675,100 @@ void Table::refresh_index_accessors()
             m_index_accessors[col_ndx] = new StringIndex(ref, &m_index_refs, col_ndx, virtual_col, get_alloc());
         }
     }
+
+    refresh_ordered_index_accessors();
+    refresh_substring_index_accessors();
+}
+
+void Table::refresh_ordered_index_accessors()
+{
+    // The slot holding the ordered indexes is only present if one has been added at some point
+    if (m_top.size() > top_position_for_ordered_indexes && m_top.get_as_ref(top_position_for_ordered_indexes)) {
+        m_ordered_index_refs.init_from_parent();
+    }
+    else {
+        m_ordered_index_refs.detach();
+    }
+
+    size_t col_ndx_end = m_leaf_ndx2colkey.size();
+    for (size_t col_ndx = col_ndx_end; col_ndx < m_ordered_index_accessors.size(); col_ndx++) {
+        delete m_ordered_index_accessors[col_ndx];
+    }
+    m_ordered_index_accessors.resize(col_ndx_end);
+
+    for (size_t col_ndx = 0; col_ndx < col_ndx_end; col_ndx++) {
+        OrderedIndex*& index = m_ordered_index_accessors[col_ndx];
+        ref_type ref = 0;
+        if (m_ordered_index_refs.is_attached() && col_ndx < m_ordered_index_refs.size())
+            ref = m_ordered_index_refs.get_as_ref(col_ndx);
+
+        if (index && ref == 0) { // accessor drop
+            delete index;
+            index = nullptr;
+        }
+        else if (ref != 0) {
+            ClusterColumn virtual_col(&m_clusters, m_leaf_ndx2colkey[col_ndx]);
+            if (index) { // still there, refresh
+                index->refresh_accessor_tree(virtual_col);
+            }
+            else { // new index
+                index = new OrderedIndex(ref, &m_ordered_index_refs, col_ndx, virtual_col, get_alloc());
+            }
+        }
+    }
+}
+
+void Table::refresh_substring_index_accessors()
+{
+    if (m_top.size() > top_position_for_substring_indexes && m_top.get_as_ref(top_position_for_substring_indexes)) {
+        m_substring_index_refs.init_from_parent();
+    }
+    else {
+        m_substring_index_refs.detach();
+    }
+
+    size_t col_ndx_end = m_leaf_ndx2colkey.size();
+    for (size_t col_ndx = col_ndx_end; col_ndx < m_substring_index_accessors.size(); col_ndx++) {
+        delete m_substring_index_accessors[col_ndx];
+    }
+    m_substring_index_accessors.resize(col_ndx_end);
+
+    for (size_t col_ndx = 0; col_ndx < col_ndx_end; col_ndx++) {
+        SubstringIndex*& index = m_substring_index_accessors[col_ndx];
+        ref_type ref = 0;
+        if (m_substring_index_refs.is_attached() && col_ndx < m_substring_index_refs.size())
+            ref = m_substring_index_refs.get_as_ref(col_ndx);
+
+        if (index && ref == 0) { // accessor drop
+            delete index;
+            index = nullptr;
+        }
+        else if (ref != 0) {
+            ClusterColumn virtual_col(&m_clusters, m_leaf_ndx2colkey[col_ndx]);
+            if (index) { // still there, refresh
+                index->refresh_accessor_tree(virtual_col);
+            }
+            else { // new index
+                index = new SubstringIndex(ref, &m_substring_index_refs, col_ndx, virtual_col, get_alloc());
+            }
+        }
+    }
+}
+
+void Table::rebuild_optional_indexes()
+{
+    for (auto index : m_ordered_index_accessors) {
+        if (index) {
+            index->clear(); // Throws
+            index->build(); // Throws
+        }
+    }
+    for (auto index : m_substring_index_accessors) {
+        if (index) {
+            index->clear(); // Throws
+            index->build(); // Throws
+        }
+    }
 }
 
 bool Table::is_cross_table_link_target() const noexcept
@@ -2377,6 +2790,14 @@ void Table::verify() const
         m_top.verify();
     m_spec.verify();
     m_clusters.verify();
+    for (auto index : m_ordered_index_accessors) {
+        if (index)
+            index->verify();
+    }
+    for (auto index : m_substring_index_accessors) {
+        if (index)
+            index->verify();
+    }
 #endif
 }
 
@@ -3147,6 +3568,8 @@ ColKey Table::set_nullability(ColKey col_key, bool nullable, bool throw_on_null)
         return col_key;
 
     bool si = has_search_index(col_key);
+    bool ordered = has_search_index(col_key, IndexType::Ordered);
+    bool substring = has_search_index(col_key, IndexType::Substring);
     std::string column_name(get_column_name(col_key));
     auto type = get_real_column_type(col_key);
     auto list = is_list(col_key);
@@ -3170,6 +3593,10 @@ ColKey Table::set_nullability(ColKey col_key, bool nullable, bool throw_on_null)
 
     if (si)
         add_search_index(new_col);
+    if (ordered)
+        add_search_index(new_col, IndexType::Ordered);
+    if (substring)
+        add_search_index(new_col, IndexType::Substring);
 
     return new_col;
 }
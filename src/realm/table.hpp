@@ -53,6 +53,8 @@ class ConstTableView;
 class Group;
 class SortDescriptor;
 class StringIndex;
+class OrderedIndex;
+class SubstringIndex;
 class TableView;
 template <class>
 class Columns;
@@ -67,6 +69,16 @@ struct Link {
 };
 typedef Link BackLink;
 
+/// The kinds of search index that can be added to a column. A `General`
+/// index (StringIndex) answers equality conditions and is available for
+/// Int, Bool, String and Timestamp columns. An `Ordered` index
+/// (OrderedIndex) keeps the values in sorted order, and is used for range
+/// conditions and for sorting on Int and Timestamp columns. A `Substring`
+/// index (SubstringIndex) maps the trigrams of the values of a String column
+/// to the objects holding them, and is used for Contains, BeginsWith,
+/// EndsWith and Like conditions, with or without case sensitivity.
+enum class IndexType { General, Ordered, Substring };
+
 
 namespace _impl {
 class TableFriend;
@@ -232,15 +244,44 @@ public:
     /// index. The search index cannot be removed from the primary key of a
     /// table.
     ///
+    /// A column can have an index of each IndexType at the same time. Adding
+    /// an `Ordered` index to a column that is not of type Int or Timestamp, or
+    /// a `Substring` index to a column that is not of type String, throws
+    /// LogicError::illegal_combination.
+    ///
     /// \param col_key The key of a column of the table.
+    /// \param type The kind of index.
 
-    bool has_search_index(ColKey col_key) const noexcept;
-    void add_search_index(ColKey col_key);
-    void remove_search_index(ColKey col_key);
+    bool has_search_index(ColKey col_key, IndexType type = IndexType::General) const noexcept;
+    void add_search_index(ColKey col_key, IndexType type = IndexType::General);
+    void remove_search_index(ColKey col_key, IndexType type = IndexType::General);
 
     void enumerate_string_column(ColKey col_key);
     bool is_enumerated(ColKey col_key) const noexcept;
+    /// Count the distinct values of the String column \a col_key, giving up
+    /// once more than \a limit have been found. Returns `limit + 1` in that
+    /// case. This is used to decide if the column should be enumerated.
+    size_t count_unique_strings(ColKey col_key, size_t limit) const;
     bool contains_unique_values(ColKey col_key) const;
+    /// Store the Int and Timestamp values modified by the current write
+    /// transaction in a more compact encoding where that is possible. This is
+    /// done on commit if DBOptions::enable_integer_compression is set.
+    void compress_integer_leaves();
+    /// Summarize the Int, Float, Double and Timestamp values of the leaves
+    /// modified by the current write transaction, so that queries can skip
+    /// leaves which can not match. This is done on commit if
+    /// DBOptions::enable_zone_maps is set.
+    void update_zone_maps();
+    /// Gather the statistics of column \a col_key from the zone maps, or, if
+    /// the table has none, from the values of a sample of at most 64 leaves.
+    /// Returns false if no leaf of the table is summarized, as for an empty
+    /// table or a column of another type than Int, Float, Double and
+    /// Timestamp. The statistics are cached until the table is modified or
+    /// refreshed.
+    bool get_column_statistics(ColKey col_key, ColumnStatistics& stats) const;
+    /// As above, but returns the cached statistics without copying them, or
+    /// null if no leaf of the table is summarized.
+    std::shared_ptr<const ColumnStatistics> get_column_statistics(ColKey col_key) const;
 
     //@}
 
@@ -403,6 +444,20 @@ public:
             return nullptr;
         return m_index_accessors[col.get_index().val];
     }
+    // Will return pointer to ordered index accessor. Will return nullptr if no ordered index
+    OrderedIndex* get_ordered_index(ColKey col) const noexcept
+    {
+        report_invalid_key(col);
+        size_t col_ndx = col.get_index().val;
+        return col_ndx < m_ordered_index_accessors.size() ? m_ordered_index_accessors[col_ndx] : nullptr;
+    }
+    // Will return pointer to substring index accessor. Will return nullptr if no substring index
+    SubstringIndex* get_substring_index(ColKey col) const noexcept
+    {
+        report_invalid_key(col);
+        size_t col_ndx = col.get_index().val;
+        return col_ndx < m_substring_index_accessors.size() ? m_substring_index_accessors[col_ndx] : nullptr;
+    }
     template <class T>
     ObjKey find_first(ColKey col_key, T value) const;
 
@@ -685,17 +740,42 @@ private:
     Array m_index_refs; // 5th slot in m_top
     Array m_opposite_table;  // 7th slot in m_top
     Array m_opposite_column; // 8th slot in m_top
+    Array m_ordered_index_refs; // 13th slot in m_top, if present
+    Array m_substring_index_refs; // 14th slot in m_top, if present
     std::vector<StringIndex*> m_index_accessors;
+    std::vector<OrderedIndex*> m_ordered_index_accessors;
+    std::vector<SubstringIndex*> m_substring_index_accessors;
     ColKey m_primary_key_col;
     Replication* const* m_repl;
     static Replication* g_dummy_replication;
     bool m_is_frozen = false;
     TableRef m_own_ref;
 
+    // See get_column_statistics(). A frozen table may be queried from several
+    // threads, so the cache is protected by a mutex.
+    struct CachedColumnStatistics {
+        uint_fast64_t content_version;
+        uint_fast64_t storage_version;
+        std::shared_ptr<const ColumnStatistics> stats;
+    };
+    mutable std::mutex m_column_statistics_mutex;
+    mutable std::map<ColKey, CachedColumnStatistics> m_column_statistics;
+
     void batch_erase_rows(const KeyColumn& keys);
     size_t do_set_link(ColKey col_key, size_t row_ndx, size_t target_row_ndx);
 
     void populate_search_index(ColKey col_key);
+    void add_ordered_index(ColKey col_key);
+    void remove_ordered_index(ColKey col_key);
+    void refresh_ordered_index_accessors();
+    void add_substring_index(ColKey col_key);
+    void remove_substring_index(ColKey col_key);
+    void refresh_substring_index_accessors();
+    // Rebuild the ordered and substring indexes. Used when upgrading a file, in
+    // which an earlier version may have left them stale.
+    void rebuild_optional_indexes();
+    // Remove the zone maps, for the same reason
+    void drop_zone_maps();
 
     // Migration support
     void migrate_column_info(util::FunctionRef<void()>);
@@ -933,6 +1013,10 @@ private:
     static constexpr int top_position_for_collision_map = 10;
     static constexpr int top_position_for_pk_col = 11;
     static constexpr int top_array_size = 12;
+    // Optional slots beyond top_array_size. These are only added when needed, and belong
+    // to file format version 11, as every writer must maintain them.
+    static constexpr int top_position_for_ordered_indexes = 12;
+    static constexpr int top_position_for_substring_indexes = 13;
 
     enum { s_collision_map_lo = 0, s_collision_map_hi = 1, s_collision_map_local_id = 2, s_collision_map_num_slots };
 
@@ -1226,6 +1310,8 @@ inline Table::Table(Allocator& alloc)
     , m_index_refs(m_alloc)
     , m_opposite_table(m_alloc)
     , m_opposite_column(m_alloc)
+    , m_ordered_index_refs(m_alloc)
+    , m_substring_index_refs(m_alloc)
     , m_repl(&g_dummy_replication)
     , m_own_ref(this, alloc.get_instance_version())
 {
@@ -1233,6 +1319,8 @@ inline Table::Table(Allocator& alloc)
     m_index_refs.set_parent(&m_top, top_position_for_search_indexes);
     m_opposite_table.set_parent(&m_top, top_position_for_opposite_table);
     m_opposite_column.set_parent(&m_top, top_position_for_opposite_column);
+    m_ordered_index_refs.set_parent(&m_top, top_position_for_ordered_indexes);
+    m_substring_index_refs.set_parent(&m_top, top_position_for_substring_indexes);
 
     ref_type ref = create_empty_table(m_alloc); // Throws
     ArrayParent* parent = nullptr;
@@ -1248,6 +1336,8 @@ inline Table::Table(Replication* const* repl, Allocator& alloc)
     , m_index_refs(m_alloc)
     , m_opposite_table(m_alloc)
     , m_opposite_column(m_alloc)
+    , m_ordered_index_refs(m_alloc)
+    , m_substring_index_refs(m_alloc)
     , m_repl(repl)
     , m_own_ref(this, alloc.get_instance_version())
 {
@@ -1255,6 +1345,8 @@ inline Table::Table(Replication* const* repl, Allocator& alloc)
     m_index_refs.set_parent(&m_top, top_position_for_search_indexes);
     m_opposite_table.set_parent(&m_top, top_position_for_opposite_table);
     m_opposite_column.set_parent(&m_top, top_position_for_opposite_column);
+    m_ordered_index_refs.set_parent(&m_top, top_position_for_ordered_indexes);
+    m_substring_index_refs.set_parent(&m_top, top_position_for_substring_indexes);
 }
 
 inline void Table::revive(Replication* const* repl, Allocator& alloc, bool writable)
@@ -20,11 +20,120 @@
 #include <realm/column_integer.hpp>
 #include <realm/index_string.hpp>
 #include <realm/db.hpp>
+#include <realm/impl/input_stream.hpp>
+#include <realm/impl/transact_log.hpp>
 
 #include <unordered_set>
 
 using namespace realm;
 
+namespace {
+
+// Collects the keys of the objects in one table that are created, removed or modified by a series of changesets
+class ChangedObjectCollector : public _impl::NullInstructionObserver {
+public:
+    ChangedObjectCollector(TableKey table_key, size_t max_objects)
+        : m_table_key(table_key)
+        , m_max_objects(max_objects)
+    {
+    }
+
+    // Returns false if the table was cleared or changed schema, or too many objects were changed
+    bool is_usable() const
+    {
+        return !m_overflow;
+    }
+    std::vector<ObjKey>& get_keys()
+    {
+        return m_keys;
+    }
+
+    bool select_table(TableKey key)
+    {
+        m_selected = (key == m_table_key);
+        return true;
+    }
+    bool select_list(ColKey, ObjKey key)
+    {
+        return add(key);
+    }
+    bool select_link_list(ColKey, ObjKey key)
+    {
+        return add(key);
+    }
+    bool erase_group_level_table(TableKey key)
+    {
+        if (key == m_table_key)
+            m_overflow = true;
+        return true;
+    }
+    bool create_object(ObjKey key)
+    {
+        return add(key);
+    }
+    bool remove_object(ObjKey key)
+    {
+        return add(key);
+    }
+    bool modify_object(ColKey, ObjKey key)
+    {
+        return add(key);
+    }
+    bool clear_table(size_t)
+    {
+        return schema_or_table_change();
+    }
+    bool insert_column(ColKey)
+    {
+        return schema_or_table_change();
+    }
+    bool erase_column(ColKey)
+    {
+        return schema_or_table_change();
+    }
+    bool set_link_type(ColKey)
+    {
+        return schema_or_table_change();
+    }
+
+private:
+    TableKey m_table_key;
+    size_t m_max_objects;
+    bool m_selected = false;
+    bool m_overflow = false;
+    std::vector<ObjKey> m_keys;
+
+    bool add(ObjKey key)
+    {
+        // Consecutive instructions usually concern the same object
+        if (m_selected && !m_overflow && (m_keys.empty() || m_keys.back() != key)) {
+            if (m_keys.size() < m_max_objects)
+                m_keys.push_back(key);
+            else
+                m_overflow = true;
+        }
+        return true;
+    }
+    bool schema_or_table_change()
+    {
+        if (m_selected)
+            m_overflow = true;
+        return true;
+    }
+};
+
+// The version of the snapshot bound by 'group', if it is a read transaction. Changes made during a write transaction
+// can not be found in the history until they are committed, and not at all if they are rolled back.
+util::Optional<VersionID::version_type> get_read_version(Group* group)
+{
+    auto tr = dynamic_cast<Transaction*>(group);
+    if (tr && tr->get_transact_stage() == DB::transact_Reading)
+        return tr->get_version_of_current_transaction().version;
+    return util::none;
+}
+
+} // anonymous namespace
+
 ConstTableView::ConstTableView(ConstTableView& src, Transaction*, PayloadPolicy)
     : ObjList(&m_table_view_key_values)
     , m_source_column_key(src.m_source_column_key)
@@ -442,7 +551,9 @@ void ConstTableView::sync_if_needed() const
 {
     if (!is_in_sync()) {
         // FIXME: Is this a reasonable handling of constness?
-        const_cast<ConstTableView*>(this)->do_sync();
+        auto self = const_cast<ConstTableView*>(this);
+        if (!self->update_incrementally())
+            self->do_sync();
     }
 }
 
@@ -605,6 +716,136 @@ void ConstTableView::do_sync()
     do_sort(m_descriptor_ordering);
 
     m_last_seen_versions = get_dependency_versions();
+    m_sync_version = m_table ? get_read_version(m_table.unchecked_ptr()->get_parent_group()) : util::none;
+}
+
+bool ConstTableView::update_incrementally()
+{
+    // The objects changed since the view was last synchronized are found in the changesets stored in the history.
+    // That is only enough to bring the view up to date if whether an object is included, and where, depends on
+    // nothing but the values of that object. So the view must be the result of a query on a single table, with no
+    // restriction to a range or another view, and ordered by at most a sort on columns of that table. Neither may
+    // follow links or backlinks, as a change to the object at the other end is not a change to this one, even when
+    // both are in the same table.
+    if (!m_sync_version || !m_table || m_linklist_source || m_distinct_column_source || m_source_column_key)
+        return false;
+    if (!m_query.m_table || m_query.m_view || m_start != 0 || m_end != size_t(-1) || m_limit != size_t(-1))
+        return false;
+    if (m_descriptor_ordering.size() > 1 ||
+        (m_descriptor_ordering.size() == 1 && m_descriptor_ordering.get_type(0) != DescriptorType::Sort))
+        return false;
+    if (m_last_seen_versions.size() != 1 || get_dependency_versions().size() != 1)
+        return false;
+    if (m_query.may_read_other_objects())
+        return false;
+
+    auto read_version = get_read_version(m_table.unchecked_ptr()->get_parent_group());
+    if (!read_version || *read_version < *m_sync_version)
+        return false;
+    auto tr = static_cast<Transaction*>(m_table->get_parent_group());
+    _impl::History* hist = tr->get_history();
+    if (!hist)
+        return false;
+    hist->update_from_parent(*read_version);
+    if (*m_sync_version < hist->get_oldest_available_version())
+        return false;
+
+    // Reevaluating a changed object costs about as much as a binary search in the view, so give up when rerunning
+    // the query would not be much more expensive
+    size_t max_changes = std::max<size_t>(m_table->size() / 8, 16);
+    ChangedObjectCollector collector(m_table->get_key(), max_changes);
+    {
+        _impl::ChangesetInputStream in(*hist, *m_sync_version, *read_version);
+        _impl::TransactLogParser parser;
+        parser.parse(in, collector); // Throws
+    }
+    if (!collector.is_usable())
+        return false;
+
+    CriticalSection cs(m_race_detector);
+
+    std::vector<ObjKey>& changed = collector.get_keys();
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+    using IndexPair = BaseDescriptor::IndexPair;
+    BaseDescriptor::Sorter sorter;
+    bool sorted = !m_descriptor_ordering.is_empty();
+    if (sorted) {
+        sorter = m_descriptor_ordering[0]->sorter(*m_table, BaseDescriptor::IndexPairs());
+        if (sorter.has_links())
+            return false;
+    }
+    // The full sort is stable over the query result, which is in key order, so equal entries are ordered by key
+    auto less = [&](const IndexPair& a, const IndexPair& b) {
+        if (sorter(a, b, false))
+            return true;
+        if (sorter(b, a, false))
+            return false;
+        return a.key_for_object < b.key_for_object;
+    };
+
+    // The node accessors may hold state computed from the previous snapshot, such as search index results
+    if (!changed.empty())
+        m_query.init();
+    BaseDescriptor::IndexPairs added;
+    for (ObjKey key : changed) {
+        if (!m_table->is_valid(key))
+            continue;
+        ConstObj obj = m_table->get_object(key);
+        if (m_query.eval_object(obj)) {
+            added.emplace_back(key, added.size());
+            if (sorted)
+                sorter.cache_first_column(added.back());
+        }
+    }
+
+    size_t sz = m_key_values->size();
+    std::vector<ObjKey> kept;
+    kept.reserve(sz);
+    for (size_t i = 0; i < sz; ++i) {
+        ObjKey key = m_key_values->get(i);
+        if (!std::binary_search(changed.begin(), changed.end(), key))
+            kept.push_back(key);
+    }
+
+    std::vector<ObjKey> result;
+    result.reserve(kept.size() + added.size());
+    if (!sorted) {
+        // Both sequences are in key order
+        auto added_key = [](const IndexPair& p) { return p.key_for_object; };
+        auto it = kept.begin();
+        for (auto& p : added) {
+            auto pos = std::lower_bound(it, kept.end(), added_key(p));
+            result.insert(result.end(), it, pos);
+            result.push_back(added_key(p));
+            it = pos;
+        }
+        result.insert(result.end(), it, kept.end());
+    }
+    else {
+        std::sort(added.begin(), added.end(), less);
+        auto it = kept.begin();
+        for (auto& p : added) {
+            auto pos = std::lower_bound(it, kept.end(), p, [&](ObjKey key, const IndexPair& value) {
+                IndexPair entry(key, 0);
+                sorter.cache_first_column(entry);
+                return less(entry, value);
+            });
+            result.insert(result.end(), it, pos);
+            result.push_back(p.key_for_object);
+            it = pos;
+        }
+        result.insert(result.end(), it, kept.end());
+    }
+
+    m_key_values->clear();
+    for (ObjKey key : result)
+        m_key_values->add(key);
+
+    m_last_seen_versions = get_dependency_versions();
+    m_sync_version = read_version;
+    return true;
 }
 
 bool ConstTableView::is_in_table_order() const
@@ -23,6 +23,7 @@
 #include <realm/table.hpp>
 #include <realm/util/features.h>
 #include <realm/obj_list.hpp>
+#include <realm/version_id.hpp>
 
 namespace realm {
 
@@ -295,6 +296,12 @@ public:
     // query used to generate the view. If derived from another view, that
     // view will be synchronized as well.
     //
+    // A view over a query on a single table, with at most one sort and no
+    // distinct or limit, is instead patched when it was last synchronized
+    // during a read transaction on a DB with a history: only the objects
+    // created, modified or removed since then, according to the changesets
+    // in the history, are evaluated and merged into the existing order.
+    //
     // "live" or "reactive" views are implemented by calling sync_if_needed
     // before any of the other access-methods whenever the view may have become
     // outdated.
@@ -357,6 +364,8 @@ protected:
     void get_dependencies(TableVersions&) const override;
 
     void do_sync();
+    // Patch the view with the changes made since m_sync_version. Returns false if that is not possible.
+    bool update_incrementally();
 
     // The source column index that this view contain backlinks for.
     ColKey m_source_column_key;
@@ -383,6 +392,8 @@ protected:
     size_t m_limit = size_t(-1);
 
     mutable TableVersions m_last_seen_versions;
+    // Version of the snapshot the view was last synchronized in, if that happened during a read transaction
+    util::Optional<VersionID::version_type> m_sync_version;
 
 private:
     KeyColumn m_table_view_key_values; // We should generally not use this name
@@ -543,6 +554,7 @@ inline ConstTableView::ConstTableView(const ConstTableView& tv)
     , m_end(tv.m_end)
     , m_limit(tv.m_limit)
     , m_last_seen_versions(tv.m_last_seen_versions)
+    , m_sync_version(tv.m_sync_version)
     , m_table_view_key_values(tv.m_table_view_key_values)
 {
     m_limit_count = tv.m_limit_count;
@@ -563,6 +575,7 @@ inline ConstTableView::ConstTableView(ConstTableView&& tv) noexcept
     // if we are created from a table view which is outdated, take care to use the outdated
     // version number so that we can later trigger a sync if needed.
     , m_last_seen_versions(std::move(tv.m_last_seen_versions))
+    , m_sync_version(tv.m_sync_version)
     , m_table_view_key_values(std::move(tv.m_table_view_key_values))
 {
     m_limit_count = tv.m_limit_count;
@@ -575,6 +588,7 @@ inline ConstTableView& ConstTableView::operator=(ConstTableView&& tv) noexcept
     m_table_view_key_values = std::move(tv.m_table_view_key_values);
     m_query = std::move(tv.m_query);
     m_last_seen_versions = tv.m_last_seen_versions;
+    m_sync_version = tv.m_sync_version;
     m_start = tv.m_start;
     m_end = tv.m_end;
     m_limit = tv.m_limit;
@@ -598,6 +612,7 @@ inline ConstTableView& ConstTableView::operator=(const ConstTableView& tv)
 
     m_query = tv.m_query;
     m_last_seen_versions = tv.m_last_seen_versions;
+    m_sync_version = tv.m_sync_version;
     m_start = tv.m_start;
     m_end = tv.m_end;
     m_limit = tv.m_limit;
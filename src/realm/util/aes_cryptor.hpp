@@ -53,6 +53,13 @@ public:
     bool read(FileDesc fd, off_t pos, char* dst, size_t size);
     void write(FileDesc fd, off_t pos, const char* src, size_t size) noexcept;
 
+    // Decrypt the blocks of [pos, pos + size) for read-ahead, stopping at the
+    // first block which has not been written or fails verification. The
+    // blocks are decrypted in place, so no other thread may access 'dst'
+    // meanwhile. With num_threads > 1, large batches are split between that
+    // many threads. Returns the number of bytes decrypted.
+    size_t read_ahead(FileDesc fd, off_t pos, char* dst, size_t size, size_t num_threads);
+
 private:
     enum EncryptionMode {
 #if REALM_PLATFORM_APPLE
@@ -73,15 +80,22 @@ private:
 #elif defined(_WIN32)
     BCRYPT_KEY_HANDLE m_aes_key_handle;
 #else
-    uint8_t m_aesKey[32];
-    EVP_CIPHER_CTX* m_ctx;
+    EVP_CIPHER_CTX* m_encr_ctx;
+    EVP_CIPHER_CTX* m_decr_ctx;
 #endif
 
+    uint8_t m_key[64];
     uint8_t m_hmacKey[32];
     std::vector<iv_table> m_iv_buffer;
     std::unique_ptr<char[]> m_rw_buffer;
     std::unique_ptr<char[]> m_dst_buffer;
+    // Encrypted blocks read by read() and read_ahead()
+    std::vector<char> m_read_buffer;
+    // Cryptors used by the extra threads of read_ahead()
+    std::vector<std::unique_ptr<AESCryptor>> m_workers;
 
+    size_t read_blocks(FileDesc fd, off_t pos, size_t size);
+    bool check_block(const char* src, size_t len, iv_table& iv) const;
     void calc_hmac(const void* src, size_t len, uint8_t* dst, const uint8_t* key) const;
     bool check_hmac(const void* data, size_t len, const uint8_t* hmac) const;
     void crypt(EncryptionMode mode, off_t pos, char* dst, const char* src, const char* stored_iv) noexcept;
@@ -0,0 +1,184 @@
+/*************************************************************************
+ *
+ * Copyright 2021 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <realm/util/compression.hpp>
+
+using namespace realm;
+using namespace realm::util;
+
+
+namespace {
+
+constexpr size_t g_min_match = 4;
+constexpr size_t g_max_offset = 65535;
+constexpr int g_hash_bits = 12;
+
+inline uint32_t read_32(const char* p) noexcept
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof v);
+    return v;
+}
+
+inline size_t hash_32(uint32_t v) noexcept
+{
+    return size_t((v * 2654435761U) >> (32 - g_hash_bits));
+}
+
+// Write the continuation bytes of a length of at least 15
+inline bool put_length(char*& out, char* out_end, size_t length) noexcept
+{
+    length -= 15;
+    for (;;) {
+        if (out == out_end)
+            return false;
+        if (length < 255) {
+            *out++ = char(length);
+            return true;
+        }
+        *out++ = char(255);
+        length -= 255;
+    }
+}
+
+inline bool get_length(const unsigned char*& in, const unsigned char* in_end, size_t& length) noexcept
+{
+    unsigned char b;
+    do {
+        if (in == in_end)
+            return false;
+        b = *in++;
+        length += b;
+    } while (b == 255);
+    return true;
+}
+
+// Write a sequence. A match length of zero means that there is no match, which
+// is only allowed for the last sequence.
+bool put_sequence(char*& out, char* out_end, const char* literals, size_t num_literals, size_t offset,
+                  size_t match_length) noexcept
+{
+    if (out == out_end)
+        return false;
+    size_t match_code = match_length ? match_length - g_min_match : 0;
+    *out++ = char((std::min(num_literals, size_t(15)) << 4) | std::min(match_code, size_t(15)));
+    if (num_literals >= 15 && !put_length(out, out_end, num_literals))
+        return false;
+    if (size_t(out_end - out) < num_literals)
+        return false;
+    std::memcpy(out, literals, num_literals);
+    out += num_literals;
+    if (match_length) {
+        if (out_end - out < 2)
+            return false;
+        *out++ = char(offset & 0xFF);
+        *out++ = char(offset >> 8);
+        if (match_code >= 15 && !put_length(out, out_end, match_code))
+            return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+
+size_t compression::compress(const char* in, size_t size, char* out, size_t out_size) noexcept
+{
+    // Most recent position of each hashed 4 byte sequence. Entries may be
+    // stale or collide, so candidates are always compared to the input.
+    uint32_t table[size_t(1) << g_hash_bits] = {};
+    char* out_begin = out;
+    char* out_end = out + out_size;
+    size_t anchor = 0; // Start of pending literals
+    size_t pos = 1;
+    if (size > g_min_match) {
+        size_t limit = size - g_min_match;
+        while (pos <= limit) {
+            uint32_t v = read_32(in + pos);
+            size_t h = hash_32(v);
+            size_t candidate = table[h];
+            table[h] = uint32_t(pos);
+            if (candidate < pos && pos - candidate <= g_max_offset && read_32(in + candidate) == v) {
+                size_t length = g_min_match;
+                while (pos + length < size && in[candidate + length] == in[pos + length])
+                    ++length;
+                if (!put_sequence(out, out_end, in + anchor, pos - anchor, pos - candidate, length))
+                    return 0;
+                pos += length;
+                anchor = pos;
+                continue;
+            }
+            // Step faster through data that does not compress
+            pos += 1 + ((pos - anchor) >> 6);
+        }
+    }
+    if (!put_sequence(out, out_end, in + anchor, size - anchor, 0, 0))
+        return 0;
+    return size_t(out - out_begin);
+}
+
+
+bool compression::decompress(const char* in, size_t size, char* out, size_t out_size) noexcept
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+    const unsigned char* p_end = p + size;
+    char* out_begin = out;
+    char* out_end = out + out_size;
+    for (;;) {
+        if (p == p_end)
+            return false;
+        unsigned token = *p++;
+        size_t num_literals = token >> 4;
+        if (num_literals == 15 && !get_length(p, p_end, num_literals))
+            return false;
+        if (size_t(p_end - p) < num_literals || size_t(out_end - out) < num_literals)
+            return false;
+        std::memcpy(out, p, num_literals);
+        p += num_literals;
+        out += num_literals;
+        if (out == out_end)
+            return (token & 15) == 0 && p == p_end;
+
+        if (p_end - p < 2)
+            return false;
+        size_t offset = size_t(p[0]) | size_t(p[1]) << 8;
+        p += 2;
+        if (offset == 0 || offset > size_t(out - out_begin))
+            return false;
+        size_t length = token & 15;
+        if (length == 15 && !get_length(p, p_end, length))
+            return false;
+        length += g_min_match;
+        if (size_t(out_end - out) < length)
+            return false;
+        const char* match = out - offset;
+        if (offset >= length) {
+            std::memcpy(out, match, length);
+            out += length;
+        }
+        else {
+            // The match overlaps the output it produces
+            for (size_t i = 0; i < length; ++i)
+                *out++ = match[i];
+        }
+    }
+}
@@ -0,0 +1,71 @@
+/*************************************************************************
+ *
+ * Copyright 2021 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_UTIL_COMPRESSION_HPP
+#define REALM_UTIL_COMPRESSION_HPP
+
+#include <cstddef>
+
+namespace realm {
+namespace util {
+namespace compression {
+
+/*
+A fast LZ77 block compressor in the style of LZ4, intended for small blocks of
+data with recurring byte sequences, such as transaction logs. There is no
+entropy coding, so decompression is a simple copying loop.
+
+The compressed block is a sequence of sequences, each of which is a token byte,
+literals and a match:
+
+    token     high 4 bits: number of literals, low 4 bits: match length - 4.
+              A value of 15 is continued by bytes which are added to it, where
+              a byte of 255 means that another one follows.
+    literals  bytes copied to the output as they are
+    offset    2 bytes, little endian, distance back from the current output
+              position to the start of the match (1 - 65535)
+    length    continuation bytes of the match length, if needed
+
+The size of the decompressed data is not part of the block, and must be known
+by the caller. The last sequence ends after its literals, when the output is
+complete.
+*/
+
+/// compress_bound() returns the size of the largest block that compress() can
+/// produce for \a size bytes of input.
+inline size_t compress_bound(size_t size) noexcept
+{
+    return size + size / 255 + 16;
+}
+
+/// Compress \a size bytes from \a in into \a out, which must have room for
+/// \a out_size bytes. Returns the size of the compressed block, or zero if it
+/// does not fit in \a out_size bytes, which can not happen if \a out_size is
+/// at least compress_bound(size).
+size_t compress(const char* in, size_t size, char* out, size_t out_size) noexcept;
+
+/// Decompress the block of \a size bytes at \a in into exactly \a out_size
+/// bytes at \a out. Returns false if the block is malformed, or does not
+/// decompress into \a out_size bytes.
+bool decompress(const char* in, size_t size, char* out, size_t out_size) noexcept;
+
+} // namespace compression
+} // namespace util
+} // namespace realm
+
+#endif // REALM_UTIL_COMPRESSION_HPP
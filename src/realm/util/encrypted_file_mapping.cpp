@@ -25,6 +25,7 @@
 #include <algorithm>
 #include <stdexcept>
 #include <system_error>
+#include <thread>
 
 #ifdef REALM_DEBUG
 #include <cstdio>
@@ -168,13 +169,18 @@ AESCryptor::AESCryptor(const uint8_t* key)
     ret = BCryptGenerateSymmetricKey(hAesAlg, &m_aes_key_handle, nullptr, 0, (PBYTE)key, 32, 0);
     REALM_ASSERT_RELEASE_EX(ret == 0 && "BCryptGenerateSymmetricKey()", ret);
 #else
-    m_ctx = EVP_CIPHER_CTX_new();
+    m_encr_ctx = EVP_CIPHER_CTX_new();
+    m_decr_ctx = EVP_CIPHER_CTX_new();
 
-    if (!m_ctx)
+    if (!m_encr_ctx || !m_decr_ctx)
         handle_error();
 
-    memcpy(m_aesKey, key, 32);
+    // The key schedules are set up once here, crypt() only sets the iv
+    if (!EVP_CipherInit_ex(m_encr_ctx, EVP_aes_256_cbc(), NULL, key, NULL, mode_Encrypt) ||
+        !EVP_CipherInit_ex(m_decr_ctx, EVP_aes_256_cbc(), NULL, key, NULL, mode_Decrypt))
+        handle_error();
 #endif
+    memcpy(m_key, key, 64);
     memcpy(m_hmacKey, key + 32, 32);
 }
 
@@ -185,8 +191,10 @@ AESCryptor::~AESCryptor() noexcept
     CCCryptorRelease(m_decr);
 #elif defined(_WIN32)
 #else
-    EVP_CIPHER_CTX_cleanup(m_ctx);
-    EVP_CIPHER_CTX_free(m_ctx);
+    EVP_CIPHER_CTX_cleanup(m_encr_ctx);
+    EVP_CIPHER_CTX_free(m_encr_ctx);
+    EVP_CIPHER_CTX_cleanup(m_decr_ctx);
+    EVP_CIPHER_CTX_free(m_decr_ctx);
 #endif
 }
 
@@ -237,48 +245,75 @@ bool AESCryptor::check_hmac(const void* src, size_t len, const uint8_t* hmac) co
     return result == 0;
 }
 
-bool AESCryptor::read(FileDesc fd, off_t pos, char* dst, size_t size)
+size_t AESCryptor::read_blocks(FileDesc fd, off_t pos, size_t size)
 {
-    REALM_ASSERT(size % block_size == 0);
-    while (size > 0) {
-        ssize_t bytes_read = check_read(fd, real_offset(pos), m_rw_buffer.get(), block_size);
+    // The blocks between two metadata blocks are contiguous in the file, so
+    // they are read with a single call
+    if (m_read_buffer.size() < size)
+        m_read_buffer.resize(size); // Throws
+    size_t bytes_read = 0;
+    while (bytes_read < size) {
+        off_t block_pos = pos + off_t(bytes_read);
+        size_t index = size_t(block_pos) / block_size;
+        size_t blocks_in_group = blocks_per_metadata_block - index % blocks_per_metadata_block;
+        size_t len = std::min(size - bytes_read, blocks_in_group * block_size);
+        size_t actual = check_read(fd, real_offset(block_pos), m_read_buffer.data() + bytes_read, len);
+        bytes_read += actual;
+        if (actual < len)
+            break;
+    }
+    return bytes_read;
+}
 
-        if (bytes_read == 0)
-            return false;
+bool AESCryptor::check_block(const char* src, size_t len, iv_table& iv) const
+{
+    if (iv.iv1 == 0) {
+        // This block has never been written to, so we've just read pre-allocated
+        // space. No memset() since the code using this doesn't rely on
+        // pre-allocated space being zeroed.
+        return false;
+    }
 
-        iv_table& iv = get_iv_table(fd, pos);
-        if (iv.iv1 == 0) {
-            // This block has never been written to, so we've just read pre-allocated
-            // space. No memset() since the code using this doesn't rely on
-            // pre-allocated space being zeroed.
+    if (!check_hmac(src, len, iv.hmac1)) {
+        // Either the DB is corrupted or we were interrupted between writing the
+        // new IV and writing the data
+        if (iv.iv2 == 0) {
+            // Very first write was interrupted
             return false;
         }
 
-        if (!check_hmac(m_rw_buffer.get(), bytes_read, iv.hmac1)) {
-            // Either the DB is corrupted or we were interrupted between writing the
-            // new IV and writing the data
-            if (iv.iv2 == 0) {
-                // Very first write was interrupted
-                return false;
-            }
-
-            if (check_hmac(m_rw_buffer.get(), bytes_read, iv.hmac2)) {
-                // Un-bump the IV since the write with the bumped IV never actually
-                // happened
-                memcpy(&iv.iv1, &iv.iv2, 32);
-            }
-            else {
-                // If the file has been shrunk and then re-expanded, we may have
-                // old hmacs that don't go with this data. ftruncate() is
-                // required to fill any added space with zeroes, so assume that's
-                // what happened if the buffer is all zeroes
-                for (ssize_t i = 0; i < bytes_read; ++i) {
-                    if (m_rw_buffer[i] != 0)
-                        throw DecryptionFailed();
-                }
-                return false;
+        if (check_hmac(src, len, iv.hmac2)) {
+            // Un-bump the IV since the write with the bumped IV never actually
+            // happened
+            memcpy(&iv.iv1, &iv.iv2, 32);
+        }
+        else {
+            // If the file has been shrunk and then re-expanded, we may have
+            // old hmacs that don't go with this data. ftruncate() is
+            // required to fill any added space with zeroes, so assume that's
+            // what happened if the buffer is all zeroes
+            for (size_t i = 0; i < len; ++i) {
+                if (src[i] != 0)
+                    throw DecryptionFailed();
             }
+            return false;
         }
+    }
+    return true;
+}
+
+bool AESCryptor::read(FileDesc fd, off_t pos, char* dst, size_t size)
+{
+    REALM_ASSERT(size % block_size == 0);
+    size_t bytes_read = read_blocks(fd, pos, size); // Throws
+    for (size_t offset = 0; offset < size; offset += block_size) {
+        if (offset >= bytes_read)
+            return false;
+
+        const char* src = m_read_buffer.data() + offset;
+        iv_table& iv = get_iv_table(fd, pos + off_t(offset));
+        if (!check_block(src, std::min(block_size, bytes_read - offset), iv))
+            return false;
 
         // We may expect some adress ranges of the destination buffer of
         // AESCryptor::read() to stay unmodified, i.e. being overwritten with
@@ -293,16 +328,78 @@ bool AESCryptor::read(FileDesc fd, off_t pos, char* dst, size_t size)
         //
         // We therefore decrypt to a temporary buffer first and then copy the
         // completely decrypted data after.
-        crypt(mode_Decrypt, pos, m_dst_buffer.get(), m_rw_buffer.get(), reinterpret_cast<const char*>(&iv.iv1));
-        memcpy(dst, m_dst_buffer.get(), block_size);
-
-        pos += block_size;
-        dst += block_size;
-        size -= block_size;
+        crypt(mode_Decrypt, pos + off_t(offset), m_dst_buffer.get(), src, reinterpret_cast<const char*>(&iv.iv1));
+        memcpy(dst + offset, m_dst_buffer.get(), block_size);
     }
     return true;
 }
 
+size_t AESCryptor::read_ahead(FileDesc fd, off_t pos, char* dst, size_t size, size_t num_threads)
+{
+    REALM_ASSERT(size % block_size == 0);
+    size_t num_blocks = read_blocks(fd, pos, size) / block_size; // Throws
+
+    // Looking up the iv tables may read them from the file, so it is done up
+    // front. The tables have their final capacity, so the entries stay put.
+    std::vector<iv_table*> ivs(num_blocks);
+    for (size_t i = 0; i < num_blocks; ++i)
+        ivs[i] = &get_iv_table(fd, pos + off_t(i * block_size));
+
+    // Returns the first block of [begin, end) which could not be decrypted
+    auto decrypt = [&](AESCryptor& cryptor, size_t begin, size_t end) noexcept {
+        for (size_t i = begin; i < end; ++i) {
+            const char* src = m_read_buffer.data() + i * block_size;
+            try {
+                if (!cryptor.check_block(src, block_size, *ivs[i]))
+                    return i;
+            }
+            catch (const DecryptionFailed&) {
+                return i;
+            }
+            cryptor.crypt(mode_Decrypt, pos + off_t(i * block_size), dst + i * block_size, src,
+                          reinterpret_cast<const char*>(&ivs[i]->iv1));
+        }
+        return end;
+    };
+
+    // Starting a thread costs about as much as decrypting a few blocks
+    const size_t min_blocks_per_thread = 16;
+    num_threads = std::max(std::min(num_threads, num_blocks / min_blocks_per_thread), size_t(1));
+    if (num_threads == 1)
+        return decrypt(*this, 0, num_blocks) * block_size;
+
+    while (m_workers.size() < num_threads - 1)
+        m_workers.emplace_back(new AESCryptor(m_key)); // Throws
+
+    size_t blocks_per_thread = (num_blocks + num_threads - 1) / num_threads;
+    std::vector<size_t> first_failed(num_threads);
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (size_t t = 1; t < num_threads; ++t) {
+        size_t begin = std::min(t * blocks_per_thread, num_blocks);
+        size_t end = std::min(begin + blocks_per_thread, num_blocks);
+        AESCryptor& worker = *m_workers[t - 1];
+        try {
+            threads.emplace_back([&, t, begin, end] {
+                first_failed[t] = decrypt(worker, begin, end);
+            });
+        }
+        catch (const std::system_error&) {
+            first_failed[t] = decrypt(worker, begin, end);
+        }
+    }
+    first_failed[0] = decrypt(*this, 0, std::min(blocks_per_thread, num_blocks));
+    for (auto& thread : threads)
+        thread.join();
+
+    for (size_t t = 0; t < num_threads; ++t) {
+        size_t end = std::min((t + 1) * blocks_per_thread, num_blocks);
+        if (first_failed[t] < end)
+            return first_failed[t] * block_size;
+    }
+    return num_blocks * block_size;
+}
+
 void AESCryptor::write(FileDesc fd, off_t pos, const char* src, size_t size) noexcept
 {
     REALM_ASSERT(size % block_size == 0);
@@ -367,19 +464,20 @@ void AESCryptor::crypt(EncryptionMode mode, off_t pos, char* dst, const char* sr
     }
 
 #else
-    if (!EVP_CipherInit_ex(m_ctx, EVP_aes_256_cbc(), NULL, m_aesKey, iv, mode))
+    EVP_CIPHER_CTX* ctx = mode == mode_Encrypt ? m_encr_ctx : m_decr_ctx;
+    if (!EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv, mode))
         handle_error();
 
     int len;
     // Use zero padding - we always write a whole page
-    EVP_CIPHER_CTX_set_padding(m_ctx, 0);
+    EVP_CIPHER_CTX_set_padding(ctx, 0);
 
-    if (!EVP_CipherUpdate(m_ctx, reinterpret_cast<uint8_t*>(dst), &len, reinterpret_cast<const uint8_t*>(src),
+    if (!EVP_CipherUpdate(ctx, reinterpret_cast<uint8_t*>(dst), &len, reinterpret_cast<const uint8_t*>(src),
                           block_size))
         handle_error();
 
     // Finalize the encryption. Should not output further data.
-    if (!EVP_CipherFinal_ex(m_ctx, reinterpret_cast<uint8_t*>(dst) + len, &len))
+    if (!EVP_CipherFinal_ex(ctx, reinterpret_cast<uint8_t*>(dst) + len, &len))
         handle_error();
 #endif
 }
@@ -504,15 +602,84 @@ void EncryptedFileMapping::refresh_page(size_t local_page_ndx)
 
     char* addr = page_addr(local_page_ndx);
 
+    bool sequential = false;
     if (!copy_up_to_date_page(local_page_ndx)) {
         size_t page_ndx_in_file = local_page_ndx + m_first_page;
         m_file.cryptor.read(m_file.fd, off_t(page_ndx_in_file << m_page_shift),
                             addr, static_cast<size_t>(1ULL << m_page_shift));
+
+        if (local_page_ndx == m_last_decrypted_page + 1) {
+            ++m_num_sequential_decryptions;
+        }
+        else {
+            m_num_sequential_decryptions = 1;
+        }
+        m_last_decrypted_page = local_page_ndx;
+        sequential = m_num_sequential_decryptions >= s_read_ahead_threshold;
     }
     if (is_not(m_page_state[local_page_ndx], UpToDate | PartiallyUpToDate))
         m_num_decrypted++;
     clear(m_page_state[local_page_ndx], PartiallyUpToDate);
     set(m_page_state[local_page_ndx], UpToDate);
+
+    if (sequential)
+        read_ahead(local_page_ndx + 1);
+}
+
+size_t EncryptedFileMapping::s_read_ahead_pages = 16;
+size_t EncryptedFileMapping::s_read_ahead_threads = 1;
+
+void EncryptedFileMapping::set_read_ahead(size_t max_pages, size_t num_threads) noexcept
+{
+    s_read_ahead_pages = max_pages;
+    s_read_ahead_threads = std::max(num_threads, size_t(1));
+}
+
+void EncryptedFileMapping::read_ahead(size_t local_page_ndx) noexcept
+{
+    // Only pages which have never been decrypted, or have been reclaimed, are
+    // read ahead, as nobody can be looking at them. Pages which are up to
+    // date in another mapping may have changes which are not in the file yet.
+    auto up_to_date_elsewhere = [&](size_t ndx) {
+        size_t page_ndx_in_file = ndx + m_first_page;
+        for (EncryptedFileMapping* m : m_file.mappings) {
+            if (m != this && m->contains_page(page_ndx_in_file) &&
+                is(m->m_page_state[page_ndx_in_file - m->m_first_page], UpToDate))
+                return true;
+        }
+        return false;
+    };
+    size_t end = std::min(local_page_ndx + s_read_ahead_pages, m_page_state.size());
+    size_t last = local_page_ndx;
+    while (last < end && is_not(m_page_state[last], UpToDate | PartiallyUpToDate | Dirty) &&
+           !up_to_date_elsewhere(last))
+        ++last;
+    if (last == local_page_ndx)
+        return;
+
+    size_t decrypted;
+    try {
+        size_t page_ndx_in_file = local_page_ndx + m_first_page;
+        decrypted = m_file.cryptor.read_ahead(m_file.fd, off_t(page_ndx_in_file << m_page_shift),
+                                              page_addr(local_page_ndx), (last - local_page_ndx) << m_page_shift,
+                                              s_read_ahead_threads);
+    }
+    catch (const std::exception&) {
+        // Read-ahead is only an optimization. Errors are reported when the
+        // page is actually accessed.
+        return;
+    }
+
+    // The pages are not marked as touched, so the reclaimer releases them
+    // again if they are not used
+    size_t num_pages = decrypted >> m_page_shift;
+    for (size_t idx = local_page_ndx; idx < local_page_ndx + num_pages; ++idx) {
+        set(m_page_state[idx], UpToDate);
+        m_num_decrypted++;
+        m_chunk_dont_scan[idx >> page_to_chunk_shift] = 0;
+    }
+    if (num_pages > 0)
+        m_last_decrypted_page = local_page_ndx + num_pages - 1;
 }
 
 void EncryptedFileMapping::write_page(size_t local_page_ndx) noexcept
@@ -849,6 +1016,8 @@ void EncryptedFileMapping::set(void* new_addr, size_t new_size, size_t new_file_
     size_t num_pages = new_size >> m_page_shift;
 
     m_num_decrypted = 0;
+    m_last_decrypted_page = size_t(-1);
+    m_num_sequential_decryptions = 0;
     m_page_state.clear();
     m_chunk_dont_scan.clear();
 
@@ -73,6 +73,10 @@ public:
     void reclaim_untouched(size_t& progress_ptr, size_t& accumulated_savings) noexcept;
 
     bool contains_page(size_t page_in_file) const;
+
+    // Configure read-ahead for all mappings, see set_encryption_read_ahead().
+    // Must be called with the mapping mutex locked.
+    static void set_read_ahead(size_t max_pages, size_t num_threads) noexcept;
     size_t get_local_index_of_address(const void* addr, size_t offset = 0) const;
 
     size_t get_end_index()
@@ -95,6 +99,14 @@ private:
     size_t m_first_page;
     size_t m_num_decrypted; // 1 for every page decrypted
 
+    // When this many pages have been decrypted one after another, the
+    // following pages are read ahead
+    size_t m_last_decrypted_page = size_t(-1);
+    size_t m_num_sequential_decryptions = 0;
+    static constexpr size_t s_read_ahead_threshold = 3;
+    static size_t s_read_ahead_pages;
+    static size_t s_read_ahead_threads;
+
     enum PageState {
         Touched = 1,           // a ref->ptr translation has taken place
         UpToDate = 2,          // the page is fully up to date
@@ -135,6 +147,7 @@ private:
     void mark_outdated(size_t local_page_ndx) noexcept;
     bool copy_up_to_date_page(size_t local_page_ndx) noexcept;
     void refresh_page(size_t local_page_ndx);
+    void read_ahead(size_t local_page_ndx) noexcept;
     void write_page(size_t local_page_ndx) noexcept;
     void write_and_update_all(size_t local_page_ndx, size_t begin_offset, size_t end_offset) noexcept;
     void reclaim_page(size_t page_ndx);
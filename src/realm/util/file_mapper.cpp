@@ -286,6 +286,12 @@ void set_page_reclaim_governor(PageReclaimGovernor* new_governor)
     ensure_reclaimer_thread_runs();
 }
 
+void set_encryption_read_ahead(size_t max_pages, size_t num_threads)
+{
+    UniqueLock lock(mapping_mutex);
+    EncryptedFileMapping::set_read_ahead(max_pages, num_threads);
+}
+
 size_t get_num_decrypted_pages()
 {
     return num_decrypted_pages.load();
@@ -76,6 +76,12 @@ inline void set_page_reclaim_governor_to_default()
 // Retrieves the number of in memory decrypted pages, across all open files.
 size_t get_num_decrypted_pages();
 
+// Configure read-ahead for encrypted files. When pages of a mapping are
+// decrypted in sequence, up to 'max_pages' following pages are decrypted in a
+// single batch, split between up to 'num_threads' threads. A 'max_pages' of
+// zero disables read-ahead. The default is 16 pages on a single thread.
+void set_encryption_read_ahead(size_t max_pages, size_t num_threads = 1);
+
 // Retrieves the
 // - amount of memory used for decrypted pages, across all open files.
 // - current target for the reclaimer (desired number of decrypted pages)
@@ -150,6 +156,10 @@ size_t inline get_num_decrypted_pages()
     return 0;
 }
 
+void inline set_encryption_read_ahead(size_t, size_t)
+{
+}
+
 void inline encryption_read_barrier(const void*, size_t, EncryptedFileMapping*, HeaderToSize = nullptr)
 {
 }
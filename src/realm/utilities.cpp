@@ -106,6 +106,7 @@ void cpuid_init()
     }
 
     bool avxSupported = false;
+    unsigned long long xcrFeatureMask = 0;
 
 // seems like in jenkins builds, __GNUC__ is defined for clang?! todo fixme
 #if !defined __clang__ && ((defined(_MSC_FULL_VER) && _MSC_FULL_VER >= 160040219) || defined __GNUC__)
@@ -114,20 +115,42 @@ void cpuid_init()
 
     if (osUsesXSAVE_XRSTORE && cpuAVXSuport) {
         // Check if the OS will save the YMM registers
-        unsigned long long xcrFeatureMask = _xgetbv(_XCR_XFEATURE_ENABLED_MASK);
+        xcrFeatureMask = _xgetbv(_XCR_XFEATURE_ENABLED_MASK);
         avxSupported = (xcrFeatureMask & 0x6) || false;
     }
 #endif
 
     if (avxSupported) {
         avx_support = 0; // AVX1 supported
+
+        // AVX2 and AVX-512 are reported in the extended feature flags (leaf 7, subleaf 0)
+        int max_leaf, ext_ebx = 0;
+#ifdef _MSC_VER
+        __cpuid(CPUInfo, 0);
+        max_leaf = CPUInfo[0];
+        if (max_leaf >= 7) {
+            __cpuidex(CPUInfo, 7, 0);
+            ext_ebx = CPUInfo[1];
+        }
+#else
+        int ebx, ecx, edx;
+        __asm("cpuid" : "=a"(max_leaf), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0), "c"(0));
+        if (max_leaf >= 7)
+            __asm("cpuid" : "=a"(max_leaf), "=b"(ext_ebx), "=c"(ecx), "=d"(edx) : "a"(7), "c"(0));
+#endif
+        if (ext_ebx & (1 << 5)) {
+            avx_support = 1; // AVX2 supported
+
+            // AVX-512 Foundation and Byte/Word instructions, and the OS must save the opmask and ZMM registers
+            bool cpuAVX512Support = (ext_ebx & (1 << 16)) && (ext_ebx & (1 << 30));
+            if (cpuAVX512Support && (xcrFeatureMask & 0xE6) == 0xE6)
+                avx_support = 2; // AVX-512 supported
+        }
     }
     else {
         avx_support = -1; // No AVX supported
     }
 
-// 1 is reserved for AVX2
-
 #endif
 }
 
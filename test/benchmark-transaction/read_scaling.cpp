@@ -0,0 +1,105 @@
+/*************************************************************************
+ *
+ * Copyright 2021 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+// Measures how the rate of starting and ending read transactions scales with
+// the number of threads doing so concurrently on the same DB. Each thread runs
+// a fixed number of begin_read()/end_read() pairs, optionally while another
+// read transaction keeps the latest snapshot pinned, as a UI thread would.
+//
+// Usage: realm-benchmark-transaction-read-scaling [max threads] [transactions per thread]
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <realm.hpp>
+#include <realm/db.hpp>
+
+#include "../util/timer.hpp"
+#include "../util/test_path.hpp"
+
+using namespace realm;
+using namespace realm::test_util;
+
+namespace {
+
+double run(DB& db, int num_threads, long num_transactions)
+{
+    auto reader = [&] {
+        for (long i = 0; i < num_transactions; ++i) {
+            auto rt = db.start_read();
+        }
+    };
+
+    Timer timer(Timer::type_RealTime);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i)
+        threads.emplace_back(reader);
+    for (auto& thread : threads)
+        thread.join();
+    return timer.get_elapsed_time();
+}
+
+void report(DB& db, const char* title, int max_threads, long num_transactions)
+{
+    std::cout << title << "\n";
+    std::cout << "  threads   transactions/s   ns/transaction   speedup\n";
+    double single_rate = 0;
+    for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        double seconds = run(db, num_threads, num_transactions);
+        double rate = num_threads * num_transactions / seconds;
+        if (num_threads == 1)
+            single_rate = rate;
+        std::cout << std::setw(9) << num_threads << std::setw(17) << std::fixed << std::setprecision(0) << rate
+                  << std::setw(17) << std::setprecision(1) << 1e9 * num_threads / rate << std::setw(10)
+                  << std::setprecision(2) << rate / single_rate << "\n";
+    }
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+    int max_threads = int(std::max(4u, std::thread::hardware_concurrency()));
+    long num_transactions = 100000;
+    if (argc > 1)
+        max_threads = std::atoi(argv[1]);
+    if (argc > 2)
+        num_transactions = std::atol(argv[2]);
+
+    SharedGroupTestPathGuard path("benchmark_transaction_read_scaling.realm");
+    DBRef db = DB::create(path);
+    {
+        auto wt = db->start_write();
+        auto table = wt->add_table("table");
+        auto col = table->add_column(type_Int, "int");
+        for (int i = 0; i < 1000; ++i)
+            table->create_object().set(col, i);
+        wt->commit();
+    }
+
+    report(*db, "Read transactions, no other transactions open", max_threads, num_transactions);
+    {
+        auto pinned = db->start_read();
+        report(*db, "Read transactions, latest snapshot kept open", max_threads, num_transactions);
+    }
+}
@@ -29,6 +29,7 @@
 #include <realm/array_unsigned.hpp>
 #include <realm/column_integer.hpp>
 #include <realm/query_conditions.hpp>
+#include <realm/util/scope_exit.hpp>
 
 #include "test.hpp"
 
@@ -1658,4 +1659,97 @@ TEST(Array_Sum)
     c.destroy();
 }
 
+#ifdef REALM_COMPILER_AVX
+
+namespace {
+
+template <class Cond>
+void check_avx_find(TestContext& test_context, const Array& a, const std::vector<int64_t>& v, int64_t value,
+                    size_t begin, size_t end)
+{
+    Cond c;
+    size_t count = 0;
+    size_t first = not_found;
+    int64_t sum = 0;
+    for (size_t i = begin; i < end; ++i) {
+        if (c(v[i], value)) {
+            if (first == not_found)
+                first = i;
+            ++count;
+            sum += v[i];
+        }
+    }
+
+    QueryState<int64_t> count_state(act_Count);
+    a.find<Cond>(act_Count, value, begin, end, 0, &count_state);
+    CHECK_EQUAL(count, size_t(count_state.m_state));
+
+    QueryState<int64_t> sum_state(act_Sum);
+    a.find<Cond>(act_Sum, value, begin, end, 0, &sum_state);
+    CHECK_EQUAL(sum, sum_state.m_state);
+
+    CHECK_EQUAL(first, a.find_first<Cond>(value, begin, end));
+}
+
+} // anonymous namespace
+
+// Compare the AVX2 and AVX-512 kernels with a plain loop for every width they handle
+TEST(Array_Avx)
+{
+    if (!sseavx<2>())
+        return;
+
+    auto original_avx_support = avx_support;
+    auto restore = util::make_scope_exit([&]() noexcept {
+        avx_support = original_avx_support;
+    });
+
+    Random random(random_int<unsigned long>());
+    Array a(Allocator::get_default());
+    a.create(Array::type_Normal);
+
+    for (signed char level = 1; level <= original_avx_support; ++level) {
+        avx_support = level; // 1: AVX2, 2: AVX-512
+        for (int64_t limit : {int64_t(100), int64_t(30000), int64_t(2000000000), int64_t(1) << 52}) {
+            a.clear();
+            std::vector<int64_t> v;
+            for (size_t i = 0; i < 1500; ++i) {
+                int64_t x = random.draw_int<int64_t>(-limit, limit);
+                a.add(x);
+                v.push_back(x);
+            }
+
+            for (size_t begin : {size_t(0), size_t(3), size_t(77)}) {
+                for (size_t end : {v.size(), v.size() - 5, begin + 300}) {
+                    for (int64_t value : {v[begin + 10], v[end - 1], int64_t(0), limit / 2}) {
+                        check_avx_find<Equal>(test_context, a, v, value, begin, end);
+                        check_avx_find<NotEqual>(test_context, a, v, value, begin, end);
+                        check_avx_find<Greater>(test_context, a, v, value, begin, end);
+                        check_avx_find<Less>(test_context, a, v, value, begin, end);
+                    }
+
+                    int64_t sum = 0;
+                    for (size_t i = begin; i < end; ++i)
+                        sum += v[i];
+                    CHECK_EQUAL(sum, a.sum(begin, end));
+
+                    auto max = std::max_element(v.begin() + begin, v.begin() + end);
+                    auto min = std::min_element(v.begin() + begin, v.begin() + end);
+                    int64_t res;
+                    size_t ndx;
+                    CHECK(a.maximum(res, begin, end, &ndx));
+                    CHECK_EQUAL(*max, res);
+                    CHECK_EQUAL(size_t(max - v.begin()), ndx);
+                    CHECK(a.minimum(res, begin, end, &ndx));
+                    CHECK_EQUAL(*min, res);
+                    CHECK_EQUAL(size_t(min - v.begin()), ndx);
+                }
+            }
+        }
+    }
+    a.destroy();
+}
+
+#endif // REALM_COMPILER_AVX
+
 #endif // TEST_ARRAY
@@ -22,8 +22,10 @@
 #include <realm/array_blobs_small.hpp>
 
 #include "test.hpp"
+#include "util/random.hpp"
 
 using namespace realm;
+using namespace realm::test_util;
 
 
 // Test independence and thread-safety
@@ -308,4 +310,68 @@ TEST(ArraySmallBlobs_Nulls)
 }
 
 
+namespace {
+
+template <class Cond>
+bool string_matches(StringData needle, StringData value)
+{
+    if (value.is_null())
+        return false;
+    if (std::is_same<Cond, Equal>::value)
+        return value == needle;
+    if (std::is_same<Cond, BeginsWith>::value)
+        return value.begins_with(needle);
+    return value.ends_with(needle);
+}
+
+template <class Cond>
+void check_find_string_matches(unit_test::TestContext& test_context, const ArraySmallBlobs& a,
+                               StringData needle, size_t begin, size_t end)
+{
+    std::vector<uint64_t> matches((end - begin + 63) / 64, uint64_t(-1));
+    a.find_string_matches<Cond>(needle, begin, end, matches.data());
+    for (size_t i = begin; i < end; ++i) {
+        bool bit = (matches[(i - begin) / 64] >> ((i - begin) % 64)) & 1;
+        CHECK_EQUAL(bit, string_matches<Cond>(needle, a.get_string(i)));
+    }
+}
+
+} // anonymous namespace
+
+TEST(ArraySmallBlobs_FindStringMatches)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const char alphabet[] = {'a', 'b', '\0'};
+
+    ArraySmallBlobs a(Allocator::get_default());
+    a.create();
+    std::vector<std::string> values;
+    for (size_t i = 0; i < 300; ++i) {
+        if (random.draw_int_mod(10) == 0) {
+            a.add_string(StringData());
+            continue;
+        }
+        std::string value;
+        size_t size = random.draw_int<size_t>(0, 63);
+        for (size_t j = 0; j < size; ++j)
+            value += alphabet[random.draw_int_mod(3)];
+        a.add_string(value);
+        values.push_back(value);
+    }
+
+    for (size_t round = 0; round < 50; ++round) {
+        std::string needle = values[random.draw_int_mod(values.size())];
+        if (needle.empty())
+            needle = "a";
+        std::string prefix = needle.substr(0, random.draw_int<size_t>(1, needle.size()));
+        std::string suffix = needle.substr(random.draw_int<size_t>(0, needle.size() - 1));
+        size_t begin = random.draw_int<size_t>(0, a.size());
+        size_t end = random.draw_int<size_t>(begin, a.size());
+        check_find_string_matches<Equal>(test_context, a, needle, begin, end);
+        check_find_string_matches<BeginsWith>(test_context, a, prefix, begin, end);
+        check_find_string_matches<EndsWith>(test_context, a, suffix, begin, end);
+    }
+    a.destroy();
+}
+
 #endif // TEST_ARRAY_BINARY
@@ -19,6 +19,7 @@
 #include "testsettings.hpp"
 
 #include <limits>
+#include <vector>
 
 #include <realm/array_integer.hpp>
 #include <realm/column_integer.hpp>
@@ -371,6 +372,149 @@ TEST(ArrayIntNull_MinMaxOfNegativeIntegers)
     a.destroy();
 }
 
+TEST(ArrayInteger_Encode)
+{
+    ArrayInteger a(Allocator::get_default());
+    a.create(Array::type_Normal);
+
+    // Already as small as it gets
+    for (int64_t i = 0; i < 100; ++i)
+        a.add(i);
+    CHECK_NOT(a.try_encode());
+
+    // Sorted values far from zero
+    const int64_t base = 1600000000;
+    a.clear();
+    std::vector<int64_t> values;
+    for (int64_t i = 0; i < 1000; ++i) {
+        values.push_back(base + i * 3);
+        a.add(values.back());
+    }
+    size_t byte_size = a.get_byte_size();
+    CHECK(a.try_encode());
+    CHECK(a.is_encoded());
+    CHECK_LESS(a.get_byte_size(), byte_size);
+    CHECK_NOT(a.try_encode());
+
+    for (size_t i = 0; i < values.size(); ++i) {
+        CHECK_EQUAL(a.get(i), values[i]);
+        CHECK_EQUAL(Array::get(a.get_header(), i), values[i]);
+    }
+    int64_t chunk[8];
+    a.get_chunk(8, chunk);
+    CHECK_EQUAL(chunk[0], values[8]);
+    CHECK_EQUAL(chunk[7], values[15]);
+
+    CHECK_EQUAL(a.find_first(base + 300), 100);
+    CHECK_EQUAL(a.find_first(base + 301), not_found);
+    CHECK_EQUAL(a.find_first(0), not_found);
+    CHECK_EQUAL(a.find_first<Greater>(base + 2994), 999);
+    CHECK_EQUAL(a.find_first<Less>(base + 3), 0);
+    CHECK_EQUAL(a.find_first<NotEqual>(base), 1);
+    CHECK_EQUAL(a.find_first<Greater>(std::numeric_limits<int64_t>::min()), 0);
+    CHECK_EQUAL(a.find_first<Less>(std::numeric_limits<int64_t>::min()), not_found);
+    CHECK_EQUAL(a.find_first<Less>(std::numeric_limits<int64_t>::max()), 0);
+    CHECK_EQUAL(a.count(base + 3), 1);
+    CHECK_EQUAL(a.count(3), 0);
+    CHECK_EQUAL(a.lower_bound_int(base + 4), 2);
+    CHECK_EQUAL(a.upper_bound_int(base + 3), 2);
+    CHECK_EQUAL(a.find_gte(base + 4, 0), 2);
+    CHECK_EQUAL(a.sum(), 1000 * base + 3 * 999 * 1000 / 2);
+    CHECK_EQUAL(a.sum(10, 20), 10 * base + 3 * (10 + 19) * 10 / 2);
+    int64_t result;
+    size_t ndx;
+    CHECK(a.maximum(result, 0, npos, &ndx));
+    CHECK_EQUAL(result, base + 2997);
+    CHECK_EQUAL(ndx, 999);
+    CHECK(a.minimum(result, 500, 600, &ndx));
+    CHECK_EQUAL(result, base + 1500);
+    CHECK_EQUAL(ndx, 500);
+
+    // Modification decodes the array
+    a.set(10, -1);
+    CHECK_NOT(a.is_encoded());
+    values[10] = -1;
+    a.insert(0, 7);
+    values.insert(values.begin(), 7);
+    for (size_t i = 0; i < values.size(); ++i)
+        CHECK_EQUAL(a.get(i), values[i]);
+
+    // All values equal
+    a.clear();
+    for (int i = 0; i < 100; ++i)
+        a.add(-base);
+    CHECK(a.try_encode());
+    CHECK_EQUAL(a.get(99), -base);
+    CHECK_EQUAL(a.sum(), -100 * base);
+    CHECK_EQUAL(a.count(-base), 100);
+    CHECK_EQUAL(a.find_first(0), not_found);
+    CHECK_EQUAL(a.find_first<NotEqual>(0), 0);
+    a.erase(50);
+    CHECK_EQUAL(a.size(), 99);
+    CHECK_EQUAL(a.get(50), -base);
+
+    // Close to the limits of int64_t
+    const int64_t max = std::numeric_limits<int64_t>::max();
+    a.clear();
+    for (int i = 0; i < 100; ++i)
+        a.add(max - i);
+    CHECK(a.try_encode());
+    CHECK_EQUAL(a.get(0), max);
+    CHECK_EQUAL(a.find_first(max - 50), 50);
+    CHECK_EQUAL(a.find_first(0), not_found);
+    CHECK_EQUAL(a.find_first<Greater>(-1), 0);
+    a.adjust(0, -max);
+    CHECK_EQUAL(a.get(0), 0);
+    CHECK_EQUAL(a.get(1), max - 1);
+
+    a.destroy();
+}
+
+TEST(ArrayIntNull_Encode)
+{
+    ArrayIntNull a(Allocator::get_default());
+    a.create(Array::type_Normal);
+
+    // Nulls only
+    for (int i = 0; i < 100; ++i)
+        a.add(util::none);
+    CHECK_NOT(a.try_encode());
+
+    const int64_t base = -100000;
+    a.clear();
+    std::vector<util::Optional<int64_t>> values;
+    for (int64_t i = 0; i < 1000; ++i) {
+        values.push_back(i % 7 == 3 ? util::none : util::make_optional(base + i));
+        a.add(values.back());
+    }
+    CHECK(a.try_encode());
+    for (size_t i = 0; i < values.size(); ++i)
+        CHECK_EQUAL(a.get(i), values[i]);
+    CHECK_EQUAL(a.find_first(util::Optional<int64_t>()), 3);
+    CHECK_EQUAL(a.find_first(base + 1), 1);
+    CHECK_EQUAL(a.find_first<NotEqual>(util::Optional<int64_t>(), 3), 4);
+    CHECK_EQUAL(a.find_first<Greater>(base + 998), 999);
+    int64_t result;
+    CHECK(a.maximum(result));
+    CHECK_EQUAL(result, base + 999);
+    CHECK(a.minimum(result));
+    CHECK_EQUAL(result, base);
+
+    // The null value chosen by the encoding can still be stored
+    int64_t null_value = a.null_value();
+    a.set(1, null_value);
+    CHECK_NOT(a.is_encoded());
+    values[1] = null_value;
+    a.set(2, 0);
+    values[2] = 0;
+    a.add(util::none);
+    values.push_back(util::none);
+    for (size_t i = 0; i < values.size(); ++i)
+        CHECK_EQUAL(a.get(i), values[i]);
+
+    a.destroy();
+}
+
 TEST(ArrayRef_Basic)
 {
     ArrayRef a(Allocator::get_default());
@@ -23,6 +23,7 @@
 #include <realm/column_integer.hpp>
 
 #include "test.hpp"
+#include "util/random.hpp"
 
 using namespace realm;
 using namespace realm::test_util;
@@ -755,4 +756,85 @@ TEST(ArrayString_Null2)
 }
 
 
+namespace {
+
+template <class Cond>
+bool string_matches(StringData needle, StringData value)
+{
+    if (value.is_null())
+        return false;
+    if (std::is_same<Cond, Equal>::value)
+        return value == needle;
+    if (std::is_same<Cond, BeginsWith>::value)
+        return value.begins_with(needle);
+    return value.ends_with(needle);
+}
+
+template <class Cond>
+void check_find_matches(unit_test::TestContext& test_context, const ArrayStringShort& a, StringData needle,
+                        size_t begin, size_t end)
+{
+    std::vector<uint64_t> matches((end - begin + 63) / 64, uint64_t(-1));
+    a.find_matches<Cond>(needle, begin, end, matches.data());
+    for (size_t i = begin; i < end; ++i) {
+        bool bit = (matches[(i - begin) / 64] >> ((i - begin) % 64)) & 1;
+        CHECK_EQUAL(bit, string_matches<Cond>(needle, a.get(i)));
+    }
+    // Bits past the end are cleared
+    if ((end - begin) % 64 != 0)
+        CHECK_EQUAL(matches.back() >> ((end - begin) % 64), 0);
+}
+
+} // anonymous namespace
+
+TEST(ArrayString_FindMatches)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const char alphabet[] = {'a', 'b', '\0'};
+
+    // One round per slot width, with values up to the largest size fitting in it
+    for (size_t max_size : {1, 3, 7, 15, 31, 63}) {
+        ArrayStringShort a(Allocator::get_default(), true);
+        a.create();
+        std::vector<std::string> values;
+        for (size_t i = 0; i < 200; ++i) {
+            if (random.draw_int_mod(10) == 0) {
+                a.add(StringData());
+                continue;
+            }
+            std::string value;
+            size_t size = random.draw_int<size_t>(0, max_size);
+            for (size_t j = 0; j < size; ++j)
+                value += alphabet[random.draw_int_mod(3)];
+            a.add(value);
+            values.push_back(value);
+        }
+
+        for (size_t round = 0; round < 20; ++round) {
+            // Pick needles from the values, so that there are matches
+            std::string needle = values[random.draw_int_mod(values.size())];
+            if (needle.empty())
+                needle = "a";
+            std::string prefix = needle.substr(0, random.draw_int<size_t>(1, needle.size()));
+            std::string suffix = needle.substr(random.draw_int<size_t>(0, needle.size() - 1));
+            size_t begin = random.draw_int<size_t>(0, a.size());
+            size_t end = random.draw_int<size_t>(begin, a.size());
+            check_find_matches<Equal>(test_context, a, needle, begin, end);
+            check_find_matches<BeginsWith>(test_context, a, prefix, begin, end);
+            check_find_matches<EndsWith>(test_context, a, suffix, begin, end);
+            check_find_matches<Equal>(test_context, a, needle, 0, a.size());
+            check_find_matches<BeginsWith>(test_context, a, prefix, 0, a.size());
+            check_find_matches<EndsWith>(test_context, a, suffix, 0, a.size());
+
+            size_t expected = not_found;
+            for (size_t i = begin; i < end && expected == not_found; ++i) {
+                if (string_matches<Equal>(needle, a.get(i)))
+                    expected = i;
+            }
+            CHECK_EQUAL(a.find_first(needle, begin, end), expected);
+        }
+        a.destroy();
+    }
+}
+
 #endif // TEST_ARRAY_STRING
@@ -24,6 +24,7 @@
 
 #include <realm/util/aes_cryptor.hpp>
 #include <realm/util/encrypted_file_mapping.hpp>
+#include <realm/util/file_mapper.hpp>
 
 #include "test.hpp"
 
@@ -184,5 +185,95 @@ TEST(EncryptedFile_LargePages)
     close(fd);
 }
 
+TEST(EncryptedFile_CryptorReadAhead)
+{
+    TEST_PATH(path);
+
+    // Spans two metadata blocks
+    const size_t num_blocks = 100;
+    std::vector<char> data(4096 * num_blocks);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<char>(i * 7 + i / 4096);
+
+    int fd = open(path.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    {
+        AESCryptor cryptor(test_key);
+        cryptor.set_file_size(off_t(data.size()));
+        cryptor.write(fd, 0, data.data(), data.size());
+    }
+
+    // Reading beyond the written blocks stops at the end of them
+    for (size_t num_threads : {1, 4}) {
+        AESCryptor cryptor(test_key);
+        cryptor.set_file_size(off_t(data.size() + 4096 * 20));
+        std::vector<char> buffer(data.size() + 4096 * 20);
+        size_t decrypted = cryptor.read_ahead(fd, 0, buffer.data(), buffer.size(), num_threads);
+        CHECK_EQUAL(decrypted, data.size());
+        CHECK(memcmp(buffer.data(), data.data(), data.size()) == 0);
+
+        decrypted = cryptor.read_ahead(fd, 4096 * 60, buffer.data(), 4096 * 8, num_threads);
+        CHECK_EQUAL(decrypted, 4096 * 8);
+        CHECK(memcmp(buffer.data(), data.data() + 4096 * 60, 4096 * 8) == 0);
+    }
+
+    // Damage block 70, which is preceded by two metadata blocks in the file
+    char byte;
+    CHECK_EQUAL(pread(fd, &byte, 1, (70 + 2) * 4096 + 100), 1);
+    byte ^= 1;
+    CHECK_EQUAL(pwrite(fd, &byte, 1, (70 + 2) * 4096 + 100), 1);
+    for (size_t num_threads : {1, 4}) {
+        AESCryptor cryptor(test_key);
+        cryptor.set_file_size(off_t(data.size()));
+        std::vector<char> buffer(data.size());
+        size_t decrypted = cryptor.read_ahead(fd, 0, buffer.data(), buffer.size(), num_threads);
+        CHECK_EQUAL(decrypted, 4096 * 70);
+        CHECK(memcmp(buffer.data(), data.data(), decrypted) == 0);
+    }
+    close(fd);
+}
+
+TEST(EncryptedFile_SequentialReadAhead)
+{
+    TEST_PATH(path);
+
+    const size_t size = page_size() * 64;
+    {
+        File file(path, File::mode_Write);
+        file.set_encryption_key(reinterpret_cast<const char*>(test_key));
+        file.resize(size);
+        File::Map<char> map(file, File::access_ReadWrite, size);
+        encryption_read_barrier(map, 0, size);
+        for (size_t i = 0; i < size; ++i)
+            map.get_addr()[i] = static_cast<char>(i / 8);
+        encryption_write_barrier(map, 0, size);
+        map.sync();
+    }
+
+    set_encryption_read_ahead(8, 2);
+    {
+        File file(path, File::mode_Read);
+        file.set_encryption_key(reinterpret_cast<const char*>(test_key));
+        File::Map<char> map(file, File::access_ReadOnly, size);
+        EncryptedFileMapping* mapping = map.get_encrypted_mapping();
+
+        // The third page read in sequence triggers read-ahead
+        for (size_t i = 0; i < 3; ++i)
+            encryption_read_barrier(map, i * page_size(), 1);
+        CHECK_EQUAL(mapping->collect_decryption_count(), 3 + 8);
+
+        for (size_t i = 0; i < size; i += page_size()) {
+            encryption_read_barrier(map, i, page_size());
+            for (size_t j = i; j < i + page_size(); ++j) {
+                if (map.get_addr()[j] != static_cast<char>(j / 8)) {
+                    CHECK_EQUAL(int(map.get_addr()[j]), int(static_cast<char>(j / 8)));
+                    break;
+                }
+            }
+        }
+        CHECK_EQUAL(mapping->collect_decryption_count(), 64);
+    }
+    set_encryption_read_ahead(16, 1);
+}
+
 #endif // REALM_ENABLE_ENCRYPTION
 #endif // TEST_ENCRYPTED_FILE_MAPPING
@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <sstream>
 
 #include <sys/stat.h>
 #ifndef _WIN32
@@ -39,6 +40,8 @@ static const mode_t2 MS_MODE_MASK = 0x0000ffff;
 
 #include <realm.hpp>
 #include <realm/util/file.hpp>
+#include <realm/impl/output_stream.hpp>
+#include <realm/impl/parallel_array_writer.hpp>
 
 #include "test.hpp"
 #include "test_table_helper.hpp"
@@ -1804,6 +1807,84 @@ TEST(Group_WriteEmpty)
 }
 
 
+TEST(Group_WriteParallel)
+{
+    Group group;
+    for (int t = 0; t < 5; ++t) {
+        std::string name = "table_" + util::to_string(t);
+        TableRef table = group.add_table(name);
+        auto col_int = table->add_column(type_Int, "int");
+        auto col_str = table->add_column(type_String, "str", true);
+        auto col_bin = table->add_column(type_Binary, "bin");
+        auto col_list = table->add_column_list(type_Int, "list");
+        table->add_search_index(col_int);
+        std::string blob(100 * t, 'x');
+        for (int i = 0; i < 1000 * t; ++i) {
+            Obj obj = table->create_object();
+            obj.set(col_int, i * 7919 % 1000);
+            if (i % 3) {
+                std::string str = util::to_string(i);
+                obj.set(col_str, StringData(str));
+            }
+            obj.set(col_bin, BinaryData(blob));
+            obj.get_list<Int>(col_list).add(i);
+        }
+    }
+
+    Allocator& alloc = _impl::GroupFriend::get_alloc(group);
+    ref_type top_ref = _impl::GroupFriend::get_top_ref(group);
+    std::ostringstream expected;
+    {
+        _impl::OutputStream out(expected);
+        Array::write(top_ref, alloc, out, false);
+    }
+    // Several combinations of thread count and chunk count
+    for (size_t num_threads = 1; num_threads <= 4; ++num_threads) {
+        for (size_t size_hint : {size_t(0), size_t(-1)}) {
+            std::ostringstream parallel;
+            _impl::OutputStream out(parallel);
+            _impl::write_array_parallel(top_ref, alloc, out, num_threads, size_hint);
+            CHECK(parallel.str() == expected.str());
+        }
+    }
+}
+
+
+TEST(Group_WriteLarge)
+{
+    GROUP_TEST_PATH(path_1);
+    GROUP_TEST_PATH(path_2);
+    std::string blob(2000, 'y');
+    {
+        // Above the size at which tables are written in parallel
+        Group group;
+        TableRef table = group.add_table("table");
+        auto col_int = table->add_column(type_Int, "int");
+        auto col_bin = table->add_column(type_Binary, "bin");
+        for (int i = 0; i < 3000; ++i)
+            table->create_object().set(col_int, i).set(col_bin, BinaryData(blob));
+        group.write(path_1);
+    }
+    {
+        Group group(path_1);
+        CHECK_GREATER(group.get_used_space(), 4 * 1024 * 1024);
+        group.write(path_2);
+    }
+    Group group(path_2);
+    ConstTableRef table = group.get_table("table");
+    CHECK_EQUAL(table->size(), 3000);
+    auto col_int = table->get_column_key("int");
+    auto col_bin = table->get_column_key("bin");
+    int64_t sum = 0;
+    for (auto& obj : *table) {
+        sum += obj.get<Int>(col_int);
+        CHECK(obj.get<Binary>(col_bin) == BinaryData(blob));
+    }
+    CHECK_EQUAL(sum, 3000 * 2999 / 2);
+    group.verify();
+}
+
+
 #ifdef REALM_DEBUG
 #ifdef REALM_TO_DOT
 
@@ -258,8 +258,6 @@ TEST(StringIndex_NonIndexable)
     TableRef target_table = group.add_table("target");
     table->add_column_link(type_Link, "link", *target_table);
     table->add_column_link(type_LinkList, "linkList", *target_table);
-    table->add_column(type_Double, "double");
-    table->add_column(type_Float, "float");
     table->add_column(type_Binary, "binary");
 
     for (auto col : table->get_column_keys()) {
@@ -1837,4 +1835,54 @@ TEST(StringIndex_QuerySingleObject)
     CHECK_EQUAL(q.count(), 0);
 }
 
+TEST_TYPES(StringIndex_FloatingPoint, float, double)
+{
+    using T = TEST_TYPE;
+    const T nan = std::numeric_limits<T>::quiet_NaN();
+    Group g;
+    auto table = g.add_table("table");
+    auto col = table->add_column(ColumnTypeTraits<T>::id, "value", true);
+    table->add_search_index(col);
+    CHECK(table->has_search_index(col));
+    StringIndex* index = table->get_search_index(col);
+
+    ObjKey k_pos = table->create_object().set(col, T(0.0)).get_key();
+    ObjKey k_neg = table->create_object().set(col, T(-0.0)).get_key();
+    ObjKey k_nan = table->create_object().set(col, nan).get_key();
+    ObjKey k_val = table->create_object().set(col, T(1.5)).get_key();
+    table->create_object();
+
+    // -0 and +0 are equal, NaN is not equal to anything and null is only equal to null
+    CHECK_EQUAL(index->count(T(0.0)), 2);
+    CHECK_EQUAL(index->count(T(-0.0)), 2);
+    CHECK_EQUAL(index->count(nan), 0);
+    CHECK_EQUAL(index->count(null{}), 1);
+    CHECK_EQUAL(index->find_first(T(-0.0)), k_pos);
+    CHECK_EQUAL(index->find_first(T(1.5)), k_val);
+    CHECK_EQUAL(index->find_first(nan), ObjKey());
+    CHECK_EQUAL(table->find_first(col, T(1.5)), k_val);
+    CHECK_EQUAL(table->find_first(col, nan), ObjKey());
+
+    // Objects holding NaN must still be found when they are updated or removed
+    table->get_object(k_nan).set(col, T(2.5));
+    CHECK_EQUAL(index->find_first(T(2.5)), k_nan);
+    table->get_object(k_val).set(col, nan);
+    table->get_object(k_neg).set_null(col);
+    CHECK_EQUAL(index->count(T(0.0)), 1);
+    CHECK_EQUAL(index->count(null{}), 2);
+    table->remove_object(k_val);
+    table->remove_object(k_pos);
+    CHECK_EQUAL(index->count(T(0.0)), 0);
+    table->verify();
+
+    table->remove_search_index(col);
+    table->create_object().set(col, nan);
+    table->create_object().set(col, T(-0.0));
+    table->add_search_index(col);
+    index = table->get_search_index(col);
+    CHECK_EQUAL(index->count(T(0.0)), 1);
+    CHECK_EQUAL(index->count(null{}), 2);
+    table->verify();
+}
+
 #endif // TEST_INDEX_STRING
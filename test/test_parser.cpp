@@ -3397,4 +3397,57 @@ TEST(Parser_TimestampNullable)
 }
 
 
+TEST(Parser_InList)
+{
+    Group g;
+    TableRef table = g.add_table("table");
+    auto int_col = table->add_column(type_Int, "int");
+    auto int_null_col = table->add_column(type_Int, "int_null", true);
+    auto str_col = table->add_column(type_String, "str", true);
+    auto date_col = table->add_column(type_Timestamp, "date", true);
+    auto double_col = table->add_column(type_Double, "dbl");
+    auto link_col = table->add_column_link(type_Link, "link", *table);
+
+    for (int i = 0; i < 10; ++i) {
+        Obj obj = table->create_object();
+        obj.set(int_col, i);
+        obj.set(double_col, i / 2.0);
+        if (i != 0) {
+            obj.set(int_null_col, i);
+            obj.set(str_col, StringData(util::to_string(i)));
+            obj.set(date_col, Timestamp(i, 0));
+        }
+    }
+    table->begin()->set(link_col, table->begin()->get_key());
+
+    verify_query(test_context, table, "int IN {1, 2, 3}", 3);
+    verify_query(test_context, table, "int in {}", 0);
+    verify_query(test_context, table, "int IN {1,2,2,3 , 11}", 3);
+    verify_query(test_context, table, "!(int IN {1, 2, 3})", 7);
+    verify_query(test_context, table, "int IN {1, 2, 3} AND int_null IN {2, 3, 4}", 2);
+    verify_query(test_context, table, "int_null IN {1, 2, null}", 3);
+    verify_query(test_context, table, "str IN {'1', \"5\", '11'}", 2);
+    verify_query(test_context, table, "str IN {'1', nil}", 2);
+    verify_query(test_context, table, "str IN[c] {'1', '2'}", 2);
+    verify_query(test_context, table, "date IN {T1:0, T2:0, null}", 3);
+    // Not supported by the hash lookup, so evaluated as ORed equalities
+    verify_query(test_context, table, "dbl IN {0.5, 1, 7}", 3);
+    verify_query(test_context, table, "link.int IN {0, 1}", 1);
+
+    Query q = table->where();
+    query_builder::NoArguments args;
+    realm::query_builder::apply_predicate(q, realm::parser::parse("int IN {1, 2}").predicate, args);
+    CHECK_EQUAL(q.get_description(), "int IN {1, 2}");
+
+    util::Any arg_list[] = {Int(4), null()};
+    verify_query_sub(test_context, table, "int_null IN {$0, $1}", arg_list, 2, 2);
+
+    CHECK_THROW_ANY(verify_query(test_context, table, "int == {1, 2}", 0));
+    CHECK_THROW_ANY(verify_query(test_context, table, "{1, 2} IN int", 0));
+    CHECK_THROW_ANY(verify_query(test_context, table, "int IN {1, int}", 0));
+    CHECK_THROW_ANY(verify_query(test_context, table, "int IN {1, 2", 0));
+    CHECK_THROW_ANY(verify_query(test_context, table, "int IN {'a'}", 0));
+}
+
+
 #endif // TEST_PARSER
@@ -2501,6 +2501,57 @@ TEST(Query_StrEnum)
     }
 }
 
+TEST(Query_StrEnumEqualInDistinct)
+{
+    // Equal, IN and distinct compare the indexes into the table of unique values of an enumerated column
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    Table table;
+    auto col_str = table.add_column(type_String, "str", true);
+    auto col_plain = table.add_column(type_String, "plain", true);
+    const char* values[] = {"red", "green", "blue", "", nullptr, "a much longer value than the others"};
+    for (size_t i = 0; i < REALM_MAX_BPNODE_SIZE * 3; ++i) {
+        StringData value = values[random.draw_int_mod(6)];
+        table.create_object().set(col_str, value).set(col_plain, value);
+    }
+    table.enumerate_string_column(col_str);
+    CHECK(table.is_enumerated(col_str));
+
+    auto check_same = [&](Query q, Query expected_q) {
+        TableView tv = q.find_all();
+        TableView expected = expected_q.find_all();
+        CHECK_EQUAL(tv.size(), expected.size());
+        for (size_t i = 0; i < tv.size() && i < expected.size(); ++i)
+            CHECK_EQUAL(tv.get_key(i), expected.get_key(i));
+    };
+    for (const char* value : {"red", "", static_cast<const char*>(nullptr), "missing"}) {
+        StringData needle = value;
+        check_same(table.where().equal(col_str, needle), table.where().equal(col_plain, needle));
+        check_same(table.where().not_equal(col_str, needle), table.where().not_equal(col_plain, needle));
+    }
+    check_same(table.where().equal(col_str, "blue").Or().equal(col_str, StringData()).Or().equal(col_str, "x"),
+               table.where().equal(col_plain, "blue").Or().equal(col_plain, StringData()).Or().equal(col_plain, "x"));
+    check_same(table.where().equal(col_str, "missing").Or().equal(col_str, "other"),
+               table.where().equal(col_plain, "missing").Or().equal(col_plain, "other"));
+
+    TableView tv = table.where().find_all();
+    tv.distinct(col_str);
+    TableView expected = table.where().find_all();
+    expected.distinct(col_plain);
+    CHECK_EQUAL(tv.size(), 6);
+    CHECK_EQUAL(tv.size(), expected.size());
+    for (size_t i = 0; i < tv.size() && i < expected.size(); ++i)
+        CHECK_EQUAL(tv.get_key(i), expected.get_key(i));
+
+    // Distinct followed by sort
+    DescriptorOrdering ordering;
+    ordering.append_distinct(DistinctDescriptor({{col_str}}));
+    ordering.append_sort(SortDescriptor({{col_str}}, {false}));
+    tv = table.where().find_all(ordering);
+    CHECK_EQUAL(tv.size(), 6);
+    for (size_t i = 1; i < tv.size(); ++i)
+        CHECK(tv.get_object(i - 1).get<String>(col_str) > tv.get_object(i).get<String>(col_str));
+}
+
 TEST(Query_StrIndex)
 {
     Random random(random_int<unsigned long>()); // Seed from slow global generator
@@ -22,6 +22,7 @@
 #include <cstdlib> // itoa()
 #include <initializer_list>
 #include <limits>
+#include <set>
 #include <vector>
 
 #include <realm.hpp>
@@ -5313,4 +5314,762 @@ TEST(Query_NotImmediatelyBeforeKnownRange)
     CHECK_EQUAL(q.count(), 1);
 }
 
+TEST(Query_Parallel)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBRef db = DB::create(*hist);
+    ColKey col_int, col_null_int, col_double, col_str;
+    const size_t num_rows = 20 * REALM_MAX_BPNODE_SIZE;
+    {
+        auto wt = db->start_write();
+        TableRef table = wt->add_table("table");
+        col_int = table->add_column(type_Int, "int");
+        col_null_int = table->add_column(type_Int, "null_int", true);
+        col_double = table->add_column(type_Double, "double");
+        col_str = table->add_column(type_String, "str");
+        for (size_t i = 0; i < num_rows; ++i) {
+            int64_t v = int64_t((i * 7919) % 1000);
+            Obj obj = table->create_object().set_all(v, v, double(v) / 2, v % 3 ? "foo" : "bar");
+            if (i % 5 == 0)
+                obj.set_null(col_null_int);
+        }
+        wt->commit();
+    }
+
+    auto frozen = db->start_frozen();
+    ConstTableRef table = frozen->get_table("table");
+    CHECK(table->is_frozen());
+
+    auto check = [&](Query q) {
+        Query par(q);
+        par.set_num_threads(4);
+        CHECK_EQUAL(par.get_num_threads(), 4);
+
+        TableView tv = q.find_all();
+        TableView par_tv = par.find_all();
+        CHECK_EQUAL(tv.size(), par_tv.size());
+        bool same = tv.size() == par_tv.size();
+        for (size_t i = 0; same && i < tv.size(); ++i)
+            same = tv.get_key(i) == par_tv.get_key(i);
+        CHECK(same);
+        CHECK_EQUAL(q.count(), par.count());
+
+        ObjKey k1, k2;
+        CHECK_EQUAL(q.sum_int(col_int), par.sum_int(col_int));
+        CHECK_EQUAL(q.sum_int(col_null_int), par.sum_int(col_null_int));
+        CHECK_EQUAL(q.maximum_int(col_int, &k1), par.maximum_int(col_int, &k2));
+        CHECK_EQUAL(k1, k2);
+        CHECK_EQUAL(q.minimum_int(col_null_int, &k1), par.minimum_int(col_null_int, &k2));
+        CHECK_EQUAL(k1, k2);
+        size_t c1, c2;
+        CHECK_EQUAL(q.average_int(col_null_int, &c1), par.average_int(col_null_int, &c2));
+        CHECK_EQUAL(c1, c2);
+        CHECK_EQUAL(q.sum_double(col_double), par.sum_double(col_double));
+        CHECK_EQUAL(q.maximum_double(col_double, &k1), par.maximum_double(col_double, &k2));
+        CHECK_EQUAL(k1, k2);
+    };
+
+    check(table->where().greater(col_int, 500));
+    check(table->where().equal(col_str, "foo").less(col_double, 200.0));
+    check(table->where().equal(col_null_int, null()));
+    check(table->where().greater(col_int, 2000));
+    check(table->where().equal(col_int, 10).Or().equal(col_int, 990));
+    check(table->column<Int>(col_int) > table->column<Double>(col_double) + 300);
+
+    // Limits and ranges are evaluated sequentially
+    Query q = table->where().greater(col_int, 100);
+    q.set_num_threads(4);
+    CHECK_EQUAL(q.find_all(0, size_t(-1), 10).size(), 10);
+
+    // A table of a live transaction is always queried on the calling thread
+    auto rt = db->start_read();
+    Query live = rt->get_table("table")->where().greater(col_int, 500);
+    live.set_num_threads(4);
+    CHECK_EQUAL(live.count(), table->where().greater(col_int, 500).count());
+}
+
+TEST(Query_SortLimit)
+{
+    Group g;
+    TableRef target = g.add_table("target");
+    auto col_target = target->add_column(type_Int, "value");
+    TableRef table = g.add_table("table");
+    auto col_int = table->add_column(type_Int, "int");
+    auto col_str = table->add_column(type_String, "str", true);
+    auto col_link = table->add_column_link(type_Link, "link", *target);
+
+    for (int i = 0; i < 10; ++i)
+        target->create_object().set(col_target, 9 - i);
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    for (int i = 0; i < 1000; ++i) {
+        Obj obj = table->create_object();
+        obj.set(col_int, random.draw_int_mod(50));
+        if (random.draw_int_mod(10))
+            obj.set(col_str, std::string(1, char('a' + random.draw_int_mod(20))));
+        if (random.draw_int_mod(10))
+            obj.set(col_link, target->get_object(random.draw_int_mod(10)).get_key());
+    }
+
+    auto check = [&](SortDescriptor sort, size_t limit) {
+        TableView expected = table->where().find_all();
+        expected.sort(sort);
+
+        DescriptorOrdering ordering;
+        ordering.append_sort(sort);
+        ordering.append_limit(limit);
+        TableView tv = table->where().find_all();
+        tv.apply_descriptor_ordering(ordering);
+
+        size_t expected_size = std::min(limit, expected.size());
+        CHECK_EQUAL(tv.size(), expected_size);
+        CHECK_EQUAL(tv.get_num_results_excluded_by_limit(), expected.size() - expected_size);
+        for (size_t i = 0; i < tv.size() && i < expected_size; ++i)
+            CHECK_EQUAL(tv.get_key(i), expected.get_key(i));
+
+        // A distinct after the limit must see the limited rows in sorted order
+        ordering.append_distinct(DistinctDescriptor({{col_str}}));
+        tv.apply_descriptor_ordering(ordering);
+        std::vector<ObjKey> distinct;
+        std::set<util::Optional<std::string>> seen;
+        for (size_t i = 0; i < expected_size; ++i) {
+            StringData str = expected.get(i).get<String>(col_str);
+            if (seen.insert(str.is_null() ? util::none : util::make_optional(std::string(str))).second)
+                distinct.push_back(expected.get_key(i));
+        }
+        CHECK_EQUAL(tv.size(), distinct.size());
+        for (size_t i = 0; i < tv.size() && i < distinct.size(); ++i)
+            CHECK_EQUAL(tv.get_key(i), distinct[i]);
+    };
+
+    for (size_t limit : {0, 1, 20, 999, 1000, 2000}) {
+        check(SortDescriptor({{col_int}}), limit);
+        check(SortDescriptor({{col_int}}, {false}), limit);
+        check(SortDescriptor({{col_str}, {col_int}}, {true, false}), limit);
+        check(SortDescriptor({{col_link, col_target}, {col_int}}), limit);
+    }
+}
+
+TEST(Query_SortMultipleColumns)
+{
+    Group g;
+    TableRef target = g.add_table("target");
+    auto col_target = target->add_column(type_Int, "value");
+    TableRef table = g.add_table("table");
+    auto col_int = table->add_column(type_Int, "int");
+    auto col_str = table->add_column(type_String, "str", true);
+    auto col_double = table->add_column(type_Double, "double", true);
+    auto col_link = table->add_column_link(type_Link, "link", *target);
+
+    for (int i = 0; i < 5; ++i)
+        target->create_object().set(col_target, i % 3);
+
+    const char* strings[] = {"a", "B", "b", "A", "\xc3\xa6"};
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    for (int i = 0; i < 500; ++i) {
+        Obj obj = table->create_object();
+        obj.set(col_int, random.draw_int_mod(3));
+        if (random.draw_int_mod(10))
+            obj.set(col_str, StringData(strings[random.draw_int_mod(5)]));
+        if (random.draw_int_mod(10))
+            obj.set(col_double, double(random.draw_int_mod(4)));
+        if (random.draw_int_mod(10))
+            obj.set(col_link, target->get_object(random.draw_int_mod(5)).get_key());
+    }
+
+    std::vector<ObjKey> keys;
+    for (auto& obj : *table)
+        keys.push_back(obj.get_key());
+
+    // int ascending, then str descending (bytewise), then double ascending
+    {
+        TableView tv = table->where().find_all();
+        tv.sort(SortDescriptor({{col_int}, {col_str}, {col_double}}, {true, false, true}));
+        auto expected = keys;
+        std::stable_sort(expected.begin(), expected.end(), [&](ObjKey a, ObjKey b) {
+            Obj obj_a = table->get_object(a);
+            Obj obj_b = table->get_object(b);
+            if (obj_a.get<Int>(col_int) != obj_b.get<Int>(col_int))
+                return obj_a.get<Int>(col_int) < obj_b.get<Int>(col_int);
+            StringData str_a = obj_a.get<String>(col_str);
+            StringData str_b = obj_b.get<String>(col_str);
+            if (str_a != str_b)
+                return str_b < str_a;
+            return Mixed(obj_a.get<util::Optional<double>>(col_double))
+                       .compare(Mixed(obj_b.get<util::Optional<double>>(col_double))) < 0;
+        });
+        CHECK_EQUAL(tv.size(), expected.size());
+        for (size_t i = 0; i < tv.size(); ++i)
+            CHECK_EQUAL(tv.get_key(i), expected[i]);
+    }
+
+    // int descending, then a value through a link (null links last), then str
+    {
+        TableView tv = table->where().find_all();
+        tv.sort(SortDescriptor({{col_int}, {col_link, col_target}, {col_str}}, {false, true, true}));
+        auto link_value = [&](const Obj& obj) {
+            ObjKey k = obj.get<ObjKey>(col_link);
+            return k ? util::make_optional(target->get_object(k).get<Int>(col_target)) : util::none;
+        };
+        auto expected = keys;
+        std::stable_sort(expected.begin(), expected.end(), [&](ObjKey a, ObjKey b) {
+            Obj obj_a = table->get_object(a);
+            Obj obj_b = table->get_object(b);
+            if (obj_a.get<Int>(col_int) != obj_b.get<Int>(col_int))
+                return obj_a.get<Int>(col_int) > obj_b.get<Int>(col_int);
+            auto link_a = link_value(obj_a);
+            auto link_b = link_value(obj_b);
+            if (link_a != link_b)
+                return !link_b || (link_a && *link_a < *link_b);
+            return obj_a.get<String>(col_str) < obj_b.get<String>(col_str);
+        });
+        CHECK_EQUAL(tv.size(), expected.size());
+        for (size_t i = 0; i < tv.size(); ++i)
+            CHECK_EQUAL(tv.get_key(i), expected[i]);
+    }
+}
+
+TEST(Query_OrderedIndex)
+{
+    Group g;
+    TableRef table = g.add_table("table");
+    auto col_int = table->add_column(type_Int, "int", true);
+    auto col_int_plain = table->add_column(type_Int, "int_plain", true);
+    auto col_ts = table->add_column(type_Timestamp, "ts", true);
+    auto col_ts_plain = table->add_column(type_Timestamp, "ts_plain", true);
+    table->add_search_index(col_int, IndexType::Ordered);
+    table->add_search_index(col_ts, IndexType::Ordered);
+    CHECK(table->has_search_index(col_int, IndexType::Ordered));
+    CHECK_NOT(table->has_search_index(col_int));
+    CHECK_THROW(table->add_search_index(table->add_column(type_String, "str"), IndexType::Ordered), LogicError);
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    auto set_random = [&](Obj obj) {
+        if (random.draw_int_mod(10) == 0) {
+            obj.set_null(col_int);
+            obj.set_null(col_int_plain);
+        }
+        else {
+            int64_t v = random.draw_int_mod(100);
+            obj.set(col_int, v);
+            obj.set(col_int_plain, v);
+        }
+        if (random.draw_int_mod(10) == 0) {
+            obj.set_null(col_ts);
+            obj.set_null(col_ts_plain);
+        }
+        else {
+            Timestamp v(random.draw_int_mod(100), random.draw_int_mod(2) * 500);
+            obj.set(col_ts, v);
+            obj.set(col_ts_plain, v);
+        }
+    };
+    for (int i = 0; i < 1000; ++i)
+        set_random(table->create_object());
+
+    auto check_same = [&](Query q, Query expected_q) {
+        TableView tv = q.find_all();
+        TableView expected = expected_q.find_all();
+        CHECK_EQUAL(tv.size(), expected.size());
+        for (size_t i = 0; i < tv.size() && i < expected.size(); ++i)
+            CHECK_EQUAL(tv.get_key(i), expected.get_key(i));
+        CHECK_EQUAL(q.count(), expected.size());
+        CHECK_EQUAL(q.sum_int(col_int_plain), expected_q.sum_int(col_int_plain));
+    };
+    auto check_sort = [&](TableView tv, TableView expected, ColKey col, ColKey plain_col) {
+        for (bool ascending : {true, false}) {
+            for (size_t limit : {size_t(0), size_t(1), size_t(10), size_t(-1)}) {
+                DescriptorOrdering ordering;
+                ordering.append_sort(SortDescriptor({{col}}, {ascending}));
+                DescriptorOrdering expected_ordering;
+                expected_ordering.append_sort(SortDescriptor({{plain_col}}, {ascending}));
+                if (limit != size_t(-1)) {
+                    ordering.append_limit(limit);
+                    expected_ordering.append_limit(limit);
+                }
+                tv.apply_descriptor_ordering(ordering);
+                expected.apply_descriptor_ordering(expected_ordering);
+                CHECK_EQUAL(tv.size(), expected.size());
+                CHECK_EQUAL(tv.get_num_results_excluded_by_limit(), expected.get_num_results_excluded_by_limit());
+                for (size_t i = 0; i < tv.size() && i < expected.size(); ++i)
+                    CHECK_EQUAL(tv.get_key(i), expected.get_key(i));
+            }
+        }
+    };
+    auto check = [&] {
+        table->verify();
+        for (int64_t v : {-1, 0, 3, 50, 96, 99, 100}) {
+            check_same(table->where().greater(col_int, v), table->where().greater(col_int_plain, v));
+            check_same(table->where().greater_equal(col_int, v), table->where().greater_equal(col_int_plain, v));
+            check_same(table->where().less(col_int, v), table->where().less(col_int_plain, v));
+            check_same(table->where().less_equal(col_int, v), table->where().less_equal(col_int_plain, v));
+            check_same(table->where().greater(col_int, v).less(col_int, v + 5),
+                       table->where().greater(col_int_plain, v).less(col_int_plain, v + 5));
+
+            Timestamp ts(v, v < 0 ? 0 : 500);
+            check_same(table->where().greater(col_ts, ts), table->where().greater(col_ts_plain, ts));
+            check_same(table->where().greater_equal(col_ts, ts), table->where().greater_equal(col_ts_plain, ts));
+            check_same(table->where().less(col_ts, ts), table->where().less(col_ts_plain, ts));
+            check_same(table->where().less_equal(col_ts, ts), table->where().less_equal(col_ts_plain, ts));
+        }
+
+        check_sort(table->where().find_all(), table->where().find_all(), col_int, col_int_plain);
+        check_sort(table->where().find_all(), table->where().find_all(), col_ts, col_ts_plain);
+        check_sort(table->where().less(col_int_plain, 50).find_all(), table->where().less(col_int_plain, 50).find_all(),
+                   col_ts, col_ts_plain);
+    };
+    check();
+
+    // The index must follow every kind of change to the column
+    for (int i = 0; i < 200; ++i) {
+        Obj obj = table->get_object(random.draw_int_mod(table->size()));
+        switch (random.draw_int_mod(4)) {
+            case 0:
+                set_random(obj);
+                break;
+            case 1:
+                if (!obj.is_null(col_int)) {
+                    obj.add_int(col_int, 7);
+                    obj.add_int(col_int_plain, 7);
+                }
+                break;
+            case 2:
+                obj.remove();
+                break;
+            case 3:
+                table->create_object(ObjKey{}, {{col_int, 42}, {col_int_plain, 42}});
+                break;
+        }
+    }
+    check();
+
+    table->remove_search_index(col_int, IndexType::Ordered);
+    CHECK_NOT(table->has_search_index(col_int, IndexType::Ordered));
+    table->add_search_index(col_int, IndexType::Ordered);
+    check();
+
+    table->clear();
+    CHECK_EQUAL(table->where().greater(col_int, 0).count(), 0);
+    table->verify();
+}
+
+TEST(Query_SubstringIndex)
+{
+    Group g;
+    TableRef table = g.add_table("table");
+    auto col_str = table->add_column(type_String, "str", true);
+    auto col_plain = table->add_column(type_String, "plain", true);
+    table->add_search_index(col_str, IndexType::Substring);
+    CHECK(table->has_search_index(col_str, IndexType::Substring));
+    CHECK_NOT(table->has_search_index(col_str));
+    CHECK_THROW(table->add_search_index(table->add_column(type_Int, "int"), IndexType::Substring), LogicError);
+
+    // Characters are drawn from a small alphabet so that short needles have many matches and long ones few.
+    // Multibyte characters only match case insensitively through the verification of the candidates.
+    const char* alphabet[] = {"a", "b", "c", "d", "e", "f", "g", "h",
+                              "A", "B", "C", "D", "*", "\xc3\xa6", "\xc3\x86"};
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    auto random_string = [&](size_t max_len) {
+        std::string str;
+        size_t len = random.draw_int_max(max_len);
+        for (size_t i = 0; i < len; ++i)
+            str += alphabet[random.draw_int_mod(sizeof(alphabet) / sizeof(alphabet[0]))];
+        return str;
+    };
+    auto set_random = [&](Obj obj) {
+        if (random.draw_int_mod(10) == 0) {
+            obj.set_null(col_str);
+            obj.set_null(col_plain);
+        }
+        else {
+            std::string str = random_string(12);
+            obj.set(col_str, StringData(str));
+            obj.set(col_plain, StringData(str));
+        }
+    };
+    for (int i = 0; i < 1000; ++i)
+        set_random(table->create_object());
+
+    auto check_same = [&](Query q, Query expected_q) {
+        TableView tv = q.find_all();
+        TableView expected = expected_q.find_all();
+        CHECK_EQUAL(tv.size(), expected.size());
+        for (size_t i = 0; i < tv.size() && i < expected.size(); ++i)
+            CHECK_EQUAL(tv.get_key(i), expected.get_key(i));
+        CHECK_EQUAL(q.count(), expected.size());
+        CHECK_EQUAL(q.find(), expected_q.find());
+    };
+    auto check = [&] {
+        table->verify();
+        std::vector<std::string> needles = {"", "a", "ab", "aB", "abc", "Abc", "abcd", "*a", "a*b", "\xc3\xa6",
+                                            "a\xc3\xa6" "b", "a\xc3\x86" "b", "hhhhhhhhhhhhh"};
+        for (int i = 0; i < 20; ++i)
+            needles.push_back(random_string(6));
+        for (auto& needle : needles) {
+            StringData n(needle);
+            std::string infix_str = "*" + needle + "?";
+            std::string pattern_str = "a?" + needle + "*c";
+            StringData infix(infix_str);
+            StringData pattern(pattern_str);
+            for (bool case_sensitive : {true, false}) {
+                check_same(table->where().contains(col_str, n, case_sensitive),
+                           table->where().contains(col_plain, n, case_sensitive));
+                check_same(table->where().begins_with(col_str, n, case_sensitive),
+                           table->where().begins_with(col_plain, n, case_sensitive));
+                check_same(table->where().ends_with(col_str, n, case_sensitive),
+                           table->where().ends_with(col_plain, n, case_sensitive));
+                check_same(table->where().like(col_str, n, case_sensitive),
+                           table->where().like(col_plain, n, case_sensitive));
+                check_same(table->where().like(col_str, infix, case_sensitive),
+                           table->where().like(col_plain, infix, case_sensitive));
+                check_same(table->where().like(col_str, pattern, case_sensitive),
+                           table->where().like(col_plain, pattern, case_sensitive));
+                check_same(table->where().contains(col_str, n, case_sensitive).equal(col_plain, "abc"),
+                           table->where().contains(col_plain, n, case_sensitive).equal(col_plain, "abc"));
+            }
+        }
+    };
+    check();
+
+    // The index must follow every kind of change to the column
+    for (int i = 0; i < 200; ++i) {
+        Obj obj = table->get_object(random.draw_int_mod(table->size()));
+        switch (random.draw_int_mod(3)) {
+            case 0:
+                set_random(obj);
+                break;
+            case 1:
+                obj.remove();
+                break;
+            case 2:
+                table->create_object(ObjKey{}, {{col_str, "abcabc"}, {col_plain, "abcabc"}});
+                break;
+        }
+    }
+    check();
+
+    table->remove_search_index(col_str, IndexType::Substring);
+    CHECK_NOT(table->has_search_index(col_str, IndexType::Substring));
+    table->add_search_index(col_str, IndexType::Substring);
+    check();
+
+    table->clear();
+    CHECK_EQUAL(table->where().contains(col_str, "abc").count(), 0);
+    table->verify();
+}
+
+TEST(Query_StringBulkScan)
+{
+    // Equal, BeginsWith and EndsWith are evaluated a leaf at a time on small and medium strings; big strings use
+    // the element by element scan
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    for (size_t max_len : {8, 40, 100}) {
+        Group g;
+        TableRef table = g.add_table("table");
+        auto col_str = table->add_column(type_String, "str", true);
+        auto col_int = table->add_column(type_Int, "int");
+        std::vector<std::string> values;
+        for (int i = 0; i < 2000; ++i) {
+            Obj obj = table->create_object().set(col_int, i % 3);
+            if (random.draw_int_mod(10) == 0) {
+                obj.set_null(col_str);
+                continue;
+            }
+            std::string str;
+            size_t len = random.draw_int_max(max_len);
+            for (size_t j = 0; j < len; ++j)
+                str += "ab"[random.draw_int_mod(2)];
+            obj.set(col_str, StringData(str));
+            values.push_back(str);
+        }
+
+        for (int round = 0; round < 10; ++round) {
+            std::string needle = values[random.draw_int_mod(values.size())];
+            if (needle.empty())
+                needle = "a";
+            std::string affix = needle.substr(0, std::min(needle.size(), size_t(3)));
+            StringData needle_str(needle), affix_str(affix);
+
+            size_t equal = 0, begins = 0, ends = 0, equal_1 = 0, begins_1 = 0, ends_1 = 0;
+            for (auto& obj : *table) {
+                StringData str = obj.get<String>(col_str);
+                if (str.is_null())
+                    continue;
+                bool is_1 = obj.get<Int>(col_int) == 1;
+                if (str == needle_str) {
+                    ++equal;
+                    equal_1 += is_1;
+                }
+                if (str.begins_with(affix_str)) {
+                    ++begins;
+                    begins_1 += is_1;
+                }
+                if (str.ends_with(affix_str)) {
+                    ++ends;
+                    ends_1 += is_1;
+                }
+            }
+            CHECK_EQUAL(table->where().equal(col_str, needle_str).count(), equal);
+            CHECK_EQUAL(table->where().begins_with(col_str, affix_str).count(), begins);
+            CHECK_EQUAL(table->where().ends_with(col_str, affix_str).count(), ends);
+            // Not the first condition, so evaluated for one object at a time
+            CHECK_EQUAL(table->where().equal(col_int, 1).equal(col_str, needle_str).count(), equal_1);
+            CHECK_EQUAL(table->where().equal(col_int, 1).begins_with(col_str, affix_str).count(), begins_1);
+            CHECK_EQUAL(table->where().equal(col_int, 1).ends_with(col_str, affix_str).count(), ends_1);
+        }
+    }
+}
+
+TEST(Query_BitmapOrNot)
+{
+    // Or and Not conditions over wide ranges are evaluated into match bitmaps, narrow ones one object at a time
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    Group g;
+    TableRef table = g.add_table("table");
+    auto col_int = table->add_column(type_Int, "int");
+    auto col_null = table->add_column(type_Int, "int_null", true);
+    auto col_str = table->add_column(type_String, "str");
+    auto col_dbl = table->add_column(type_Double, "dbl");
+    for (int i = 0; i < 3000; ++i) {
+        Obj obj = table->create_object();
+        obj.set(col_int, random.draw_int<int64_t>(0, 99));
+        if (random.draw_int_mod(5) != 0)
+            obj.set(col_null, random.draw_int<int64_t>(0, 9));
+        std::string str(1, char('a' + random.draw_int_mod(20)));
+        obj.set(col_str, StringData(str));
+        obj.set(col_dbl, double(random.draw_int_mod(1000)) / 10);
+    }
+
+    auto check = [&](Query q, util::FunctionRef<bool(const Obj&)> pred) {
+        std::vector<ObjKey> expected;
+        for (auto& obj : *table) {
+            if (pred(obj))
+                expected.push_back(obj.get_key());
+        }
+        TableView tv = q.find_all();
+        CHECK_EQUAL(tv.size(), expected.size());
+        for (size_t i = 0; i < tv.size() && i < expected.size(); ++i)
+            CHECK_EQUAL(tv.get_key(i), expected[i]);
+        CHECK_EQUAL(q.count(), expected.size());
+        CHECK_EQUAL(q.find(), expected.empty() ? ObjKey() : expected[0]);
+        TableView limited = q.find_all(0, size_t(-1), 10);
+        CHECK_EQUAL(limited.size(), std::min(expected.size(), size_t(10)));
+        for (size_t i = 0; i < limited.size() && i < expected.size(); ++i)
+            CHECK_EQUAL(limited.get_key(i), expected[i]);
+    };
+
+    // Many alternatives over different columns and conditions, which are not combined into one condition
+    Query q_or = table->where().group();
+    for (int i = 0; i < 10; ++i) {
+        if (i)
+            q_or.Or();
+        std::string str(1, char('a' + i));
+        q_or.equal(col_int, int64_t(i * 7)).Or().equal(col_str, StringData(str));
+    }
+    q_or.Or().greater(col_dbl, 99.5).end_group();
+    auto pred_or = [&](const Obj& obj) {
+        int64_t v = obj.get<Int>(col_int);
+        char c = obj.get<String>(col_str)[0];
+        return (v % 7 == 0 && v < 70) || c < 'a' + 10 || obj.get<double>(col_dbl) > 99.5;
+    };
+    check(q_or, pred_or);
+
+    // Alternatives that are themselves conjunctions
+    Query q_and_or = table->where()
+                         .group()
+                         .less(col_int, 10)
+                         .equal(col_null, 3)
+                         .Or()
+                         .greater(col_int, 90)
+                         .equal(col_str, "b")
+                         .Or()
+                         .equal(col_null, null())
+                         .less(col_dbl, 5.0)
+                         .end_group();
+    auto pred_and_or = [&](const Obj& obj) {
+        int64_t v = obj.get<Int>(col_int);
+        auto n = obj.get<util::Optional<int64_t>>(col_null);
+        return (v < 10 && n == 3) || (v > 90 && obj.get<String>(col_str) == "b") ||
+               (!n && obj.get<double>(col_dbl) < 5.0);
+    };
+    check(q_and_or, pred_and_or);
+
+    // Preceded by a selective condition, so the Or node is probed one object at a time
+    check(table->where().equal(col_int, 42).and_query(q_or),
+          [&](const Obj& obj) { return obj.get<Int>(col_int) == 42 && pred_or(obj); });
+    check(table->where().greater(col_dbl, 50.0).and_query(q_and_or),
+          [&](const Obj& obj) { return obj.get<double>(col_dbl) > 50.0 && pred_and_or(obj); });
+
+    // Negations
+    check(table->where().Not().greater(col_int, 5), [&](const Obj& obj) { return obj.get<Int>(col_int) <= 5; });
+    check(table->where().Not().group().less(col_int, 50).not_equal(col_str, "c").end_group(),
+          [&](const Obj& obj) { return !(obj.get<Int>(col_int) < 50 && obj.get<String>(col_str) != "c"); });
+    check(table->where().Not().and_query(q_or), [&](const Obj& obj) { return !pred_or(obj); });
+    check(table->where().equal(col_str, "d").Not().and_query(q_and_or),
+          [&](const Obj& obj) { return obj.get<String>(col_str) == "d" && !pred_and_or(obj); });
+    check(table->where().Not().equal(col_null, null()).Or().Not().less(col_int, 30), [&](const Obj& obj) {
+        return bool(obj.get<util::Optional<int64_t>>(col_null)) || obj.get<Int>(col_int) >= 30;
+    });
+}
+
+TEST(Query_In)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    Group g;
+    TableRef target = g.add_table("target");
+    TableRef table = g.add_table("table");
+    auto col_int = table->add_column(type_Int, "int");
+    auto col_null = table->add_column(type_Int, "int_null", true);
+    auto col_str = table->add_column(type_String, "str", true);
+    auto col_date = table->add_column(type_Timestamp, "date", true);
+    auto col_link = table->add_column_link(type_Link, "link", *target);
+    auto col_indexed = table->add_column(type_Int, "int_indexed");
+    auto col_str_indexed = table->add_column(type_String, "str_indexed");
+    table->add_search_index(col_indexed);
+    table->add_search_index(col_str_indexed);
+
+    std::vector<ObjKey> target_keys;
+    target->create_objects(50, target_keys);
+    std::vector<std::string> strings;
+    for (int i = 0; i < 50; ++i)
+        strings.push_back("str" + util::to_string(i));
+    for (int i = 0; i < 5000; ++i) {
+        Obj obj = table->create_object();
+        int64_t v = random.draw_int<int64_t>(0, 9999);
+        obj.set(col_int, v);
+        obj.set(col_indexed, v);
+        obj.set(col_str_indexed, StringData(strings[v % 50]));
+        if (i % 7 != 0) {
+            obj.set(col_null, int64_t(random.draw_int_mod(100)));
+            obj.set(col_str, StringData(strings[random.draw_int_mod(50)]));
+            obj.set(col_date, Timestamp(random.draw_int_mod(100), 0));
+            obj.set(col_link, target_keys[random.draw_int_mod(50)]);
+        }
+    }
+
+    auto check_same = [&](Query q, Query expected_q) {
+        TableView tv = q.find_all();
+        TableView expected = expected_q.find_all();
+        CHECK_EQUAL(tv.size(), expected.size());
+        for (size_t i = 0; i < tv.size() && i < expected.size(); ++i)
+            CHECK_EQUAL(tv.get_key(i), expected.get_key(i));
+        CHECK_EQUAL(q.count(), expected.size());
+        CHECK_EQUAL(q.find(), expected_q.find());
+    };
+    // The equivalent chain of ORed equalities
+    auto equal_any = [&](ColKey col, const std::vector<Mixed>& values) {
+        Query q = table->where().group();
+        for (auto& value : values) {
+            q.Or();
+            if (value.is_null())
+                q.equal(col, null());
+            else if (value.get_type() == type_Int)
+                q.equal(col, value.get_int());
+            else if (value.get_type() == type_String)
+                q.equal(col, value.get_string());
+            else if (value.get_type() == type_Timestamp)
+                q.equal(col, value.get_timestamp());
+            else
+                q.links_to(col, value.get<ObjKey>());
+        }
+        if (values.empty())
+            q.and_query(std::unique_ptr<realm::Expression>(new FalseExpression));
+        return q.end_group();
+    };
+
+    for (size_t num_values : {0, 1, 10, 100, 3000}) {
+        std::vector<Mixed> ints, ints_null, strs, dates, links;
+        for (size_t i = 0; i < num_values; ++i) {
+            ints.push_back(random.draw_int<int64_t>(0, 9999));
+            ints_null.push_back(int64_t(random.draw_int_mod(120)));
+            strs.push_back(StringData(strings[random.draw_int_mod(50)]));
+            dates.push_back(Timestamp(random.draw_int_mod(120), 0));
+            links.push_back(target_keys[random.draw_int_mod(50)]);
+        }
+        check_same(table->where().in(col_int, ints), equal_any(col_int, ints));
+        check_same(table->where().in(col_indexed, ints), equal_any(col_int, ints));
+        check_same(table->where().in(col_null, ints_null), equal_any(col_null, ints_null));
+        check_same(table->where().in(col_str, strs), equal_any(col_str, strs));
+        check_same(table->where().in(col_str_indexed, strs), equal_any(col_str_indexed, strs));
+        check_same(table->where().in(col_date, dates), equal_any(col_date, dates));
+        if (num_values <= 100)
+            check_same(table->where().in(col_link, links), equal_any(col_link, links));
+
+        ints_null.push_back(Mixed());
+        strs.push_back(Mixed());
+        dates.push_back(Mixed());
+        check_same(table->where().in(col_null, ints_null), equal_any(col_null, ints_null));
+        check_same(table->where().in(col_str, strs), equal_any(col_str, strs));
+        check_same(table->where().in(col_date, dates), equal_any(col_date, dates));
+
+        // Combined with other conditions
+        check_same(table->where().greater(col_int, 5000).in(col_null, ints_null),
+                   table->where().greater(col_int, 5000).and_query(equal_any(col_null, ints_null)));
+        check_same(table->where().Not().in(col_str, strs), table->where().Not().and_query(equal_any(col_str, strs)));
+    }
+
+    // Enumerated strings are matched by their index in the table of unique values
+    std::vector<Mixed> strs = {StringData(strings[3]), StringData(strings[17]), Mixed()};
+    Query expected = equal_any(col_str, strs);
+    size_t count = expected.count();
+    table->enumerate_string_column(col_str);
+    CHECK_EQUAL(table->where().in(col_str, strs).count(), count);
+
+    CHECK_THROW(table->where().in(col_int, {Mixed(StringData("a"))}), LogicError);
+    CHECK_THROW(table->where().in(col_str, {Mixed(int64_t(1))}), LogicError);
+    CHECK_THROW(table->where().in(col_link, {Mixed(int64_t(1))}), LogicError);
+}
+
+TEST_TYPES(Query_FloatingPointIndex, float, double)
+{
+    using T = TEST_TYPE;
+    const T nan = std::numeric_limits<T>::quiet_NaN();
+    Group g;
+    TableRef table = g.add_table("table");
+    auto col = table->add_column(ColumnTypeTraits<T>::id, "value", true);
+    auto col_plain = table->add_column(ColumnTypeTraits<T>::id, "value_plain", true);
+    table->add_search_index(col);
+
+    const T values[] = {T(0.0), T(-0.0), T(1.5), T(0.1), T(-7.25), nan};
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    for (int i = 0; i < 500; ++i) {
+        Obj obj = table->create_object();
+        size_t ndx = random.draw_int_mod(std::extent<decltype(values)>::value + 1);
+        if (ndx < std::extent<decltype(values)>::value) {
+            obj.set(col, values[ndx]);
+            obj.set(col_plain, values[ndx]);
+        }
+    }
+
+    auto check_same = [&](Query q, Query expected_q) {
+        TableView tv = q.find_all();
+        TableView expected = expected_q.find_all();
+        CHECK_EQUAL(tv.size(), expected.size());
+        for (size_t i = 0; i < tv.size() && i < expected.size(); ++i)
+            CHECK_EQUAL(tv.get_key(i), expected.get_key(i));
+        CHECK_EQUAL(q.count(), expected.size());
+        CHECK_EQUAL(q.find(), expected_q.find());
+    };
+
+    for (T v : values) {
+        check_same(table->where().equal(col, v), table->where().equal(col_plain, v));
+        check_same(table->where().equal(col, v).greater(col_plain, T(-1)),
+                   table->where().equal(col_plain, v).greater(col_plain, T(-1)));
+        check_same(table->where().not_equal(col, v), table->where().not_equal(col_plain, v));
+        check_same(table->column<T>(col) == v, table->column<T>(col_plain) == v);
+        CHECK_EQUAL(table->find_first(col, v), table->find_first(col_plain, v));
+        if (std::is_same<T, float>::value)
+            CHECK_EQUAL(table->count_float(col, float(v)), table->count_float(col_plain, float(v)));
+        else
+            CHECK_EQUAL(table->count_double(col, double(v)), table->count_double(col_plain, double(v)));
+    }
+    check_same(table->where().equal(col, null()), table->where().equal(col_plain, null()));
+    check_same(table->column<T>(col) == null(), table->column<T>(col_plain) == null());
+    check_same(table->column<T>(col) == 0.1, table->column<T>(col_plain) == 0.1);
+    check_same(table->column<T>(col) == 1.5f, table->column<T>(col_plain) == 1.5f);
+    check_same(table->column<T>(col) == 0, table->column<T>(col_plain) == 0);
+    table->verify();
+}
+
 #endif // TEST_QUERY
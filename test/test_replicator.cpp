@@ -0,0 +1,227 @@
+/*************************************************************************
+ *
+ * Copyright 2021 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include "testsettings.hpp"
+#ifdef TEST_REPLICATOR
+
+#include <realm.hpp>
+#include <realm/history.hpp>
+#include <realm/list.hpp>
+#include <realm/replicator.hpp>
+
+#include "test.hpp"
+
+using namespace realm;
+using namespace realm::test_util;
+using unit_test::TestContext;
+
+
+namespace {
+
+bool same_contents(const Group& a, const Group& b)
+{
+    auto table_keys = a.get_table_keys();
+    if (table_keys.size() != b.get_table_keys().size())
+        return false;
+    for (size_t i = 0; i < table_keys.size(); ++i) {
+        TableKey key = table_keys[i];
+        ConstTableRef ta = a.get_table(key);
+        ConstTableRef tb = b.get_table(key);
+        if (ta->get_name() != tb->get_name() || ta->size() != tb->size() ||
+            ta->get_column_count() != tb->get_column_count())
+            return false;
+        for (auto& obj : *ta) {
+            if (!tb->is_valid(obj.get_key()))
+                return false;
+            ConstObj other = tb->get_object(obj.get_key());
+            bool differs = ta->for_each_public_column([&](ColKey col_key) {
+                if (tb->get_column_name(col_key) != ta->get_column_name(col_key))
+                    return true;
+                if (col_key.get_attrs().test(col_attr_List)) {
+                    auto la = obj.get_listbase_ptr(col_key);
+                    auto lb = other.get_listbase_ptr(col_key);
+                    if (la->size() != lb->size())
+                        return true;
+                    for (size_t j = 0; j < la->size(); ++j) {
+                        if (la->get_any(j) != lb->get_any(j))
+                            return true;
+                    }
+                    return false;
+                }
+                return obj.get_any(col_key) != other.get_any(col_key);
+            });
+            if (differs)
+                return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+
+TEST(Replicator_CatchUp)
+{
+    SHARED_GROUP_TEST_PATH(primary_path);
+    SHARED_GROUP_TEST_PATH(follower_path);
+    TestPathGuard progress_guard(std::string(follower_path) + ".replica");
+
+    auto hist = make_in_realm_history(primary_path);
+    DBRef primary = DB::create(*hist);
+    ColKey col_int, col_str, col_link, col_list;
+    {
+        auto wt = primary->start_write();
+        auto origin = wt->add_table("origin");
+        auto target = wt->add_table("target");
+        col_int = origin->add_column(type_Int, "int");
+        col_str = origin->add_column(type_String, "str", true);
+        col_link = origin->add_column_link(type_Link, "link", *target);
+        col_list = origin->add_column_list(type_Int, "list");
+        for (int i = 0; i < 10; ++i)
+            target->create_object();
+        for (int i = 0; i < 100; ++i)
+            origin->create_object().set(col_int, i);
+        wt->commit();
+    }
+
+    auto seeded = Replicator::seed(*primary, follower_path);
+    auto follower_hist = make_in_realm_history(follower_path);
+    DBRef follower = DB::create(*follower_hist);
+    {
+        // Changes made before the Replicator exists
+        auto wt = primary->start_write();
+        auto origin = wt->get_table("origin");
+        origin->get_object(size_t(0)).set(col_str, "first");
+        wt->commit();
+    }
+    Replicator replicator(primary, follower);
+    seeded.reset();
+    CHECK_EQUAL(replicator.get_primary_version(), primary->get_version_of_latest_snapshot());
+    CHECK(same_contents(*primary->start_read(), *follower->start_read()));
+
+    // Several commits are applied as one
+    for (int i = 0; i < 5; ++i) {
+        auto wt = primary->start_write();
+        auto origin = wt->get_table("origin");
+        auto target = wt->get_table("target");
+        Obj obj = origin->get_object(size_t(i));
+        obj.set(col_int, i * 1000);
+        obj.set(col_link, target->get_object(size_t(i)).get_key());
+        auto list = obj.get_list<Int>(col_list);
+        for (int j = 0; j <= i; ++j)
+            list.add(j);
+        origin->get_object(size_t(50 + i)).remove();
+        origin->create_object().set(col_str, "new");
+        wt->commit();
+    }
+    auto before = follower->get_version_of_latest_snapshot();
+    CHECK_EQUAL(replicator.catch_up(), primary->get_version_of_latest_snapshot());
+    CHECK_EQUAL(follower->get_version_of_latest_snapshot(), before + 1);
+    CHECK(same_contents(*primary->start_read(), *follower->start_read()));
+
+    // Schema changes, including a table and a column that do not survive
+    {
+        auto wt = primary->start_write();
+        auto origin = wt->get_table("origin");
+        wt->add_table("transient");
+        origin->add_column(type_Double, "transient");
+        auto col_bool = origin->add_column(type_Bool, "bool");
+        origin->rename_column(col_str, "text");
+        wt->rename_table(wt->get_table("target")->get_key(), "destination");
+        origin->add_search_index(col_int);
+        for (auto& obj : *origin)
+            obj.set(col_bool, true);
+        wt->commit();
+    }
+    {
+        auto wt = primary->start_write();
+        auto origin = wt->get_table("origin");
+        wt->remove_table("transient");
+        origin->remove_column(origin->get_column_key("transient"));
+        wt->add_table_with_primary_key("people", type_String, "name")->create_object_with_primary_key("Alice");
+        wt->get_table("destination")->clear();
+        wt->commit();
+    }
+    replicator.catch_up();
+    CHECK(same_contents(*primary->start_read(), *follower->start_read()));
+    {
+        auto rt = follower->start_read();
+        auto origin = rt->get_table("origin");
+        CHECK(origin->has_search_index(col_int));
+        CHECK_EQUAL(origin->get_column_name(col_str), "text");
+        auto people = rt->get_table("people");
+        CHECK(people->get_primary_key_column());
+        CHECK(people->find_first(people->get_primary_key_column(), StringData("Alice")));
+        CHECK(origin->get_object(size_t(0)).is_null(col_link));
+    }
+
+    // A new Replicator resumes where the previous one stopped
+    {
+        auto wt = primary->start_write();
+        wt->get_table("origin")->create_object().set(col_int, 7);
+        wt->commit();
+    }
+    Replicator resumed(primary, follower);
+    CHECK_EQUAL(resumed.get_primary_version(), primary->get_version_of_latest_snapshot());
+    CHECK(same_contents(*primary->start_read(), *follower->start_read()));
+}
+
+
+TEST(Replicator_ResyncRequired)
+{
+    SHARED_GROUP_TEST_PATH(primary_path);
+    SHARED_GROUP_TEST_PATH(follower_path);
+    TestPathGuard progress_guard(std::string(follower_path) + ".replica");
+
+    auto hist = make_in_realm_history(primary_path);
+    DBRef primary = DB::create(*hist);
+    {
+        auto wt = primary->start_write();
+        wt->add_table("table")->add_column(type_Int, "int");
+        wt->commit();
+    }
+    auto follower_hist = make_in_realm_history(follower_path);
+
+    // Not seeded
+    {
+        util::File::try_remove(follower_path);
+        DBRef follower = DB::create(*follower_hist);
+        CHECK_THROW(Replicator(primary, follower), Replicator::ResyncRequired);
+    }
+    util::File::try_remove(follower_path);
+    util::File::try_remove(std::string(follower_path) + ".lock");
+
+    Replicator::seed(*primary, follower_path);
+    DBRef follower = DB::create(*follower_hist);
+    Replicator replicator(primary, follower);
+    {
+        // Modified behind the back of the Replicator
+        auto wt = follower->start_write();
+        wt->get_table("table")->create_object();
+        wt->commit();
+    }
+    {
+        auto wt = primary->start_write();
+        wt->get_table("table")->create_object();
+        wt->commit();
+    }
+    CHECK_THROW(replicator.catch_up(), Replicator::ResyncRequired);
+    CHECK_THROW(Replicator(primary, follower), Replicator::ResyncRequired);
+}
+
+#endif // TEST_REPLICATOR
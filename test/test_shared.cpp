@@ -42,6 +42,7 @@
 
 #include <realm/history.hpp>
 #include <realm.hpp>
+#include <realm/query_engine.hpp>
 #include <realm/util/features.h>
 #include <realm/util/safe_int_ops.hpp>
 #include <memory>
@@ -1449,6 +1450,246 @@ TEST(Shared_WriterThreads)
 }
 
 
+TEST(Shared_GroupCommit)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    const int thread_count = 8;
+    const int num_commits = 50;
+    ColKey col;
+    {
+        DBOptions options(crypt_key());
+        options.enable_group_commit = true;
+        options.group_commit_max_delay = std::chrono::milliseconds(1);
+        DBRef sg = DB::create(path, false, options);
+        {
+            WriteTransaction wt(sg);
+            auto t = wt.add_table("test");
+            col = t->add_column(type_Int, "value");
+            for (int i = 0; i < thread_count; ++i)
+                t->create_object(ObjKey(i));
+            wt.commit();
+        }
+
+        auto writer = [&](int i) {
+            for (int j = 0; j < num_commits; ++j) {
+                auto tr = sg->start_write();
+                auto obj = tr->get_table("test")->get_object(ObjKey(i));
+                obj.set(col, obj.get<Int>(col) + 1);
+                DB::version_type version;
+                if (j % 2 == 0) {
+                    version = tr->commit();
+                }
+                else {
+                    version = tr->commit_and_continue_as_read();
+                    CHECK_EQUAL(tr->get_version(), version);
+                    CHECK_EQUAL(j + 1, tr->get_table("test")->get_object(ObjKey(i)).get<Int>(col));
+                }
+                CHECK_GREATER_EQUAL(sg->get_version_of_latest_snapshot(), version);
+            }
+        };
+
+        Thread threads[thread_count];
+        for (int i = 0; i < thread_count; ++i)
+            threads[i].start([&writer, i] { writer(i); });
+        for (int i = 0; i < thread_count; ++i)
+            threads[i].join();
+    }
+
+    // Every commit must have been made durable before it returned, so a new
+    // session must find all of them through the file header
+    DBRef sg = DB::create(path, true, DBOptions(crypt_key()));
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    auto t = rt.get_table("test");
+    for (int i = 0; i < thread_count; ++i)
+        CHECK_EQUAL(num_commits, t->get_object(ObjKey(i)).get<Int>(col));
+}
+
+TEST(Shared_GroupCommitVisibleBeforeDurable)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBOptions options(crypt_key());
+    options.enable_group_commit = true;
+    // The flush is only started before this delay when the other writer is done
+    options.group_commit_max_delay = std::chrono::seconds(60);
+    DBRef sg = DB::create(path, false, options);
+    ColKey col;
+    {
+        WriteTransaction wt(sg);
+        auto t = wt.add_table("test");
+        col = t->add_column(type_Int, "value");
+        t->create_object(ObjKey(0));
+        wt.commit();
+    }
+    // A DB of its own stands in for a reader in another process
+    DBRef reader = DB::create(path, true, DBOptions(crypt_key()));
+
+    // The write lock must be released by the thread which took it
+    std::atomic<bool> has_write_lock{false};
+    std::atomic<bool> may_commit{false};
+    std::atomic<bool> writer_started{false};
+    std::atomic<bool> writer_in_transaction{false};
+    std::atomic<bool> may_roll_back{false};
+    std::atomic<bool> committed{false};
+    Thread writer, committer;
+    committer.start([&] {
+        auto tr = sg->start_write();
+        tr->get_table("test")->get_object(ObjKey(0)).set(col, 1);
+        has_write_lock = true;
+        while (!may_commit)
+            millisleep(1);
+        tr->commit();
+        committed = true;
+    });
+    while (!has_write_lock)
+        millisleep(1);
+    writer.start([&] {
+        writer_started = true;
+        auto wt = sg->start_write();
+        writer_in_transaction = true;
+        while (!may_roll_back)
+            millisleep(1);
+        wt->rollback();
+    });
+    while (!writer_started)
+        millisleep(1);
+    // Give the writer time to queue up for the write lock
+    millisleep(100);
+
+    auto start = std::chrono::steady_clock::now();
+    may_commit = true;
+    while (!writer_in_transaction)
+        millisleep(1);
+
+    // The flush of the commit waits for the other writer, but the commit can
+    // be read already
+    {
+        ReadTransaction rt(reader);
+        CHECK_EQUAL(1, rt.get_table("test")->get_object(ObjKey(0)).get<Int>(col));
+    }
+    CHECK_NOT(committed);
+
+    // A rollback must let the flush proceed right away
+    may_roll_back = true;
+    writer.join();
+    committer.join();
+    CHECK(committed);
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(30));
+}
+
+TEST(Shared_AsyncCommit)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    const int thread_count = 4;
+    const int num_commits = 100;
+    std::mutex mutex;
+    std::vector<DB::version_type> committed;
+    std::vector<DB::version_type> durable;
+    ColKey col;
+    {
+        DBRef sg = DB::create(path, false, DBOptions(crypt_key()));
+        {
+            WriteTransaction wt(sg);
+            auto t = wt.add_table("test");
+            col = t->add_column(type_Int, "value");
+            for (int i = 0; i < thread_count; ++i)
+                t->create_object(ObjKey(i));
+            wt.commit();
+        }
+
+        auto on_durable = [&](DB::version_type version, std::exception_ptr error) {
+            CHECK(!error);
+            std::lock_guard<std::mutex> lock(mutex);
+            durable.push_back(version);
+        };
+        auto writer = [&](int i) {
+            for (int j = 0; j < num_commits; ++j) {
+                auto tr = sg->start_write();
+                auto obj = tr->get_table("test")->get_object(ObjKey(i));
+                obj.set(col, obj.get<Int>(col) + 1);
+                // Mix in ordinary commits, which flush everything committed before them
+                DB::version_type version = j % 10 == 9 ? tr->commit() : tr->commit_async(on_durable);
+                CHECK_GREATER_EQUAL(sg->get_version_of_latest_snapshot(), version);
+                if (j % 10 != 9) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    committed.push_back(version);
+                }
+            }
+        };
+
+        Thread threads[thread_count];
+        for (int i = 0; i < thread_count; ++i)
+            threads[i].start([&writer, i] { writer(i); });
+        for (int i = 0; i < thread_count; ++i)
+            threads[i].join();
+
+        // Closing waits for the outstanding commits
+        sg->close();
+        std::sort(committed.begin(), committed.end());
+        CHECK(std::is_sorted(durable.begin(), durable.end()));
+        CHECK(committed == durable);
+    }
+
+    DBRef sg = DB::create(path, true, DBOptions(crypt_key()));
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    auto t = rt.get_table("test");
+    for (int i = 0; i < thread_count; ++i)
+        CHECK_EQUAL(num_commits, t->get_object(ObjKey(i)).get<Int>(col));
+
+    // Without full durability there is nothing to wait for
+    SHARED_GROUP_TEST_PATH(path_2);
+    DBRef sg_2 = DB::create(path_2, false, DBOptions(DBOptions::Durability::MemOnly, crypt_key()));
+    auto wt = sg_2->start_write();
+    wt->add_table("test");
+    util::Optional<DB::version_type> reported;
+    DB::version_type version = wt->commit_async([&](DB::version_type v, std::exception_ptr error) {
+        CHECK(!error);
+        reported = v;
+    });
+    CHECK(reported);
+    CHECK_EQUAL(version, *reported);
+}
+
+TEST(Shared_AsyncCommitCallbackReleasesDB)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBRef sg = DB::create(path, false, DBOptions(crypt_key()));
+    ColKey col;
+    {
+        WriteTransaction wt(sg);
+        auto t = wt.add_table("test");
+        col = t->add_column(type_Int, "value");
+        t->create_object(ObjKey(0));
+        wt.commit();
+    }
+
+    // Releasing the last reference from a callback destroys the DB on the
+    // sync thread, once the outstanding callbacks are done
+    std::atomic<bool> may_release{false};
+    std::atomic<int> num_callbacks{0};
+    for (int i = 1; i <= 2; ++i) {
+        auto tr = sg->start_write();
+        tr->get_table("test")->get_object(ObjKey(0)).set(col, i);
+        tr->commit_async([&, i](DB::version_type, std::exception_ptr error) {
+            CHECK(!error);
+            if (i == 1) {
+                while (!may_release)
+                    millisleep(1);
+                sg.reset();
+            }
+            ++num_callbacks;
+        });
+    }
+    may_release = true;
+    while (num_callbacks < 2)
+        millisleep(1);
+
+    DBRef sg_2 = DB::create(path, true, DBOptions(crypt_key()));
+    ReadTransaction rt(sg_2);
+    CHECK_EQUAL(2, rt.get_table("test")->get_object(ObjKey(0)).get<Int>(col));
+}
+
 #if !REALM_ENABLE_ENCRYPTION && defined(ENABLE_ROBUST_AGAINST_DEATH_DURING_WRITE)
 // this unittest has issues that has not been fully understood, but could be
 // related to interaction between posix robust mutexes and the fork() system call.
@@ -1584,6 +1825,597 @@ TEST(Shared_SpaceOveruse)
 }
 
 
+TEST(Shared_FreeSpaceReuse)
+{
+    // Rewrite values of varying sizes, so that free chunks of many size
+    // classes are created and reused. Once the data has reached its final
+    // size, the file must stop growing.
+    SHARED_GROUP_TEST_PATH(path);
+    DBRef sg = DB::create(path, false, DBOptions(crypt_key()));
+    const size_t num_objects = 200;
+    ColKey col;
+    {
+        WriteTransaction wt(sg);
+        auto table = wt.add_table("table");
+        col = table->add_column(type_Binary, "data");
+        for (size_t i = 0; i < num_objects; ++i)
+            table->create_object(ObjKey(i));
+        wt.commit();
+    }
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    std::string data(8000, 'x');
+    auto churn = [&](int num_transactions) {
+        for (int i = 0; i < num_transactions; ++i) {
+            WriteTransaction wt(sg);
+            auto table = wt.get_table("table");
+            for (int j = 0; j < 10; ++j) {
+                auto key = ObjKey(random.draw_int_mod(num_objects));
+                size_t size = random.draw_int_max(data.size());
+                table->get_object(key).set(col, BinaryData(data.data(), size));
+            }
+            wt.commit();
+        }
+    };
+
+    churn(200);
+    size_t file_size = size_t(util::File(path).get_size());
+    churn(200);
+    CHECK_LESS_EQUAL(size_t(util::File(path).get_size()), file_size * 2);
+
+    // The space of values freed together is merged into one chunk, which is
+    // then found for a value more than twice the size of any of them
+    auto largest_free_chunk = [&] {
+        ReadTransaction rt(sg);
+        Allocator& alloc = _impl::GroupFriend::get_alloc(rt.get_group());
+        Array top(alloc);
+        top.init_from_ref(_impl::GroupFriend::get_top_ref(rt.get_group()));
+        Array lengths(alloc);
+        lengths.init_from_ref(top.get_as_ref(4));
+        int64_t largest = 0;
+        for (size_t i = 0; i < lengths.size(); ++i)
+            largest = std::max(largest, lengths.get(i));
+        return size_t(largest);
+    };
+    const size_t num_big = 16;
+    std::string big(256 * 1024, 'y');
+    {
+        WriteTransaction wt(sg);
+        auto table = wt.get_table("table");
+        for (size_t i = 0; i < num_big; ++i)
+            table->get_object(ObjKey(i)).set(col, BinaryData(big.data(), big.size()));
+        wt.commit();
+    }
+    for (int i = 0; i < 3; ++i) {
+        WriteTransaction wt(sg);
+        auto table = wt.get_table("table");
+        if (i == 0) {
+            for (size_t j = 0; j < num_big; ++j)
+                table->get_object(ObjKey(j)).set(col, BinaryData(big.data(), 0));
+        }
+        wt.commit();
+    }
+    CHECK_GREATER_EQUAL(largest_free_chunk(), num_big * big.size());
+    file_size = size_t(util::File(path).get_size());
+    {
+        std::string bigger(num_big * big.size() * 3 / 8, 'z');
+        WriteTransaction wt(sg);
+        wt.get_table("table")->get_object(ObjKey(0)).set(col, BinaryData(bigger.data(), bigger.size()));
+        wt.commit();
+    }
+    CHECK_EQUAL(size_t(util::File(path).get_size()), file_size);
+
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+}
+
+TEST(Shared_CommitChecksum)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBOptions options; // No encryption, as the file is damaged on purpose below
+    options.enable_commit_checksum = true;
+    ColKey col;
+    {
+        DBRef sg = DB::create(path, false, options);
+        {
+            WriteTransaction wt(sg);
+            col = wt.add_table("table")->add_column(type_Int, "value");
+            wt.commit();
+        }
+        for (int64_t i = 1; i <= 20; ++i) {
+            WriteTransaction wt(sg);
+            wt.get_table("table")->create_object().set(col, i);
+            wt.get_group().verify();
+            wt.commit();
+        }
+        ReadTransaction rt(sg);
+        rt.get_group().verify();
+    }
+
+    // Damage the data written by the last commit, as if the file header had
+    // made it to disk, but not all of the data
+    {
+        util::File file(path, util::File::mode_Update);
+        uint64_t top_refs[2];
+        file.read(reinterpret_cast<char*>(top_refs), sizeof top_refs);
+        char info[8];
+        file.read(info);
+        char flags = info[7];
+        CHECK(flags & 2);
+        uint64_t top_ref = top_refs[flags & 1];
+
+        char header[NodeHeader::header_size];
+        file.seek(top_ref);
+        file.read(header);
+        uint64_t record_ref = top_ref + NodeHeader::get_byte_size_from_header(header);
+        file.seek(record_ref);
+        file.read(header);
+        std::vector<char> record(NodeHeader::get_byte_size_from_header(header));
+        file.seek(record_ref);
+        file.read(record.data(), record.size());
+        uint64_t ref = uint64_t(Array::get(record.data(), 0));
+        CHECK_GREATER(uint64_t(Array::get(record.data(), 1)), 0);
+
+        char byte;
+        file.seek(ref);
+        file.read(&byte, 1);
+        byte ^= 1;
+        file.seek(ref);
+        file.write(&byte, 1);
+    }
+
+    // The previous commit must be used instead
+    {
+        DBRef sg = DB::create(path, false, options);
+        CHECK(sg->incomplete_commit_discarded());
+        {
+            ReadTransaction rt(sg);
+            rt.get_group().verify();
+            CHECK_EQUAL(rt.get_table("table")->size(), 19);
+        }
+        WriteTransaction wt(sg);
+        wt.get_table("table")->create_object().set(col, 21);
+        wt.commit();
+    }
+    {
+        DBRef sg = DB::create(path, false, DBOptions());
+        CHECK_NOT(sg->incomplete_commit_discarded());
+        ReadTransaction rt(sg);
+        rt.get_group().verify();
+        ConstTableRef table = rt.get_table("table");
+        CHECK_EQUAL(table->size(), 20);
+        CHECK_EQUAL(table->maximum_int(col), 21);
+    }
+}
+
+TEST(Shared_AutoEnumeration)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBOptions options(crypt_key());
+    options.enable_auto_enumeration = true;
+    DBRef sg = DB::create(path, false, options);
+    ColKey col_status, col_name, col_small;
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("table");
+        TableRef small_table = wt.add_table("small");
+        col_status = table->add_column(type_String, "status", true);
+        col_name = table->add_column(type_String, "name");
+        col_small = small_table->add_column(type_String, "status");
+        const char* statuses[] = {"new", "active", "closed", nullptr};
+        for (int i = 0; i < 2000; ++i) {
+            std::string name = util::to_string(i);
+            table->create_object().set(col_status, StringData(statuses[i % 4])).set(col_name, StringData(name));
+            if (i < 100)
+                small_table->create_object().set(col_small, StringData(statuses[i % 3]));
+        }
+        wt.commit();
+    }
+    {
+        ReadTransaction rt(sg);
+        rt.get_group().verify();
+        ConstTableRef table = rt.get_table("table");
+        CHECK(table->is_enumerated(col_status));
+        // Too many distinct values, and too few objects
+        CHECK_NOT(table->is_enumerated(col_name));
+        CHECK_NOT(rt.get_table("small")->is_enumerated(col_small));
+        CHECK_EQUAL(table->get_num_unique_values(col_status), 4);
+        CHECK_EQUAL(table->where().equal(col_status, "active").count(), 500);
+        CHECK_EQUAL(table->where().equal(col_status, StringData()).count(), 500);
+        CHECK_EQUAL(table->where().equal(col_status, "new").Or().equal(col_status, "closed").count(), 1000);
+        TableView tv = table->where().find_all();
+        tv.distinct(col_status);
+        CHECK_EQUAL(tv.size(), 4);
+    }
+
+    // New values are added to the table of unique values
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.get_table("table");
+        table->get_object(0).set(col_status, "archived");
+        CHECK_EQUAL(table->where().equal(col_status, "archived").count(), 1);
+        wt.get_group().verify();
+        wt.commit();
+    }
+    ReadTransaction rt(sg);
+    CHECK_EQUAL(rt.get_table("table")->where().equal(col_status, "archived").count(), 1);
+    CHECK_EQUAL(rt.get_table("table")->where().equal(col_status, "new").count(), 499);
+
+    // Disabled by default
+    SHARED_GROUP_TEST_PATH(path_2);
+    DBRef sg_2 = DB::create(path_2, false, DBOptions(crypt_key()));
+    {
+        WriteTransaction wt(sg_2);
+        TableRef table = wt.add_table("table");
+        auto col = table->add_column(type_String, "status");
+        for (int i = 0; i < 2000; ++i)
+            table->create_object().set(col, "same");
+        wt.commit();
+        ReadTransaction rt_2(sg_2);
+        CHECK_NOT(rt_2.get_table("table")->is_enumerated(col));
+    }
+}
+
+TEST(Shared_IntegerCompression)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SHARED_GROUP_TEST_PATH(path_2);
+    DBOptions options(crypt_key());
+    options.enable_integer_compression = true;
+    DBRef sg = DB::create(path, false, options);
+    DBRef sg_2 = DB::create(path_2, false, DBOptions(crypt_key()));
+    const int64_t base = 1600000000;
+    ColKey col_int, col_null, col_date;
+    for (auto db : {sg, sg_2}) {
+        WriteTransaction wt(db);
+        TableRef table = wt.add_table("table");
+        col_int = table->add_column(type_Int, "int");
+        col_null = table->add_column(type_Int, "null", true);
+        col_date = table->add_column(type_Timestamp, "date");
+        for (int i = 0; i < 3000; ++i) {
+            Obj obj = table->create_object().set(col_int, base + i).set(col_date, Timestamp(base + i, 0));
+            if (i % 3)
+                obj.set(col_null, -base - i);
+        }
+        wt.commit();
+    }
+    size_t byte_size;
+    {
+        ReadTransaction rt(sg_2);
+        byte_size = rt.get_table("table")->compute_aggregated_byte_size();
+    }
+
+    auto check = [&](ConstTableRef table, int64_t first) {
+        CHECK_EQUAL(table->get_object(0).get<Int>(col_int), first);
+        CHECK_EQUAL(table->get_object(1).get<Int>(col_int), base + 1);
+        CHECK_EQUAL(table->get_object(1).get<util::Optional<Int>>(col_null), -base - 1);
+        CHECK(table->get_object(3).is_null(col_null));
+        CHECK_EQUAL(table->get_object(2999).get<Timestamp>(col_date), Timestamp(base + 2999, 0));
+        CHECK_EQUAL(table->where().equal(col_int, base + 1500).count(), 1);
+        CHECK_EQUAL(table->where().greater(col_int, base + 2000).count(), 999);
+        CHECK_EQUAL(table->where().less(col_null, -base - 2000).count(), 666);
+        CHECK_EQUAL(table->where().equal(col_null, null()).count(), 1000);
+        CHECK_EQUAL(table->where().greater_equal(col_date, Timestamp(base + 1000, 0)).count(), 2000);
+        CHECK_EQUAL(table->sum_int(col_int), 3000 * base + 2999 * 3000 / 2 + first - base);
+        CHECK_EQUAL(table->maximum_int(col_int), base + 2999);
+        CHECK_EQUAL(table->minimum_int(col_null), -base - 2999);
+        CHECK_EQUAL(table->maximum_timestamp(col_date), Timestamp(base + 2999, 0));
+    };
+    {
+        ReadTransaction rt(sg);
+        rt.get_group().verify();
+        ConstTableRef table = rt.get_table("table");
+        CHECK_LESS(table->compute_aggregated_byte_size(), byte_size);
+        check(table, base);
+    }
+
+    // Encoded leaves are decoded when modified
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.get_table("table");
+        table->get_object(0).set(col_int, 0);
+        check(table, 0);
+        wt.get_group().verify();
+        wt.commit();
+    }
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    check(rt.get_table("table"), 0);
+}
+
+TEST(Shared_ZoneMaps)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SHARED_GROUP_TEST_PATH(path_2);
+    DBOptions options(crypt_key());
+    options.enable_zone_maps = true;
+    DBRef sg = DB::create(path, false, options);
+    DBRef sg_2 = DB::create(path_2, false, DBOptions(crypt_key()));
+    ColKey col_int, col_null, col_double, col_float, col_date;
+    for (auto db : {sg, sg_2}) {
+        WriteTransaction wt(db);
+        TableRef table = wt.add_table("table");
+        col_int = table->add_column(type_Int, "int");
+        col_null = table->add_column(type_Int, "null", true);
+        col_double = table->add_column(type_Double, "double");
+        col_float = table->add_column(type_Float, "float", true);
+        col_date = table->add_column(type_Timestamp, "date", true);
+        for (int i = 0; i < 3000; ++i) {
+            Obj obj = table->create_object(ObjKey(i));
+            obj.set(col_int, i * 10).set(col_double, i * 0.5 - 100);
+            if (i % 7)
+                obj.set(col_null, 3000 - i);
+            if (i % 5)
+                obj.set(col_float, float(i % 100));
+            int64_t seconds = i / 3 - 100;
+            int32_t nanoseconds = (i % 3) * 1000;
+            if (i % 11)
+                obj.set(col_date, Timestamp(seconds, seconds < 0 ? -nanoseconds : nanoseconds));
+        }
+        table->get_object(ObjKey(2500)).set(col_double, std::nan(""));
+        wt.commit();
+    }
+
+    // Compare the results of queries with those found by a full scan
+    auto check = [&] {
+        ReadTransaction rt(sg);
+        ReadTransaction rt_2(sg_2);
+        rt.get_group().verify();
+        ConstTableRef table = rt.get_table("table");
+        ConstTableRef table_2 = rt_2.get_table("table");
+        auto compare = [&](Query q, Query q_2) {
+            CHECK_EQUAL(q.count(), q_2.count());
+            CHECK_EQUAL(q.find(), q_2.find());
+            CHECK_EQUAL(q.find_all().size(), q_2.find_all().size());
+            CHECK_EQUAL(q.sum_int(col_int), q_2.sum_int(col_int));
+        };
+        for (int64_t v : {-10, 0, 1000, 1005, 15000, 29990, 40000}) {
+            compare(table->where().equal(col_int, v), table_2->where().equal(col_int, v));
+            compare(table->where().not_equal(col_int, v), table_2->where().not_equal(col_int, v));
+            compare(table->where().greater(col_int, v), table_2->where().greater(col_int, v));
+            compare(table->where().less_equal(col_int, v), table_2->where().less_equal(col_int, v));
+            compare(table->where().equal(col_null, v / 10), table_2->where().equal(col_null, v / 10));
+            compare(table->where().less(col_null, v / 10), table_2->where().less(col_null, v / 10));
+            compare(table->where().greater_equal(col_int, v).less(col_int, v + 2000),
+                    table_2->where().greater_equal(col_int, v).less(col_int, v + 2000));
+            compare(table->where().equal(col_int, v).Or().equal(col_int, v + 5000),
+                    table_2->where().equal(col_int, v).Or().equal(col_int, v + 5000));
+        }
+        compare(table->where().equal(col_null, null()), table_2->where().equal(col_null, null()));
+        compare(table->where().not_equal(col_null, null()), table_2->where().not_equal(col_null, null()));
+        for (double v : {-200.0, -100.0, -0.0, 0.0, 600.0, 1400.0}) {
+            compare(table->where().equal(col_double, v), table_2->where().equal(col_double, v));
+            compare(table->where().greater(col_double, v), table_2->where().greater(col_double, v));
+            compare(table->where().less(col_double, v), table_2->where().less(col_double, v));
+            compare(table->where().equal(col_float, float(v / 10)), table_2->where().equal(col_float, float(v / 10)));
+            compare(table->where().greater(col_float, float(v / 10)),
+                    table_2->where().greater(col_float, float(v / 10)));
+        }
+        compare(table->where().equal(col_float, null()), table_2->where().equal(col_float, null()));
+        for (int64_t s : {-200, -100, 0, 50, 400, 1000}) {
+            for (Timestamp v : {Timestamp(s, 0), Timestamp(s, s < 0 ? -1000 : 1000)}) {
+                compare(table->where().equal(col_date, v), table_2->where().equal(col_date, v));
+                compare(table->where().greater(col_date, v), table_2->where().greater(col_date, v));
+                compare(table->where().less(col_date, v), table_2->where().less(col_date, v));
+                compare(table->where().not_equal(col_date, v), table_2->where().not_equal(col_date, v));
+            }
+        }
+        compare(table->where().equal(col_date, Timestamp()), table_2->where().equal(col_date, Timestamp()));
+    };
+
+    auto count_summarized_leaves = [&] {
+        ReadTransaction rt(sg);
+        size_t summarized = 0;
+        rt.get_table("table")->traverse_clusters([&](const Cluster* cluster) {
+            ValueRange range;
+            if (cluster->get_value_range(col_int, range)) {
+                CHECK_EQUAL(range.size, cluster->node_size());
+                ++summarized;
+            }
+            return false;
+        });
+        return summarized;
+    };
+
+    // All leaves are summarized on commit
+    size_t num_leaves = count_summarized_leaves();
+    CHECK_GREATER(num_leaves, 1);
+    check();
+
+    // Modified leaves are summarized anew
+    for (auto db : {sg, sg_2}) {
+        WriteTransaction wt(db);
+        TableRef table = wt.get_table("table");
+        table->get_object(ObjKey(1000)).set(col_int, 100000);
+        table->get_object(ObjKey(1001)).set_null(col_null);
+        table->get_object(ObjKey(1002)).set(col_double, -1000.0);
+        table->get_object(ObjKey(1003)).set(col_date, Timestamp(-1000, 0));
+        table->remove_object(ObjKey(2000));
+        for (int i = 0; i < 300; ++i)
+            table->create_object(ObjKey(1500 * 10 + i)).set(col_int, -i);
+        wt.commit();
+    }
+    CHECK_EQUAL(count_summarized_leaves(), num_leaves + 1);
+    check();
+
+    // Modifying a leaf invalidates its summary until the next commit
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.get_table("table");
+        table->get_object(ObjKey(10)).set(col_int, 1000000);
+        CHECK_EQUAL(table->where().greater(col_int, 500000).count(), 1);
+        wt.commit();
+    }
+    {
+        WriteTransaction wt(sg_2);
+        wt.get_table("table")->get_object(ObjKey(10)).set(col_int, 1000000);
+        wt.commit();
+    }
+    check();
+
+    // Summaries are kept up to date by a DB not building them, as far as
+    // invalidating the ones of modified leaves
+    sg.reset();
+    {
+        DBRef db = DB::create(path, false, DBOptions(crypt_key()));
+        WriteTransaction wt(db);
+        wt.get_table("table")->get_object(ObjKey(20)).set(col_int, 2000000);
+        wt.commit();
+    }
+    {
+        WriteTransaction wt(sg_2);
+        wt.get_table("table")->get_object(ObjKey(20)).set(col_int, 2000000);
+        wt.commit();
+    }
+    sg = DB::create(path, false, options);
+    CHECK_EQUAL(count_summarized_leaves(), num_leaves);
+    check();
+}
+
+TEST(Shared_ColumnStatistics)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBOptions options(crypt_key());
+    options.enable_zone_maps = true;
+    DBRef sg = DB::create(path, false, options);
+    ColKey col_time, col_kind, col_value;
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("table");
+        col_time = table->add_column(type_Timestamp, "time");
+        col_kind = table->add_column(type_Int, "kind", true);
+        col_value = table->add_column(type_Double, "value");
+        for (int i = 0; i < 10000; ++i) {
+            Obj obj = table->create_object().set(col_time, Timestamp(i, 0)).set(col_value, i * 0.25);
+            if (i % 10)
+                obj.set(col_kind, i % 10);
+        }
+        wt.commit();
+    }
+
+    ReadTransaction rt(sg);
+    ConstTableRef table = rt.get_table("table");
+    ColumnStatistics stats;
+    CHECK(table->get_column_statistics(col_kind, stats));
+    CHECK_EQUAL(stats.num_objects, 10000);
+    CHECK_EQUAL(stats.num_summarized, 10000);
+    CHECK_GREATER(stats.ranges.size(), 1);
+
+    // The estimates are exact for evenly distributed values
+    auto estimate = [&](ColKey col, auto f) {
+        double dD = 0;
+        CHECK(estimate_match_distance(table.unchecked_ptr(), col, f, dD));
+        return 10000 / dD - 1;
+    };
+    CHECK_APPROXIMATELY_EQUAL(estimate(col_time, [](const ValueRange& r) {
+                                  return estimate_range_matches<Greater>(r, 8999);
+                              }),
+                              1000, 1);
+    CHECK_APPROXIMATELY_EQUAL(estimate(col_time, [](const ValueRange& r) {
+                                  return estimate_range_matches<LessEqual>(r, 99);
+                              }),
+                              100, 1);
+    CHECK_APPROXIMATELY_EQUAL(estimate(col_time, [](const ValueRange& r) {
+                                  return estimate_range_matches<Equal>(r, 5000);
+                              }),
+                              1, 0.01);
+    CHECK_APPROXIMATELY_EQUAL(estimate(col_kind, [](const ValueRange& r) {
+                                  return estimate_range_matches<Equal>(r, 3);
+                              }),
+                              1000, 50);
+    CHECK_APPROXIMATELY_EQUAL(estimate(col_kind, [](const ValueRange& r) {
+                                  return estimate_range_matches_null<Equal>(r);
+                              }),
+                              1000, 1);
+    CHECK_APPROXIMATELY_EQUAL(estimate(col_value, [](const ValueRange& r) {
+                                  return estimate_range_matches<Equal>(r, zone_map_key(1.0));
+                              }),
+                              1, 0.01);
+    double dD = 0;
+    CHECK_NOT(estimate_match_distance(
+        table.unchecked_ptr(), col_kind, [](const ValueRange& r) { return estimate_range_matches<Like>(r, 0); }, dD));
+
+    // Compound conditions give the same results whichever is most selective
+    CHECK_EQUAL(table->where().equal(col_kind, 3).greater(col_time, Timestamp(9900, 0)).count(), 10);
+    CHECK_EQUAL(table->where().greater(col_time, Timestamp(9900, 0)).equal(col_kind, 3).count(), 10);
+    CHECK_EQUAL(table->where().equal(col_kind, 3).equal(col_value, 500.75).find(), table->get_object(2003).get_key());
+    CHECK_EQUAL(table->where().equal(col_value, 500.75).equal(col_kind, 3).find(), table->get_object(2003).get_key());
+    CHECK_EQUAL(table->where().equal(col_kind, null()).less(col_value, 10.0).sum_double(col_value), 0 + 2.5 + 5 + 7.5);
+
+    // Without zone maps, a sample of the leaves is read
+    SHARED_GROUP_TEST_PATH(path_2);
+    DBRef sg_2 = DB::create(path_2, false, DBOptions(crypt_key()));
+    {
+        WriteTransaction wt(sg_2);
+        TableRef table_2 = wt.add_table("table");
+        auto col = table_2->add_column(type_Int, "int");
+        auto col_str = table_2->add_column(type_String, "str");
+        for (int i = 0; i < 100000; ++i)
+            table_2->create_object().set(col, i);
+        CHECK(table_2->get_column_statistics(col, stats));
+        CHECK_EQUAL(stats.num_objects, 100000);
+        CHECK_LESS(stats.num_summarized, 100000);
+        CHECK_GREATER(stats.ranges.size(), 32);
+        CHECK_LESS_EQUAL(stats.ranges.size(), 65);
+        double dD = 0;
+        CHECK(estimate_match_distance(
+            table_2.unchecked_ptr(), col,
+            [](const ValueRange& r) { return estimate_range_matches<Greater>(r, 89999); }, dD));
+        CHECK_APPROXIMATELY_EQUAL(100000 / dD - 1, 10000, 2000);
+        CHECK_NOT(table_2->get_column_statistics(col_str, stats));
+    }
+}
+
+TEST_TYPES(Shared_ColumnStatisticsChooseCondition, std::true_type, std::false_type)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBOptions options(crypt_key());
+    options.enable_zone_maps = TEST_TYPE::value;
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBRef sg = DB::create(*hist, options);
+    ColKey col_seq, col_kind;
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("table");
+        col_seq = table->add_column(type_Int, "seq");
+        col_kind = table->add_column(type_Int, "kind");
+        for (int i = 0; i < 10000; ++i)
+            table->create_object().set(col_seq, i).set(col_kind, i % 10);
+        wt.commit();
+    }
+
+    TransactionRef rt = sg->start_read();
+    ConstTableRef table = rt->get_table("table");
+
+    // The statistics are gathered once for each version of the table
+    auto stats = table->get_column_statistics(col_kind);
+    CHECK(stats);
+    CHECK_EQUAL(stats, table->get_column_statistics(col_kind));
+    {
+        WriteTransaction wt(sg);
+        wt.get_table("table")->create_object().set(col_seq, 10000).set(col_kind, 0);
+        wt.commit();
+    }
+    rt->advance_read();
+    CHECK_NOT_EQUAL(stats, table->get_column_statistics(col_kind));
+    CHECK_EQUAL(table->get_column_statistics(col_kind)->num_objects, 10001);
+
+    // The search is driven by the condition of the lowest cost, see Query::find_best_node()
+    auto cost = [&](std::unique_ptr<ParentNode> node) {
+        node->set_table(table);
+        node->init();
+        return node->cost();
+    };
+    using GreaterNode = IntegerNode<ArrayInteger, Greater>;
+    using EqualNode = IntegerNode<ArrayInteger, Equal>;
+    double cost_kind = cost(std::make_unique<EqualNode>(3, col_kind));
+    CHECK_LESS(cost(std::make_unique<GreaterNode>(9900, col_seq)), cost_kind);
+    CHECK_GREATER(cost(std::make_unique<GreaterNode>(5000, col_seq)), cost_kind);
+
+    CHECK_EQUAL(table->where().equal(col_kind, 3).greater(col_seq, 9900).count(), 10);
+    CHECK_EQUAL(table->where().greater(col_seq, 5000).equal(col_kind, 3).count(), 500);
+}
+
 TEST(Shared_Notifications)
 {
     // Create a new shared db
@@ -3987,6 +4819,214 @@ TEST(Shared_GetCommitSize)
     }
 }
 
+TEST(Shared_ConcurrentReadTransactions)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBRef db = DB::create(path, false, DBOptions(crypt_key()));
+    ColKey col_a, col_b;
+    {
+        auto wt = db->start_write();
+        auto t = wt->add_table("table");
+        col_a = t->add_column(type_Int, "a");
+        col_b = t->add_column(type_Int, "b");
+        t->create_object(ObjKey(0)).set(col_a, 0).set(col_b, 0);
+        wt->commit();
+    }
+
+    const int num_readers = 8;
+    const int num_commits = 200;
+    std::atomic<bool> done{false};
+    std::atomic<int> failures{0};
+
+    auto reader = [&](int thread_ndx) {
+        int64_t last_value = 0;
+        TransactionRef pinned;
+        while (!done) {
+            // Half of the threads keep a snapshot open while starting new
+            // transactions, so that locks are both shared and released
+            if (thread_ndx % 2 && !pinned)
+                pinned = db->start_read();
+            auto rt = db->start_read();
+            auto t = rt->get_table("table");
+            Obj obj = t->get_object(ObjKey(0));
+            int64_t value = obj.get<Int>(col_a);
+            if (value != obj.get<Int>(col_b) || value < last_value)
+                ++failures;
+            last_value = value;
+
+            // Starting a transaction on the same version shares its lock
+            auto frozen = db->start_frozen(rt->get_version_of_current_transaction());
+            if (frozen->get_table("table")->get_object(ObjKey(0)).get<Int>(col_a) != value)
+                ++failures;
+            if (value % 7 == 0)
+                pinned.reset();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_readers; ++i)
+        threads.emplace_back(reader, i);
+    for (int i = 1; i <= num_commits; ++i) {
+        auto wt = db->start_write();
+        auto t = wt->get_table("table");
+        t->get_object(ObjKey(0)).set(col_a, i).set(col_b, i);
+        wt->commit();
+        // The committing thread sees its own commit
+        auto rt = db->start_read();
+        CHECK_EQUAL(rt->get_table("table")->get_object(ObjKey(0)).get<Int>(col_a), i);
+    }
+    done = true;
+    for (auto& thread : threads)
+        thread.join();
+    CHECK_EQUAL(failures, 0);
+}
+
+TEST(Shared_CloseWithSharedReadTransactions)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBRef db = DB::create(path, false, DBOptions(crypt_key()));
+    auto rt_1 = db->start_read();
+    auto rt_2 = db->start_read();
+    auto rt_3 = db->start_frozen(rt_1->get_version_of_current_transaction());
+    db->close(true);
+    rt_2->close();
+    rt_1 = nullptr;
+    rt_3 = nullptr;
+}
+
+TEST(Shared_OnlineCompaction)
+{
+    // Grow the file, then delete most of the data. Small commits must move the
+    // remaining data to the front of the file without disturbing a reader which
+    // still uses the old copies, and the file must shrink once it is gone.
+    SHARED_GROUP_TEST_PATH(path);
+    DBOptions options(crypt_key());
+    options.enable_online_compaction = true;
+    options.online_compaction_work_limit = 64 * 1024;
+    DBRef db = DB::create(path, false, options);
+    const size_t num_objects = 2000;
+    const size_t num_kept = 100;
+    std::string data(2000, 'x');
+    ColKey col_data, col_int;
+    {
+        auto wt = db->start_write();
+        auto table = wt->add_table("table");
+        col_data = table->add_column(type_Binary, "data");
+        col_int = table->add_column(type_Int, "int");
+        for (size_t i = 0; i < num_objects; ++i)
+            table->create_object(ObjKey(i)).set(col_data, BinaryData(data)).set(col_int, int64_t(i));
+        wt->commit();
+    }
+    {
+        auto wt = db->start_write();
+        auto table = wt->get_table("table");
+        for (size_t i = num_kept; i < num_objects; ++i)
+            table->remove_object(ObjKey(i));
+        wt->commit();
+    }
+    size_t file_size = size_t(util::File(path).get_size());
+
+    auto rt = db->start_read();
+    for (int i = 0; i < 100; ++i) {
+        auto wt = db->start_write();
+        wt->get_table("table")->get_object(ObjKey(i % num_kept)).set(col_int, int64_t(i));
+        wt->commit();
+        if (i == 50) {
+            auto table = rt->get_table("table");
+            CHECK_EQUAL(table->size(), num_kept);
+            for (size_t j = 0; j < num_kept; ++j)
+                CHECK_EQUAL(table->get_object(ObjKey(j)).get<BinaryData>(col_data), BinaryData(data));
+            rt->verify();
+            rt = nullptr;
+        }
+    }
+
+    rt = db->start_read();
+    rt->verify();
+    auto table = rt->get_table("table");
+    CHECK_EQUAL(table->size(), num_kept);
+    for (size_t j = 0; j < num_kept; ++j)
+        CHECK_EQUAL(table->get_object(ObjKey(j)).get<BinaryData>(col_data), BinaryData(data));
+    if (!crypt_key())
+        CHECK_LESS(size_t(util::File(path).get_size()), file_size / 2);
+    rt = nullptr;
+
+    // The compacted file can be reopened
+    db->close();
+    db = DB::create(path, false, options);
+    rt = db->start_read();
+    rt->verify();
+    CHECK_EQUAL(rt->get_table("table")->size(), num_kept);
+}
+
+TEST(Shared_CompressedHistory)
+{
+    // A reader at an old version catches up by replaying compressed
+    // changesets, including ones written by a writer without compression
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path, true));
+    std::unique_ptr<Replication> hist_plain(make_in_realm_history(path));
+    DBRef db = DB::create(*hist, DBOptions(crypt_key()));
+    DBRef db_plain = DB::create(*hist_plain, DBOptions(crypt_key()));
+    ColKey col_str, col_int;
+    {
+        auto wt = db->start_write();
+        auto table = wt->add_table("table");
+        col_str = table->add_column(type_String, "str");
+        col_int = table->add_column(type_Int, "int");
+        wt->commit();
+    }
+
+    auto rt = db->start_read();
+    auto table_r = rt->get_table("table");
+    for (int i = 0; i < 20; ++i) {
+        auto wt = (i % 4 == 3 ? db_plain : db)->start_write();
+        auto table = wt->get_table("table");
+        for (int j = 0; j < 100; ++j)
+            table->create_object().set(col_str, "value " + std::to_string(j % 10)).set(col_int, i);
+        if (i % 5 == 4)
+            table->get_object(size_t(i * 10)).remove();
+        wt->commit();
+    }
+    rt->advance_read();
+    CHECK_EQUAL(table_r->size(), 1996);
+    CHECK_EQUAL(table_r->where().equal(col_int, 6).count(), 100);
+    rt->verify();
+
+    auto wt = db->start_write();
+    CHECK(*wt->get_table("table") == *table_r);
+}
+
+
+TEST(Shared_CompressedHistorySize)
+{
+    // With a reader holding on to an old version, the history grows with every
+    // commit. Compressed, it takes up much less space.
+    auto run = [&](const std::string& path, bool compress) {
+        std::unique_ptr<Replication> hist(make_in_realm_history(path, compress));
+        DBRef db = DB::create(*hist);
+        {
+            auto wt = db->start_write();
+            auto table = wt->add_table("table");
+            table->add_column(type_String, "str");
+            wt->commit();
+        }
+        auto rt = db->start_read();
+        for (int i = 0; i < 200; ++i) {
+            auto wt = db->start_write();
+            auto table = wt->get_table("table");
+            auto col = table->get_column_key("str");
+            for (int j = 0; j < 200; ++j)
+                table->create_object().set(col, "a string that is the same in every object");
+            wt->commit();
+        }
+        return size_t(util::File(path).get_size());
+    };
+    SHARED_GROUP_TEST_PATH(path_1);
+    SHARED_GROUP_TEST_PATH(path_2);
+    CHECK_LESS(run(path_1, true), run(path_2, false));
+}
+
 /*
 #include <valgrind/callgrind.h>
 TEST(Shared_TimestampQuery)
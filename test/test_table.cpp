@@ -4247,6 +4247,108 @@ TEST(Table_SearchIndexFindAll)
     CHECK_EQUAL(tv.size(), 6);
 }
 
+TEST(Table_OrderedIndex)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    ColKey col_ts;
+    ColKey col_int;
+    {
+        std::unique_ptr<Replication> hist(make_in_realm_history(path));
+        DBRef db = DB::create(*hist);
+        auto wt = db->start_write();
+        auto table = wt->add_table("events");
+        col_ts = table->add_column(type_Timestamp, "time");
+        col_int = table->add_column(type_Int, "value");
+        for (int i = 0; i < 100; ++i)
+            table->create_object(ObjKey(i)).set(col_ts, Timestamp(99 - i, 0)).set(col_int, i);
+        table->add_search_index(col_ts, IndexType::Ordered);
+        wt->commit_and_continue_as_read();
+
+        CHECK(table->has_search_index(col_ts, IndexType::Ordered));
+        CHECK_EQUAL(table->where().greater(col_ts, Timestamp(95, 0)).count(), 4);
+
+        // Accessors must follow the changes made across commits
+        wt->promote_to_write();
+        table->get_object(ObjKey(0)).set(col_ts, Timestamp(10, 0));
+        table->remove_object(ObjKey(1));
+        table->add_search_index(col_int, IndexType::Ordered);
+        wt->commit_and_continue_as_read();
+        CHECK_EQUAL(table->where().greater(col_ts, Timestamp(95, 0)).count(), 2);
+        CHECK_EQUAL(table->where().less(col_int, 5).count(), 4);
+        table->verify();
+
+        wt->promote_to_write();
+        table->create_object(ObjKey(100)).set(col_ts, Timestamp(200, 0));
+        table->remove_column(col_int);
+        wt->commit();
+    }
+
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBRef db = DB::create(*hist);
+    auto rt = db->start_read();
+    auto table = rt->get_table("events");
+    CHECK(table->has_search_index(col_ts, IndexType::Ordered));
+    CHECK_EQUAL(table->where().greater(col_ts, Timestamp(95, 0)).count(), 3);
+    TableView tv = table->where().find_all();
+    DescriptorOrdering ordering;
+    ordering.append_sort(SortDescriptor({{col_ts}}, {false}));
+    ordering.append_limit(2);
+    tv.apply_descriptor_ordering(ordering);
+    CHECK_EQUAL(tv.size(), 2);
+    CHECK_EQUAL(tv.get_key(0), ObjKey(100));
+    CHECK_EQUAL(tv.get_key(1), ObjKey(2));
+    table->verify();
+}
+
+TEST(Table_SubstringIndex)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    ColKey col_name;
+    ColKey col_other;
+    {
+        std::unique_ptr<Replication> hist(make_in_realm_history(path));
+        DBRef db = DB::create(*hist);
+        auto wt = db->start_write();
+        auto table = wt->add_table("products");
+        col_name = table->add_column(type_String, "name");
+        col_other = table->add_column(type_String, "other");
+        for (int i = 0; i < 100; ++i)
+            table->create_object(ObjKey(i)).set(col_name, util::format("Product %1", i));
+        table->add_search_index(col_name, IndexType::Substring);
+        wt->commit_and_continue_as_read();
+
+        CHECK(table->has_search_index(col_name, IndexType::Substring));
+        CHECK_EQUAL(table->where().contains(col_name, "uct 4").count(), 11);
+        CHECK_EQUAL(table->where().ends_with(col_name, "7").count(), 10);
+
+        // Accessors must follow the changes made across commits
+        wt->promote_to_write();
+        table->get_object(ObjKey(40)).set(col_name, "Gadget");
+        table->remove_object(ObjKey(41));
+        table->add_search_index(col_other, IndexType::Substring);
+        table->create_object(ObjKey(100)).set(col_other, "Gadget");
+        wt->commit_and_continue_as_read();
+        CHECK_EQUAL(table->where().contains(col_name, "uct 4").count(), 9);
+        CHECK_EQUAL(table->where().contains(col_name, "DGE", false).count(), 1);
+        CHECK_EQUAL(table->where().begins_with(col_other, "Gad").count(), 1);
+        table->verify();
+
+        wt->promote_to_write();
+        table->create_object(ObjKey(101)).set(col_name, "Product 4x");
+        table->remove_column(col_other);
+        wt->commit();
+    }
+
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBRef db = DB::create(*hist);
+    auto rt = db->start_read();
+    auto table = rt->get_table("products");
+    CHECK(table->has_search_index(col_name, IndexType::Substring));
+    CHECK_EQUAL(table->where().contains(col_name, "uct 4").count(), 10);
+    CHECK_EQUAL(table->where().like(col_name, "*4?").count(), 9);
+    table->verify();
+}
+
 namespace {
 
 template <class T, bool nullable>
@@ -26,6 +26,7 @@
 #include <cwchar>
 
 #include <realm.hpp>
+#include <realm/history.hpp>
 
 #include "util/misc.hpp"
 
@@ -2918,4 +2919,149 @@ TEST(TableView_TimestampMaxRemoveRow)
     CHECK_EQUAL(tv.maximum_timestamp(col_date), Timestamp(8, 0));
 }
 
+TEST(TableView_IncrementalSync)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBRef db = DB::create(*hist);
+    ColKey col_int, col_str;
+    {
+        auto wt = db->start_write();
+        auto table = wt->add_table("table");
+        col_int = table->add_column(type_Int, "int", true);
+        col_str = table->add_column(type_String, "str");
+        for (int i = 0; i < 1000; ++i)
+            table->create_object().set(col_int, i % 50).set(col_str, util::to_string(i % 7));
+        wt->commit();
+    }
+
+    auto rt = db->start_read();
+    ConstTableRef table = rt->get_table("table");
+    auto make_query = [&] {
+        return table->where().greater(col_int, 10).less(col_int, 30);
+    };
+    TableView plain = make_query().find_all();
+    TableView sorted = make_query().find_all();
+    sorted.sort(SortDescriptor({{col_int}, {col_str}}, {false, true}));
+    TableView limited = make_query().find_all();
+    limited.sort(col_int);
+    limited.limit(LimitDescriptor(5));
+
+    auto check_same = [&](TableView& tv, DescriptorOrdering ordering) {
+        tv.sync_if_needed();
+        TableView expected = make_query().find_all(ordering);
+        CHECK_EQUAL(tv.size(), expected.size());
+        for (size_t i = 0; i < tv.size() && i < expected.size(); ++i)
+            CHECK_EQUAL(tv.get_key(i), expected.get_key(i));
+    };
+    DescriptorOrdering sort_ordering;
+    sort_ordering.append_sort(SortDescriptor({{col_int}, {col_str}}, {false, true}));
+    DescriptorOrdering limit_ordering;
+    limit_ordering.append_sort(SortDescriptor({{col_int}}));
+    limit_ordering.append_limit(LimitDescriptor(5));
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    for (int round = 0; round < 20; ++round) {
+        {
+            auto wt = db->start_write();
+            auto t = wt->get_table("table");
+            for (int i = 0; i < 10; ++i) {
+                switch (random.draw_int_mod(4)) {
+                    case 0:
+                        t->create_object().set(col_int, random.draw_int_mod(50));
+                        break;
+                    case 1:
+                        if (t->size() > 0)
+                            t->remove_object(t->get_object(random.draw_int_mod(t->size())).get_key());
+                        break;
+                    case 2:
+                        if (t->size() > 0)
+                            t->get_object(random.draw_int_mod(t->size())).set_null(col_int);
+                        break;
+                    default:
+                        if (t->size() > 0)
+                            t->get_object(random.draw_int_mod(t->size()))
+                                .set(col_int, random.draw_int_mod(50))
+                                .set(col_str, util::to_string(random.draw_int_mod(7)));
+                        break;
+                }
+            }
+            wt->commit();
+        }
+        rt->advance_read();
+        check_same(plain, DescriptorOrdering());
+        check_same(sorted, sort_ordering);
+        check_same(limited, limit_ordering);
+    }
+
+    // Changes committed through the same transaction
+    rt->promote_to_write();
+    table.cast_away_const()->get_object(plain.get_key(0)).set(col_int, 0);
+    table.cast_away_const()->create_object().set(col_int, 20);
+    rt->commit_and_continue_as_read();
+    check_same(plain, DescriptorOrdering());
+    check_same(sorted, sort_ordering);
+
+    // Clearing the table makes the view run the query again
+    {
+        auto wt = db->start_write();
+        wt->get_table("table")->clear();
+        wt->commit();
+    }
+    rt->advance_read();
+    check_same(plain, DescriptorOrdering());
+    CHECK_EQUAL(plain.size(), 0);
+}
+
+TEST(TableView_IncrementalSyncSelfLink)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBRef db = DB::create(*hist);
+    ColKey col_int, col_link;
+    std::vector<ObjKey> keys;
+    {
+        auto wt = db->start_write();
+        auto table = wt->add_table("table");
+        col_int = table->add_column(type_Int, "int");
+        col_link = table->add_column_link(type_Link, "link", *table);
+        for (int i = 0; i < 20; ++i)
+            keys.push_back(table->create_object().set(col_int, i % 10).get_key());
+        for (int i = 10; i < 20; ++i)
+            table->get_object(keys[i]).set(col_link, keys[i - 10]);
+        wt->commit();
+    }
+
+    auto rt = db->start_read();
+    ConstTableRef table = rt->get_table("table");
+    TableView linked = (table->link(col_link).column<Int>(col_int) > 5).find_all();
+    TableView backlinked = (table->column<BackLink>(*table, col_link).count() > 0).find_all();
+    CHECK_EQUAL(linked.size(), 4);
+    CHECK_EQUAL(backlinked.size(), 10);
+
+    // Only the objects at the other end of the links are changed
+    {
+        auto wt = db->start_write();
+        auto t = wt->get_table("table");
+        t->get_object(keys[2]).set(col_int, 8);
+        t->get_object(keys[9]).set(col_int, 0);
+        t->get_object(keys[15]).set_null(col_link);
+        wt->commit();
+    }
+    rt->advance_read();
+    linked.sync_if_needed();
+    backlinked.sync_if_needed();
+
+    TableView expected_linked = (table->link(col_link).column<Int>(col_int) > 5).find_all();
+    CHECK_EQUAL(linked.size(), 4);
+    CHECK_EQUAL(linked.size(), expected_linked.size());
+    for (size_t i = 0; i < linked.size() && i < expected_linked.size(); ++i)
+        CHECK_EQUAL(linked.get_key(i), expected_linked.get_key(i));
+    CHECK_EQUAL(linked.find_by_source_ndx(keys[12]) != npos, true);
+
+    CHECK_EQUAL(backlinked.size(), 9);
+    for (size_t i = 0; i < backlinked.size(); ++i)
+        CHECK_NOT_EQUAL(backlinked.get_key(i), keys[5]);
+}
+
 #endif // TEST_TABLE_VIEW
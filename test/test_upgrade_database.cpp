@@ -1218,6 +1218,123 @@ TEST(Upgrade_Database_6_10)
     CHECK(t);
 }
 
+TEST(Upgrade_Database_10_11)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    ColKey col;
+    ColKey col_plain;
+    ColKey col_str;
+    auto has_zone_maps = [&](ConstTableRef t) {
+        bool summarized = false;
+        t->traverse_clusters([&](const Cluster* cluster) {
+            ValueRange range;
+            summarized = cluster->get_value_range(col, range);
+            return summarized;
+        });
+        return summarized;
+    };
+    // The leaf refs of the first object whose value needs 16 bits, which are
+    // the offsets of the leaves in the file, as it is not encrypted
+    int64_t changed_value = 0;
+    ref_type int_leaf = 0;
+    ref_type plain_leaf = 0;
+    ref_type str_leaf = 0;
+    {
+        DBOptions options;
+        options.enable_zone_maps = true;
+        DBRef db = DB::create(path, false, options);
+        auto wt = db->start_write();
+        auto t = wt->add_table("table");
+        col = t->add_column(type_Int, "int");
+        col_plain = t->add_column(type_Int, "plain");
+        col_str = t->add_column(type_String, "string");
+        t->add_search_index(col, IndexType::Ordered);
+        t->add_search_index(col_str, IndexType::Substring);
+        for (int i = 0; i < 2000; i++)
+            t->create_object().set(col, i).set(col_plain, i).set(col_str, util::format("item %1", i));
+        wt->commit();
+
+        auto rt = db->start_read();
+        auto rt_table = rt->get_table("table");
+        CHECK(has_zone_maps(rt_table));
+        rt_table->traverse_clusters([&](const Cluster* cluster) {
+            // The first slot of a leaf holds the keys of its objects
+            Array leaf(cluster->get_alloc());
+            leaf.init_from_ref(cluster->get_as_ref(1 + col.get_index().val));
+            if (leaf.get_width() != 16)
+                return false;
+            changed_value = leaf.get(0);
+            int_leaf = leaf.get_ref();
+            plain_leaf = cluster->get_as_ref(1 + col_plain.get_index().val);
+            str_leaf = cluster->get_as_ref(1 + col_str.get_index().val);
+            return true;
+        });
+    }
+    CHECK_OR_RETURN(int_leaf);
+
+    // Change the values of that object without updating the indexes and the
+    // zone maps, as a writer of version 10 of the file format, which does not
+    // know them, would have done
+    {
+        File file(path, File::mode_Update);
+        auto set_value = [&](ref_type leaf) {
+            int16_t value = 5000;
+            char bytes[2] = {char(value & 0xff), char(value >> 8)};
+            file.seek(leaf + 8);
+            file.write(bytes, sizeof(bytes));
+        };
+        set_value(int_leaf);
+        set_value(plain_leaf);
+        std::string old_str = util::format("item %1", changed_value);
+        old_str.push_back(0);
+        std::string leaf_bytes(256, 0);
+        file.seek(str_leaf);
+        file.read(&leaf_bytes[0], leaf_bytes.size());
+        size_t pos = leaf_bytes.find(old_str);
+        CHECK_OR_RETURN(pos != std::string::npos);
+        file.seek(str_leaf + pos);
+        file.write("x", 1);
+    }
+
+    // Mark the file as written by version 10 of the file format, which is
+    // stored for each of the two top refs at offset 20 of the header. Such a
+    // writer may also have left the commit record flag set, which must not
+    // be trusted.
+    {
+        File file(path, File::mode_Update);
+        char header[24];
+        file.read(header, sizeof(header));
+        header[20] = header[21] = 10;
+        header[23] |= 2;
+        file.seek(0);
+        file.write(header, sizeof(header));
+    }
+
+    bool allow_upgrade = false;
+    CHECK_THROW(DB::create(path, false, DBOptions(DBOptions::Durability::Full, nullptr, allow_upgrade)),
+                FileFormatUpgradeRequired);
+
+    DBRef db = DB::create(path);
+    CHECK_NOT(db->incomplete_commit_discarded());
+    auto rt = db->start_read();
+    CHECK_EQUAL(_impl::GroupFriend::get_file_format_version(*rt), 11);
+    auto t = rt->get_table("table");
+    ObjKey changed_key = t->find_first_int(col_plain, 5000);
+    CHECK(changed_key);
+    // The indexes are rebuilt from the values
+    CHECK(t->has_search_index(col, IndexType::Ordered));
+    CHECK_EQUAL(t->where().greater(col, 1989).count(), 11);
+    CHECK_EQUAL(t->where().greater(col, 4000).find(), changed_key);
+    CHECK_EQUAL(t->where().equal(col, changed_value).count(), 0);
+    CHECK(t->has_search_index(col_str, IndexType::Substring));
+    CHECK_EQUAL(t->where().contains(col_str, "xtem").find(), changed_key);
+    CHECK_EQUAL(t->where().contains(col_str, "m 4").count(), 111);
+    // The zone maps are dropped, as the version 10 writer may have left them stale
+    CHECK_NOT(has_zone_maps(t));
+    CHECK_EQUAL(t->where().greater(col_plain, 4000).find(), changed_key);
+    rt->verify();
+}
+
 namespace {
 constexpr bool generate_json = false;
 }
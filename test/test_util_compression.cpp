@@ -0,0 +1,117 @@
+/*************************************************************************
+ *
+ * Copyright 2021 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include "testsettings.hpp"
+#ifdef TEST_UTIL_COMPRESSION
+
+#include <string>
+#include <vector>
+
+#include <realm/util/compression.hpp>
+
+#include "test.hpp"
+
+using namespace realm;
+using namespace realm::util;
+using namespace realm::test_util;
+
+namespace {
+
+// Returns the compressed size, after checking that the data can be restored
+size_t round_trip(unit_test::TestContext& test_context, const std::string& data)
+{
+    std::vector<char> compressed(compression::compress_bound(data.size()));
+    size_t size = compression::compress(data.data(), data.size(), compressed.data(), compressed.size());
+    CHECK_GREATER(size, 0);
+    std::string decompressed(data.size(), '\0');
+    CHECK(compression::decompress(compressed.data(), size, &decompressed[0], decompressed.size()));
+    CHECK(decompressed == data);
+    return size;
+}
+
+} // anonymous namespace
+
+
+TEST(Compression_RoundTrip)
+{
+    round_trip(test_context, "");
+    round_trip(test_context, "a");
+    round_trip(test_context, "abcd");
+    round_trip(test_context, "abcdabcd");
+
+    // Long runs are encoded as overlapping matches
+    CHECK_LESS(round_trip(test_context, std::string(100000, 'x')), 500);
+
+    std::string repeated;
+    for (int i = 0; i < 1000; ++i)
+        repeated += "table " + std::to_string(i % 10) + " column " + std::to_string(i % 7) + ";";
+    CHECK_LESS(round_trip(test_context, repeated), repeated.size() / 2);
+
+    // Random data must not grow by more than the bound allows
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    for (size_t size : {15, 16, 300, 70000}) {
+        std::string noise(size, '\0');
+        for (auto& c : noise)
+            c = char(random.draw_int<int>(0, 255));
+        round_trip(test_context, noise);
+    }
+
+    // Matches further back than the largest offset
+    std::string far(200000, '\0');
+    for (size_t i = 0; i < far.size(); ++i)
+        far[i] = char(random.draw_int<int>(0, 3));
+    round_trip(test_context, far + far);
+}
+
+
+TEST(Compression_OutputTooSmall)
+{
+    std::string data(1000, 'y');
+    char out[4];
+    CHECK_EQUAL(compression::compress(data.data(), data.size(), out, sizeof out), 0);
+    CHECK_EQUAL(compression::compress(data.data(), data.size(), out, 0), 0);
+}
+
+
+TEST(Compression_Malformed)
+{
+    std::string data = "abcdefgh abcdefgh abcdefgh abcdefgh";
+    std::vector<char> compressed(compression::compress_bound(data.size()));
+    size_t size = compression::compress(data.data(), data.size(), compressed.data(), compressed.size());
+    std::string out(data.size(), '\0');
+
+    // Truncated block, and wrong decompressed size
+    CHECK_NOT(compression::decompress(compressed.data(), size - 1, &out[0], out.size()));
+    CHECK_NOT(compression::decompress(compressed.data(), size, &out[0], out.size() - 1));
+    CHECK_NOT(compression::decompress(compressed.data(), 0, &out[0], out.size()));
+
+    // Offset reaching before the start of the output
+    const char bad_offset[] = {char(0x10), 'a', char(0x05), char(0x00), char(0x00)};
+    CHECK_NOT(compression::decompress(bad_offset, sizeof bad_offset, &out[0], 5));
+
+    // Arbitrary data must not make decompression read or write out of bounds
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    for (int i = 0; i < 1000; ++i) {
+        std::vector<char> noise(random.draw_int<size_t>(1, 64));
+        for (auto& c : noise)
+            c = char(random.draw_int<int>(0, 255));
+        compression::decompress(noise.data(), noise.size(), &out[0], out.size());
+    }
+}
+
+#endif // TEST_UTIL_COMPRESSION
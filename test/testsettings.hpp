@@ -71,6 +71,7 @@
 #define TEST_TRANSACTIONS
 #define TEST_TRANSACTIONS_LASSE
 #define TEST_REPLICATION
+#define TEST_REPLICATOR
 #define TEST_UTF8
 #define TEST_COLUMN_LARGE
 #define TEST_JSON
@@ -80,6 +81,7 @@
 
 #define TEST_UTIL_ANY
 #define TEST_UTIL_BASE64
+#define TEST_UTIL_COMPRESSION
 #define TEST_UTIL_ERROR
 #define TEST_UTIL_INSPECT
 #define TEST_UTIL_FILE